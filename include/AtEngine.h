@@ -0,0 +1,200 @@
+#ifndef AT_ENGINE_H
+#define AT_ENGINE_H
+
+/**
+ * @file AtEngine.h
+ * @brief Non-blocking AT-command engine for ESP-AT firmware (MEGA side)
+ *
+ * Replaces the old busy-wait sendATCommand(). Commands are queued and sent
+ * one at a time; update() drains whatever bytes the link has buffered and
+ * returns, so the caller's loop() never waits on the module.
+ *
+ * Responses are parsed as a byte stream. Every known token is matched
+ * incrementally from the start of the line (one compare per token per
+ * byte), so no response string is ever accumulated or searched:
+ * - Final results:  OK, ERROR, FAIL, SEND OK, SEND FAIL
+ * - CIPSEND prompt: '>' at the start of a line (not newline terminated)
+ * - URCs:           ready, WIFI CONNECTED, WIFI GOT IP, WIFI DISCONNECT,
+ *                   CONNECT, CLOSED, busy ...
+ * - Socket data:    +IPD,<len>:<bytes> (handed over byte by byte)
+ * Any other line (e.g. "+CWJAP:...") is reported as an information line
+ * for the command in flight.
+ */
+
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+enum AtResult
+{
+    AT_RESULT_OK,
+    AT_RESULT_ERROR,   // ERROR, FAIL or SEND FAIL
+    AT_RESULT_TIMEOUT
+};
+
+enum AtUrc
+{
+    AT_URC_READY,           // Module (re)booted
+    AT_URC_WIFI_CONNECTED,
+    AT_URC_WIFI_GOT_IP,
+    AT_URC_WIFI_DISCONNECT,
+    AT_URC_CONNECT,         // TCP link up
+    AT_URC_CLOSED,          // TCP link down
+    AT_URC_BUSY             // Module still processing the previous command
+};
+
+// Command flags
+#define AT_FLAG_WAIT_READY 0x01 // Finishes on "ready" instead of OK (AT+RST)
+#define AT_FLAG_SEND_DATA 0x02  // AT+CIPSEND=<length>, prompt, payload, SEND OK
+
+/**
+ * @class AtClient
+ * @brief Callbacks from AtEngine to the object that owns the link
+ */
+class AtClient
+{
+public:
+    virtual ~AtClient() {}
+
+    /**
+     * @brief A queued command finished
+     * @param tag Tag given when the command was queued
+     * @param result OK, ERROR or TIMEOUT
+     */
+    virtual void onAtResult(uint8_t tag, AtResult result) = 0;
+
+    /**
+     * @brief Write the command text (text == NULL) or the CIPSEND payload
+     * @param tag Tag of the command being sent
+     * @param out Link to the module; the engine adds the command's CRLF
+     */
+    virtual void onAtWrite(uint8_t /*tag*/, Print & /*out*/) {}
+
+    /**
+     * @brief Unsolicited result code
+     */
+    virtual void onAtUrc(AtUrc /*urc*/) {}
+
+    /**
+     * @brief Information line that is not a known token
+     * @param tag Tag of the command in flight (0xFF if none)
+     * @param line NUL-terminated line, truncated to AT_LINE_MAX - 1 chars
+     */
+    virtual void onAtLine(uint8_t /*tag*/, const char * /*line*/) {}
+
+    /**
+     * @brief One byte of +IPD socket data
+     * @param c Data byte
+     * @param remaining Bytes still to come in this +IPD frame
+     */
+    virtual void onAtData(char /*c*/, uint16_t /*remaining*/) {}
+};
+
+/**
+ * @class AtEngine
+ * @brief Command queue plus streaming response parser
+ */
+class AtEngine
+{
+public:
+    static const uint8_t NO_TAG = 0xFF;
+
+    /**
+     * @param link Serial port wired to the ESP-AT module
+     * @param client Receiver for results, URCs, lines and socket data
+     */
+    AtEngine(Stream &link, AtClient &client);
+
+    /**
+     * @brief Queue a command
+     * @param text Command without CRLF (must stay valid until it is sent),
+     *             or NULL to have AtClient::onAtWrite() write it
+     * @param tag Caller's identifier, passed back in every callback
+     * @param timeoutMs Time allowed for the final result
+     * @param flags AT_FLAG_* bits
+     * @return false if the queue is full
+     */
+    bool send(const char *text, uint8_t tag, uint16_t timeoutMs, uint8_t flags = 0);
+
+    /**
+     * @brief Queue AT+CIPSEND; the payload is written by onAtWrite() at the prompt
+     * @param length Exact payload length in bytes
+     * @param tag Caller's identifier
+     * @param timeoutMs Time allowed for the prompt and again for SEND OK
+     * @return false if the queue is full
+     */
+    bool sendData(uint16_t length, uint8_t tag, uint16_t timeoutMs);
+
+    /**
+     * @brief Parse buffered input, handle timeouts and start the next command
+     *
+     * Call every loop; never blocks (apart from writing a command to the link).
+     */
+    void update();
+
+    /**
+     * @brief Drop every queued command; the one in flight still completes
+     */
+    void clearQueue();
+
+    bool isIdle() const { return _state == AT_IDLE && _count == 0; }
+    uint8_t pending() const { return _count + (_state == AT_IDLE ? 0 : 1); }
+
+    /**
+     * @brief Tag of the command in flight, or NO_TAG
+     */
+    uint8_t activeTag() const { return _state == AT_IDLE ? NO_TAG : _active.tag; }
+
+private:
+    struct Command
+    {
+        const char *text;
+        uint16_t timeout;
+        uint16_t length;   // Payload length for AT_FLAG_SEND_DATA
+        uint8_t tag;
+        uint8_t flags;
+    };
+
+    enum State
+    {
+        AT_IDLE,
+        AT_WAIT_RESULT, // Command sent, waiting for its final result
+        AT_WAIT_PROMPT, // CIPSEND sent, waiting for '>'
+        AT_WAIT_SENT    // Payload written, waiting for SEND OK
+    };
+
+    static const uint8_t TOKEN_COUNT = 13;
+
+    enum RxMode
+    {
+        RX_LINE,
+        RX_IPD_LENGTH,
+        RX_IPD_DATA
+    };
+
+    Stream &_link;
+    AtClient &_client;
+
+    Command _queue[AT_QUEUE_SIZE];
+    uint8_t _head;
+    uint8_t _count;
+
+    Command _active;
+    State _state;
+    unsigned long _sentAt;
+
+    // Streaming parser state
+    RxMode _rxMode;
+    char _line[AT_LINE_MAX];
+    uint8_t _lineLength;             // Bytes seen on this line (saturates)
+    uint8_t _match[TOKEN_COUNT];     // Per-token matched prefix length
+    uint16_t _ipdRemaining;
+
+    void startNext();
+    void finish(AtResult result);
+    void feed(char c);
+    void endLine();
+    void resetLine();
+    void handleToken(uint8_t token);
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef AUTH_CACHE_H
+#define AUTH_CACHE_H
+
+/**
+ * @file AuthCache.h
+ * @brief Persisted Firebase session tokens (ESP8266)
+ *
+ * The ID token and refresh token of the anonymous user are kept in flash
+ * (/auth.json) so reconnects and reboots reuse the same session instead of
+ * calling signUp() and creating a new anonymous user each time. The ID
+ * token is handed back to the Firebase client with its remaining lifetime;
+ * the client refreshes it (one securetoken request) only when it is within
+ * AUTH_REFRESH_MARGIN of expiry.
+ */
+
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+class AuthCache {
+public:
+    AuthCache();
+
+    /**
+     * @brief Load persisted tokens from flash
+     * @return true if a refresh token was found
+     */
+    bool load();
+
+    /**
+     * @brief Persist a new token pair (skipped if the ID token is unchanged)
+     * @param idToken Current ID token
+     * @param refreshToken Current refresh token
+     * @param expiresAt Unix time the ID token expires, 0 if unknown
+     * @return true if written
+     */
+    bool save(const String& idToken, const String& refreshToken, unsigned long expiresAt);
+
+    /**
+     * @brief Persist the expiry of the current token once it is known
+     * @param expiresAt Unix time the ID token expires
+     * @return true if written
+     *
+     * A token issued before time sync is saved without an expiry; this
+     * fills it in after the first sync, so the next boot can reuse it.
+     */
+    bool saveExpiry(unsigned long expiresAt);
+
+    /**
+     * @brief Forget the session (e.g. refresh token revoked)
+     */
+    void clear();
+
+    bool isValid() const { return _refreshToken.length() > 0; }
+    bool expiryKnown() const { return _expiresAt != 0; }
+    const char* idToken() const { return _idToken.c_str(); }
+    const char* refreshToken() const { return _refreshToken.c_str(); }
+
+    /**
+     * @brief Remaining ID token lifetime
+     * @param now Current Unix time, 0 if not synced
+     * @return Seconds left, 0 if expired or unknown (forces a refresh)
+     */
+    unsigned long secondsLeft(unsigned long now) const;
+
+private:
+    String _idToken;
+    String _refreshToken;
+    unsigned long _expiresAt;
+
+    static const char* AUTH_FILE;
+
+    bool write();  // Rewrite AUTH_FILE from the fields above
+};
+
+#endif
@@ -100,6 +100,7 @@ private:
     byte readCMDLastByte();
     String readDWIN();
     String handle();
+    int readFrameByte(unsigned long frameStart);
     String checkHex(byte currentNo);
     void flushSerial();
 
@@ -0,0 +1,221 @@
+#ifndef FIREBASE_STORAGE_H
+#define FIREBASE_STORAGE_H
+
+/**
+ * @file FirebaseStorage.h
+ * @brief Firebase RTDB storage through an ESP8266 running ESP-AT firmware
+ *
+ * Alternative topology to esp8266_main.cpp (env:megaatmega2560_at): the
+ * MEGA itself drives an ESP-AT module on ESP8266_SERIAL and POSTs batches
+ * to the Realtime Database. All AT traffic goes through AtEngine, so
+ * bring-up (reset, mode, join) and every sync run in the background while
+ * update() is called from loop().
+ *
+ * The request is never held in RAM: its length is measured by a dry run
+ * of the writers, then it is regenerated straight into the link in
+ * AT_SEND_SEGMENT-sized AT+CIPSEND segments. One TCP/TLS connection is
+ * kept open across syncs; a batch only counts as delivered once the HTTP
+ * response arriving through +IPD carries a 2xx status.
+ */
+
+#include "Config.h"
+#include "DataStorage.h"
+#include "LocalStorage.h"
+#include "AtEngine.h"
+
+/**
+ * @class FirebaseStorage
+ * @brief Batched, non-blocking DataStorage backend over ESP-AT
+ *
+ * Samples are staged in a FIREBASE_RING_SIZE ring; update() sends the
+ * oldest BATCH_SIZE of them once that many are waiting or
+ * FIREBASE_SYNC_INTERVAL has passed, and new samples keep arriving in the
+ * ring while a batch is in flight. When the ring is full (link down)
+ * samples spill to the optional LocalStorage and are pulled back in
+ * order once there is room again. A failed bring-up is retried every
+ * AT_RETRY_INTERVAL.
+ */
+class FirebaseStorage : public DataStorage, private AtClient {
+public:
+    /**
+     * @param host RTDB host name (e.g. FIREBASE_HOST)
+     * @param auth Database secret or token appended as ?auth= (may be empty)
+     * @param devId Device identifier used in the data path
+     * @param overflow EEPROM store for samples that do not fit the ring (optional)
+     */
+    FirebaseStorage(const String& host, const String& auth, const String& devId,
+                    LocalStorage* overflow = NULL);
+
+    /**
+     * @brief Open the link and start bring-up in the background
+     * @return true once bring-up is queued (the WiFi join completes later)
+     */
+    bool initialize() override;
+
+    /**
+     * @brief Drive the AT engine, retry bring-up and start due syncs
+     *
+     * Call every loop; never blocks.
+     */
+    void update();
+
+    /**
+     * @brief Stage a sample for upload
+     * @return false if not initialized, or the ring is full and there is no overflow store
+     */
+    bool saveData(const SensorData& data) override;
+
+    /**
+     * @brief Read a sample not yet delivered (0 = oldest, ring before overflow)
+     */
+    bool retrieveData(SensorData& data, int index) override;
+
+    /**
+     * @brief Samples not yet delivered (ring + overflow)
+     */
+    int getRecordCount() override;
+
+    /**
+     * @brief Drop undelivered samples (those already in a request still complete)
+     */
+    bool clearStorage() override;
+
+    String getStorageType() override { return "FirebaseStorage"; }
+
+    /**
+     * @brief Whether the module reports an IP address
+     */
+    bool isWiFiConnected() const { return wifiConnected; }
+
+    /**
+     * @brief HTTP status of the last completed request (0 if none yet)
+     */
+    int getLastHttpStatus() const { return lastHttpStatus; }
+
+private:
+    enum LinkState {
+        LINK_OFF,
+        LINK_STARTING,  // Reset, echo off, mode, join queued
+        LINK_READY,     // Joined, idle
+        LINK_SYNCING,   // Connect, send segments, wait for the response
+        LINK_FAILED     // Bring-up failed, waiting for the retry
+    };
+
+    enum CommandTag {
+        TAG_RESET,
+        TAG_ECHO_OFF,
+        TAG_MODE,
+        TAG_SINGLE_LINK,
+        TAG_SSL_SIZE,
+        TAG_JOIN,
+        TAG_CONNECT,
+        TAG_SEND,
+        TAG_CLOSE
+    };
+
+    // HTTP response parser states (fed from +IPD data)
+    enum ResponseState {
+        RESP_VERSION,   // "HTTP/1.1" up to the first space
+        RESP_CODE,      // Status digits
+        RESP_REASON,    // Rest of the status line
+        RESP_HEADERS,
+        RESP_BODY,
+        RESP_DONE
+    };
+
+    AtEngine at;
+    LocalStorage* spill;
+
+    String firebaseHost;
+    String firebaseAuth;
+    String deviceId;
+
+    LinkState linkState;
+    bool wifiConnected;
+    bool tcpConnected;       // From CONNECT / CLOSED, kept open across syncs
+    unsigned long lastSyncTime;
+    bool lastSyncFailed;     // Hold full batches back until the sync interval
+    unsigned long linkFailedAt;
+
+    SensorData batchBuffer[FIREBASE_RING_SIZE];
+    uint8_t batchHead;       // Ring index of the oldest staged sample
+    int batchCount;          // Staged samples in the ring
+    int syncingCount;        // Oldest samples covered by the request in flight
+
+    uint32_t bodyLength;     // JSON body bytes (Content-Length)
+    uint32_t requestLength;  // Header + body bytes
+    uint32_t sendOffset;     // Request bytes already accepted by the module
+    uint16_t segmentLength;  // Bytes in the CIPSEND segment in flight
+
+    bool awaitingResponse;   // Request fully sent, response not complete yet
+    unsigned long sentAt;    // millis() when the last segment was accepted
+    ResponseState responseState;
+    int httpStatus;          // Status of the response being parsed
+    int lastHttpStatus;
+    uint32_t responseRemaining; // Body bytes still to skip
+    uint8_t headerMatch;     // Matched prefix of "content-length:" on this line
+    uint8_t headerColumn;    // Bytes seen on this header line
+
+    /**
+     * @brief Queue reset, echo off, single-link and station+AP mode, WiFi join
+     * @param reset Start with AT+RST (false when the module just rebooted)
+     */
+    void startBringUp(bool reset = true);
+
+    /**
+     * @brief Measure the oldest staged batch and queue connect (if needed) + send
+     * @return false if there is nothing to send or the link is not ready
+     */
+    bool syncBatch();
+
+    /**
+     * @brief Queue AT+CIPSEND for the next slice of the request
+     */
+    void sendNextSegment();
+
+    /**
+     * @brief Abort the batch in flight; it stays staged for the next attempt
+     * @param reason Logged through handleError()
+     * @param closeLink Also close the connection (state unknown)
+     */
+    void failSync(const char* reason, bool closeLink);
+
+    /**
+     * @brief The response is complete: release the batch on 2xx, drop it on
+     *        a 4xx that a retry cannot fix, keep it staged otherwise
+     */
+    void finishResponse();
+
+    /**
+     * @brief Feed one byte of the HTTP response
+     */
+    void parseResponse(char c);
+
+    /**
+     * @brief Pull spilled samples back into the ring, oldest first
+     */
+    void refillFromSpill();
+
+    /**
+     * @brief Staged sample by age (0 = oldest)
+     */
+    SensorData& staged(int index) { return batchBuffer[(batchHead + index) % FIREBASE_RING_SIZE]; }
+
+    /**
+     * @brief Write the HTTP request (headers, then writeBody()) to a sink
+     */
+    void writeRequest(Print& out);
+
+    /**
+     * @brief Write the JSON array of the syncingCount oldest samples
+     */
+    void writeBody(Print& out);
+
+    void onAtResult(uint8_t tag, AtResult result) override;
+    void onAtWrite(uint8_t tag, Print& out) override;
+    void onAtUrc(AtUrc urc) override;
+    void onAtLine(uint8_t tag, const char* line) override;
+    void onAtData(char c, uint16_t remaining) override;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef FIRESTORE_DOCUMENT_H
+#define FIRESTORE_DOCUMENT_H
+
+/**
+ * @file FirestoreDocument.h
+ * @brief Firestore REST document built in a fixed buffer
+ *
+ * The upload lanes send one small flat document per record, summary or
+ * alarm: {"fields":{"temp":{"doubleValue":47.25},"relay1":{"integerValue":"1"}}}
+ * FirebaseJson builds the same text from a heap node per path segment and
+ * a heap copy of every key and value, thousands of short-lived blocks an
+ * hour on a heap that must stay unfragmented for weeks. This writes the
+ * JSON straight into its own buffer and never allocates.
+ *
+ * A field that does not fit marks the document as overflowed; c_str()
+ * then returns NULL and the caller skips the upload.
+ */
+
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+class FirestoreDocument
+{
+public:
+    FirestoreDocument();
+
+    void addDouble(const char *name, double value);
+    void addInteger(const char *name, unsigned long value); // integerValue is a JSON string
+    void addString(const char *name, const char *value);
+    void addBool(const char *name, bool value);
+
+    /**
+     * @brief The finished document, or NULL if a field did not fit
+     */
+    const char *c_str();
+
+    size_t length() const { return _length; }
+
+private:
+    char _buffer[FIRESTORE_DOC_MAX];
+    size_t _length;
+    bool _closed;
+    bool _overflow;
+
+    void beginField(const char *name, const char *type);
+    void append(const char *text);
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+/**
+ * @file HeapMonitor.h
+ * @brief ESP8266 heap sampling, day-long trend and alarms
+ *
+ * A unit that stays up for weeks does not run out of heap at once: free
+ * heap creeps down (a leak) or stays put while the largest free block
+ * shrinks (fragmentation) until a TLS buffer no longer fits and every
+ * upload fails. update() samples ESP.getHeapStats() every
+ * HEAP_SAMPLE_INTERVAL, averages the samples into one trend point per
+ * HEAP_TREND_BUCKET and fits a least-squares line through the last
+ * HEAP_TREND_POINTS of them, giving bytes per hour and fragmentation
+ * points per hour.
+ *
+ * Alarms are raised once per crossing (takeRaised()) and re-armed when the
+ * figure is back past its limit by an eighth: free heap or largest block
+ * under HEAP_ALARM_FREE / HEAP_ALARM_BLOCK, fragmentation over
+ * HEAP_ALARM_FRAG, and free heap falling faster than HEAP_ALARM_LEAK once
+ * half the trend window is filled. Fixed memory, no allocation.
+ */
+
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+// Alarm bits (alarms(), takeRaised())
+#define HEAP_ALARM_LOW_FREE 0x01
+#define HEAP_ALARM_LOW_BLOCK 0x02
+#define HEAP_ALARM_FRAGMENTED 0x04
+#define HEAP_ALARM_LEAKING 0x08
+
+class HeapMonitor
+{
+public:
+    HeapMonitor();
+
+    /**
+     * @brief Sample the heap when HEAP_SAMPLE_INTERVAL has passed
+     * @return true if a sample was taken
+     */
+    bool update();
+
+    /**
+     * @brief Fold one reading into the trend and the alarm state
+     */
+    void sample(uint32_t freeHeap, uint32_t maxBlock, uint8_t fragmentation);
+
+    uint32_t freeHeap() const { return _free; }
+    uint32_t maxBlock() const { return _maxBlock; }
+    uint8_t fragmentation() const { return _fragmentation; }
+
+    /**
+     * @brief Free heap slope over the trend window (bytes/hour), 0 below 3 points
+     */
+    long freeTrend() const;
+
+    /**
+     * @brief Fragmentation slope over the trend window (tenths of a point/hour)
+     */
+    int fragTrend() const;
+
+    /**
+     * @brief Trend points collected so far (up to HEAP_TREND_POINTS)
+     */
+    uint8_t trendPoints() const { return _points; }
+
+    /**
+     * @brief HEAP_ALARM_* bits currently active
+     */
+    uint8_t alarms() const { return _alarms; }
+
+    /**
+     * @brief Alarm bits raised since the last call
+     */
+    uint8_t takeRaised();
+
+    /**
+     * @brief One "HEAP:" line with the current figures and the trend
+     */
+    void printReport(Print &out) const;
+
+private:
+    unsigned long _lastSample;
+    uint32_t _free;
+    uint32_t _maxBlock;
+    uint8_t _fragmentation;
+
+    // Current bucket, folded into a trend point when full
+    uint32_t _bucketFreeSum;
+    uint32_t _bucketFragSum;
+    uint16_t _bucketSamples;
+
+    uint32_t _freePoints[HEAP_TREND_POINTS];  // Mean free heap per bucket
+    uint16_t _fragPoints[HEAP_TREND_POINTS];  // Mean fragmentation per bucket (tenths)
+    uint8_t _head;                            // Oldest point
+    uint8_t _points;
+
+    uint8_t _alarms;
+    uint8_t _raised;
+
+    float slope(bool fragmentation) const;
+    void updateAlarm(uint8_t bit, bool over, bool clear);
+};
+
+#endif
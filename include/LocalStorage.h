@@ -25,16 +25,22 @@
  * EEPROM Layout:
  * - Bytes 0-7: Header (magic number, version, record count, current index)
  * - Bytes 8+: Sensor data records (32 bytes each)
+ *
+ * Record layout: 2-byte length prefix (bit 15 = uploaded flag) + CSV text.
+ * Record indexes are logical: index 0 is always the oldest stored record.
  */
 class LocalStorage : public DataStorage {
 private:
-    static const int HEADER_SIZE = 10;     // Header: magic(2) + version(1) + index(2) + count(2) + checksum(1) + reserved(2)
+    static const int HEADER_SIZE = 10;     // Header: magic(2) + version(1) + index(2) + count(2) + checksum(1) + boot epoch(2)
     static const int RECORD_START = HEADER_SIZE;  // Start address for data records
     static const uint8_t STORAGE_VERSION = 1;     // Version for compatibility checks
+    static const uint16_t RECORD_FLAG_UPLOADED = 0x8000;  // Length-prefix bit: record already in the cloud
+    static const uint16_t RECORD_LENGTH_MASK = 0x7FFF;    // Length-prefix bits holding the CSV length
     int maxRecords;        // Maximum number of records that can be stored
     int recordSize;        // Size of each record in bytes (includes 2-byte length prefix)
     int currentIndex;      // Current write position (circular buffer)
     int recordCount;       // Number of records currently stored
+    uint16_t bootEpoch;    // Incremented on every initialize(); tags unsynced timestamps
 
     // EEPROM structure management methods
 
@@ -57,6 +63,22 @@ private:
      */
     int calculateAddress(int index);
 
+    /**
+     * @brief Map a logical record index (0 = oldest) to its physical slot
+     * @param index Logical record index
+     * @return Physical slot index in the circular buffer
+     */
+    int physicalSlot(int index) const;
+
+    /**
+     * @brief Write a CSV record (length prefix, data, zero padding) at an address
+     * @param address EEPROM address of the record slot
+     * @param csv Record text, must fit in recordSize - 2
+     * @param length Length of csv
+     * @param flagBits Bits to OR into the length prefix (RECORD_FLAG_UPLOADED)
+     */
+    void writeRecord(int address, const char* csv, size_t length, uint16_t flagBits);
+
 public:
     /**
      * @brief Constructor with configurable storage parameters
@@ -128,6 +150,44 @@ public:
      * @return true if export successful, false on error
      */
     bool exportToCSV(String& output, int startIndex = 0, int count = -1);
+
+    /**
+     * @brief Flag a stored record as uploaded so other upload lanes skip it
+     * @param index Logical record index (0 = oldest)
+     * @return true if the flag was written, false on error
+     *
+     * Not committed on its own (ESP8266): persisted by the next saveData().
+     */
+    bool markUploaded(int index);
+
+    /**
+     * @brief Check whether a stored record was already uploaded
+     * @param index Logical record index (0 = oldest)
+     * @return true if the record carries the uploaded flag
+     */
+    bool isUploaded(int index);
+
+    /**
+     * @brief Drop the oldest records from the buffer (FIFO consume)
+     * @param count Number of records to drop (clamped to the record count)
+     * @return Number of records actually dropped
+     *
+     * Not committed on its own (ESP8266): persisted by the next saveData().
+     */
+    int removeOldest(int count);
+
+    /**
+     * @brief Boot epoch of this run (persisted in the header)
+     */
+    uint16_t getBootEpoch() const { return bootEpoch; }
+
+    /**
+     * @brief Convert unsynced timestamps of one boot epoch to Unix time in one pass
+     * @param epoch Boot epoch whose records to correct
+     * @param offset Unix time minus uptime (s) for that boot
+     * @return Number of records corrected (records that no longer fit stay flagged)
+     */
+    int restampUnsynced(uint16_t epoch, unsigned long offset);
 };
 
 #endif
\ No newline at end of file
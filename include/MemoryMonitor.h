@@ -0,0 +1,110 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+/**
+ * @file MemoryMonitor.h
+ * @brief SRAM headroom on the MEGA: stack painting, heap and per-task probes
+ *
+ * At boot (.init3, before any constructor runs) everything between the end
+ * of .bss and the stack pointer is filled with a canary byte. Whatever the
+ * heap or the stack writes there afterwards stops being canary, so the
+ * longest canary run left between them is RAM nobody has used yet: its top
+ * is the deepest the stack has been, its bottom the highest the heap has
+ * been. scan() finds that run (~2 ms for the whole 8 KB at 16 MHz); the
+ * peak getters return what the last scan saw.
+ *
+ * beginTask()/endTask() measure one piece of loop() on its own: begin
+ * repaints MEMORY_PROBE_WINDOW bytes below the stack pointer, end looks
+ * for the lowest byte written in that window. A task deeper than the
+ * window reports the window size.
+ *
+ * Painting cannot see untouched bytes at the bottom of a frame (a JSON
+ * pool that is never filled), so every figure is a lower bound on use.
+ *
+ * Only the AVR build measures anything; elsewhere supported() is false and
+ * every figure is 0.
+ */
+
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+// loop() pieces with their own stack probe
+enum MemoryTask
+{
+    MEM_TASK_RTD,     // rtdSensor()
+    MEM_TASK_CELL,    // loadCell()
+    MEM_TASK_JSON,    // readSensors() + send
+    MEM_TASK_HMI,     // updateHmiDisplay()
+    MEM_TASK_LISTEN,  // hmi.listen()
+    MEM_TASK_ESP,     // processESPMessages() / cloud.update()
+    MEM_TASK_COUNT
+};
+
+class MemoryMonitor
+{
+public:
+    /**
+     * @brief True when the figures are real (AVR build)
+     */
+    static bool supported();
+
+    /**
+     * @brief Free RAM right now: heap free list + gap between heap and stack
+     */
+    static uint16_t freeNow();
+
+    /**
+     * @brief Largest single malloc() that would succeed right now
+     */
+    static uint16_t largestFreeBlock();
+
+    /**
+     * @brief Find the untouched gap between heap and stack (call once per sample)
+     */
+    static void scan();
+
+    /**
+     * @brief Bytes neither heap nor stack has touched since boot (last scan)
+     */
+    static uint16_t unusedSinceBoot();
+
+    /**
+     * @brief Deepest stack use since boot, in bytes below RAMEND (last scan)
+     */
+    static uint16_t stackPeak();
+
+    /**
+     * @brief Highest heap extent since boot, in bytes above __heap_start (last scan)
+     */
+    static uint16_t heapPeak();
+
+    /**
+     * @brief Start the stack probe for one task (repaints the probe window)
+     */
+    static void beginTask(uint8_t task);
+
+    /**
+     * @brief End the probe and keep the task's peak
+     */
+    static void endTask(uint8_t task);
+
+    /**
+     * @brief Deepest stack use of one task since boot (bytes below its entry)
+     */
+    static uint16_t taskPeak(uint8_t task);
+
+    /**
+     * @brief One "MEM:" line with every figure
+     */
+    static void printReport(Print &out);
+
+private:
+    static uint16_t _stackPeak;
+    static uint16_t _heapPeak;
+    static uint16_t _unused;
+    static uint16_t _taskPeak[MEM_TASK_COUNT];
+    static uint8_t *_probeBottom;
+    static uint8_t *_probeTop;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef MONOTONIC_CLOCK_H
+#define MONOTONIC_CLOCK_H
+
+/**
+ * @file MonotonicClock.h
+ * @brief Rollover-safe 64-bit uptime clock (both boards)
+ *
+ * millis() wraps after 49.7 days and micros() after 71.6 minutes. This
+ * service extends both to 64 bits by counting wraps: every call compares
+ * the 32-bit value with the previous one and carries into the high word
+ * when it went backwards. A wrap is only missed if no call happens for a
+ * whole period, so update() is called once per loop() pass.
+ *
+ * Use it for anything absolute (uptime, fallback timestamps, TimeSync
+ * anchors). Interval checks written as "now - last >= interval" on 32-bit
+ * values are already wrap-safe and can stay as they are.
+ *
+ * Main-loop context only: the wrap state is not protected against
+ * concurrent use from interrupt handlers.
+ */
+
+#include <Arduino.h>
+
+class MonotonicClock {
+public:
+    /**
+     * @brief Milliseconds since boot, never wraps
+     */
+    static uint64_t millis64();
+
+    /**
+     * @brief Microseconds since boot, never wraps (needs a call every < 71 min)
+     */
+    static uint64_t micros64();
+
+    /**
+     * @brief Keep both wrap counters current (call every loop pass)
+     */
+    static void update();
+
+private:
+    static uint32_t _lastMillis;
+    static uint32_t _millisWraps;
+    static uint32_t _lastMicros;
+    static uint32_t _microsWraps;
+};
+
+#endif
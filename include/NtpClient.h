@@ -0,0 +1,87 @@
+#ifndef NTP_CLIENT_H
+#define NTP_CLIENT_H
+
+/**
+ * @file NtpClient.h
+ * @brief Minimal SNTP client (RFC 4330) over any Arduino UDP socket
+ *
+ * One 48-byte request/response per sample. Each reply yields the clock
+ * offset and round-trip delay from the four timestamps:
+ *
+ *   t1 = local send, t2 = server receive, t3 = server send, t4 = local receive
+ *   offset = ((t2 - t1) + (t3 - t4)) / 2
+ *   delay  = (t4 - t1) - (t3 - t2)
+ *
+ * query() takes several samples across the configured servers and keeps
+ * the one with the smallest delay (its offset has the tightest error
+ * bound, +/- delay / 2). Servers are "host" or "host:port", so a local
+ * NTP stand-in (tools/ntp_standin.py) can be used instead of the pool.
+ */
+
+#include <Arduino.h>
+#include <Udp.h>
+
+/**
+ * @struct NtpSample
+ * @brief Result of one request/response exchange
+ */
+struct NtpSample {
+    int64_t offsetMs;    // Unix time (ms) minus MonotonicClock::millis64()
+    uint32_t delayMs;    // Round-trip network delay (ms)
+    uint8_t stratum;     // Server stratum (1 = primary reference)
+};
+
+class NtpClient {
+public:
+    static const int PACKET_SIZE = 48;
+    static const uint16_t DEFAULT_PORT = 123;
+
+    /**
+     * @param udp Socket to use (WiFiUDP on the ESP, any UDP for testing)
+     */
+    explicit NtpClient(UDP& udp);
+
+    /**
+     * @brief Set the server list ("host" or "host:port"); pointers must stay valid
+     */
+    void setServers(const char* const* servers, uint8_t count);
+
+    /**
+     * @brief Sample the servers and return the best (lowest delay) result
+     * @param best Filled with the chosen sample
+     * @param samples Number of exchanges to attempt (spread across servers)
+     * @param timeoutMs Per-exchange reply timeout
+     * @return true if at least one valid reply was received
+     */
+    bool query(NtpSample& best, uint8_t samples, uint16_t timeoutMs);
+
+    /**
+     * @brief Build a client request carrying transmitMs as its transmit timestamp
+     */
+    static void buildRequest(uint8_t* packet, uint64_t transmitMs);
+
+    /**
+     * @brief Validate a server reply and compute offset/delay
+     * @param packet 48-byte reply
+     * @param t1 Local send time (ms), must match the echoed originate timestamp
+     * @param t4 Local receive time (ms)
+     * @param sample Filled on success
+     * @return false for malformed, unsynchronised, kiss-o'-death or stale replies
+     */
+    static bool parseResponse(const uint8_t* packet, uint64_t t1, uint64_t t4, NtpSample& sample);
+
+    /**
+     * @brief Convert between Unix milliseconds and 64-bit NTP timestamps
+     */
+    static uint64_t unixMsToNtp(uint64_t unixMs);
+    static uint64_t ntpToUnixMs(uint64_t ntp);
+
+private:
+    UDP& _udp;
+    const char* const* _servers;
+    uint8_t _serverCount;
+
+    bool exchange(const char* server, uint16_t timeoutMs, NtpSample& sample);
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef REMOTE_CONFIG_H
+#define REMOTE_CONFIG_H
+
+/**
+ * @file RemoteConfig.h
+ * @brief Versioned runtime settings pulled from FB_CONFIG_PATH
+ *
+ * The ESP8266 polls the cloud config document, validates it, persists it
+ * to flash and forwards only the changed MEGA-side fields over the serial
+ * link as "CFG:key=value" lines, finishing with "CFG:version=N". The MEGA
+ * reports the version it runs as "cv" in every sample, so the ESP knows
+ * when a push has landed or must be repeated (e.g. after a MEGA reset).
+ *
+ * Cloud document (all fields optional except version):
+ * {"version":3,"sample_ms":1000,"batas_ka":15.0,"temp_high":70,"temp_low":40,
+ *  "upload_batch":10,"agg_window_s":60,"raw_mode":0,"raw_decimation":10}
+ */
+
+#include "SystemConfig.h"
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * @struct DeviceSettings
+ * @brief Every field that can be tuned without reflashing
+ */
+struct DeviceSettings {
+    unsigned long version;        // 0 = compile-time defaults, no remote config yet
+
+    // MEGA-side settings (pushed over the link)
+    unsigned long sampleInterval; // Sensor read interval (ms)
+    float batasKa;                // Moisture target (%)
+    float tempHigh;               // SSR off at/above (°C)
+    float tempLow;                // SSR on at/below (°C)
+
+    // ESP-side settings (applied locally)
+    uint16_t uploadBatchSize;     // Max backlog records per backfill pass
+    uint16_t aggWindowSeconds;    // Summary window length
+    uint8_t rawUploadMode;        // RAW_UPLOAD_FULL / DECIMATED / OFF
+    uint16_t rawDecimation;       // Keep 1 of N samples when decimated
+
+    /**
+     * @brief Settings the firmware boots with (both boards)
+     */
+    static DeviceSettings defaults();
+};
+
+/**
+ * @class RemoteConfig
+ * @brief Validation, persistence and MEGA delta generation for DeviceSettings
+ */
+class RemoteConfig {
+public:
+    RemoteConfig();
+
+    /**
+     * @brief Load persisted settings from flash (keeps defaults on failure)
+     * @return true if a valid persisted config was loaded
+     */
+    bool load();
+
+    /**
+     * @brief Persist the current settings to flash
+     * @return true if written
+     */
+    bool save();
+
+    /**
+     * @brief Validate a config document and make it current
+     * @param doc Parsed config document (missing fields keep current values;
+     *            a field of the wrong type or out of range rejects it)
+     * @return true if the document was valid and carried a different version
+     */
+    bool apply(JsonDocument& doc);
+
+    /**
+     * @brief Write "CFG:" lines for MEGA fields that differ from what it runs
+     * @param from Settings the MEGA currently runs, or NULL if unknown (send all)
+     * @param out Stream connected to the MEGA
+     * @return Number of fields sent (the version line is always sent)
+     */
+    int writeMegaDelta(const DeviceSettings* from, Print& out) const;
+
+    const DeviceSettings& current() const { return _current; }
+    unsigned long version() const { return _current.version; }
+
+    /**
+     * @brief Check every field against its allowed range
+     */
+    static bool validate(const DeviceSettings& settings);
+
+private:
+    DeviceSettings _current;
+
+    static const char* CONFIG_FILE;
+
+    static bool fromJSON(JsonDocument& doc, DeviceSettings& settings);
+    static void toJSON(const DeviceSettings& settings, JsonDocument& doc);
+};
+
+#endif
@@ -12,6 +12,14 @@
 #include "SystemConfig.h"
 #include <Arduino.h>
 
+// Longest CSV line the buffer versions of toCSV()/fromCSV() handle
+#define SENSOR_CSV_MAX 96
+
+// Same-second sequence: one base-36 digit after the timestamp, so the
+// longest synced record ("4294967295_z,-242.02,1000.00,1") is 30 chars
+#define SENSOR_SEQUENCE_DIGITS "0123456789abcdefghijklmnopqrstuvwxyz"
+#define SENSOR_SEQUENCE_MAX 35
+
 /**
  * @struct SensorData
  * @brief Dynamic container for sensor measurements
@@ -28,6 +36,9 @@ struct SensorData {
     uint8_t relay1;            // Relay 1 state (SSR): 0=OFF, 1=ON
     uint8_t relay2;            // Relay 2 state: 0=OFF, 1=ON
     float kadarAir;            // Moisture content (%) - not stored in EEPROM, only sent to Firebase
+    uint8_t flags;             // DATA_FLAG_* bits, 0 for a normal sample
+    uint16_t bootEpoch;        // Boot the uptime timestamp belongs to (only with DATA_FLAG_UNSYNCED_TIME)
+    uint16_t sequence;         // Samples stamped before it in the same second (0..SENSOR_SEQUENCE_MAX)
 
     // Accessor methods for clearer code
     void setTemperature(float temp) { values[0] = temp; }
@@ -53,60 +64,105 @@ struct SensorData {
 
     /**
      * @brief Convert sensor data to CSV format (dynamic based on sensor config)
-     * @return String containing comma-separated values
+     * @param buffer Output, NUL-terminated
+     * @param size Buffer size (SENSOR_CSV_MAX is always enough)
+     * @return Length written, 0 if it did not fit or the sequence is over
+     *         SENSOR_SEQUENCE_MAX
      *
      * Format adapts to SENSOR_COUNT from SensorConfig.h
      * Example: "12345,25.50,100.25,1" for 2 sensors
+     * A non-zero sequence follows the timestamp as one base-36 digit, and
+     * non-zero flags are appended as a trailing field, followed by the boot
+     * epoch for unsynced timestamps: "1767225600_a,25.50,100.25,1",
+     * "12345,25.50,100.25,1,1,7"
+     *
+     * Builds on the stack: no heap allocation, so the store path does not
+     * fragment a long-running unit's heap.
      */
-    String toCSV() const {
-        String csv = String(timestamp);
-        for (int i = 0; i < SENSOR_COUNT; i++) {
-            csv += "," + String(values[i], 2);
+    size_t toCSV(char *buffer, size_t size) const {
+        char number[48];  // dtostrf() prints every integer digit: 39 for FLT_MAX, plus sign and decimals
+        if (sequence > SENSOR_SEQUENCE_MAX) return 0;
+
+        size_t length = snprintf(buffer, size, "%lu", (unsigned long)timestamp);
+        if (sequence > 0 && length < size) {
+            length += snprintf(buffer + length, size - length, "_%c", SENSOR_SEQUENCE_DIGITS[sequence]);
+        }
+        for (int i = 0; i < SENSOR_COUNT && length < size; i++) {
+            dtostrf(values[i], 1, 2, number);  // Same digits as String(value, 2)
+            length += snprintf(buffer + length, size - length, ",%s", number);
         }
-        csv += "," + String(status);
-        return csv;
+        if (length < size) {
+            length += snprintf(buffer + length, size - length, ",%u", (unsigned)status);
+        }
+        if (flags != 0 && length < size) {
+            length += snprintf(buffer + length, size - length, ",%u", (unsigned)flags);
+        }
+        if ((flags & DATA_FLAG_UNSYNCED_TIME) && length < size) {
+            length += snprintf(buffer + length, size - length, ",%u", (unsigned)bootEpoch);
+        }
+        return length < size ? length : 0;
+    }
+
+    /**
+     * @brief Convert sensor data to CSV format as a String
+     */
+    String toCSV() const {
+        char csv[SENSOR_CSV_MAX];
+        return toCSV(csv, sizeof(csv)) ? String(csv) : String();
     }
 
     /**
      * @brief Parse CSV string back into SensorData structure (dynamic)
-     * @param csv Comma-separated string to parse
+     * @param csv NUL-terminated comma-separated line to parse
      * @return true if parsing successful, false on error
      *
      * Automatically adapts to sensor count from SensorConfig.h
      */
-    bool fromCSV(const String& csv) {
-        int pos = 0;
-        int nextComma = csv.indexOf(',');
-
-        if (nextComma == -1) return false;
-
-        // Parse timestamp
-        timestamp = strtoul(csv.substring(0, nextComma).c_str(), NULL, 10);
-        pos = nextComma + 1;
+    bool fromCSV(const char *csv) {
+        const char *comma = strchr(csv, ',');
+        if (comma == NULL) return false;
+
+        // Parse timestamp and the optional "_<digit>" sequence
+        char *end;
+        timestamp = strtoul(csv, &end, 10);
+        sequence = 0;
+        if (*end == '_' && end[1] != '\0') {
+            const char *digit = strchr(SENSOR_SEQUENCE_DIGITS, end[1]);
+            if (digit != NULL) sequence = digit - SENSOR_SEQUENCE_DIGITS;
+        }
+        const char *pos = comma + 1;
 
-        // Parse sensor values dynamically
+        // Parse sensor values dynamically; status must follow the last one
         for (int i = 0; i < SENSOR_COUNT; i++) {
-            nextComma = csv.indexOf(',', pos);
-            if (nextComma == -1 && i < SENSOR_COUNT - 1) return false;
-
-            if (i == SENSOR_COUNT - 1) {
-                // Last sensor value
-                int statusComma = csv.indexOf(',', pos);
-                if (statusComma == -1) return false;
-                values[i] = csv.substring(pos, statusComma).toFloat();
-                pos = statusComma + 1;
-            } else {
-                values[i] = csv.substring(pos, nextComma).toFloat();
-                pos = nextComma + 1;
-            }
+            comma = strchr(pos, ',');
+            if (comma == NULL) return false;
+            values[i] = atof(pos);
+            pos = comma + 1;
         }
 
-        // Parse status
-        status = csv.substring(pos).toInt();
+        // Parse status and the optional flags / boot epoch fields
+        flags = 0;
+        bootEpoch = 0;
+        status = atol(pos);
+        comma = strchr(pos, ',');
+        if (comma != NULL) {
+            flags = atol(comma + 1);
+
+            if (flags & DATA_FLAG_UNSYNCED_TIME) {
+                comma = strchr(comma + 1, ',');
+                if (comma != NULL) {
+                    bootEpoch = atol(comma + 1);
+                }
+            }
+        }
 
         return true;
     }
 
+    bool fromCSV(const String& csv) {
+        return fromCSV(csv.c_str());
+    }
+
     /**
      * @brief Convert sensor data to JSON format for Firebase (dynamic)
      * @return String containing JSON object
@@ -145,9 +145,15 @@
 // ========================================
 
 #define DATA_SAMPLE_INTERVAL 1000     // Read sensors every 5 seconds
+#define DATA_SAMPLE_INTERVAL_MIN 1000 // Floor for a remote sample_ms: every sample is an upload and a flash commit
 #define AUTO_SYNC_INTERVAL 300000     // Sync to Firebase every 5 minutes
 #define DISPLAY_STATUS_INTERVAL 30000 // Show status every 30 seconds
 
+// Control thresholds (boot defaults, tunable remotely via FB_CONFIG_PATH)
+#define TEMP_SSR_OFF 70.0    // SSR off at/above this temperature (°C)
+#define TEMP_SSR_ON 40.0     // SSR on at/below this temperature (°C)
+#define MOISTURE_TARGET 15.0 // batas_ka: moisture target (%)
+
 // ========================================
 // SECTION 5: LOCAL STORAGE (EEPROM)
 // ========================================
@@ -163,8 +169,32 @@
 
 #define ESP_SERIAL_BAUD 115200        // Serial baud rate for ESP8266
 #define ESP_WIFI_CHECK_INTERVAL 30000 // Check WiFi every 30 seconds
-#define ESP_RECONNECT_ATTEMPTS 20     // Max WiFi reconnect attempts
+#define ESP_SERIAL_RX_BUFFER 1024     // UART RX buffer: ~5 s of MEGA samples while a request blocks
+#define INGEST_MAX_LINES 8            // MEGA lines handled per ingest pass
+#define ESP_LINE_MAX 300              // Longest MEGA line accepted; longer ones are discarded
+#define FIRESTORE_DOC_MAX 768         // Largest upload document (window summary ~560 chars)
+#define MEGA_LINE_MAX 128             // Longest ESP line the MEGA takes (TIME:/CFG: < 40 chars)
+
+// SNTP time source ("host" or "host:port" for a local stand-in)
+#define NTP_SERVERS "id.pool.ntp.org", "pool.ntp.org", "time.google.com"
+#define NTP_SAMPLES 4                 // Exchanges per sync; lowest round trip wins
+#define NTP_TIMEOUT 800               // Per-exchange reply timeout (ms)
+
+// Clock discipline (both boards, see TimeSync.h)
+#define TIME_SLEW_RATE_PPM 500        // Max slew: 0.5 ms corrected per second
+#define TIME_STEP_THRESHOLD 2000      // Errors beyond this (ms) are stepped, not slewed
+#define TIME_DRIFT_MIN_INTERVAL 3600000UL // Shortest baseline for a drift estimate (ms)
+#define TIME_DRIFT_MAX_PPM 500        // Clamp for the drift estimate
+#define UNIX_TIME_MIN 1609459200UL    // 2021-01-01: smaller timestamps are uptime seconds
+#define WIFI_CONNECT_TIMEOUT 15000    // Abandon a connection attempt after 15 s
+#define WIFI_BACKOFF_MIN 1000         // First retry delay after a failure (ms)
+#define WIFI_BACKOFF_MAX 60000        // Retry delay cap, doubles up to this (ms)
+#define WIFI_FAST_CONNECT_TIMEOUT 1500 // Cached BSSID/channel/IP attempt before full scan (ms)
+#define WIFI_RTC_SLOT 0               // RTC user-memory block for the fast-connect cache (32 bytes)
 #define ESP_RESPONSE_TIMEOUT 1000     // Response timeout (ms)
+#define UPLOAD_BATCH_SIZE 10          // Max backlog records per backfill pass
+#define UPLOAD_BACKOFF_MIN 1000       // Upload lanes pause this long after a failed request (ms)
+#define UPLOAD_BACKOFF_MAX 60000      // Pause cap, doubles up to this while requests keep failing (ms)
 
 // ========================================
 // SECTION 7: FIREBASE PATHS
@@ -176,6 +206,13 @@
 #define FB_STATUS_PATH FB_DEVICE_PATH "/status"
 #define FB_CONFIG_PATH FB_DEVICE_PATH "/config"
 
+#define STATUS_PUBLISH_INTERVAL 60000 // Telemetry document to FB_STATUS_PATH every minute
+#define CONFIG_POLL_INTERVAL 10000    // Check FB_CONFIG_PATH version every 10 seconds
+#define CONFIG_PUSH_RETRY 5000        // Re-send config delta until the MEGA acknowledges it (CFGACK:)
+
+#define AUTH_TOKEN_LIFETIME 3600      // Firebase ID token lifetime (s)
+#define AUTH_REFRESH_MARGIN 300       // Refresh the ID token this long before it expires (s)
+
 // ========================================
 // SECTION 8: SERIAL & DEBUG
 // ========================================
@@ -184,6 +221,13 @@
 #define DEBUG_MODE true
 #define VERBOSE_LOGGING false
 
+// The ESP8266 console is the MEGA's Serial3: lines for every sample
+// (DATA:, SAVED:, LIVE:) overrun its 64-byte buffer and splice into TIME:
+// and CFG: lines, so they are only sent for load tests
+#ifndef ESP_SAMPLE_ECHO
+#define ESP_SAMPLE_ECHO 0
+#endif
+
 // ========================================
 // SECTION 9: STATUS CODES
 // ========================================
@@ -193,6 +237,80 @@
 #define STATUS_SENSOR_FAULT -1
 #define STATUS_WIFI_OFFLINE -2
 
+// SensorData flag bits (stored as an optional trailing CSV field)
+#define DATA_FLAG_UNSYNCED_TIME 0x01 // Timestamp is uptime, taken before time sync
+
+// Alarm event codes (MEGA flags them, ESP uploads them on the fast path)
+#define ALARM_TEMP_HIGH "temp_high" // Temperature crossed the upper limit
+#define ALARM_KA_TARGET "ka_target" // Moisture reached batas_ka
+#define ALARM_RTD_FAULT "rtd_fault" // MAX31865 reported a fault
+#define ALARM_HYSTERESIS 1.0        // Re-arm margin for threshold alarms
+#define ALARM_QUEUE_SIZE 8          // Alarms held on the ESP while offline
+
+// ========================================
+// SECTION 10: EDGE AGGREGATION (ESP8266)
+// ========================================
+
+// Raw sample upload modes
+#define RAW_UPLOAD_FULL 0      // Store and upload every raw sample
+#define RAW_UPLOAD_DECIMATED 1 // Store every RAW_DECIMATION_FACTOR-th sample
+#define RAW_UPLOAD_OFF 2       // Upload window summaries only
+
+#define AGG_WINDOW_SECONDS 60           // Summary window length (1 minute)
+#define AGG_QUEUE_SIZE 8                // Closed windows waiting for upload
+#define RAW_UPLOAD_MODE RAW_UPLOAD_FULL // Bandwidth vs. fidelity per deployment
+#define RAW_DECIMATION_FACTOR 10        // Keep 1 of N samples when decimated
+
+// ========================================
+// SECTION 11: ESP-AT LINK (MEGA, FirebaseStorage)
+// ========================================
+
+// MEGA drives an ESP-AT module itself instead of talking to esp8266_main
+// (set by env:megaatmega2560_at)
+#ifndef ESP_AT_FIREBASE
+#define ESP_AT_FIREBASE 0
+#endif
+
+#define AT_QUEUE_SIZE 6               // Commands waiting behind the one in flight
+#define AT_LINE_MAX 64                // Longest response line kept for inspection
+#define AT_COMMAND_TIMEOUT 2000       // Plain commands (ms)
+#define AT_RESET_TIMEOUT 5000         // AT+RST until "ready" (ms)
+#define AT_JOIN_TIMEOUT 20000         // AT+CWJAP until OK/FAIL (ms)
+#define AT_CONNECT_TIMEOUT 10000      // AT+CIPSTART until OK (ms)
+#define AT_SEND_TIMEOUT 10000         // CIPSEND prompt, and again SEND OK (ms)
+#define AT_SEND_SEGMENT 2048          // Max payload per AT+CIPSEND (ESP-AT limit)
+#define AT_RESPONSE_TIMEOUT 10000     // Last segment accepted -> HTTP response complete (ms)
+#define AT_RETRY_INTERVAL 10000       // Wait before restarting a failed bring-up (ms)
+#define AT_KEEPALIVE_SECONDS 60       // TCP keep-alive on the persistent connection
+#define AT_FIREBASE_TLS 1             // 1 = SSL on 443 (RTDB default), 0 = plain TCP on 80
+#define FIREBASE_BATCH_SIZE 10        // Samples per RTDB write
+#define FIREBASE_RING_SIZE 16         // Staged samples in RAM; overflow spills to EEPROM
+
+// ========================================
+// SECTION 12: MEMORY MONITOR (MEGA)
+// ========================================
+
+#define MEMORY_PROBE_ENABLED 1        // Per-task stack probes around the loop() tasks
+#define MEMORY_PROBE_WINDOW 512       // Stack repainted below each task's entry (bytes)
+#define MEMORY_REPORT_INTERVAL 60000  // "MEM:" console line every minute
+
+// ========================================
+// SECTION 13: HEAP MONITOR (ESP8266)
+// ========================================
+
+#define HEAP_SAMPLE_INTERVAL 10000    // ESP.getHeapStats() every 10 s
+#define HEAP_TREND_BUCKET 3600000UL   // One trend point per hour (mean of its samples)
+#define HEAP_TREND_POINTS 24          // Trend over the last day
+#define HEAP_REPORT_INTERVAL 600000UL // "HEAP:" console line every 10 minutes
+#define HEAP_ALARM_FREE 8192          // Alarm below this much free heap (bytes)
+#define HEAP_ALARM_BLOCK 6144         // Alarm below this largest block: a TLS record buffer must fit
+#define HEAP_ALARM_FRAG 50            // Alarm above this fragmentation (%)
+#define HEAP_ALARM_LEAK 256           // Alarm when free heap falls faster (bytes/hour, half a window of points)
+#define ALARM_HEAP_FREE "heap_free"   // Free heap under its limit
+#define ALARM_HEAP_BLOCK "heap_block" // Largest block under its limit (own code: both usually trip together)
+#define ALARM_HEAP_FRAG "heap_frag"   // Fragmentation over its limit
+#define ALARM_HEAP_LEAK "heap_leak"   // Free heap trending down
+
 // ========================================
 // LEGACY COMPATIBILITY (DO NOT EDIT)
 // ========================================
@@ -204,5 +322,6 @@
 #define FIREBASE_SYNC_INTERVAL AUTO_SYNC_INTERVAL
 #define ESP8266_SERIAL Serial3
 #define ESP8266_BAUDRATE ESP_SERIAL_BAUD
+#define BATCH_SIZE FIREBASE_BATCH_SIZE
 
 #endif
\ No newline at end of file
@@ -1,29 +1,58 @@
 /**
  * @file TimeSync.h
- * @brief Time Synchronization Module using WorldTimeAPI
+ * @brief Time Synchronization Module using SNTP
  *
- * This module fetches real Unix timestamps from worldtimeapi.org
- * and stores the time offset in EEPROM for offline use.
+ * This module queries the NTP servers in NTP_SERVERS (see NtpClient),
+ * keeps the lowest-delay of NTP_SAMPLES replies and anchors Unix time to
+ * the 64-bit MonotonicClock with millisecond precision, so a long
+ * network outage cannot be corrupted by the 49.7-day millis() wrap.
+ * Nothing is persisted: the EEPROM belongs to LocalStorage, and a time
+ * saved before a reset cannot be carried across it (millis() restarts).
+ * Until the first sync, callers flag their samples as unsynced.
+ *
+ * Clock discipline (both boards): the first sync steps the clock. Later
+ * syncs estimate the crystal drift from the time elapsed between them
+ * (at least TIME_DRIFT_MIN_INTERVAL apart) and apply it continuously; the
+ * remaining error is slewed out at TIME_SLEW_RATE_PPM instead of stepped,
+ * so timestamps stay monotonic across resyncs. Errors above
+ * TIME_STEP_THRESHOLD are still stepped.
  */
 
 #ifndef TIME_SYNC_H
 #define TIME_SYNC_H
 
 #include <Arduino.h>
+#include "SystemConfig.h"
 
 class TimeSync
 {
 public:
     TimeSync();
 
-    // Initialize time sync (call in setup)
+    // Initialize time sync (call in setup, never blocks)
     bool begin();
 
     // Get current Unix timestamp (seconds since 1970-01-01)
     unsigned long getUnixTime();
 
-    // Sync time from API (returns true if successful)
-    bool syncTimeFromAPI();
+    // Get current Unix timestamp in milliseconds (drift and slew corrected)
+    uint64_t getUnixTimeMs();
+
+    // Sync time from NTP (returns true if successful)
+    bool syncTimeFromNTP();
+
+    // Override the NTP server list ("host" or "host:port"), e.g. a local stand-in
+    void setNtpServers(const char *const *servers, uint8_t count);
+
+    // Offset (Unix ms - millis64()) and round-trip delay of the last sync
+    long long getLastOffsetMs() { return _lastOffsetMs; }
+    unsigned long getLastRoundTrip() { return _lastRoundTrip; }
+
+    // Estimated crystal drift (ppm, positive = local clock runs slow)
+    float getDriftPpm() { return _driftPpm; }
+
+    // Correction still being slewed out (ms)
+    long getPendingSlewMs();
 
     // Check if time is synced
     bool isSynced();
@@ -35,24 +64,33 @@ public:
     void update();
 
     // Set time manually (for AVR receiving time from ESP8266)
-    void setUnixTime(unsigned long unixTime);
+    void setUnixTime(unsigned long unixTime, uint16_t millisPart = 0);
+
+    // Parse "TIME:<unix>" or "TIME:<unix>.<fraction>" as the ESP8266 sends it.
+    // Digits only, seconds within 32 bits, at most 3 fraction digits (".5" is
+    // 500 ms); anything else returns false and leaves the outputs alone.
+    static bool parseTimeMessage(const char *line, unsigned long &unixTime, uint16_t &millisPart);
 
 private:
-    unsigned long _bootUnixTime;      // Unix time when system booted
-    unsigned long _bootMillis;        // millis() when time was synced
+    uint64_t _anchorUnixMs;           // Disciplined Unix time (ms) at _anchorMillis
+    uint64_t _anchorMillis;           // MonotonicClock::millis64() of the anchor
+    float _driftPpm;                  // Rate correction applied since the anchor
+    long _slewMs;                     // Error to slew out, starting at the anchor
+    bool _driftValid;
+
+    uint64_t _refUnixMs;              // Last measurement used as drift baseline
+    uint64_t _refMillis;
+
     bool _timeSynced;
     unsigned long _lastSyncAttempt;
+    long long _lastOffsetMs;
+    unsigned long _lastRoundTrip;
 
-    // EEPROM addresses for time storage
-    static const int EEPROM_TIME_ADDR = 0;
-    static const int EEPROM_MILLIS_ADDR = 4;
-    static const int EEPROM_VALID_FLAG_ADDR = 8;
-
-    // Save time to EEPROM
-    void saveTimeToEEPROM();
+    // Disciplined Unix time (ms) at a given millis64() value
+    uint64_t unixMsAt(uint64_t localMs);
 
-    // Load time from EEPROM
-    bool loadTimeFromEEPROM();
+    // Feed one measurement (true Unix ms observed at localMs) into the clock
+    void applySync(uint64_t unixMs, uint64_t localMs);
 };
 
 #endif // TIME_SYNC_H
@@ -0,0 +1,150 @@
+#ifndef UPLOAD_TELEMETRY_H
+#define UPLOAD_TELEMETRY_H
+
+/**
+ * @file UploadTelemetry.h
+ * @brief Upload pipeline metrics for the ESP8266 status document
+ *
+ * Collects throughput, request latency, failure classes and resource
+ * usage with fixed memory (latency is kept as a bucket histogram, not a
+ * sample list). The ESP publishes one coalesced status document per
+ * STATUS_PUBLISH_INTERVAL to FB_STATUS_PATH and then starts a new period.
+ */
+
+#include <Arduino.h>
+
+// Failure classes for upload requests
+#define FAIL_NETWORK 0 // No HTTP response (connection, DNS, timeout)
+#define FAIL_AUTH 1    // 401 / 403
+#define FAIL_CLIENT 2  // Other 4xx
+#define FAIL_SERVER 3  // 5xx
+#define FAIL_OTHER 4   // Anything else
+#define FAIL_CLASSES 5
+
+/**
+ * @class UploadTelemetry
+ * @brief Per-period upload counters plus since-boot resource watermarks
+ */
+class UploadTelemetry
+{
+public:
+    UploadTelemetry();
+
+    /**
+     * @brief Record a successful upload request
+     * @param latencyMs Request round-trip time
+     * @param bytes Payload size sent
+     * @param records Number of records carried by the request
+     */
+    void recordSuccess(unsigned long latencyMs, size_t bytes, int records);
+
+    /**
+     * @brief Record a failed upload request
+     * @param httpCode HTTP status, or <= 0 when no response was received
+     * @param latencyMs Time spent before the failure
+     */
+    void recordFailure(int httpCode, unsigned long latencyMs);
+
+    /**
+     * @brief Count a record, summary or alarm dropped after a non-retryable failure
+     */
+    void recordRejected() { _rejected++; }
+
+    /**
+     * @brief Latest heap figures and their since-boot watermarks
+     * @param freeHeap Free heap (bytes)
+     * @param maxBlock Largest free block (bytes)
+     * @param fragmentation ESP.getHeapFragmentation() (%)
+     */
+    void sampleHeap(uint32_t freeHeap, uint32_t maxBlock, uint8_t fragmentation);
+
+    /**
+     * @brief Heap trend and alarm state from the HeapMonitor
+     * @param freePerHour Free heap slope (bytes/hour)
+     * @param fragTenthsPerHour Fragmentation slope (tenths of a point/hour)
+     * @param alarms Active HEAP_ALARM_* bits
+     */
+    void setHeapTrend(long freePerHour, int fragTenthsPerHour, uint8_t alarms);
+
+    /**
+     * @brief Latest SRAM figures the MEGA reported with a sample
+     * @param freeNow Free RAM at that sample (bytes)
+     * @param unused RAM neither heap nor stack has touched since the MEGA booted
+     * @param largestBlock Largest malloc() that would have succeeded
+     * @param stackPeak Deepest stack use since the MEGA booted
+     */
+    void sampleMegaMemory(uint16_t freeNow, uint16_t unused, uint16_t largestBlock, uint16_t stackPeak);
+
+    /**
+     * @brief Track alarm detection-to-cloud latency
+     */
+    void recordAlarmLatency(unsigned long latencyMs);
+
+    /**
+     * @brief Record how long the last WiFi (re)connect took
+     * @param connectMs Attempt start to GOT_IP (ms)
+     * @param fast true if the cached BSSID/channel/static-IP path was used
+     */
+    void recordWiFiConnect(unsigned long connectMs, bool fast);
+
+    /**
+     * @brief Latency percentile for the current period from the histogram
+     * @param percent Percentile (1-100)
+     * @return Upper bound of the bucket holding the percentile (ms), 0 if no data
+     */
+    unsigned long latencyPercentile(uint8_t percent) const;
+
+    /**
+     * @brief Serialize the current period as a flat JSON object
+     * @param buffer Output buffer
+     * @param size Buffer size
+     * @param backlog Records/events still waiting for upload
+     * @param rssi WiFi signal strength (dBm)
+     * @param unixTime Current Unix time (0 if not synced)
+     * @return Number of characters written (0 if the buffer was too small)
+     */
+    size_t toJSON(char *buffer, size_t size, int backlog, int rssi, unsigned long unixTime) const;
+
+    /**
+     * @brief Start a new reporting period (watermarks are kept)
+     */
+    void resetPeriod();
+
+    uint32_t getHeapLowWater() const { return _heapLowWater; }
+
+private:
+    static const uint8_t LATENCY_BUCKETS = 12;
+    static const uint16_t BUCKET_LIMITS[LATENCY_BUCKETS]; // Upper bound of each bucket (ms)
+
+    unsigned long _periodStart;
+    unsigned long _requests;
+    unsigned long _records;
+    unsigned long _bytes;
+    unsigned long _failures[FAIL_CLASSES];
+    unsigned long _rejected;
+    uint16_t _latencyHistogram[LATENCY_BUCKETS + 1]; // Last bucket = above all limits
+    unsigned long _latencyMax;
+
+    uint32_t _heapLowWater;
+    uint32_t _heapLast;
+    uint32_t _heapBlock;
+    uint32_t _heapBlockMin;
+    uint8_t _heapFrag;
+    uint8_t _heapFragMax;
+    long _heapTrend;               // Bytes/hour
+    int _heapFragTrend;            // Tenths of a point/hour
+    uint8_t _heapAlarms;
+    uint16_t _megaRamFree;         // Not reset per period: 0 until the MEGA reports
+    uint16_t _megaRamMin;          // Lowest free RAM seen in a sample
+    uint16_t _megaRamUnused;
+    uint16_t _megaHeapBlock;
+    uint16_t _megaStackPeak;
+    unsigned long _alarmLatencyMax;
+    unsigned long _alarmLatencyLast;
+    unsigned long _wifiConnectMs;  // Not reset per period: last connect stays visible
+    bool _wifiFast;
+
+    void recordLatency(unsigned long latencyMs);
+};
+
+#endif
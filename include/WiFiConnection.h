@@ -0,0 +1,132 @@
+#ifndef WIFI_CONNECTION_H
+#define WIFI_CONNECTION_H
+
+/**
+ * @file WiFiConnection.h
+ * @brief Event-driven, non-blocking WiFi connection manager (ESP8266)
+ *
+ * Replaces the old busy-wait connectWiFi(). Association and DHCP run in
+ * the background; the SDK reports progress through station-mode events
+ * and update() only moves the state machine forward, so loop() never
+ * waits on the access point.
+ *
+ * States:
+ * - IDLE:       nothing in progress (before begin())
+ * - CONNECTING: WiFi.begin() issued, waiting for GOT_IP or timeout
+ * - CONNECTED:  station has an IP address
+ * - BACKOFF:    last attempt failed, waiting before the next one
+ *
+ * Fast reconnect: after every successful connection the BSSID, channel
+ * and IP configuration are cached in a CRC-checked RTC memory slot (lost
+ * on power-off) and mirrored to flash (written only when they change).
+ * The next attempt joins that BSSID/channel directly with a static IP,
+ * skipping the scan and DHCP; if it does not finish within
+ * WIFI_FAST_CONNECT_TIMEOUT the manager falls back to a full scan + DHCP.
+ */
+
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+#ifdef ESP8266
+#include <ESP8266WiFi.h>
+
+/**
+ * @struct WiFiFastConnectCache
+ * @brief Last good access point and IP configuration (32 bytes, RTC aligned)
+ */
+struct WiFiFastConnectCache
+{
+    uint32_t magic;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t mask;
+    uint32_t dns;
+    uint32_t crc; // CRC32 of every field above
+};
+
+enum WiFiConnectionState
+{
+    CONN_IDLE,
+    CONN_CONNECTING,
+    CONN_CONNECTED,
+    CONN_BACKOFF
+};
+
+class WiFiConnection
+{
+public:
+    WiFiConnection();
+
+    /**
+     * @brief Register event handlers and start the first attempt
+     * @param ssid Network name
+     * @param password Network password
+     */
+    void begin(const char *ssid, const char *password);
+
+    /**
+     * @brief Advance the state machine (call every loop, never blocks)
+     */
+    void update();
+
+    bool isConnected() const { return _state == CONN_CONNECTED; }
+    WiFiConnectionState getState() const { return _state; }
+    const char *getStateName() const;
+
+    /**
+     * @brief Duration of the last successful attempt (begin -> GOT_IP), ms
+     */
+    unsigned long getLastConnectTime() const { return _lastConnectTime; }
+
+    /**
+     * @brief Number of successful connections since boot
+     */
+    unsigned long getConnectCount() const { return _connectCount; }
+
+    /**
+     * @brief Whether the current/last connection used the cached fast path
+     */
+    bool wasFastConnect() const { return _fastAttempt; }
+
+    /**
+     * @brief Drop the cached access point (e.g. after changing networks)
+     */
+    void forgetCache();
+
+private:
+    const char *_ssid;
+    const char *_password;
+
+    WiFiConnectionState _state;
+    unsigned long _attemptStart;   // millis() when the current attempt began
+    unsigned long _backoffStart;   // millis() when backoff began
+    unsigned long _backoffDelay;   // Current backoff length (ms), doubles per failure
+    unsigned long _lastConnectTime;
+    unsigned long _connectCount;
+
+    WiFiFastConnectCache _cache;
+    bool _cacheValid;
+    bool _fastAttempt;     // Current attempt uses the cache
+    bool _skipFast;        // Fast path just failed; next attempt does a full scan
+
+    // Set from SDK event callbacks, consumed by update()
+    volatile bool _gotIp;
+    volatile bool _disconnected;
+
+    WiFiEventHandler _gotIpHandler;
+    WiFiEventHandler _disconnectedHandler;
+
+    void startAttempt();
+    void enterBackoff();
+
+    bool loadCache();
+    void storeCache();
+    static uint32_t crc32(const uint8_t *data, size_t length);
+};
+
+#endif // ESP8266
+
+#endif
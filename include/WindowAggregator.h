@@ -0,0 +1,97 @@
+#ifndef WINDOW_AGGREGATOR_H
+#define WINDOW_AGGREGATOR_H
+
+/**
+ * @file WindowAggregator.h
+ * @brief Rolling per-window summaries computed on the ESP8266
+ *
+ * Dashboards mostly need per-minute min/max/avg values instead of every
+ * raw sample. This module folds each ingested sample into the current
+ * window in O(1) time and hands back a closed WindowSummary once the
+ * window ends, so summaries can be uploaded on their own lane.
+ */
+
+#include "SystemConfig.h"
+#include "SensorData.h"
+#include <Arduino.h>
+
+// Channels tracked per window (index into WindowSummary arrays)
+#define AGG_TEMPERATURE 0
+#define AGG_WEIGHT 1
+#define AGG_KADAR_AIR 2
+#define AGG_CHANNELS 3
+
+/**
+ * @struct WindowSummary
+ * @brief Min/max/avg of every channel plus relay duty cycle for one window
+ */
+struct WindowSummary {
+    unsigned long windowStart;     // Timestamp of window start (same clock as samples)
+    uint16_t windowSeconds;        // Window length in seconds
+    uint16_t sampleCount;          // Samples folded into this window
+    float minValue[AGG_CHANNELS];
+    float maxValue[AGG_CHANNELS];
+    float avgValue[AGG_CHANNELS];
+    float relay1Duty;              // Fraction of samples with relay 1 ON (0.0 - 1.0)
+    float relay2Duty;              // Fraction of samples with relay 2 ON (0.0 - 1.0)
+};
+
+/**
+ * @class WindowAggregator
+ * @brief Incremental fixed-window aggregator (no sample history kept)
+ *
+ * Windows are aligned to multiples of the window length on the sample
+ * timestamp, so every device produces comparable buckets once time is synced.
+ */
+class WindowAggregator {
+public:
+    /**
+     * @brief Constructor
+     * @param windowSeconds Window length in seconds (default: AGG_WINDOW_SECONDS)
+     */
+    WindowAggregator(uint16_t windowSeconds = AGG_WINDOW_SECONDS);
+
+    /**
+     * @brief Fold a sample into the current window
+     * @param data Sample to add
+     * @param closed Filled with the previous window if this sample closed it
+     * @return true if a window was closed and `closed` is valid
+     */
+    bool addSample(const SensorData& data, WindowSummary& closed);
+
+    /**
+     * @brief Close the current window if its end time has passed
+     * @param now Current time on the same clock as sample timestamps
+     * @param closed Filled with the closed window
+     * @return true if a window was closed and `closed` is valid
+     */
+    bool flush(unsigned long now, WindowSummary& closed);
+
+    /**
+     * @brief Change the window length (discards the window in progress)
+     * @param windowSeconds New window length in seconds (0 is ignored)
+     */
+    void setWindowSeconds(uint16_t windowSeconds);
+
+    uint16_t getWindowSeconds() const { return _windowSeconds; }
+
+    /**
+     * @brief Number of samples in the window currently being built
+     */
+    uint16_t getPendingSamples() const { return _count; }
+
+private:
+    uint16_t _windowSeconds;
+    unsigned long _windowStart;
+    uint16_t _count;
+    float _min[AGG_CHANNELS];
+    float _max[AGG_CHANNELS];
+    float _sum[AGG_CHANNELS];
+    uint16_t _relay1On;
+    uint16_t _relay2On;
+
+    void reset(unsigned long windowStart);
+    void close(WindowSummary& closed);  // Emits the summary and empties the window
+};
+
+#endif
@@ -0,0 +1,327 @@
+/**
+ * @file AtEngine.cpp
+ * @brief Non-blocking AT-command engine implementation
+ */
+
+#include "../include/AtEngine.h"
+
+// Tokens recognised at the start of a line. Every entry before TOK_BUSY
+// must fill the whole line; TOK_BUSY and TOK_IPD only have to start it.
+// TOKENS lists them in this order; AtEngine::TOKEN_COUNT is their number.
+enum AtToken
+{
+    TOK_OK,
+    TOK_ERROR,
+    TOK_FAIL,
+    TOK_SEND_OK,
+    TOK_SEND_FAIL,
+    TOK_READY,
+    TOK_WIFI_CONNECTED,
+    TOK_WIFI_GOT_IP,
+    TOK_WIFI_DISCONNECT,
+    TOK_CONNECT,
+    TOK_CLOSED,
+    TOK_BUSY,
+    TOK_IPD
+};
+
+static const char *const TOKENS[] = {
+    "OK",
+    "ERROR",
+    "FAIL",
+    "SEND OK",
+    "SEND FAIL",
+    "ready",
+    "WIFI CONNECTED",
+    "WIFI GOT IP",
+    "WIFI DISCONNECT",
+    "CONNECT",
+    "CLOSED",
+    "busy ",
+    "+IPD,"};
+
+static const uint8_t IPD_PREFIX_LENGTH = 5; // strlen("+IPD,")
+
+AtEngine::AtEngine(Stream &link, AtClient &client)
+    : _link(link),
+      _client(client),
+      _head(0),
+      _count(0),
+      _state(AT_IDLE),
+      _sentAt(0),
+      _rxMode(RX_LINE),
+      _ipdRemaining(0)
+{
+    resetLine();
+}
+
+bool AtEngine::send(const char *text, uint8_t tag, uint16_t timeoutMs, uint8_t flags)
+{
+    if (_count >= AT_QUEUE_SIZE)
+    {
+        return false;
+    }
+
+    Command &cmd = _queue[(_head + _count) % AT_QUEUE_SIZE];
+    cmd.text = text;
+    cmd.timeout = timeoutMs;
+    cmd.length = 0;
+    cmd.tag = tag;
+    cmd.flags = flags;
+    _count++;
+    return true;
+}
+
+bool AtEngine::sendData(uint16_t length, uint8_t tag, uint16_t timeoutMs)
+{
+    if (!send(NULL, tag, timeoutMs, AT_FLAG_SEND_DATA))
+    {
+        return false;
+    }
+
+    _queue[(_head + _count - 1) % AT_QUEUE_SIZE].length = length;
+    return true;
+}
+
+void AtEngine::update()
+{
+    while (_link.available() > 0)
+    {
+        feed((char)_link.read());
+    }
+
+    if (_state != AT_IDLE && millis() - _sentAt >= _active.timeout)
+    {
+        finish(AT_RESULT_TIMEOUT);
+    }
+
+    if (_state == AT_IDLE && _count > 0)
+    {
+        startNext();
+    }
+}
+
+void AtEngine::clearQueue()
+{
+    _head = 0;
+    _count = 0;
+}
+
+void AtEngine::startNext()
+{
+    _active = _queue[_head];
+    _head = (_head + 1) % AT_QUEUE_SIZE;
+    _count--;
+
+    if (_active.flags & AT_FLAG_SEND_DATA)
+    {
+        _link.print(F("AT+CIPSEND="));
+        _link.print(_active.length);
+        _state = AT_WAIT_PROMPT;
+    }
+    else
+    {
+        if (_active.text)
+        {
+            _link.print(_active.text);
+        }
+        else
+        {
+            _client.onAtWrite(_active.tag, _link);
+        }
+        _state = AT_WAIT_RESULT;
+    }
+
+    _link.print(F("\r\n"));
+    _sentAt = millis();
+}
+
+void AtEngine::finish(AtResult result)
+{
+    // Idle before the callback so the client can queue its next step
+    _state = AT_IDLE;
+    _client.onAtResult(_active.tag, result);
+}
+
+void AtEngine::feed(char c)
+{
+    switch (_rxMode)
+    {
+    case RX_IPD_DATA:
+        _ipdRemaining--;
+        _client.onAtData(c, _ipdRemaining);
+        if (_ipdRemaining == 0)
+        {
+            _rxMode = RX_LINE;
+            resetLine();
+        }
+        return;
+
+    case RX_IPD_LENGTH:
+        if (c >= '0' && c <= '9')
+        {
+            _ipdRemaining = _ipdRemaining * 10 + (c - '0');
+        }
+        else if (c == ':' && _ipdRemaining > 0)
+        {
+            _rxMode = RX_IPD_DATA;
+        }
+        else
+        {
+            // Malformed frame header: resynchronise on the next line
+            _rxMode = RX_LINE;
+            resetLine();
+        }
+        return;
+
+    case RX_LINE:
+        break;
+    }
+
+    if (c == '\n')
+    {
+        endLine();
+        return;
+    }
+    if (c == '\r')
+    {
+        return;
+    }
+
+    if (_lineLength == 0)
+    {
+        if (c == ' ')
+        {
+            return;
+        }
+
+        // The CIPSEND prompt is "> " with no line end after it
+        if (c == '>' && _state == AT_WAIT_PROMPT)
+        {
+            _client.onAtWrite(_active.tag, _link);
+            _state = AT_WAIT_SENT;
+            _sentAt = millis();
+            return;
+        }
+    }
+
+    // A token is still a candidate only while every byte so far matched it
+    for (uint8_t t = 0; t < TOKEN_COUNT; t++)
+    {
+        if (_match[t] == _lineLength && TOKENS[t][_lineLength] == c)
+        {
+            _match[t]++;
+        }
+    }
+
+    if (_lineLength < AT_LINE_MAX - 1)
+    {
+        _line[_lineLength] = c;
+    }
+    if (_lineLength < 0xFF)
+    {
+        _lineLength++;
+    }
+
+    if (_lineLength == IPD_PREFIX_LENGTH && _match[TOK_IPD] == IPD_PREFIX_LENGTH)
+    {
+        _rxMode = RX_IPD_LENGTH;
+        _ipdRemaining = 0;
+    }
+}
+
+void AtEngine::endLine()
+{
+    for (uint8_t t = 0; t < TOKEN_COUNT; t++)
+    {
+        bool complete = _match[t] > 0 && TOKENS[t][_match[t]] == '\0';
+        if (complete && (t >= TOK_BUSY || _match[t] == _lineLength))
+        {
+            resetLine();
+            handleToken(t);
+            return;
+        }
+    }
+
+    if (_lineLength > 0)
+    {
+        uint8_t end = _lineLength < AT_LINE_MAX - 1 ? _lineLength : AT_LINE_MAX - 1;
+        _line[end] = '\0';
+        _client.onAtLine(activeTag(), _line);
+    }
+
+    resetLine();
+}
+
+void AtEngine::resetLine()
+{
+    _lineLength = 0;
+    for (uint8_t t = 0; t < TOKEN_COUNT; t++)
+    {
+        _match[t] = 0;
+    }
+}
+
+void AtEngine::handleToken(uint8_t token)
+{
+    switch (token)
+    {
+    case TOK_OK:
+        // CIPSEND answers OK before its prompt; AT+RST before "ready"
+        if (_state == AT_WAIT_RESULT && !(_active.flags & AT_FLAG_WAIT_READY))
+        {
+            finish(AT_RESULT_OK);
+        }
+        break;
+
+    case TOK_ERROR:
+    case TOK_FAIL:
+        if (_state != AT_IDLE)
+        {
+            finish(AT_RESULT_ERROR);
+        }
+        break;
+
+    case TOK_SEND_OK:
+        if (_state == AT_WAIT_SENT)
+        {
+            finish(AT_RESULT_OK);
+        }
+        break;
+
+    case TOK_SEND_FAIL:
+        if (_state == AT_WAIT_SENT)
+        {
+            finish(AT_RESULT_ERROR);
+        }
+        break;
+
+    case TOK_READY:
+        // Expected after AT+RST; anywhere else the module reset under us
+        if (_state != AT_IDLE)
+        {
+            finish(_active.flags & AT_FLAG_WAIT_READY ? AT_RESULT_OK : AT_RESULT_ERROR);
+        }
+        _client.onAtUrc(AT_URC_READY);
+        break;
+
+    case TOK_WIFI_CONNECTED:
+        _client.onAtUrc(AT_URC_WIFI_CONNECTED);
+        break;
+    case TOK_WIFI_GOT_IP:
+        _client.onAtUrc(AT_URC_WIFI_GOT_IP);
+        break;
+    case TOK_WIFI_DISCONNECT:
+        _client.onAtUrc(AT_URC_WIFI_DISCONNECT);
+        break;
+    case TOK_CONNECT:
+        _client.onAtUrc(AT_URC_CONNECT);
+        break;
+    case TOK_CLOSED:
+        _client.onAtUrc(AT_URC_CLOSED);
+        break;
+    case TOK_BUSY:
+        _client.onAtUrc(AT_URC_BUSY);
+        break;
+    }
+}
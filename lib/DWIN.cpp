@@ -70,6 +70,10 @@
 void DWIN::init(Stream* port, bool isSoft){
     this->_dwinSerial = port;
     this->_isSoft = isSoft;
+    this->_echo = false;
+    this->_isConnected = false;
+    this->cbfunc_valid = false;
+    this->listenerCallback = nullptr;
 }
 
 
@@ -128,11 +132,11 @@ void DWIN::setText(long address, String textData){
     int dataLen = textData.length();
     byte startCMD[] = {CMD_HEAD1, CMD_HEAD2, (byte)(dataLen+3), CMD_WRITE,
     (byte)((address >> 8) & 0xFF), (byte)(address & 0xFF)};
-    byte dataCMD[dataLen];textData.getBytes(dataCMD, dataLen+1);
     byte sendBuffer[6+dataLen];
 
+    // Straight from the String: getBytes() would also write the NUL
     memcpy(sendBuffer, startCMD, sizeof(startCMD));
-    memcpy(sendBuffer+6, dataCMD, sizeof(dataCMD));
+    memcpy(sendBuffer+6, textData.c_str(), dataLen);
 
     _dwinSerial->write(sendBuffer, sizeof(sendBuffer));
     readDWIN();
@@ -204,10 +208,22 @@ String DWIN::checkHex(byte currentNo){
     return String(currentNo, HEX);
 }
 
+// Next byte of a frame that has started; the rest follows at line speed,
+// so give up once the frame has taken CMD_READ_TIMEOUT (-1)
+int DWIN::readFrameByte(unsigned long frameStart){
+    while(_dwinSerial->available() <= 0){
+        if (millis() - frameStart >= CMD_READ_TIMEOUT){
+            return -1;
+        }
+    }
+    return _dwinSerial->read();
+}
+
 String DWIN::handle(){
 
-    int lastByte;
+    int lastByte = 0;
     String response;
+    String lastResponse;
     String address;
     String message;
     bool isSubstr = false;
@@ -216,16 +232,21 @@ String DWIN::handle(){
     unsigned long startTime = millis(); 
   
     while((millis() - startTime < READ_TIMEOUT)){
-        while(_dwinSerial->available() > 0){
-            delay(10);
+        while(_dwinSerial->available() > 0 && (millis() - startTime < READ_TIMEOUT)){
             int inhex = _dwinSerial->read();
             if (inhex == 90 || inhex == 165){
                 isFirstByte = true;
                 response.concat(checkHex(inhex)+" ");
                 continue;
             }
+            unsigned long frameStart = millis();
+            bool complete = true;
             for(int i = 1 ; i <= inhex ;i++){
-                int inByte = _dwinSerial->read();
+                int inByte = readFrameByte(frameStart);
+                if (inByte < 0){
+                    complete = false;  // Cut short: never read past what the panel sent
+                    break;
+                }
                 response.concat(checkHex(inByte)+" ");
                 if (i <= 3){
                     if((i == 2) || (i == 3)){
@@ -248,16 +269,29 @@ String DWIN::handle(){
                 }
                 lastByte = inByte;
             }
-        }
-    }
 
-    if (isFirstByte &&_echo){
-        Serial.println("Address : " + address + " | Data : " + String(lastByte, HEX) + " | Message : " + message + " | Response " +response );
-    }
-    if (isFirstByte){
-        listenerCallback(address, lastByte, message, response);
+            // One callback per frame: two touches in one read stay two events
+            if (isFirstByte && complete){
+                if (_echo){
+                    Serial.println("Address : " + address + " | Data : " + String(lastByte, HEX) + " | Message : " + message + " | Response " +response );
+                }
+                if (listenerCallback){
+                    listenerCallback(address, lastByte, message, response);
+                }
+            }
+            if (complete){
+                lastResponse = response;
+            }
+            response = "";
+            address = "";
+            message = "";
+            lastByte = 0;
+            isSubstr = false;
+            messageEnd = true;
+            isFirstByte = false;
+        }
     }
-    return response;
+    return lastResponse;
 }
 
 
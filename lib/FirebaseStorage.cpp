@@ -1,41 +1,90 @@
 #include "../include/FirebaseStorage.h"
 #include "../include/Config.h"
 
-FirebaseStorage::FirebaseStorage(const String& host, const String& auth, const String& devId)
-    : firebaseHost(host), firebaseAuth(auth), deviceId(devId),
-      wifiConnected(false), lastSyncTime(0), batchCount(0) {
+/**
+ * Print sink that only counts bytes (request and body length dry runs)
+ */
+class CountingPrint : public Print {
+public:
+    uint32_t count;
+    CountingPrint() : count(0) {}
+    size_t write(uint8_t) override { count++; return 1; }
+};
+
+/**
+ * Print filter that passes through bytes [start, end) of what is written to it
+ */
+class SegmentPrint : public Print {
+public:
+    SegmentPrint(Print& out, uint32_t start, uint32_t end) : out(out), position(0), start(start), end(end) {}
+    size_t write(uint8_t c) override {
+        if (position >= start && position < end) {
+            out.write(c);
+        }
+        position++;
+        return 1;
+    }
+
+private:
+    Print& out;
+    uint32_t position;
+    uint32_t start;
+    uint32_t end;
+};
+
+static const char CONTENT_LENGTH[] = "content-length:";
+static const uint8_t CONTENT_LENGTH_SIZE = sizeof(CONTENT_LENGTH) - 1;
+
+// The server refused the request itself: sending it again fails the same
+// way. Auth, timeout and rate-limit answers are worth a retry.
+static bool permanentFailure(int httpStatus) {
+    return httpStatus >= 400 && httpStatus < 500 && httpStatus != 401 && httpStatus != 403 &&
+           httpStatus != 408 && httpStatus != 429;
+}
+
+FirebaseStorage::FirebaseStorage(const String& host, const String& auth, const String& devId,
+                                 LocalStorage* overflow)
+    : at(ESP8266_SERIAL, *this), spill(overflow),
+      firebaseHost(host), firebaseAuth(auth), deviceId(devId),
+      linkState(LINK_OFF), wifiConnected(false), tcpConnected(false), lastSyncTime(0), lastSyncFailed(false), linkFailedAt(0),
+      batchHead(0), batchCount(0), syncingCount(0),
+      bodyLength(0), requestLength(0), sendOffset(0), segmentLength(0),
+      awaitingResponse(false), sentAt(0), responseState(RESP_DONE), httpStatus(0), lastHttpStatus(0),
+      responseRemaining(0), headerMatch(0), headerColumn(0) {
 }
 
 bool FirebaseStorage::initialize() {
     Serial.println(F("Initializing Firebase Storage..."));
 
-    // Initialize ESP8266 communication
+    // Initialize ESP8266 communication; bring-up continues in update()
     ESP8266_SERIAL.begin(ESP8266_BAUDRATE);
-    delay(1000);
+    startBringUp();
 
-    // Reset ESP8266
-    if (!sendATCommand("AT+RST", "ready", 10000)) {
-        handleError("ESP8266 reset failed");
-        return false;
-    }
+    isInitialized = true;
+    return true;
+}
 
-    // Set mode to Station + AP
-    if (!sendATCommand("AT+CWMODE=3", "OK", 5000)) {
-        handleError("Failed to set WiFi mode");
-        return false;
+void FirebaseStorage::update() {
+    at.update();
+
+    unsigned long currentTime = millis();
+
+    if (awaitingResponse && currentTime - sentAt >= AT_RESPONSE_TIMEOUT) {
+        failSync("No HTTP response", true);
     }
 
-    // Connect to WiFi
-    if (!connectWiFi(WIFI_SSID, WIFI_PASSWORD)) {
-        handleError("WiFi connection failed");
-        return false;
+    if (linkState == LINK_FAILED && currentTime - linkFailedAt >= AT_RETRY_INTERVAL) {
+        startBringUp();
     }
 
-    wifiConnected = true;
-    isInitialized = true;
+    refillFromSpill();
 
-    Serial.println(F("Firebase Storage initialized successfully"));
-    return true;
+    // A full batch goes out at once, unless the last attempt failed
+    bool batchDue = batchCount >= BATCH_SIZE && !lastSyncFailed;
+    if (linkState == LINK_READY && wifiConnected && batchCount > 0 &&
+        (batchDue || currentTime - lastSyncTime >= FIREBASE_SYNC_INTERVAL)) {
+        syncBatch();
+    }
 }
 
 bool FirebaseStorage::saveData(const SensorData& data) {
@@ -44,137 +93,447 @@ bool FirebaseStorage::saveData(const SensorData& data) {
         return false;
     }
 
-    // Add batch buffer
-    if (batchCount < BATCH_SIZE) {
-        batchBuffer[batchCount++] = data;
+    // Once anything has spilled, newer samples queue behind it to keep order
+    bool spilling = spill && spill->getRecordCount() > 0;
+
+    if (!spilling && batchCount < FIREBASE_RING_SIZE) {
+        staged(batchCount) = data;
+        batchCount++;
+        return true;
     }
 
-    unsigned long currentTime = millis();
-    if (currentTime - lastSyncTime >= FIREBASE_SYNC_INTERVAL || batchCount >= BATCH_SIZE) {
-        return syncBatch();
+    if (spill) {
+        return spill->saveData(data);
     }
 
-    return true;
+    handleError("Staging buffer full");
+    return false;
+}
+
+void FirebaseStorage::refillFromSpill() {
+    if (!spill || batchCount >= FIREBASE_RING_SIZE) {
+        return;
+    }
+
+    int available = spill->getRecordCount();
+    if (available <= 0) {
+        return;
+    }
+
+    int moved = 0;
+    while (moved < available && batchCount < FIREBASE_RING_SIZE) {
+        if (!spill->retrieveData(staged(batchCount), moved)) {
+            break;
+        }
+        batchCount++;
+        moved++;
+    }
+
+    // One header rewrite for the whole refill
+    spill->removeOldest(moved);
+}
+
+void FirebaseStorage::startBringUp(bool reset) {
+    at.clearQueue();
+    linkState = LINK_STARTING;
+    wifiConnected = false;
+    tcpConnected = false;
+    awaitingResponse = false;
+
+    // Reset, then single link + station/AP mode, then join (written by onAtWrite)
+    if (reset) {
+        at.send("AT+RST", TAG_RESET, AT_RESET_TIMEOUT, AT_FLAG_WAIT_READY);
+    }
+    at.send("ATE0", TAG_ECHO_OFF, AT_COMMAND_TIMEOUT);
+    at.send("AT+CWMODE=3", TAG_MODE, AT_COMMAND_TIMEOUT);
+    at.send("AT+CIPMUX=0", TAG_SINGLE_LINK, AT_COMMAND_TIMEOUT);
+#if AT_FIREBASE_TLS
+    at.send("AT+CIPSSLSIZE=4096", TAG_SSL_SIZE, AT_COMMAND_TIMEOUT);
+#endif
+    at.send(NULL, TAG_JOIN, AT_JOIN_TIMEOUT);
 }
 
 bool FirebaseStorage::syncBatch() {
     if (batchCount == 0) {
-        return true;
+        return false;
     }
 
-    if (!checkConnection()) {
+    if (linkState != LINK_READY || !wifiConnected) {
         handleError("No WiFi connection");
         return false;
     }
 
     Serial.println(F("Syncing batch to Firebase..."));
 
-    // Create JSON array of batch data
-    DynamicJsonDocument doc(2048);
-    JsonArray array = doc.to<JsonArray>();
+    // Nothing is buffered: lengths come from a dry run of the same writers
+    syncingCount = batchCount < BATCH_SIZE ? batchCount : BATCH_SIZE;
+    CountingPrint body;
+    writeBody(body);
+    bodyLength = body.count;
+
+    CountingPrint request;
+    writeRequest(request);
+    requestLength = request.count;
+    sendOffset = 0;
+
+    responseState = RESP_VERSION;
+    httpStatus = 0;
+    linkState = LINK_SYNCING;
 
-    for (int i = 0; i < batchCount; i++) {
-        JsonObject obj = array.createNestedObject();
-        obj["timestamp"] = batchBuffer[i].timestamp;
-        obj["temperature"] = batchBuffer[i].temperature;
-        obj["weight"] = batchBuffer[i].weight;
-        obj["status"] = batchBuffer[i].status;
-        obj["deviceId"] = deviceId;
+    // Reuse the open connection; CIPSEND follows CIPSTART otherwise
+    if (tcpConnected) {
+        sendNextSegment();
+    } else {
+        at.send(NULL, TAG_CONNECT, AT_CONNECT_TIMEOUT);
     }
+    return true;
+}
 
-    String jsonData;
-    serializeJson(doc, jsonData);
+void FirebaseStorage::sendNextSegment() {
+    uint32_t left = requestLength - sendOffset;
+    segmentLength = left > AT_SEND_SEGMENT ? AT_SEND_SEGMENT : left;
+    at.sendData(segmentLength, TAG_SEND, AT_SEND_TIMEOUT);
+}
 
-    // Send to Firebase
-    String path = "/sensors/" + deviceId + "/data";
+void FirebaseStorage::failSync(const char* reason, bool closeLink) {
+    handleError(reason);
 
-    if (sendToFirebase(path, jsonData)) {
+    awaitingResponse = false;
+    responseState = RESP_DONE;
+    syncingCount = 0;
+    linkState = LINK_READY;
+    lastSyncTime = millis();  // Next attempt after the sync interval
+    lastSyncFailed = true;
+
+    if (closeLink) {
+        tcpConnected = false;
+        at.send("AT+CIPCLOSE", TAG_CLOSE, AT_COMMAND_TIMEOUT);
+    }
+}
+
+void FirebaseStorage::finishResponse() {
+    awaitingResponse = false;
+    responseState = RESP_DONE;
+    lastHttpStatus = httpStatus;
+
+    if (httpStatus < 200 || httpStatus >= 300) {
+        String reason = "HTTP status ";
+        reason += httpStatus;
+        if (!permanentFailure(httpStatus)) {
+            failSync(reason.c_str(), httpStatus == 0);
+            return;
+        }
+
+        // Retrying would be refused forever and hold back every later sample
+        reason += ", batch dropped";
+        handleError(reason);
+    } else {
         Serial.print(F("Synced "));
-        Serial.print(batchCount);
+        Serial.print(syncingCount);
         Serial.println(F(" records to Firebase"));
+    }
 
-        batchCount = 0;
-        lastSyncTime = millis();
-        return true;
-    } else {
-        handleError("Failed to sync to Firebase");
-        return false;
+    // Release the delivered (or refused) batch; later samples stay staged
+    batchHead = (batchHead + syncingCount) % FIREBASE_RING_SIZE;
+    batchCount -= syncingCount;
+    syncingCount = 0;
+
+    linkState = LINK_READY;
+    lastSyncTime = millis();
+    lastSyncFailed = false;
+}
+
+void FirebaseStorage::writeRequest(Print& out) {
+    out.print(F("POST /sensors/"));
+    out.print(deviceId);
+    out.print(F("/data.json"));
+    if (firebaseAuth.length() > 0) {
+        out.print(F("?auth="));
+        out.print(firebaseAuth);
     }
+    out.print(F(" HTTP/1.1\r\nHost: "));
+    out.print(firebaseHost);
+    out.print(F("\r\nConnection: keep-alive\r\nContent-Type: application/json\r\nContent-Length: "));
+    out.print(bodyLength);
+    out.print(F("\r\n\r\n"));
+    writeBody(out);
 }
 
-bool FirebaseStorage::sendATCommand(const String& command, const String& expectedResponse, unsigned long timeout) {
-    ESP8266_SERIAL.println(command);
+void FirebaseStorage::writeBody(Print& out) {
+    // JSON array of batch data, one object per sample
+    out.print('[');
+    for (int i = 0; i < syncingCount; i++) {
+        const SensorData& data = staged(i);
+        if (i > 0) {
+            out.print(',');
+        }
+        out.print(F("{\"timestamp\":"));
+        out.print(data.timestamp);
+        out.print(F(",\"temperature\":"));
+        out.print(data.getTemperature(), 2);
+        out.print(F(",\"weight\":"));
+        out.print(data.getWeight(), 2);
+        out.print(F(",\"status\":"));
+        out.print(data.status);
+        // Uptime stamps restart every boot: the epoch tells them apart
+        out.print(F(",\"time_synced\":"));
+        if (data.flags & DATA_FLAG_UNSYNCED_TIME) {
+            out.print(F("false,\"boot_epoch\":"));
+            out.print(data.bootEpoch);
+        } else {
+            out.print(F("true"));
+        }
+        out.print(F(",\"deviceId\":\""));
+        out.print(deviceId);
+        out.print(F("\"}"));
+    }
+    out.print(']');
+}
+
+void FirebaseStorage::parseResponse(char c) {
+    switch (responseState) {
+    case RESP_VERSION:
+        if (c == ' ') {
+            responseState = RESP_CODE;
+        }
+        break;
+
+    case RESP_CODE:
+        if (c >= '0' && c <= '9') {
+            httpStatus = httpStatus * 10 + (c - '0');
+        } else {
+            responseState = c == '\n' ? RESP_HEADERS : RESP_REASON;
+            headerMatch = 0;
+            headerColumn = 0;
+            responseRemaining = 0;
+        }
+        break;
 
-    unsigned long startTime = millis();
-    String response = "";
+    case RESP_REASON:
+        if (c == '\n') {
+            responseState = RESP_HEADERS;
+        }
+        break;
 
-    while (millis() - startTime < timeout) {
-        if (ESP8266_SERIAL.available()) {
-            char c = ESP8266_SERIAL.read();
-            response += c;
+    case RESP_HEADERS:
+        if (c == '\r') {
+            break;
+        }
+        if (c == '\n') {
+            if (headerColumn == 0) {
+                // Blank line: headers done. Without a length there is no body to wait for
+                if (responseRemaining == 0) {
+                    finishResponse();
+                } else {
+                    responseState = RESP_BODY;
+                }
+                break;
+            }
+            headerMatch = 0;
+            headerColumn = 0;
+            break;
+        }
 
-            if (response.indexOf(expectedResponse) != -1) {
-                return true;
+        // Only "Content-Length" matters: match it case-insensitively as it streams by
+        if (headerMatch == CONTENT_LENGTH_SIZE) {
+            if (c >= '0' && c <= '9') {
+                responseRemaining = responseRemaining * 10 + (c - '0');
             }
+        } else if (headerMatch == headerColumn && (c | 0x20) == CONTENT_LENGTH[headerMatch]) {
+            headerMatch++;
         }
-    }
+        if (headerColumn < 0xFF) {
+            headerColumn++;
+        }
+        break;
 
-    Serial.print(F("AT Command failed: "));
-    Serial.println(command);
-    Serial.print(F("Response: "));
-    Serial.println(response);
+    case RESP_BODY:
+        if (--responseRemaining == 0) {
+            finishResponse();
+        }
+        break;
 
-    return false;
+    case RESP_DONE:
+        break;
+    }
 }
 
-bool FirebaseStorage::connectWiFi(const String& ssid, const String& password) {
-    String cmd = "AT+CWJAP=\"" + ssid + "\",\"" + password + "\"";
-    return sendATCommand(cmd, "WIFI CONNECTED", 20000);
-}
+void FirebaseStorage::onAtResult(uint8_t tag, AtResult result) {
+    if (result != AT_RESULT_OK) {
+        switch (tag) {
+        case TAG_RESET:
+            handleError("ESP8266 reset failed");
+            break;
+        case TAG_ECHO_OFF:
+        case TAG_MODE:
+        case TAG_SINGLE_LINK:
+            handleError("Failed to set WiFi mode");
+            break;
+        case TAG_JOIN:
+            handleError("WiFi connection failed");
+            break;
+        case TAG_CONNECT:
+            // "ALREADY CONNECTED" comes back as ERROR but the link is usable
+            if (tcpConnected) {
+                sendNextSegment();
+            } else {
+                failSync("Failed to connect to Firebase", false);
+            }
+            return;
+        case TAG_SEND:
+            failSync("Failed to sync to Firebase", true);
+            return;
+        default:
+            return;  // SSL size is not supported everywhere; CIPCLOSE may find nothing open
+        }
 
-bool FirebaseStorage::sendToFirebase(const String& path, const String& jsonData) {
-    // Establish TCP connection
-    String cmd = "AT+CIPSTART=\"TCP\",\"" + firebaseHost + "\",80";
-    if (!sendATCommand(cmd, "CONNECT", 10000)) {
-        return false;
+        // Bring-up failed: drop the rest of the sequence and retry later
+        at.clearQueue();
+        linkState = LINK_FAILED;
+        linkFailedAt = millis();
+        return;
+    }
+
+    switch (tag) {
+    case TAG_JOIN:
+        wifiConnected = true;
+        linkState = LINK_READY;
+        Serial.println(F("Firebase Storage initialized successfully"));
+        break;
+
+    case TAG_CONNECT:
+        tcpConnected = true;
+        sendNextSegment();
+        break;
+
+    case TAG_SEND:
+        sendOffset += segmentLength;
+        if (sendOffset < requestLength) {
+            sendNextSegment();
+        } else if (responseState != RESP_DONE) {
+            // Delivery is decided by the HTTP status, not by SEND OK
+            awaitingResponse = true;
+            sentAt = millis();
+        }
+        break;
+
+    default:
+        break;
     }
+}
 
-    // Prepare HTTP request
-    String httpRequest = "PUT " + path + "?auth=" + firebaseAuth + " HTTP/1.1\r\n";
-    httpRequest += "Host: " + firebaseHost + "\r\n";
-    httpRequest += "Content-Type: application/json\r\n";
-    httpRequest += "Content-Length: " + String(jsonData.length()) + "\r\n\r\n";
-    httpRequest += jsonData;
+void FirebaseStorage::onAtWrite(uint8_t tag, Print& out) {
+    switch (tag) {
+    case TAG_JOIN:
+        out.print(F("AT+CWJAP=\""));
+        out.print(F(WIFI_SSID));
+        out.print(F("\",\""));
+        out.print(F(WIFI_PASSWORD));
+        out.print('"');
+        break;
+
+    case TAG_CONNECT:
+#if AT_FIREBASE_TLS
+        out.print(F("AT+CIPSTART=\"SSL\",\""));
+        out.print(firebaseHost);
+        out.print(F("\",443,"));
+#else
+        out.print(F("AT+CIPSTART=\"TCP\",\""));
+        out.print(firebaseHost);
+        out.print(F("\",80,"));
+#endif
+        out.print(AT_KEEPALIVE_SECONDS);
+        break;
+
+    case TAG_SEND: {
+        // Regenerate the request and let only this segment through
+        SegmentPrint segment(out, sendOffset, sendOffset + segmentLength);
+        writeRequest(segment);
+        break;
+    }
 
-    // Send data
-    cmd = "AT+CIPSEND=" + String(httpRequest.length());
-    if (!sendATCommand(cmd, ">", 5000)) {
-        return false;
+    default:
+        break;
     }
+}
 
-    ESP8266_SERIAL.print(httpRequest);
+void FirebaseStorage::onAtUrc(AtUrc urc) {
+    switch (urc) {
+    case AT_URC_WIFI_GOT_IP:
+        wifiConnected = true;
+        break;
+
+    case AT_URC_WIFI_DISCONNECT:
+        wifiConnected = false;
+        tcpConnected = false;
+        break;
+
+    case AT_URC_CONNECT:
+        tcpConnected = true;
+        break;
+
+    case AT_URC_CLOSED:
+        tcpConnected = false;
+        if (awaitingResponse) {
+            // "Connection: close" responses may end without a length
+            if (httpStatus > 0 && responseState != RESP_BODY) {
+                finishResponse();
+            } else {
+                failSync("Connection closed before response", false);
+            }
+        }
+        break;
+
+    case AT_URC_READY:
+        // Unexpected module reboot: everything it knew is gone
+        if (linkState != LINK_STARTING) {
+            handleError("ESP8266 reset unexpectedly");
+            startBringUp(false);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
 
-    // Wait for response
-    return sendATCommand("", "SEND OK", 10000);
+void FirebaseStorage::onAtLine(uint8_t tag, const char* line) {
+    if (tag == TAG_CONNECT && strcmp(line, "ALREADY CONNECTED") == 0) {
+        tcpConnected = true;
+    }
 }
 
-bool FirebaseStorage::checkConnection() {
-    return sendATCommand("AT+CWJAP?", "+CWJAP:", 5000);
+void FirebaseStorage::onAtData(char c, uint16_t) {
+    if (linkState == LINK_SYNCING) {
+        parseResponse(c);
+    }
 }
 
 bool FirebaseStorage::retrieveData(SensorData& data, int index) {
-    // Firebase is write-only in this implementation
-    // For reading, you would need to implement HTTP GET
-    handleError("Read operation not implemented for Firebase");
-    return false;
+    if (index < 0 || index >= getRecordCount()) {
+        handleError("Invalid index");
+        return false;
+    }
+
+    if (index < batchCount) {
+        data = staged(index);
+        return true;
+    }
+
+    return spill->retrieveData(data, index - batchCount);
 }
 
 int FirebaseStorage::getRecordCount() {
-    // Return batch buffer count
-    return batchCount;
+    int spilled = spill ? spill->getRecordCount() : 0;
+    return batchCount + spilled;
 }
 
 bool FirebaseStorage::clearStorage() {
-    batchCount = 0;
+    if (spill) {
+        spill->clearStorage();
+    }
+
+    // Samples already in the request leave with it
+    batchCount = syncingCount;
     return true;
-}
\ No newline at end of file
+}
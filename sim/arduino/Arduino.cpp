@@ -0,0 +1,127 @@
+/**
+ * @file Arduino.cpp
+ * @brief Host-native Arduino core: time, pins, random
+ */
+
+#include "Arduino.h"
+
+uint8_t SimPins::_level[SimPins::COUNT];
+uint8_t SimPins::_mode[SimPins::COUNT];
+int SimPins::_analog[SimPins::COUNT];
+
+unsigned long millis()
+{
+    SimClock::poll();
+    return (unsigned long)(SimClock::nowMicros() / 1000);
+}
+
+unsigned long micros()
+{
+    SimClock::poll();
+    return (unsigned long)SimClock::nowMicros();
+}
+
+void delay(unsigned long ms)
+{
+    SimClock::activity();
+    SimClock::advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    SimClock::advance(us);
+}
+
+void yield()
+{
+    SimClock::runTasks();
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < SimPins::COUNT)
+    {
+        SimPins::_mode[pin] = mode;
+        if (mode == INPUT_PULLUP)
+        {
+            SimPins::_level[pin] = HIGH;
+        }
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    SimPins::setLevel(pin, value ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return SimPins::level(pin);
+}
+
+int analogRead(uint8_t pin)
+{
+    return SimPins::analog(pin);
+}
+
+void analogWrite(uint8_t pin, int value)
+{
+    SimPins::setAnalog(pin, value);
+}
+
+void SimPins::setLevel(uint8_t pin, uint8_t value)
+{
+    if (pin < COUNT)
+    {
+        _level[pin] = value;
+    }
+}
+
+void SimPins::setAnalog(uint8_t pin, int value)
+{
+    if (pin < COUNT)
+    {
+        _analog[pin] = value;
+    }
+}
+
+// Deterministic per seed, independent of the host libc
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom()
+{
+    // xorshift32
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+long random(long howbig)
+{
+    return howbig > 0 ? (long)(nextRandom() % (uint32_t)howbig) : 0;
+}
+
+long random(long howsmall, long howbig)
+{
+    return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+    if (seed != 0)
+    {
+        randomState = (uint32_t)seed;
+    }
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *out)
+{
+    sprintf(out, "%*.*f", width, precision, value);
+    return out;
+}
@@ -0,0 +1,136 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+/**
+ * @file Arduino.h
+ * @brief Host-native Arduino core (env:native_mega, env:native_esp)
+ *
+ * Just enough of the AVR / ESP8266 cores for main.cpp, esp8266_main.cpp
+ * and the shared modules to compile and run unmodified on Linux:
+ * - millis()/micros()/delay() run on the virtual clock (SimClock.h)
+ * - String, Print, Stream and HardwareSerial behave like the cores
+ * - Pins are plain state: digitalRead() returns what was last written
+ *   (or set by a fake device through SimPins)
+ *
+ * unsigned long is 64-bit here, so millis() never wraps; code that needs
+ * the 32-bit wrap (MonotonicClock) truncates explicitly and still sees it.
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SimClock.h"
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#ifdef ESP8266
+#define LED_BUILTIN 2
+#else
+#define LED_BUILTIN 13
+#endif
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define A0 54
+
+// Templates instead of the AVR macros: no double evaluation, mixed types allowed
+template <typename T, typename U>
+auto min(const T &a, const U &b) -> decltype(a < b ? a : b)
+{
+    return b < a ? b : a;
+}
+
+template <typename T, typename U>
+auto max(const T &a, const U &b) -> decltype(a < b ? a : b)
+{
+    return a < b ? b : a;
+}
+
+template <typename T, typename L, typename H>
+T constrain(T amt, L low, H high)
+{
+    return amt < low ? low : (amt > high ? high : amt);
+}
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// avr-libc <stdlib.h> / ESP8266 stdlib_noniso.h
+char *dtostrf(double value, signed char width, unsigned char precision, char *out);
+
+/**
+ * @class SimPins
+ * @brief Pin state shared by the firmware and the fake devices
+ */
+class SimPins
+{
+public:
+    static const uint8_t COUNT = 70;
+
+    static uint8_t level(uint8_t pin) { return pin < COUNT ? _level[pin] : 0; }
+    static uint8_t mode(uint8_t pin) { return pin < COUNT ? _mode[pin] : 0; }
+    static void setLevel(uint8_t pin, uint8_t value);
+    static void setAnalog(uint8_t pin, int value);
+    static int analog(uint8_t pin) { return pin < COUNT ? _analog[pin] : 0; }
+
+private:
+    static uint8_t _level[COUNT];
+    static uint8_t _mode[COUNT];
+    static int _analog[COUNT];
+
+    friend void pinMode(uint8_t, uint8_t);
+};
+
+#ifdef ESP8266
+#include "Esp.h"
+#endif
+
+void setup();
+void loop();
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file EEPROM.cpp
+ * @brief EEPROM model for the host build
+ */
+
+#include "EEPROM.h"
+#include "SimClock.h"
+#include <stdio.h>
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass()
+#ifdef ESP8266
+    : _size(0),
+#else
+    : _size(CAPACITY),
+#endif
+      _writes(0),
+      _commits(0),
+      _outOfRange(0)
+{
+    memset(_data, 0xFF, sizeof(_data));
+    memset(_cellWrites, 0, sizeof(_cellWrites));
+}
+
+uint8_t EEPROMClass::read(int address) const
+{
+    if (address < 0 || address >= _size)
+    {
+        _outOfRange++;
+        return 0;
+    }
+    return _data[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+    if (address < 0 || address >= _size)
+    {
+        _outOfRange++;
+        return;
+    }
+
+    _data[address] = value;
+    _cellWrites[address]++;
+    _writes++;
+
+    if (SIM_EEPROM_WRITE_US > 0)
+    {
+        SimClock::advance(SIM_EEPROM_WRITE_US);
+    }
+}
+
+void EEPROMClass::update(int address, uint8_t value)
+{
+    if (read(address) != value)
+    {
+        write(address, value);
+    }
+}
+
+void EEPROMClass::begin(size_t size)
+{
+    _size = size > CAPACITY ? CAPACITY : (uint16_t)size;
+}
+
+bool EEPROMClass::commit()
+{
+    if (_size == 0)
+    {
+        return false;
+    }
+    _commits++;
+    SimClock::advance(SIM_EEPROM_COMMIT_US);
+    return true;
+}
+
+bool EEPROMClass::end()
+{
+    bool ok = commit();
+#ifdef ESP8266
+    _size = 0;
+#endif
+    return ok;
+}
+
+bool EEPROMClass::load(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+    size_t read = fread(_data, 1, sizeof(_data), file);
+    fclose(file);
+    return read == sizeof(_data);
+}
+
+bool EEPROMClass::save(const char *path) const
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+    size_t written = fwrite(_data, 1, sizeof(_data), file);
+    fclose(file);
+    return written == sizeof(_data);
+}
+
+void EEPROMClass::load(const uint8_t *data, size_t length)
+{
+    memset(_data, 0xFF, sizeof(_data));
+    memcpy(_data, data, length < sizeof(_data) ? length : sizeof(_data));
+}
+
+void EEPROMClass::erase()
+{
+    memset(_data, 0xFF, sizeof(_data));
+    memset(_cellWrites, 0, sizeof(_cellWrites));
+    _writes = 0;
+    _commits = 0;
+    _outOfRange = 0;
+}
+
+uint32_t EEPROMClass::maxCellWrites() const
+{
+    uint32_t worst = 0;
+    for (uint16_t i = 0; i < CAPACITY; i++)
+    {
+        if (_cellWrites[i] > worst)
+        {
+            worst = _cellWrites[i];
+        }
+    }
+    return worst;
+}
@@ -0,0 +1,114 @@
+#ifndef EEPROM_H
+#define EEPROM_H
+
+/**
+ * @file EEPROM.h
+ * @brief EEPROM model for the host build
+ *
+ * AVR flavour (env:native_mega): 4 KB, every write() programs the cell and
+ * costs SIM_EEPROM_WRITE_US of virtual time (3.3 ms on the ATmega2560).
+ * ESP8266 flavour (env:native_esp): begin(size) maps a RAM shadow; commit()
+ * writes it back (one flash sector erase + program).
+ *
+ * Erased cells read 0xFF. Per-cell write counts are kept so wear from a
+ * long simulated run can be inspected; load()/save() keep the contents
+ * across runs, like the real part keeps them across resets. Accesses past
+ * the end are ignored and counted (the AVR would wrap around, the ESP8266
+ * shadow would be overrun).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef SIM_EEPROM_WRITE_US
+#ifdef ESP8266
+#define SIM_EEPROM_WRITE_US 0
+#else
+#define SIM_EEPROM_WRITE_US 3300
+#endif
+#endif
+
+#ifndef SIM_EEPROM_COMMIT_US
+#define SIM_EEPROM_COMMIT_US 30000 // ESP8266: sector erase + program
+#endif
+
+class EEPROMClass
+{
+public:
+    static const uint16_t CAPACITY = 4096;
+
+    EEPROMClass();
+
+    uint8_t read(int address) const;
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value);
+    uint16_t length() const { return _size; }
+
+    template <typename T>
+    T &get(int address, T &value) const
+    {
+        uint8_t *p = (uint8_t *)&value;
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            p[i] = read(address + i);
+        }
+        return value;
+    }
+
+    template <typename T>
+    const T &put(int address, const T &value)
+    {
+        const uint8_t *p = (const uint8_t *)&value;
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            update(address + i, p[i]);
+        }
+        return value;
+    }
+
+    // ESP8266 API (harmless on the AVR build)
+    void begin(size_t size);
+    bool commit();
+    bool end();
+
+    // ---- Simulation side ----
+
+    /**
+     * @brief Load / save the whole image (e.g. to survive a simulated reset)
+     * @return false if the file cannot be read / written
+     */
+    bool load(const char *path);
+    bool save(const char *path) const;
+
+    /**
+     * @brief Replace the contents with an image (the rest reads erased)
+     */
+    void load(const uint8_t *data, size_t length);
+
+    /**
+     * @brief Erase to 0xFF and reset the counters
+     */
+    void erase();
+
+    unsigned long writeCount() const { return _writes; }
+    unsigned long commitCount() const { return _commits; }
+    uint32_t maxCellWrites() const;
+
+    /**
+     * @brief read()/write() calls outside the part (ignored, read 0)
+     */
+    unsigned long outOfRange() const { return _outOfRange; }
+
+private:
+    uint8_t _data[CAPACITY];
+    uint32_t _cellWrites[CAPACITY];
+    uint16_t _size;
+    unsigned long _writes;
+    unsigned long _commits;
+    mutable unsigned long _outOfRange;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,311 @@
+/**
+ * @file HardwareSerial.cpp
+ * @brief UART model for the host build
+ */
+
+#include "Arduino.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#ifdef ESP8266
+static const size_t DEFAULT_RX_BUFFER = 256;
+#else
+static const size_t DEFAULT_RX_BUFFER = 64;
+#endif
+
+static const unsigned long DEFAULT_BAUD = 115200;
+
+// Built before any other global: firmware globals such as DWIN hmi(Serial1)
+// call begin() from their constructors, in whatever order the objects link
+#define SERIAL_FIRST __attribute__((init_priority(101)))
+
+HardwareSerial Serial SERIAL_FIRST("Serial", DEFAULT_RX_BUFFER);
+HardwareSerial Serial1 SERIAL_FIRST("Serial1", DEFAULT_RX_BUFFER);
+#ifndef ESP8266
+HardwareSerial Serial2 SERIAL_FIRST("Serial2", DEFAULT_RX_BUFFER);
+HardwareSerial Serial3 SERIAL_FIRST("Serial3", DEFAULT_RX_BUFFER);
+#endif
+
+HardwareSerial::HardwareSerial(const char *name, size_t rxBufferSize)
+    : _name(name),
+      _baud(DEFAULT_BAUD),
+      _rx((uint8_t *)malloc(rxBufferSize)),
+      _rxSize(rxBufferSize),
+      _rxHead(0),
+      _rxCount(0),
+      _wire(NULL),
+      _wireSize(0),
+      _wireHead(0),
+      _wireCount(0),
+      _nextArrivalUs(0),
+      _device(NULL),
+      _echo(NULL),
+      _echoStamp(false),
+      _echoLineStart(true),
+      _overruns(0),
+      _rxTotal(0),
+      _txTotal(0),
+      _fd(-1)
+{
+}
+
+HardwareSerial::~HardwareSerial()
+{
+    free(_rx);
+    free(_wire);
+    if (_fd >= 0)
+    {
+        close(_fd);
+    }
+}
+
+void HardwareSerial::begin(unsigned long baud, uint8_t config)
+{
+    (void)config;
+    _baud = baud > 0 ? baud : DEFAULT_BAUD;
+}
+
+void HardwareSerial::end()
+{
+    _rxHead = 0;
+    _rxCount = 0;
+}
+
+size_t HardwareSerial::setRxBufferSize(size_t size)
+{
+    uint8_t *buffer = (uint8_t *)malloc(size);
+    if (!buffer)
+    {
+        return 0;
+    }
+
+    // Keep what is buffered (the ESP core drops it; it is empty at boot anyway)
+    size_t kept = 0;
+    while (_rxCount > 0 && kept < size)
+    {
+        buffer[kept++] = _rx[_rxHead];
+        _rxHead = (_rxHead + 1) % _rxSize;
+        _rxCount--;
+    }
+
+    free(_rx);
+    _rx = buffer;
+    _rxSize = size;
+    _rxHead = 0;
+    _rxCount = kept;
+    return size;
+}
+
+uint32_t HardwareSerial::byteTimeMicros() const
+{
+    // Start + 8 data + stop bits
+    return (uint32_t)((10000000ULL + _baud - 1) / _baud);
+}
+
+void HardwareSerial::inject(const uint8_t *data, size_t length, uint64_t sentAtUs)
+{
+    if (_wireCount + length > _wireSize)
+    {
+        size_t grown = _wireSize ? _wireSize : 256;
+        while (grown < _wireCount + length)
+        {
+            grown *= 2;
+        }
+
+        uint8_t *wire = (uint8_t *)malloc(grown);
+        for (size_t i = 0; i < _wireCount; i++)
+        {
+            wire[i] = _wire[(_wireHead + i) % _wireSize];
+        }
+        free(_wire);
+        _wire = wire;
+        _wireSize = grown;
+        _wireHead = 0;
+    }
+
+    // An idle line starts clocking out when the sender started
+    if (_wireCount == 0 && _nextArrivalUs < sentAtUs + byteTimeMicros())
+    {
+        _nextArrivalUs = sentAtUs + byteTimeMicros();
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        _wire[(_wireHead + _wireCount) % _wireSize] = data[i];
+        _wireCount++;
+    }
+}
+
+// Non-blocking fd, but a write waits for room like a full TX FIFO would
+static void writeAll(int fd, const uint8_t *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t n = ::write(fd, data, length);
+        if (n > 0)
+        {
+            data += n;
+            length -= (size_t)n;
+        }
+        else if (n < 0 && errno == EAGAIN)
+        {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            poll(&pfd, 1, 100);
+        }
+        else
+        {
+            return; // Other end gone
+        }
+    }
+}
+
+bool HardwareSerial::bind(const char *path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    // Raw 8-bit line: no echo, no CR/LF translation
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    _fd = fd;
+    SimClock::addTask(this);
+    return true;
+}
+
+void HardwareSerial::pump()
+{
+    if (_fd < 0)
+    {
+        return;
+    }
+
+    uint8_t buffer[256];
+    for (;;)
+    {
+        ssize_t n = ::read(_fd, buffer, sizeof(buffer));
+        if (n <= 0)
+        {
+            break;
+        }
+        inject(buffer, (size_t)n);
+    }
+}
+
+void HardwareSerial::run(uint64_t nowUs)
+{
+    (void)nowUs;
+    pump();
+}
+
+void HardwareSerial::deliver()
+{
+    pump();
+
+    uint64_t now = SimClock::nowMicros();
+    uint32_t byteTime = byteTimeMicros();
+
+    while (_wireCount > 0 && _nextArrivalUs <= now)
+    {
+        uint8_t c = _wire[_wireHead];
+        _wireHead = (_wireHead + 1) % _wireSize;
+        _wireCount--;
+        _nextArrivalUs += byteTime;
+
+        if (_rxCount < _rxSize)
+        {
+            _rx[(_rxHead + _rxCount) % _rxSize] = c;
+            _rxCount++;
+            _rxTotal++;
+        }
+        else
+        {
+            _overruns++;
+        }
+    }
+}
+
+int HardwareSerial::available()
+{
+    deliver();
+    return (int)_rxCount;
+}
+
+int HardwareSerial::peek()
+{
+    deliver();
+    return _rxCount > 0 ? _rx[_rxHead] : -1;
+}
+
+int HardwareSerial::read()
+{
+    deliver();
+    if (_rxCount == 0)
+    {
+        return -1;
+    }
+
+    uint8_t c = _rx[_rxHead];
+    _rxHead = (_rxHead + 1) % _rxSize;
+    _rxCount--;
+    SimClock::activity();
+    return c;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    if (_fd >= 0)
+    {
+        writeAll(_fd, &c, 1);
+    }
+    _txTotal++;
+    echo(c);
+    if (_device)
+    {
+        _device->receive(c);
+    }
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    if (_fd >= 0)
+    {
+        writeAll(_fd, buffer, size);
+    }
+    _txTotal += size;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        echo(buffer[i]);
+        if (_device)
+        {
+            _device->receive(buffer[i]);
+        }
+    }
+    return size;
+}
+
+void HardwareSerial::echo(uint8_t c)
+{
+    if (!_echo)
+    {
+        return;
+    }
+    if (_echoStamp && _echoLineStart)
+    {
+        fprintf(_echo, "%.3f ", SimClock::nowMicros() / 1e6);
+    }
+    fputc(c, _echo);
+    _echoLineStart = c == '\n';
+}
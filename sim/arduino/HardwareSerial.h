@@ -0,0 +1,158 @@
+#ifndef HARDWARE_SERIAL_H
+#define HARDWARE_SERIAL_H
+
+/**
+ * @file HardwareSerial.h
+ * @brief UART model for the host build
+ *
+ * RX side: bytes handed to inject() travel "on the wire" at the configured
+ * baud rate (10 bits per byte) and land in an RX buffer of the board's
+ * size (64 bytes on AVR, 256 on the ESP8266 unless setRxBufferSize() is
+ * called). A byte that arrives while the buffer is full is lost and
+ * counted, exactly the overrun the firmware would suffer on the board.
+ *
+ * TX side: every byte written goes to the attached SerialDevice (fake DWIN
+ * panel, the other board, ...) and optionally to stdout.
+ *
+ * A port can also be bound to a tty (one end of a PTY pair) to talk to a
+ * board running in another process. Bytes read from it are injected when
+ * they show up, so the baud timing and overruns above still apply; the
+ * tty is polled from every read and from the clock's background tasks.
+ */
+
+#include <stdio.h>
+#include "Stream.h"
+#include "SimClock.h"
+
+#define SERIAL_8N1 0x06
+
+/**
+ * @class SerialDevice
+ * @brief Whatever is wired to a port's TX line
+ */
+class SerialDevice
+{
+public:
+    virtual ~SerialDevice() {}
+    virtual void receive(uint8_t c) = 0;
+};
+
+class HardwareSerial : public Stream, private SimTask
+{
+public:
+    /**
+     * @param name Port name used in diagnostics ("Serial3")
+     * @param rxBufferSize Default RX buffer of the board
+     */
+    HardwareSerial(const char *name, size_t rxBufferSize);
+    ~HardwareSerial();
+
+    void begin(unsigned long baud) { begin(baud, SERIAL_8N1); }
+    void begin(unsigned long baud, uint8_t config);
+    void end();
+    size_t setRxBufferSize(size_t size);
+    unsigned long baudRate() const { return _baud; }
+
+    int available() override;
+    int peek() override;
+    int read() override;
+    int availableForWrite() override { return 64; }
+    void flush() override {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    operator bool() const { return true; }
+
+    // ---- Simulation side ----
+
+    /**
+     * @brief Put bytes on the RX wire (delivered at the baud rate)
+     *
+     * sentAtUs is when the other side started sending; a time in the past
+     * (a task catching up after a blocking call) lands the bytes as they
+     * would have arrived meanwhile, overruns included.
+     */
+    void inject(const uint8_t *data, size_t length, uint64_t sentAtUs);
+    void inject(const uint8_t *data, size_t length) { inject(data, length, SimClock::nowMicros()); }
+    void inject(const char *text) { inject((const uint8_t *)text, strlen(text)); }
+
+    /**
+     * @brief Connect a device to the TX line (NULL to disconnect)
+     */
+    void attach(SerialDevice *device) { _device = device; }
+
+    /**
+     * @brief Copy TX bytes to a host stream (e.g. stdout), NULL to stop
+     * @param stamp Start every line with the virtual time in seconds
+     */
+    void echoTo(FILE *out, bool stamp = false)
+    {
+        _echo = out;
+        _echoStamp = stamp;
+    }
+
+    /**
+     * @brief Connect the line to a tty (e.g. a PTY slave); both directions
+     * @return false if the tty cannot be opened
+     */
+    bool bind(const char *path);
+
+    /**
+     * @brief Bytes lost because the RX buffer was full
+     */
+    unsigned long rxOverruns() const { return _overruns; }
+
+    unsigned long rxBytes() const { return _rxTotal; }
+    unsigned long txBytes() const { return _txTotal; }
+    const char *name() const { return _name; }
+
+    /**
+     * @brief Bytes still travelling on the RX wire
+     */
+    size_t wirePending() const { return _wireCount; }
+
+    /**
+     * @brief Virtual time one byte occupies the wire at the current baud rate
+     */
+    uint32_t byteTimeMicros() const;
+
+private:
+    const char *_name;
+    unsigned long _baud;
+
+    uint8_t *_rx;             // RX ring (what the firmware can read)
+    size_t _rxSize;
+    size_t _rxHead;
+    size_t _rxCount;
+
+    uint8_t *_wire;           // Bytes sent to us but not arrived yet
+    size_t _wireSize;
+    size_t _wireHead;
+    size_t _wireCount;
+    uint64_t _nextArrivalUs;  // Virtual time the next wire byte lands
+
+    SerialDevice *_device;
+    FILE *_echo;
+    bool _echoStamp;
+    bool _echoLineStart;
+    unsigned long _overruns;
+    unsigned long _rxTotal;
+    unsigned long _txTotal;
+
+    int _fd;                  // Bound tty, -1 if none
+
+    void deliver();
+    void pump();
+    void echo(uint8_t c);
+    void run(uint64_t nowUs) override;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+#ifndef ESP8266
+extern HardwareSerial Serial2;
+extern HardwareSerial Serial3;
+#endif
+
+#endif
@@ -0,0 +1,271 @@
+/**
+ * @file Print.cpp
+ * @brief Arduino Print for the host build
+ */
+
+#include "Print.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+    {
+        if (write(*buffer++))
+        {
+            n++;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return n;
+}
+
+size_t Print::print(const __FlashStringHelper *str)
+{
+    return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const String &str)
+{
+    return write(str.c_str(), str.length());
+}
+
+size_t Print::print(const char str[])
+{
+    return write(str);
+}
+
+size_t Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base)
+{
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base)
+{
+    return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base)
+{
+    return print((long long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    return print((unsigned long long)value, base);
+}
+
+size_t Print::print(long long value, int base)
+{
+    if (base == 0)
+    {
+        return write((uint8_t)value);
+    }
+    if (base == 10 && value < 0)
+    {
+        size_t t = print('-');
+        return printNumber(0ULL - (unsigned long long)value, 10) + t;
+    }
+    return printNumber((unsigned long long)value, base);
+}
+
+size_t Print::print(unsigned long long value, int base)
+{
+    if (base == 0)
+    {
+        return write((uint8_t)value);
+    }
+    return printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits)
+{
+    return printFloat(value, digits);
+}
+
+size_t Print::print(const Printable &value)
+{
+    return value.printTo(*this);
+}
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper *str)
+{
+    size_t n = print(str);
+    return n + println();
+}
+
+size_t Print::println(const String &str)
+{
+    size_t n = print(str);
+    return n + println();
+}
+
+size_t Print::println(const char str[])
+{
+    size_t n = print(str);
+    return n + println();
+}
+
+size_t Print::println(char c)
+{
+    size_t n = print(c);
+    return n + println();
+}
+
+size_t Print::println(unsigned char value, int base)
+{
+    size_t n = print(value, base);
+    return n + println();
+}
+
+size_t Print::println(int value, int base)
+{
+    size_t n = print(value, base);
+    return n + println();
+}
+
+size_t Print::println(unsigned int value, int base)
+{
+    size_t n = print(value, base);
+    return n + println();
+}
+
+size_t Print::println(long value, int base)
+{
+    size_t n = print(value, base);
+    return n + println();
+}
+
+size_t Print::println(unsigned long value, int base)
+{
+    size_t n = print(value, base);
+    return n + println();
+}
+
+size_t Print::println(long long value, int base)
+{
+    size_t n = print(value, base);
+    return n + println();
+}
+
+size_t Print::println(unsigned long long value, int base)
+{
+    size_t n = print(value, base);
+    return n + println();
+}
+
+size_t Print::println(double value, int digits)
+{
+    size_t n = print(value, digits);
+    return n + println();
+}
+
+size_t Print::println(const Printable &value)
+{
+    size_t n = print(value);
+    return n + println();
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+
+    if (len < 0)
+    {
+        return 0;
+    }
+    return write((const uint8_t *)buf, (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1);
+}
+
+size_t Print::printNumber(unsigned long long value, uint8_t base)
+{
+    char buf[8 * sizeof(long long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+
+    if (base < 2)
+    {
+        base = 10;
+    }
+
+    do
+    {
+        char c = value % base;
+        value /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (value);
+
+    return write(str);
+}
+
+// Same algorithm as the AVR core (so rounding and "ovf" match the board)
+size_t Print::printFloat(double number, uint8_t digits)
+{
+    size_t n = 0;
+
+    if (isnan(number))
+        return print("nan");
+    if (isinf(number))
+        return print("inf");
+    if (number > 4294967040.0)
+        return print("ovf");
+    if (number < -4294967040.0)
+        return print("ovf");
+
+    if (number < 0.0)
+    {
+        n += print('-');
+        number = -number;
+    }
+
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; ++i)
+    {
+        rounding /= 10.0;
+    }
+    number += rounding;
+
+    unsigned long int_part = (unsigned long)number;
+    double remainder = number - (double)int_part;
+    n += print(int_part);
+
+    if (digits > 0)
+    {
+        n += print('.');
+    }
+
+    while (digits-- > 0)
+    {
+        remainder *= 10.0;
+        unsigned int toPrint = (unsigned int)remainder;
+        n += print(toPrint);
+        remainder -= toPrint;
+    }
+
+    return n;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file SimClock.cpp
+ * @brief Virtual time base implementation
+ */
+
+#include "SimClock.h"
+#include <time.h>
+
+uint64_t SimClock::_nowUs = 0;
+uint64_t SimClock::_epochUnixMs = 1767225600000ULL; // 2026-01-01 00:00:00 UTC
+uint32_t SimClock::_pollUs = 10;
+uint32_t SimClock::_pollBaseUs = 10;
+uint32_t SimClock::_pollMaxUs = 10000;
+SimTask *SimClock::_tasks[SimClock::MAX_TASKS];
+uint8_t SimClock::_taskCount = 0;
+bool SimClock::_inTasks = false;
+bool SimClock::_realtime = false;
+double SimClock::_scale = 1.0;
+uint64_t SimClock::_startNs = 0;
+
+// Longest real sleep between two runs of the background tasks
+static const uint64_t REALTIME_SLICE_NS = 1000000;
+
+// Idle poll step (virtual) from which a real-time busy-wait starts sleeping
+static const uint32_t REALTIME_IDLE_POLL_US = 1000;
+
+void SimClock::advance(uint64_t us)
+{
+    if (_realtime)
+    {
+        // Sleep in slices so serial pumps and WiFi events keep running
+        uint64_t target = realtimeMicros() + us;
+        for (uint64_t now = realtimeMicros(); now < target; now = realtimeMicros())
+        {
+            sleepVirtual(target - now);
+            runTasks();
+        }
+        return;
+    }
+
+    _nowUs += us;
+    runTasks();
+}
+
+void SimClock::poll()
+{
+    if (_realtime)
+    {
+        if (_pollUs >= REALTIME_IDLE_POLL_US)
+        {
+            sleepVirtual(_pollUs);
+        }
+    }
+    else
+    {
+        _nowUs += _pollUs;
+    }
+
+    if (_pollUs < _pollMaxUs)
+    {
+        _pollUs = _pollUs * 2 < _pollMaxUs ? _pollUs * 2 : _pollMaxUs;
+    }
+}
+
+void SimClock::setPollStep(uint32_t baseUs, uint32_t maxUs)
+{
+    _pollBaseUs = baseUs > 0 ? baseUs : 1;
+    _pollMaxUs = maxUs > _pollBaseUs ? maxUs : _pollBaseUs;
+    _pollUs = _pollBaseUs;
+}
+
+void SimClock::addTask(SimTask *task)
+{
+    if (_taskCount < MAX_TASKS)
+    {
+        _tasks[_taskCount++] = task;
+    }
+}
+
+void SimClock::runTasks()
+{
+    // A task that delays (e.g. a blocking fake request) must not re-enter
+    if (_inTasks)
+    {
+        return;
+    }
+
+    _inTasks = true;
+    for (uint8_t i = 0; i < _taskCount; i++)
+    {
+        _tasks[i]->run(nowMicros());
+    }
+    _inTasks = false;
+}
+
+void SimClock::setRealtime(double scale, uint64_t startNs)
+{
+    _scale = scale > 0 ? scale : 1.0;
+    _startNs = startNs;
+    _realtime = true;
+}
+
+uint64_t SimClock::hostNanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t SimClock::realtimeMicros()
+{
+    uint64_t host = hostNanos();
+    return host > _startNs ? (uint64_t)((host - _startNs) * _scale / 1000.0) : 0;
+}
+
+void SimClock::sleepVirtual(uint64_t us)
+{
+    uint64_t ns = (uint64_t)(us * 1000.0 / _scale);
+    if (ns > REALTIME_SLICE_NS)
+    {
+        ns = REALTIME_SLICE_NS;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = 0;
+    ts.tv_nsec = (long)ns;
+    nanosleep(&ts, NULL);
+}
@@ -0,0 +1,119 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+/**
+ * @file SimClock.h
+ * @brief Virtual time base behind millis()/micros()/delay() on the host
+ *
+ * Nothing on the host waits for real time. delay() jumps the clock forward
+ * and every millis()/micros() call costs a small poll step, so the
+ * firmware's busy-wait loops (DWIN reads, Stream timeouts, NTP replies)
+ * still terminate. Consecutive polls without any I/O double the step up
+ * to a cap, which lets a 100 ms idle wait finish in ~20 iterations; the
+ * first byte read resets it, so timing around real traffic stays fine.
+ *
+ * Background tasks (WiFi events, device models) run from delay() and
+ * yield(), the same places the ESP8266 SDK services its own stack.
+ *
+ * In real-time mode (co-simulation of both boards as separate processes)
+ * virtual time is the host's monotonic clock times a scale factor, counted
+ * from a start instant both processes share. delay() then sleeps, and an
+ * idle busy-wait sleeps in small slices instead of spinning.
+ */
+
+#include <stdint.h>
+
+/**
+ * @class SimTask
+ * @brief Something that advances with virtual time (run from delay()/yield())
+ */
+class SimTask
+{
+public:
+    virtual ~SimTask() {}
+    virtual void run(uint64_t nowUs) = 0;
+};
+
+class SimClock
+{
+public:
+    /**
+     * @brief Virtual microseconds since boot
+     */
+    static uint64_t nowMicros() { return _realtime ? realtimeMicros() : _nowUs; }
+
+    /**
+     * @brief Move the clock forward and run background tasks
+     */
+    static void advance(uint64_t us);
+
+    /**
+     * @brief Cost of one millis()/micros() call (grows while nothing happens)
+     */
+    static void poll();
+
+    /**
+     * @brief I/O happened: fall back to the base poll step
+     */
+    static void activity() { _pollUs = _pollBaseUs; }
+
+    /**
+     * @brief Configure the poll step
+     * @param baseUs Step after any activity
+     * @param maxUs Cap for the doubling while idle
+     */
+    static void setPollStep(uint32_t baseUs, uint32_t maxUs);
+
+    /**
+     * @brief Wall-clock Unix time (ms) the simulated world is at right now
+     */
+    static uint64_t unixMillis() { return _epochUnixMs + _nowUs / 1000; }
+
+    /**
+     * @brief Unix time (ms) at virtual time zero
+     */
+    static void setEpoch(uint64_t unixMs) { _epochUnixMs = unixMs; }
+
+    /**
+     * @brief Follow the host clock instead of jumping
+     * @param scale Virtual seconds per real second
+     * @param startNs CLOCK_MONOTONIC instant that is virtual time zero
+     */
+    static void setRealtime(double scale, uint64_t startNs);
+    static bool realtime() { return _realtime; }
+
+    /**
+     * @brief Host CLOCK_MONOTONIC in nanoseconds (to agree on a start instant)
+     */
+    static uint64_t hostNanos();
+
+    /**
+     * @brief Register a background task (not owned, must outlive the run)
+     */
+    static void addTask(SimTask *task);
+
+    /**
+     * @brief Run every background task once at the current time
+     */
+    static void runTasks();
+
+private:
+    static const uint8_t MAX_TASKS = 8;
+
+    static uint64_t _nowUs;
+    static uint64_t _epochUnixMs;
+    static uint32_t _pollUs;
+    static uint32_t _pollBaseUs;
+    static uint32_t _pollMaxUs;
+    static SimTask *_tasks[MAX_TASKS];
+    static uint8_t _taskCount;
+    static bool _inTasks;
+    static bool _realtime;
+    static double _scale;
+    static uint64_t _startNs;
+
+    static uint64_t realtimeMicros();
+    static void sleepVirtual(uint64_t us);
+};
+
+#endif
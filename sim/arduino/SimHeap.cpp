@@ -0,0 +1,232 @@
+/**
+ * @file SimHeap.cpp
+ * @brief ESP8266 heap model for the host build
+ */
+
+#include "SimHeap.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+
+unsigned long SimHeap::_allocations = 0;
+unsigned long SimHeap::_failures = 0;
+uint32_t SimHeap::_usedBlocks = 0;
+
+alignas(8) static uint8_t arena[SimHeap::ARENA];
+static uint16_t runLength[SimHeap::ARENA / SimHeap::BLOCK]; // Blocks of the allocation starting here
+
+// Free runs by first block; adjacent runs are always merged
+static std::map<uint32_t, uint32_t> &freeRuns()
+{
+    static std::map<uint32_t, uint32_t> runs;
+    static bool initialized = false;
+    if (!initialized)
+    {
+        runs[0] = SimHeap::ARENA / SimHeap::BLOCK;
+        initialized = true;
+    }
+    return runs;
+}
+
+static void releaseRun(uint32_t start, uint32_t length)
+{
+    std::map<uint32_t, uint32_t> &runs = freeRuns();
+
+    std::map<uint32_t, uint32_t>::iterator next = runs.find(start + length);
+    if (next != runs.end())
+    {
+        length += next->second;
+        runs.erase(next);
+    }
+
+    std::map<uint32_t, uint32_t>::iterator after = runs.lower_bound(start);
+    if (after != runs.begin())
+    {
+        std::map<uint32_t, uint32_t>::iterator previous = after;
+        --previous;
+        if (previous->first + previous->second == start)
+        {
+            previous->second += length;
+            return;
+        }
+    }
+    runs[start] = length;
+}
+
+bool SimHeap::enabled()
+{
+#if defined(ESP8266) && !defined(SIM_FUZZ)
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t SimHeap::blocksFor(size_t size)
+{
+    return (uint32_t)((size + HEADER + BLOCK - 1) / BLOCK);
+}
+
+bool SimHeap::owns(const void *ptr)
+{
+    return ptr >= (const void *)arena && ptr < (const void *)(arena + ARENA);
+}
+
+void *SimHeap::alloc(size_t size)
+{
+    if (!enabled())
+    {
+        return ::malloc(size);
+    }
+
+    uint32_t blocks = blocksFor(size);
+    std::map<uint32_t, uint32_t> &runs = freeRuns();
+
+    // Best fit, lowest address on a tie
+    std::map<uint32_t, uint32_t>::iterator best = runs.end();
+    for (std::map<uint32_t, uint32_t>::iterator it = runs.begin(); it != runs.end(); ++it)
+    {
+        if (it->second >= blocks && (best == runs.end() || it->second < best->second))
+        {
+            best = it;
+            if (it->second == blocks)
+            {
+                break;
+            }
+        }
+    }
+    if (best == runs.end())
+    {
+        _failures++;
+        return NULL;
+    }
+
+    // Split off the front, the rest stays free
+    uint32_t start = best->first;
+    uint32_t remaining = best->second - blocks;
+    runs.erase(best);
+    if (remaining)
+    {
+        runs[start + blocks] = remaining;
+    }
+
+    runLength[start] = (uint16_t)blocks;
+    _usedBlocks += blocks;
+    _allocations++;
+    return arena + start * BLOCK + HEADER;
+}
+
+void SimHeap::free(void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+    if (!owns(ptr))
+    {
+        ::free(ptr);
+        return;
+    }
+
+    uint32_t start = (uint32_t)(((uint8_t *)ptr - arena - HEADER) / BLOCK);
+    uint32_t blocks = runLength[start];
+    runLength[start] = 0;
+    _usedBlocks -= blocks;
+    releaseRun(start, blocks);
+}
+
+void *SimHeap::realloc(void *ptr, size_t size)
+{
+    if (!ptr)
+    {
+        return alloc(size);
+    }
+    if (!owns(ptr))
+    {
+        return ::realloc(ptr, size);
+    }
+    if (size == 0)
+    {
+        free(ptr);
+        return NULL;
+    }
+
+    uint32_t start = (uint32_t)(((uint8_t *)ptr - arena - HEADER) / BLOCK);
+    uint32_t current = runLength[start];
+    uint32_t blocks = blocksFor(size);
+
+    if (blocks <= current)
+    {
+        if (blocks < current)
+        {
+            runLength[start] = (uint16_t)blocks;
+            _usedBlocks -= current - blocks;
+            releaseRun(start + blocks, current - blocks);
+        }
+        return ptr;
+    }
+
+    // Grow in place into a free run right behind the block
+    std::map<uint32_t, uint32_t> &runs = freeRuns();
+    std::map<uint32_t, uint32_t>::iterator next = runs.find(start + current);
+    if (next != runs.end() && current + next->second >= blocks)
+    {
+        uint32_t taken = blocks - current;
+        uint32_t remaining = next->second - taken;
+        runs.erase(next);
+        if (remaining)
+        {
+            runs[start + blocks] = remaining;
+        }
+        runLength[start] = (uint16_t)blocks;
+        _usedBlocks += taken;
+        return ptr;
+    }
+
+    void *moved = alloc(size);
+    if (!moved)
+    {
+        return NULL; // The old block stays valid, as with realloc()
+    }
+    memcpy(moved, ptr, current * BLOCK - HEADER);
+    free(ptr);
+    return moved;
+}
+
+uint32_t SimHeap::freeBytes()
+{
+    return (BLOCKS - _usedBlocks) * BLOCK;
+}
+
+uint32_t SimHeap::maxFreeBlock()
+{
+    uint32_t largest = 0;
+    std::map<uint32_t, uint32_t> &runs = freeRuns();
+    for (std::map<uint32_t, uint32_t>::const_iterator it = runs.begin(); it != runs.end(); ++it)
+    {
+        if (it->second > largest)
+        {
+            largest = it->second;
+        }
+    }
+    return largest * BLOCK;
+}
+
+uint8_t SimHeap::fragmentation()
+{
+    double sumSquares = 0;
+    std::map<uint32_t, uint32_t> &runs = freeRuns();
+    for (std::map<uint32_t, uint32_t>::const_iterator it = runs.begin(); it != runs.end(); ++it)
+    {
+        double bytes = (double)it->second * BLOCK;
+        sumSquares += bytes * bytes;
+    }
+
+    uint32_t free = freeBytes();
+    if (free == 0)
+    {
+        return 0;
+    }
+    return (uint8_t)(100 - (uint32_t)(sqrt(sumSquares) * 100 / free));
+}
@@ -0,0 +1,72 @@
+#ifndef SIM_HEAP_H
+#define SIM_HEAP_H
+
+/**
+ * @file SimHeap.h
+ * @brief ESP8266 heap model for the host build
+ *
+ * A fixed arena managed the way the ESP8266 core's umm_malloc manages the
+ * real one: 8-byte blocks, a 4-byte header in the first block of every
+ * allocation, best fit, free neighbours merged, realloc() grown in place
+ * when the next block is free. String buffers and the Firebase shim's
+ * document nodes live here in the ESP build, so ESP.getFreeHeap(),
+ * getMaxFreeBlockSize() and getHeapFragmentation() show what the
+ * firmware's allocation pattern does to a ~40 KB heap over days of
+ * virtual time instead of what glibc does with it.
+ *
+ * Allocations fail (NULL) when no free run is large enough, as on the
+ * device. Without ESP8266 (the MEGA and bench builds) every call goes
+ * straight to malloc()/realloc()/free(), and so does the fuzz build
+ * (SIM_FUZZ), where AddressSanitizer has to see every buffer.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+class SimHeap
+{
+public:
+    static const size_t BLOCK = 8;         // umm_block
+    static const size_t HEADER = 4;        // next/prev block indexes
+    static const size_t ARENA = 40 * 1024; // Free heap of a connected unit
+
+    static void *alloc(size_t size);
+    static void *realloc(void *ptr, size_t size);
+    static void free(void *ptr);
+
+    /**
+     * @brief True when allocations go to the arena (ESP build)
+     */
+    static bool enabled();
+
+    /**
+     * @brief Free bytes (umm_free_heap_size)
+     */
+    static uint32_t freeBytes();
+
+    /**
+     * @brief Largest free run in bytes (umm_max_block_size)
+     */
+    static uint32_t maxFreeBlock();
+
+    /**
+     * @brief 100 - sqrt(sum of free run sizes squared) * 100 / free, as ESP.getHeapFragmentation()
+     */
+    static uint8_t fragmentation();
+
+    static unsigned long allocations() { return _allocations; }
+    static unsigned long failures() { return _failures; }
+    static uint32_t liveBlocks() { return _usedBlocks; }
+
+private:
+    static const uint32_t BLOCKS = ARENA / BLOCK;
+
+    static unsigned long _allocations;
+    static unsigned long _failures;
+    static uint32_t _usedBlocks;
+
+    static uint32_t blocksFor(size_t size);
+    static bool owns(const void *ptr);
+};
+
+#endif
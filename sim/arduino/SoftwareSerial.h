@@ -0,0 +1,30 @@
+#ifndef SOFTWARE_SERIAL_H
+#define SOFTWARE_SERIAL_H
+
+/**
+ * @file SoftwareSerial.h
+ * @brief SoftwareSerial for the host build (a HardwareSerial without pins)
+ *
+ * DWIN.h includes it on every non-ESP32 board; only the Uno branch of
+ * main.cpp actually uses one.
+ */
+
+#include "Arduino.h"
+
+class SoftwareSerial : public HardwareSerial
+{
+public:
+    SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverseLogic = false)
+        : HardwareSerial("SoftwareSerial", 64)
+    {
+        (void)receivePin;
+        (void)transmitPin;
+        (void)inverseLogic;
+    }
+
+    bool listen() { return true; }
+    bool isListening() { return true; }
+    bool overflow() { return rxOverruns() > 0; }
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+/**
+ * @file Stream.h
+ * @brief Arduino Stream for the host build
+ *
+ * The timed reads wait on the virtual clock exactly like the cores do, so
+ * readStringUntil() on a half-received line still blocks for the stream
+ * timeout (1 s by default) in simulated time.
+ */
+
+#include "Print.h"
+
+class Stream : public Print
+{
+public:
+    Stream() : _timeout(1000), _startMillis(0) {}
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    unsigned long getTimeout() const { return _timeout; }
+
+    bool find(const char *target);
+    bool find(char target) { return find(&target, 1); }
+    bool find(const char *target, size_t length);
+    bool findUntil(const char *target, const char *terminator);
+
+    long parseInt();
+    float parseFloat();
+
+    virtual size_t readBytes(char *buffer, size_t length);
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+    size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    size_t readBytesUntil(char terminator, uint8_t *buffer, size_t length)
+    {
+        return readBytesUntil(terminator, (char *)buffer, length);
+    }
+
+    String readString();
+    String readStringUntil(char terminator);
+
+protected:
+    unsigned long _timeout;
+    unsigned long _startMillis;
+
+    int timedRead();
+    int timedPeek();
+    int peekNextDigit(bool detectDecimal);
+};
+
+#endif
@@ -0,0 +1,722 @@
+/**
+ * @file WString.cpp
+ * @brief Arduino String for the host build
+ */
+
+#include "WString.h"
+#include "SimHeap.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Same digits as the cores' utoa/ultoa (no sign outside base 10)
+static void formatUnsigned(unsigned long long value, unsigned char base, char *buf)
+{
+    if (base < 2 || base > 36)
+    {
+        base = 10;
+    }
+
+    char tmp[66];
+    int n = 0;
+    do
+    {
+        unsigned digit = value % base;
+        tmp[n++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value > 0);
+
+    for (int i = 0; i < n; i++)
+    {
+        buf[i] = tmp[n - 1 - i];
+    }
+    buf[n] = '\0';
+}
+
+static void formatSigned(long long value, unsigned char base, char *buf)
+{
+    if (base == 10 && value < 0)
+    {
+        buf[0] = '-';
+        formatUnsigned(0ULL - (unsigned long long)value, base, buf + 1);
+    }
+    else
+    {
+        formatUnsigned((unsigned long long)value, base, buf);
+    }
+}
+
+void String::init()
+{
+    _buffer = NULL;
+    _capacity = 0;
+    _len = 0;
+}
+
+void String::invalidate()
+{
+    SimHeap::free(_buffer);
+    init();
+}
+
+bool String::changeBuffer(unsigned int maxStrLen)
+{
+    char *grown = (char *)SimHeap::realloc(_buffer, maxStrLen + 1);
+    if (!grown)
+    {
+        return false;
+    }
+    _buffer = grown;
+    _capacity = maxStrLen;
+    return true;
+}
+
+bool String::reserve(unsigned int size)
+{
+    if (_buffer && _capacity >= size)
+    {
+        return true;
+    }
+    if (changeBuffer(size))
+    {
+        if (_len == 0)
+        {
+            _buffer[0] = '\0';
+        }
+        return true;
+    }
+    return false;
+}
+
+String &String::copy(const char *cstr, unsigned int length)
+{
+    if (!reserve(length))
+    {
+        invalidate();
+        return *this;
+    }
+    _len = length;
+    memmove(_buffer, cstr, length);
+    _buffer[length] = '\0';
+    return *this;
+}
+
+void String::move(String &rhs)
+{
+    SimHeap::free(_buffer);
+    _buffer = rhs._buffer;
+    _capacity = rhs._capacity;
+    _len = rhs._len;
+    rhs.init();
+}
+
+String::String(const char *cstr)
+{
+    init();
+    if (cstr)
+    {
+        copy(cstr, strlen(cstr));
+    }
+}
+
+String::String(const char *cstr, unsigned int length)
+{
+    init();
+    if (cstr)
+    {
+        copy(cstr, length);
+    }
+}
+
+String::String(const String &str)
+{
+    init();
+    *this = str;
+}
+
+String::String(String &&rval)
+{
+    init();
+    move(rval);
+}
+
+String::String(const __FlashStringHelper *str)
+{
+    init();
+    *this = str;
+}
+
+String::String(char c)
+{
+    init();
+    char buf[2] = {c, '\0'};
+    *this = buf;
+}
+
+String::String(unsigned char value, unsigned char base)
+{
+    init();
+    char buf[9];
+    formatUnsigned(value, base, buf);
+    *this = buf;
+}
+
+String::String(int value, unsigned char base)
+{
+    init();
+    char buf[34];
+    formatSigned(value, base, buf);
+    *this = buf;
+}
+
+String::String(unsigned int value, unsigned char base)
+{
+    init();
+    char buf[33];
+    formatUnsigned(value, base, buf);
+    *this = buf;
+}
+
+String::String(long value, unsigned char base)
+{
+    init();
+    char buf[66];
+    formatSigned(value, base, buf);
+    *this = buf;
+}
+
+String::String(unsigned long value, unsigned char base)
+{
+    init();
+    char buf[66];
+    formatUnsigned(value, base, buf);
+    *this = buf;
+}
+
+String::String(long long value, unsigned char base)
+{
+    init();
+    char buf[66];
+    formatSigned(value, base, buf);
+    *this = buf;
+}
+
+String::String(unsigned long long value, unsigned char base)
+{
+    init();
+    char buf[66];
+    formatUnsigned(value, base, buf);
+    *this = buf;
+}
+
+String::String(float value, unsigned char decimalPlaces)
+    : String((double)value, decimalPlaces)
+{
+}
+
+String::String(double value, unsigned char decimalPlaces)
+{
+    init();
+    // dtostrf() on both cores
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+    *this = buf;
+}
+
+String::~String()
+{
+    SimHeap::free(_buffer);
+}
+
+void String::clear()
+{
+    _len = 0;
+    if (_buffer)
+    {
+        _buffer[0] = '\0';
+    }
+}
+
+String &String::operator=(const String &rhs)
+{
+    if (this == &rhs)
+    {
+        return *this;
+    }
+    if (rhs._buffer)
+    {
+        copy(rhs._buffer, rhs._len);
+    }
+    else
+    {
+        invalidate();
+    }
+    return *this;
+}
+
+String &String::operator=(String &&rval)
+{
+    if (this != &rval)
+    {
+        move(rval);
+    }
+    return *this;
+}
+
+String &String::operator=(const char *cstr)
+{
+    if (cstr)
+    {
+        copy(cstr, strlen(cstr));
+    }
+    else
+    {
+        invalidate();
+    }
+    return *this;
+}
+
+String &String::operator=(const __FlashStringHelper *str)
+{
+    return *this = reinterpret_cast<const char *>(str);
+}
+
+bool String::concat(const char *cstr, unsigned int length)
+{
+    if (!cstr)
+    {
+        return false;
+    }
+    if (length == 0)
+    {
+        return true;
+    }
+
+    // Appending a slice of ourselves: the realloc below may move it
+    if (_buffer && cstr >= _buffer && cstr < _buffer + _len)
+    {
+        String self(cstr, length);
+        return concat(self.c_str(), length);
+    }
+
+    unsigned int newLen = _len + length;
+    if (!reserve(newLen))
+    {
+        return false;
+    }
+    memcpy(_buffer + _len, cstr, length);
+    _len = newLen;
+    _buffer[_len] = '\0';
+    return true;
+}
+
+bool String::concat(const String &str)
+{
+    return concat(str.c_str(), str._len);
+}
+
+bool String::concat(const char *cstr)
+{
+    return cstr ? concat(cstr, strlen(cstr)) : false;
+}
+
+bool String::concat(const __FlashStringHelper *str)
+{
+    return concat(reinterpret_cast<const char *>(str));
+}
+
+bool String::concat(char c)
+{
+    return concat(&c, 1);
+}
+
+bool String::concat(unsigned char num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(int num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(unsigned int num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(long num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(unsigned long num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(long long num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(unsigned long long num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(float num)
+{
+    return concat(String(num));
+}
+
+bool String::concat(double num)
+{
+    return concat(String(num));
+}
+
+int String::compareTo(const String &s) const
+{
+    return strcmp(c_str(), s.c_str());
+}
+
+bool String::equals(const String &s) const
+{
+    return _len == s._len && compareTo(s) == 0;
+}
+
+bool String::equals(const char *cstr) const
+{
+    return strcmp(c_str(), cstr ? cstr : "") == 0;
+}
+
+bool String::equalsIgnoreCase(const String &s) const
+{
+    if (_len != s._len)
+    {
+        return false;
+    }
+    for (unsigned int i = 0; i < _len; i++)
+    {
+        if (tolower((unsigned char)_buffer[i]) != tolower((unsigned char)s._buffer[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool String::startsWith(const String &prefix) const
+{
+    return _len >= prefix._len && startsWith(prefix, 0);
+}
+
+bool String::startsWith(const String &prefix, unsigned int offset) const
+{
+    if (offset > _len || prefix._len > _len - offset)
+    {
+        return false;
+    }
+    return strncmp(c_str() + offset, prefix.c_str(), prefix._len) == 0;
+}
+
+bool String::endsWith(const String &suffix) const
+{
+    if (_len < suffix._len)
+    {
+        return false;
+    }
+    return strcmp(c_str() + _len - suffix._len, suffix.c_str()) == 0;
+}
+
+char String::charAt(unsigned int index) const
+{
+    return operator[](index);
+}
+
+void String::setCharAt(unsigned int index, char c)
+{
+    if (index < _len)
+    {
+        _buffer[index] = c;
+    }
+}
+
+char String::operator[](unsigned int index) const
+{
+    return index < _len ? _buffer[index] : 0;
+}
+
+char &String::operator[](unsigned int index)
+{
+    static char dummy;
+    if (index >= _len || !_buffer)
+    {
+        dummy = 0;
+        return dummy;
+    }
+    return _buffer[index];
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const
+{
+    if (!bufsize || !buf)
+    {
+        return;
+    }
+    if (index >= _len)
+    {
+        buf[0] = 0;
+        return;
+    }
+    unsigned int n = bufsize - 1;
+    if (n > _len - index)
+    {
+        n = _len - index;
+    }
+    memcpy(buf, _buffer + index, n);
+    buf[n] = 0;
+}
+
+int String::indexOf(char ch) const
+{
+    return indexOf(ch, 0);
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const
+{
+    if (fromIndex >= _len)
+    {
+        return -1;
+    }
+    const char *found = (const char *)memchr(_buffer + fromIndex, ch, _len - fromIndex);
+    return found ? (int)(found - _buffer) : -1;
+}
+
+int String::indexOf(const String &str) const
+{
+    return indexOf(str, 0);
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const
+{
+    if (fromIndex >= _len)
+    {
+        return -1;
+    }
+    const char *found = strstr(_buffer + fromIndex, str.c_str());
+    return found ? (int)(found - _buffer) : -1;
+}
+
+int String::lastIndexOf(char ch) const
+{
+    return _len ? lastIndexOf(ch, _len - 1) : -1;
+}
+
+int String::lastIndexOf(char ch, unsigned int fromIndex) const
+{
+    if (fromIndex >= _len)
+    {
+        return -1;
+    }
+    for (int i = fromIndex; i >= 0; i--)
+    {
+        if (_buffer[i] == ch)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int String::lastIndexOf(const String &str) const
+{
+    return _len >= str._len ? lastIndexOf(str, _len - str._len) : -1;
+}
+
+int String::lastIndexOf(const String &str, unsigned int fromIndex) const
+{
+    if (str._len == 0 || _len == 0 || str._len > _len)
+    {
+        return -1;
+    }
+    if (fromIndex >= _len)
+    {
+        fromIndex = _len - 1;
+    }
+    int found = -1;
+    for (const char *p = _buffer; p <= _buffer + fromIndex; p++)
+    {
+        p = strstr(p, str.c_str());
+        if (!p)
+        {
+            break;
+        }
+        if ((unsigned int)(p - _buffer) <= fromIndex)
+        {
+            found = p - _buffer;
+        }
+    }
+    return found;
+}
+
+String String::substring(unsigned int left, unsigned int right) const
+{
+    if (left > right)
+    {
+        unsigned int temp = right;
+        right = left;
+        left = temp;
+    }
+    if (left >= _len)
+    {
+        return String();
+    }
+    if (right > _len)
+    {
+        right = _len;
+    }
+    return String(_buffer + left, right - left);
+}
+
+void String::replace(char find, char replace)
+{
+    for (unsigned int i = 0; i < _len; i++)
+    {
+        if (_buffer[i] == find)
+        {
+            _buffer[i] = replace;
+        }
+    }
+}
+
+void String::replace(const String &find, const String &replace)
+{
+    if (_len == 0 || find._len == 0)
+    {
+        return;
+    }
+
+    String result;
+    unsigned int pos = 0;
+    int found;
+    while ((found = indexOf(find, pos)) >= 0)
+    {
+        result.concat(_buffer + pos, found - pos);
+        result.concat(replace);
+        pos = found + find._len;
+    }
+    result.concat(_buffer + pos, _len - pos);
+    *this = result;
+}
+
+void String::remove(unsigned int index)
+{
+    remove(index, (unsigned int)-1);
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+    if (index >= _len || count == 0)
+    {
+        return;
+    }
+    if (count > _len - index)
+    {
+        count = _len - index;
+    }
+    memmove(_buffer + index, _buffer + index + count, _len - index - count);
+    _len -= count;
+    _buffer[_len] = '\0';
+}
+
+void String::toLowerCase()
+{
+    for (unsigned int i = 0; i < _len; i++)
+    {
+        _buffer[i] = tolower((unsigned char)_buffer[i]);
+    }
+}
+
+void String::toUpperCase()
+{
+    for (unsigned int i = 0; i < _len; i++)
+    {
+        _buffer[i] = toupper((unsigned char)_buffer[i]);
+    }
+}
+
+void String::trim()
+{
+    if (_len == 0)
+    {
+        return;
+    }
+    unsigned int begin = 0;
+    while (begin < _len && isspace((unsigned char)_buffer[begin]))
+    {
+        begin++;
+    }
+    unsigned int end = _len;
+    while (end > begin && isspace((unsigned char)_buffer[end - 1]))
+    {
+        end--;
+    }
+    _len = end - begin;
+    if (begin > 0)
+    {
+        memmove(_buffer, _buffer + begin, _len);
+    }
+    _buffer[_len] = '\0';
+}
+
+long String::toInt() const
+{
+    return _buffer ? atol(_buffer) : 0;
+}
+
+float String::toFloat() const
+{
+    return (float)toDouble();
+}
+
+double String::toDouble() const
+{
+    return _buffer ? atof(_buffer) : 0;
+}
+
+String operator+(const String &lhs, const String &rhs)
+{
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(const String &lhs, const char *rhs)
+{
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(const char *lhs, const String &rhs)
+{
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(const String &lhs, char rhs)
+{
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(const String &lhs, const __FlashStringHelper *rhs)
+{
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file avr_bench.cpp
+ * @brief ATmega2560 firmware that runs selected MEGA code paths for simavr
+ *
+ * Built by env:simavr_bench and run by simavr_runner. The firmware's own
+ * main.cpp is compiled in with setup()/loop() renamed, so every path below
+ * is the real code (soft-float, 8-bit arithmetic, the libraries' SPI and
+ * serial waits), not a copy of it.
+ *
+ * Each path runs a few times. Every run is bracketed by a write of the
+ * path id to GPIOR1 (begin) and GPIOR2 (end); the runner watches those
+ * two registers, so the markers cost one OUT instruction each. The id to
+ * name mapping is printed on Serial as "BENCH:<id>:<name>" before the
+ * path starts, and "BENCH:DONE" ends the run.
+ */
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Adafruit_MAX31865.h>
+#include <avr/sleep.h>
+#include "HX711.h"
+#include "DWIN.h"
+#include "LocalStorage.h"
+#include "SensorData.h"
+#include "SystemConfig.h"
+#include "TimeSync.h"
+#include "MonotonicClock.h"
+
+// The firmware, with its entry points renamed so this file can drive them
+#define setup firmwareSetup
+#define loop firmwareLoop
+#include "../../src/main.cpp"
+#undef setup
+#undef loop
+
+#define BENCH_BEGIN(id) (GPIOR1 = (id))
+#define BENCH_END(id) (GPIOR2 = (id))
+
+LocalStorage benchStorage;
+volatile uint16_t benchSink = 0;
+
+// Current readings as a record (what the ESP, or FirebaseStorage, stores)
+static SensorData benchSample()
+{
+    SensorData data = SensorData();
+    data.setTemperature(Temp);
+    data.setWeight(Weight);
+    data.setKadarAir(KadarAir);
+    data.timestamp = 1760000000UL + benchSink;
+    data.status = STATUS_OK;
+    data.relay1 = statusSSR;
+    data.relay2 = digitalRead(RELAY_PIN2);
+    return data;
+}
+
+// ---------------------------------------------------------------------------
+// Paths
+
+static void pathRtdSensor()
+{
+    Temp = rtdSensor();
+}
+
+static void pathLoadCell()
+{
+    loadCell();
+}
+
+static void pathReadSensorsJson()
+{
+    String json = readSensors();
+    benchSink += json.length();
+}
+
+static void pathSampleToCsv()
+{
+    String csv = benchSample().toCSV();
+    benchSink += csv.length();
+}
+
+static void pathStorageSave()
+{
+    benchStorage.saveData(benchSample());
+    benchSink++;
+}
+
+static void pathDwinSetText()
+{
+    hmi.setText(VP_TEMP_DISPLAY, String(Temp, 2));
+}
+
+static void pathHmiUpdate()
+{
+    updateHmiDisplay();
+}
+
+// Sample and display both due: the heaviest iteration loop() has
+static void pathLoopSample()
+{
+    unsigned long now = millis();
+    lastSampleTime = now - sampleInterval;
+    lastDisplayTime = now - 500;
+    firmwareLoop();
+}
+
+// Nothing due: HMI listen, ESP link poll and the loop delay
+static void pathLoopIdle()
+{
+    unsigned long now = millis();
+    lastSampleTime = now;
+    lastDisplayTime = now;
+    firmwareLoop();
+}
+
+struct AvrBenchmark
+{
+    const char *name; // PROGMEM
+    uint8_t runs;
+    void (*op)();
+};
+
+static const char NAME_RTD_SENSOR[] PROGMEM = "rtd_sensor";
+static const char NAME_LOAD_CELL[] PROGMEM = "load_cell";
+static const char NAME_READ_SENSORS_JSON[] PROGMEM = "read_sensors_json";
+static const char NAME_SAMPLE_TO_CSV[] PROGMEM = "sample_to_csv";
+static const char NAME_STORAGE_SAVE[] PROGMEM = "storage_save";
+static const char NAME_DWIN_SET_TEXT[] PROGMEM = "dwin_set_text";
+static const char NAME_HMI_UPDATE[] PROGMEM = "hmi_update";
+static const char NAME_LOOP_SAMPLE[] PROGMEM = "loop_sample";
+static const char NAME_LOOP_IDLE[] PROGMEM = "loop_idle";
+
+static const AvrBenchmark BENCHMARKS[] = {
+    {NAME_RTD_SENSOR, 5, pathRtdSensor},
+    {NAME_LOAD_CELL, 5, pathLoadCell},
+    {NAME_READ_SENSORS_JSON, 20, pathReadSensorsJson},
+    {NAME_SAMPLE_TO_CSV, 20, pathSampleToCsv},
+    {NAME_STORAGE_SAVE, 10, pathStorageSave},
+    {NAME_DWIN_SET_TEXT, 5, pathDwinSetText},
+    {NAME_HMI_UPDATE, 3, pathHmiUpdate},
+    {NAME_LOOP_SAMPLE, 3, pathLoopSample},
+    {NAME_LOOP_IDLE, 5, pathLoopIdle},
+};
+
+// ---------------------------------------------------------------------------
+
+// The parts of the firmware's setup() the paths depend on, without its
+// multi-second HMI test and ESP boot waits
+static void benchInit()
+{
+    Serial.begin(115200);
+
+    pinMode(RELAY_PIN1, OUTPUT);
+    pinMode(RELAY_PIN2, OUTPUT);
+
+    scale.begin(HX711_DT, HX711_SCK);
+    scale.set_scale(calibration_factor);
+    scale.tare();
+
+    timeSync.begin();
+
+    hmi.hmiCallBack(hmiCallback);
+    hmi.echoEnabled(true);
+
+    #if ESP_AVAILABLE
+    ESP_SERIAL.begin(ESP8266_BAUDRATE);
+    #endif
+
+    thermo.begin(MAX31865_3WIRE);
+    benchStorage.initialize();
+}
+
+void setup()
+{
+    benchInit();
+
+    for (uint8_t id = 1; id <= sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); id++)
+    {
+        AvrBenchmark bench;
+        memcpy(&bench, &BENCHMARKS[id - 1], sizeof(bench));
+
+        Serial.print(F("BENCH:"));
+        Serial.print(id);
+        Serial.print(':');
+        Serial.println((const __FlashStringHelper *)bench.name);
+        Serial.flush();
+
+        for (uint8_t run = 0; run < bench.runs; run++)
+        {
+            BENCH_BEGIN(id);
+            bench.op();
+            BENCH_END(id);
+        }
+    }
+
+    Serial.println(F("BENCH:DONE"));
+    Serial.flush();
+
+    // Sleeping with interrupts off ends the simavr run
+    cli();
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    sleep_cpu();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,499 @@
+/**
+ * @file simavr_runner.cpp
+ * @brief Runs the avr_bench firmware under simavr and measures every path
+ *
+ * Executes the ELF one instruction at a time on a simulated 16 MHz
+ * ATmega2560 and, between a path's GPIOR1 (begin) and GPIOR2 (end) marker
+ * writes, keeps:
+ *
+ *   cycles      CPU cycles, interrupts included (min / average / max)
+ *   stack       deepest SP below the one the path started with (bytes)
+ *   heap        highest __brkval above __heap_start (bytes)
+ *   EEPROM      writes started (EECR with EEPE set); simavr finishes them
+ *               at once, so est_ms adds the 3.3 ms each one blocks the MCU
+ *
+ * and for the whole run the static RAM (.data + .bss), the peak heap and
+ * stack and the worst-case gap between them. __brkval and __heap_start
+ * come from avr-nm (--nm for another path); without it only the stack is
+ * measured.
+ *
+ * Usage: <program> <firmware.elf> [--json FILE] [--baseline FILE]
+ *                  [--threshold PCT] [--max-seconds S] [--nm AVR-NM] [--echo]
+ *
+ * --json writes one result object per line, the same layout the host
+ * benchmarks use; --baseline compares against a saved file and exits 1 when
+ * a path takes more than --threshold percent more cycles (default 1, the
+ * counts are deterministic) or more stack or heap than before.
+ */
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_uart.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static const uint32_t CPU_HZ = 16000000;
+static const uint16_t RAM_START = 0x0200; // ATmega2560 internal SRAM
+static const uint16_t RAM_END = 0x21FF;
+static const double EEPROM_WRITE_MS = 3.3;
+
+// Data-space addresses of the marker and EEPROM control registers
+static const avr_io_addr_t GPIOR1_ADDR = 0x4A;
+static const avr_io_addr_t GPIOR2_ADDR = 0x4B;
+static const avr_io_addr_t EECR_ADDR = 0x3F;
+static const uint8_t EECR_EEPE = 1 << 1;
+
+struct RunnerOptions
+{
+    const char *elf = NULL;
+    const char *jsonFile = NULL;
+    const char *baselineFile = NULL;
+    double thresholdPct = 1;
+    double maxSeconds = 600;    // Simulated; guards against a hung path
+    const char *nm = "avr-nm";
+    bool echo = false;
+};
+
+struct PathResult
+{
+    std::string name;
+    unsigned runs = 0;
+    uint64_t cyclesMin = 0;
+    uint64_t cyclesMax = 0;
+    uint64_t cyclesTotal = 0;
+    unsigned long eepromWrites = 0;
+    unsigned stackBytes = 0;
+    unsigned heapBytes = 0;
+
+    double cyclesAvg() const { return runs ? (double)cyclesTotal / runs : 0; }
+    double msAvg() const { return cyclesAvg() * 1000.0 / CPU_HZ; }
+    double estMs() const { return msAvg() + (runs ? eepromWrites * EEPROM_WRITE_MS / runs : 0); }
+};
+
+struct RunnerState
+{
+    std::vector<PathResult> paths; // Index = path id - 1
+    uint8_t active = 0;
+    uint64_t beginCycle = 0;
+    uint16_t beginSp = 0;
+    uint16_t minSp = 0;
+    uint16_t maxBrk = 0;
+    unsigned long eepromWrites = 0;
+    unsigned long eepromAtBegin = 0;
+
+    // Whole run
+    uint16_t lowestSp = RAM_END;
+    uint16_t highestBrk = 0;
+    uint16_t worstGap = 0xFFFF;
+
+    uint16_t brkAddr = 0;
+    uint16_t heapStart = 0;
+
+    std::string line;
+    bool done = false;
+    bool echo = false;
+};
+
+static RunnerState state;
+
+static PathResult &path(uint8_t id)
+{
+    if (state.paths.size() < id)
+    {
+        state.paths.resize(id);
+    }
+    return state.paths[id - 1];
+}
+
+static uint16_t stackPointer(avr_t *avr)
+{
+    return avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+}
+
+static uint16_t heapTop(avr_t *avr)
+{
+    if (!state.brkAddr)
+    {
+        return 0;
+    }
+    uint16_t brk = avr->data[state.brkAddr] | (avr->data[state.brkAddr + 1] << 8);
+    return brk ? brk : state.heapStart; // 0 until the first malloc()
+}
+
+static void onBegin(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+    (void)addr;
+    (void)param;
+    state.active = v;
+    state.beginCycle = avr->cycle;
+    state.beginSp = stackPointer(avr);
+    state.minSp = state.beginSp;
+    state.maxBrk = heapTop(avr);
+    state.eepromAtBegin = state.eepromWrites;
+}
+
+static void onEnd(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+    (void)addr;
+    (void)param;
+    if (!state.active || v != state.active)
+    {
+        return;
+    }
+
+    PathResult &p = path(v);
+    uint64_t cycles = avr->cycle - state.beginCycle;
+    p.cyclesMin = p.runs == 0 || cycles < p.cyclesMin ? cycles : p.cyclesMin;
+    p.cyclesMax = cycles > p.cyclesMax ? cycles : p.cyclesMax;
+    p.cyclesTotal += cycles;
+    p.runs++;
+    p.eepromWrites += state.eepromWrites - state.eepromAtBegin;
+
+    unsigned stack = state.beginSp - state.minSp;
+    p.stackBytes = stack > p.stackBytes ? stack : p.stackBytes;
+    unsigned heap = state.brkAddr && state.maxBrk > state.heapStart ? state.maxBrk - state.heapStart : 0;
+    p.heapBytes = heap > p.heapBytes ? heap : p.heapBytes;
+
+    state.active = 0;
+}
+
+static void onEeprom(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+    (void)avr;
+    (void)addr;
+    (void)param;
+    if (v & EECR_EEPE)
+    {
+        state.eepromWrites++;
+    }
+}
+
+// Console of the firmware: picks up "BENCH:<id>:<name>" and "BENCH:DONE"
+static void onUart(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    (void)irq;
+    (void)param;
+    char c = (char)value;
+    if (c != '\n')
+    {
+        if (c != '\r')
+        {
+            state.line += c;
+        }
+        return;
+    }
+
+    unsigned id = 0;
+    char name[64];
+    if (state.line == "BENCH:DONE")
+    {
+        state.done = true;
+    }
+    else if (sscanf(state.line.c_str(), "BENCH:%u:%63s", &id, name) == 2 && id > 0 && id < 256)
+    {
+        path((uint8_t)id).name = name;
+    }
+    else if (state.echo)
+    {
+        fprintf(stderr, "%s\n", state.line.c_str());
+    }
+    state.line.clear();
+}
+
+// Address of one data symbol, from "avr-nm" output ("00800123 B __brkval")
+static uint16_t symbolAddress(const RunnerOptions &options, const char *symbol)
+{
+    std::string command = std::string(options.nm) + " '" + options.elf + "' 2>/dev/null";
+    FILE *in = popen(command.c_str(), "r");
+    if (!in)
+    {
+        return 0;
+    }
+
+    uint16_t address = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), in))
+    {
+        unsigned long value;
+        char type;
+        char name[128];
+        if (sscanf(line, "%lx %c %127s", &value, &type, name) == 3 && strcmp(name, symbol) == 0)
+        {
+            address = (uint16_t)(value & 0xFFFF);
+        }
+    }
+    pclose(in);
+    return address;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s <firmware.elf> [--json FILE] [--baseline FILE]\n"
+            "          [--threshold PCT] [--max-seconds S] [--nm AVR-NM] [--echo]\n",
+            program);
+}
+
+static bool parseOptions(int argc, char **argv, RunnerOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--json") == 0 && hasValue)
+        {
+            options.jsonFile = argv[++i];
+        }
+        else if (strcmp(arg, "--baseline") == 0 && hasValue)
+        {
+            options.baselineFile = argv[++i];
+        }
+        else if (strcmp(arg, "--threshold") == 0 && hasValue)
+        {
+            options.thresholdPct = atof(argv[++i]);
+        }
+        else if (strcmp(arg, "--max-seconds") == 0 && hasValue)
+        {
+            options.maxSeconds = atof(argv[++i]);
+        }
+        else if (strcmp(arg, "--nm") == 0 && hasValue)
+        {
+            options.nm = argv[++i];
+        }
+        else if (strcmp(arg, "--echo") == 0)
+        {
+            options.echo = true;
+        }
+        else if (arg[0] != '-' && !options.elf)
+        {
+            options.elf = arg;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return options.elf && options.thresholdPct >= 0 && options.maxSeconds > 0;
+}
+
+static void writeResult(FILE *out, const PathResult &p)
+{
+    fprintf(out,
+            "{\"name\":\"%s\",\"runs\":%u,\"cycles_min\":%llu,\"cycles_avg\":%.0f,\"cycles_max\":%llu,"
+            "\"ms_avg\":%.3f,\"eeprom_writes\":%lu,\"est_ms\":%.3f,\"stack_bytes\":%u,\"heap_bytes\":%u}",
+            p.name.c_str(), p.runs, (unsigned long long)p.cyclesMin, p.cyclesAvg(), (unsigned long long)p.cyclesMax,
+            p.msAvg(), p.eepromWrites, p.estMs(), p.stackBytes, p.heapBytes);
+}
+
+static bool writeJson(const char *file, const std::vector<PathResult> &results)
+{
+    FILE *out = fopen(file, "w");
+    if (!out)
+    {
+        return false;
+    }
+    fprintf(out, "{\"benchmarks\":[\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        writeResult(out, results[i]);
+        fprintf(out, i + 1 < results.size() ? ",\n" : "\n");
+    }
+    fprintf(out, "]}\n");
+    return fclose(out) == 0;
+}
+
+// Numeric member of one result line as written by writeResult()
+static bool numberField(const char *line, const char *key, double &value)
+{
+    char pattern[40];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(line, pattern);
+    if (!p)
+    {
+        return false;
+    }
+    value = atof(p + strlen(pattern));
+    return true;
+}
+
+// Returns the number of regressions, -1 when the baseline cannot be read
+static int compare(const std::vector<PathResult> &results, const char *file, double thresholdPct)
+{
+    FILE *in = fopen(file, "r");
+    if (!in)
+    {
+        return -1;
+    }
+
+    int regressions = 0;
+    printf("\n%-20s %14s %14s %8s %12s %12s\n", "vs baseline", "cycles was", "cycles now", "delta", "stack was", "stack now");
+    char line[512];
+    while (fgets(line, sizeof(line), in))
+    {
+        const char *name = strstr(line, "\"name\":\"");
+        const char *end = name ? strchr(name + 8, '"') : NULL;
+        if (!end)
+        {
+            continue;
+        }
+        std::string key(name + 8, end - name - 8);
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const PathResult &now = results[i];
+            if (now.name != key)
+            {
+                continue;
+            }
+
+            double cycles = 0, stack = 0, heap = 0;
+            numberField(line, "cycles_avg", cycles);
+            numberField(line, "stack_bytes", stack);
+            numberField(line, "heap_bytes", heap);
+
+            double deltaPct = cycles > 0 ? (now.cyclesAvg() - cycles) * 100.0 / cycles : 0;
+            bool slower = deltaPct > thresholdPct;
+            bool moreStack = now.stackBytes > stack;
+            bool moreHeap = now.heapBytes > heap;
+            if (slower || moreStack || moreHeap)
+            {
+                regressions++;
+            }
+            printf("%-20s %14.0f %14.0f %+7.2f%% %12.0f %12u%s%s%s\n", key.c_str(), cycles, now.cyclesAvg(), deltaPct,
+                   stack, now.stackBytes, slower ? "  SLOWER" : "", moreStack ? "  MORE STACK" : "",
+                   moreHeap ? "  MORE HEAP" : "");
+        }
+    }
+    fclose(in);
+    return regressions;
+}
+
+int main(int argc, char **argv)
+{
+    RunnerOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    state.echo = options.echo;
+
+    static elf_firmware_t firmware;
+    if (elf_read_firmware(options.elf, &firmware) != 0)
+    {
+        fprintf(stderr, "Cannot read %s\n", options.elf);
+        return 1;
+    }
+    firmware.frequency = CPU_HZ;
+
+    avr_t *avr = avr_make_mcu_by_name("atmega2560");
+    if (!avr)
+    {
+        fprintf(stderr, "simavr has no atmega2560 core\n");
+        return 1;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &firmware);
+    avr->frequency = CPU_HZ;
+
+    state.brkAddr = symbolAddress(options, "__brkval");
+    state.heapStart = symbolAddress(options, "__heap_start");
+    if (!state.brkAddr || !state.heapStart)
+    {
+        fprintf(stderr, "No __brkval/__heap_start from %s: heap not measured\n", options.nm);
+        state.brkAddr = 0;
+    }
+
+    avr_register_io_write(avr, GPIOR1_ADDR, onBegin, NULL);
+    avr_register_io_write(avr, GPIOR2_ADDR, onEnd, NULL);
+    avr_register_io_write(avr, EECR_ADDR, onEeprom, NULL);
+
+    // Console on USART0; keep simavr from printing any port itself
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), onUart, NULL);
+    for (char port = '0'; port <= '3'; port++)
+    {
+        uint32_t flags = 0;
+        if (avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS(port), &flags) == 0)
+        {
+            flags &= ~AVR_UART_FLAG_STDIO;
+            avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS(port), &flags);
+        }
+    }
+
+    uint64_t limit = (uint64_t)(options.maxSeconds * CPU_HZ);
+    int cpu = cpu_Running;
+    while (cpu != cpu_Done && cpu != cpu_Crashed && avr->cycle < limit)
+    {
+        cpu = avr_run(avr);
+
+        uint16_t sp = stackPointer(avr);
+        uint16_t brk = heapTop(avr);
+        if (state.active)
+        {
+            state.minSp = sp < state.minSp ? sp : state.minSp;
+            state.maxBrk = brk > state.maxBrk ? brk : state.maxBrk;
+        }
+        state.lowestSp = sp < state.lowestSp ? sp : state.lowestSp;
+        state.highestBrk = brk > state.highestBrk ? brk : state.highestBrk;
+        if (brk && sp > brk && sp - brk < state.worstGap)
+        {
+            state.worstGap = sp - brk;
+        }
+    }
+
+    if (!state.done)
+    {
+        fprintf(stderr, "Firmware did not finish (%s after %.1f s simulated)\n",
+                cpu == cpu_Crashed ? "crashed" : "stopped", (double)avr->cycle / CPU_HZ);
+        return 1;
+    }
+
+    printf("%-20s %5s %12s %12s %12s %10s %8s %10s %7s %6s\n", "path", "runs", "cycles min", "cycles avg",
+           "cycles max", "ms avg", "eeprom", "est ms", "stack", "heap");
+    for (size_t i = 0; i < state.paths.size(); i++)
+    {
+        const PathResult &p = state.paths[i];
+        printf("%-20s %5u %12llu %12.0f %12llu %10.3f %8lu %10.3f %7u %6u\n", p.name.c_str(), p.runs,
+               (unsigned long long)p.cyclesMin, p.cyclesAvg(), (unsigned long long)p.cyclesMax, p.msAvg(),
+               p.eepromWrites, p.estMs(), p.stackBytes, p.heapBytes);
+    }
+
+    if (state.brkAddr)
+    {
+        printf("\nRAM: static %u B, heap peak %u B, stack peak %u B, closest stack-heap gap %u B (of %u B)\n",
+               state.heapStart - RAM_START, state.highestBrk - state.heapStart, RAM_END - state.lowestSp,
+               state.worstGap == 0xFFFF ? state.lowestSp - state.heapStart : state.worstGap,
+               RAM_END - RAM_START + 1);
+    }
+    else
+    {
+        printf("\nRAM: stack peak %u B (of %u B)\n", RAM_END - state.lowestSp, RAM_END - RAM_START + 1);
+    }
+
+    if (options.jsonFile && !writeJson(options.jsonFile, state.paths))
+    {
+        fprintf(stderr, "Cannot write %s\n", options.jsonFile);
+        return 1;
+    }
+
+    if (options.baselineFile)
+    {
+        int regressions = compare(state.paths, options.baselineFile, options.thresholdPct);
+        if (regressions < 0)
+        {
+            fprintf(stderr, "Cannot read %s\n", options.baselineFile);
+            return 1;
+        }
+        if (regressions > 0)
+        {
+            printf("%d regression(s) against %s\n", regressions, options.baselineFile);
+            return 1;
+        }
+    }
+    return 0;
+}
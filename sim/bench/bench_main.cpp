@@ -0,0 +1,589 @@
+/**
+ * @file bench_main.cpp
+ * @brief Host microbenchmarks for the firmware's per-sample hot paths
+ *
+ * Built into the native_bench environment with the MEGA flavour of the
+ * shims. Every benchmark runs one operation in a loop and reports:
+ *
+ *   ns/op      host CPU time (median of the batches; compare runs from the
+ *              same machine only)
+ *   allocs/op  malloc/realloc/calloc calls made by firmware + shim code
+ *   bytes/op   bytes requested by those calls
+ *   sim us/op  virtual time the operation costs the board (EEPROM writes,
+ *              DWIN acknowledge waits), from SimClock
+ *
+ * Allocations are counted through the linker (-Wl,--wrap=malloc,...), so
+ * only calls from objects built into the program are seen, not the C++
+ * runtime's own. Allocation counts are deterministic and comparable
+ * across machines; ns/op is not.
+ *
+ * readSensors() and handleMegaLine() live next to setup()/loop() in the
+ * firmware mains and cannot be linked here; mega_sample_json and
+ * esp_ingest_json build and parse the same document the same way.
+ *
+ * Usage: <program> [--filter TEXT] [--min-ms MS] [--repeats N]
+ *                  [--json FILE] [--baseline FILE] [--threshold PCT]
+ *
+ * --json writes one result object per line; a saved file is the baseline
+ * for a later run. --baseline compares against it and exits 1 when any
+ * benchmark got slower by more than --threshold percent or allocates more.
+ */
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include <vector>
+
+#include "DWIN.h"
+#include "LocalStorage.h"
+#include "SensorData.h"
+
+// ---------------------------------------------------------------------------
+// Allocation counting
+
+static unsigned long allocCount = 0;
+static unsigned long allocBytes = 0;
+
+extern "C"
+{
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t count, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+    void __real_free(void *ptr);
+
+    void *__wrap_malloc(size_t size)
+    {
+        allocCount++;
+        allocBytes += size;
+        return __real_malloc(size);
+    }
+
+    void *__wrap_calloc(size_t count, size_t size)
+    {
+        allocCount++;
+        allocBytes += count * size;
+        return __real_calloc(count, size);
+    }
+
+    void *__wrap_realloc(void *ptr, size_t size)
+    {
+        allocCount++;
+        allocBytes += size;
+        return __real_realloc(ptr, size);
+    }
+
+    void __wrap_free(void *ptr)
+    {
+        __real_free(ptr);
+    }
+}
+
+// new/delete from our own objects go through the wrapped malloc as well
+void *operator new(size_t size)
+{
+    void *p = malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// ---------------------------------------------------------------------------
+// Fixtures
+
+static const unsigned long SAMPLE_TS = 1760000000UL;
+
+static SensorData sampleRecord()
+{
+    SensorData data = SensorData();
+    data.setTemperature(47.25f);
+    data.setWeight(1012.5f);
+    data.setKadarAir(12.3f);
+    data.timestamp = SAMPLE_TS;
+    data.status = STATUS_OK;
+    data.relay1 = 1;
+    data.relay2 = 0;
+    return data;
+}
+
+static const SensorData SAMPLE = sampleRecord();
+static const String SAMPLE_CSV = SAMPLE.toCSV();
+
+static LocalStorage *storage = NULL;
+static DWIN *hmi = NULL;
+static char megaLine[ESP_LINE_MAX + 2];
+static volatile unsigned long sink = 0;
+
+// Same document as readSensors() in main.cpp
+static String megaSampleJson(unsigned long ts)
+{
+    StaticJsonDocument<250> doc;
+    doc["temp"] = SAMPLE.getTemperature();
+    doc["weight"] = SAMPLE.getWeight();
+    doc["ka"] = SAMPLE.getKadarAir();
+    doc["relay1"] = SAMPLE.relay1;
+    doc["relay2"] = SAMPLE.relay2;
+    doc["cv"] = 3UL;
+    doc["ts"] = ts;
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
+
+// ---------------------------------------------------------------------------
+// Benchmarks
+
+static void benchToCsv()
+{
+    String csv = SAMPLE.toCSV();
+    sink += csv.length();
+}
+
+// What LocalStorage::saveData() uses
+static void benchToCsvBuffer()
+{
+    char csv[SENSOR_CSV_MAX];
+    sink += SAMPLE.toCSV(csv, sizeof(csv));
+}
+
+static void benchFromCsv()
+{
+    SensorData data = SensorData();
+    data.fromCSV(SAMPLE_CSV);
+    sink += data.timestamp;
+}
+
+static void benchToJson()
+{
+    String json = SAMPLE.toJSON();
+    sink += json.length();
+}
+
+static void benchMegaSampleJson()
+{
+    String json = megaSampleJson(SAMPLE_TS + sink % 60);
+    sink += json.length();
+}
+
+// Parse step of handleMegaLine() in esp8266_main.cpp: the line is copied
+// first, as ingestSerial() assembles it, then trimmed and parsed in place
+static void benchEspIngestJson()
+{
+    char line[sizeof(megaLine)];
+    size_t length = strlen(megaLine);
+    memcpy(line, megaLine, length + 1);
+
+    while (length > 0 && isspace((unsigned char)line[length - 1]))
+    {
+        line[--length] = '\0';
+    }
+    if (length > ESP_LINE_MAX || line[0] != '{')
+    {
+        return;
+    }
+
+    StaticJsonDocument<384> doc;
+    DeserializationError error = deserializeJson(doc, line, length);
+    if (error || doc.containsKey("alarm"))
+    {
+        return;
+    }
+
+    SensorData data;
+    data.temperature() = doc["temp"] | 0.0;
+    data.weight() = doc["weight"] | 0.0;
+    data.kadarAir = doc["ka"] | 0.0;
+    data.relay1 = doc["relay1"] | 0;
+    data.relay2 = doc["relay2"] | 0;
+    unsigned long cv = doc["cv"] | 0UL;
+    sink += data.relay1 + cv;
+}
+
+static void benchStorageSave()
+{
+    SensorData data = SAMPLE;
+    data.timestamp += sink % 3600;
+    storage->saveData(data);
+    sink++;
+}
+
+static void benchStorageRetrieve()
+{
+    SensorData data = SensorData();
+    storage->retrieveData(data, sink % storage->getRecordCount());
+    sink += 1 + data.timestamp % 2;
+}
+
+// One 7-segment style field update, as the MEGA does for the temperature
+static void benchDwinSetText()
+{
+    hmi->setText(0x5000, String(SAMPLE.getTemperature(), 1));
+    sink++;
+}
+
+static void setupStorage()
+{
+    if (!storage)
+    {
+        storage = new LocalStorage();
+        storage->initialize();
+        storage->clearStorage();
+    }
+}
+
+static void setupRetrieve()
+{
+    setupStorage();
+    while (storage->getRecordCount() < 10)
+    {
+        storage->saveData(SAMPLE);
+    }
+}
+
+static void setupDwin()
+{
+    if (!hmi)
+    {
+        hmi = new DWIN(Serial2, 115200);
+    }
+}
+
+static void setupIngest()
+{
+    snprintf(megaLine, sizeof(megaLine), "%s\r", megaSampleJson(SAMPLE_TS).c_str());
+}
+
+struct Benchmark
+{
+    const char *name;
+    void (*setup)();
+    void (*op)();
+};
+
+static const Benchmark BENCHMARKS[] = {
+    {"sensordata_to_csv", NULL, benchToCsv},
+    {"sensordata_to_csv_buf", NULL, benchToCsvBuffer},
+    {"sensordata_from_csv", NULL, benchFromCsv},
+    {"sensordata_to_json", NULL, benchToJson},
+    {"mega_sample_json", NULL, benchMegaSampleJson},
+    {"esp_ingest_json", setupIngest, benchEspIngestJson},
+    {"localstorage_save", setupStorage, benchStorageSave},
+    {"localstorage_retrieve", setupRetrieve, benchStorageRetrieve},
+    {"dwin_set_text", setupDwin, benchDwinSetText},
+};
+
+// ---------------------------------------------------------------------------
+// Runner
+
+struct BenchOptions
+{
+    const char *filter = NULL;
+    double minMs = 20;       // Shortest batch once calibrated
+    int repeats = 5;         // Batches per benchmark; the median is reported
+    const char *jsonFile = NULL;
+    const char *baselineFile = NULL;
+    double thresholdPct = 10;
+};
+
+struct BenchResult
+{
+    String name;
+    unsigned long iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+    double simUsPerOp;
+};
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [--filter TEXT] [--min-ms MS] [--repeats N]\n"
+            "          [--json FILE] [--baseline FILE] [--threshold PCT]\n",
+            program);
+}
+
+static bool parseOptions(int argc, char **argv, BenchOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--filter") == 0 && hasValue)
+        {
+            options.filter = argv[++i];
+        }
+        else if (strcmp(arg, "--min-ms") == 0 && hasValue)
+        {
+            options.minMs = atof(argv[++i]);
+        }
+        else if (strcmp(arg, "--repeats") == 0 && hasValue)
+        {
+            options.repeats = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--json") == 0 && hasValue)
+        {
+            options.jsonFile = argv[++i];
+        }
+        else if (strcmp(arg, "--baseline") == 0 && hasValue)
+        {
+            options.baselineFile = argv[++i];
+        }
+        else if (strcmp(arg, "--threshold") == 0 && hasValue)
+        {
+            options.thresholdPct = atof(argv[++i]);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return options.minMs > 0 && options.repeats > 0 && options.thresholdPct >= 0;
+}
+
+static uint64_t runBatch(const Benchmark &bench, unsigned long iterations)
+{
+    uint64_t start = SimClock::hostNanos();
+    for (unsigned long i = 0; i < iterations; i++)
+    {
+        bench.op();
+    }
+    return SimClock::hostNanos() - start;
+}
+
+static BenchResult measure(const Benchmark &bench, const BenchOptions &options)
+{
+    if (bench.setup)
+    {
+        bench.setup();
+    }
+
+    // Warm up, then double the batch until it is long enough to time
+    unsigned long iterations = 1;
+    runBatch(bench, 1);
+    while (runBatch(bench, iterations) < options.minMs * 1e6 && iterations < (1UL << 30))
+    {
+        iterations *= 2;
+    }
+
+    std::vector<double> nsPerOp;
+    unsigned long allocs = 0;
+    unsigned long bytes = 0;
+    uint64_t simUs = 0;
+    for (int r = 0; r < options.repeats; r++)
+    {
+        unsigned long allocsBefore = allocCount;
+        unsigned long bytesBefore = allocBytes;
+        uint64_t simBefore = SimClock::nowMicros();
+
+        nsPerOp.push_back((double)runBatch(bench, iterations) / iterations);
+
+        allocs = allocCount - allocsBefore;
+        bytes = allocBytes - bytesBefore;
+        simUs = SimClock::nowMicros() - simBefore;
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+
+    BenchResult result;
+    result.name = bench.name;
+    result.iterations = iterations;
+    result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+    result.allocsPerOp = (double)allocs / iterations;
+    result.bytesPerOp = (double)bytes / iterations;
+    result.simUsPerOp = (double)simUs / iterations;
+    return result;
+}
+
+static void writeResult(FILE *out, const BenchResult &r)
+{
+    fprintf(out,
+            "{\"name\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.1f,"
+            "\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f,\"sim_us_per_op\":%.1f}",
+            r.name.c_str(), r.iterations, r.nsPerOp, r.allocsPerOp, r.bytesPerOp, r.simUsPerOp);
+}
+
+static bool writeJson(const char *path, const std::vector<BenchResult> &results)
+{
+    FILE *out = fopen(path, "w");
+    if (!out)
+    {
+        return false;
+    }
+    fprintf(out, "{\"benchmarks\":[\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        writeResult(out, results[i]);
+        fprintf(out, i + 1 < results.size() ? ",\n" : "\n");
+    }
+    fprintf(out, "]}\n");
+    return fclose(out) == 0;
+}
+
+// Numeric member of one result line as written by writeResult()
+static bool numberField(const char *line, const char *key, double &value)
+{
+    char pattern[40];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(line, pattern);
+    if (!p)
+    {
+        return false;
+    }
+    value = atof(p + strlen(pattern));
+    return true;
+}
+
+static bool readBaseline(const char *path, std::vector<BenchResult> &baseline)
+{
+    FILE *in = fopen(path, "r");
+    if (!in)
+    {
+        return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), in))
+    {
+        const char *name = strstr(line, "\"name\":\"");
+        if (!name)
+        {
+            continue;
+        }
+        name += 8;
+        const char *end = strchr(name, '"');
+        if (!end)
+        {
+            continue;
+        }
+
+        BenchResult r = BenchResult();
+        r.name = String(name).substring(0, end - name);
+        double iterations = 0;
+        numberField(line, "iterations", iterations);
+        r.iterations = (unsigned long)iterations;
+        numberField(line, "ns_per_op", r.nsPerOp);
+        numberField(line, "allocs_per_op", r.allocsPerOp);
+        numberField(line, "bytes_per_op", r.bytesPerOp);
+        numberField(line, "sim_us_per_op", r.simUsPerOp);
+        baseline.push_back(r);
+    }
+    fclose(in);
+    return true;
+}
+
+// Prints the comparison, returns the number of regressions
+static int compare(const std::vector<BenchResult> &results, const std::vector<BenchResult> &baseline,
+                   double thresholdPct)
+{
+    int regressions = 0;
+    printf("\n%-24s %12s %12s %8s %10s %10s\n", "vs baseline", "ns/op was", "ns/op now", "delta", "allocs was", "allocs now");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &now = results[i];
+        const BenchResult *was = NULL;
+        for (size_t j = 0; j < baseline.size(); j++)
+        {
+            if (baseline[j].name == now.name)
+            {
+                was = &baseline[j];
+            }
+        }
+        if (!was)
+        {
+            printf("%-24s %12s\n", now.name.c_str(), "(new)");
+            continue;
+        }
+
+        double deltaPct = was->nsPerOp > 0 ? (now.nsPerOp - was->nsPerOp) * 100.0 / was->nsPerOp : 0;
+        bool slower = deltaPct > thresholdPct;
+        bool moreAllocs = now.allocsPerOp > was->allocsPerOp + 0.005 || now.bytesPerOp > was->bytesPerOp + 0.05;
+        if (slower || moreAllocs)
+        {
+            regressions++;
+        }
+        printf("%-24s %12.1f %12.1f %+7.1f%% %10.2f %10.2f%s%s\n", now.name.c_str(), was->nsPerOp, now.nsPerOp,
+               deltaPct, was->allocsPerOp, now.allocsPerOp, slower ? "  SLOWER" : "",
+               moreAllocs ? "  MORE ALLOCS" : "");
+    }
+    return regressions;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<BenchResult> results;
+    printf("%-24s %12s %12s %10s %10s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op", "bytes/op", "sim us/op");
+    for (size_t i = 0; i < sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); i++)
+    {
+        const Benchmark &bench = BENCHMARKS[i];
+        if (options.filter && !strstr(bench.name, options.filter))
+        {
+            continue;
+        }
+
+        BenchResult r = measure(bench, options);
+        printf("%-24s %12lu %12.1f %10.2f %10.1f %12.1f\n", r.name.c_str(), r.iterations, r.nsPerOp, r.allocsPerOp,
+               r.bytesPerOp, r.simUsPerOp);
+        fflush(stdout);
+        results.push_back(r);
+    }
+
+    if (options.jsonFile && !writeJson(options.jsonFile, results))
+    {
+        fprintf(stderr, "Cannot write %s\n", options.jsonFile);
+        return 1;
+    }
+
+    if (options.baselineFile)
+    {
+        std::vector<BenchResult> baseline;
+        if (!readBaseline(options.baselineFile, baseline))
+        {
+            fprintf(stderr, "Cannot read %s\n", options.baselineFile);
+            return 1;
+        }
+        int regressions = compare(results, baseline, options.thresholdPct);
+        if (regressions > 0)
+        {
+            printf("%d regression(s) against %s\n", regressions, options.baselineFile);
+            return 1;
+        }
+    }
+    return 0;
+}
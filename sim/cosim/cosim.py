@@ -0,0 +1,496 @@
+#!/usr/bin/env python3
+"""
+Two-board co-simulation: MEGA and ESP8266 host builds over a PTY link.
+
+Starts .pio/build/native_mega/program and .pio/build/native_esp/program as
+separate processes in real-time mode (virtual time = host time x --scale,
+from a shared start instant) and sits in the middle of their serial link:
+
+    MEGA Serial3 <-> pty <-> this runner <-> pty <-> ESP Serial
+
+The boards' UART models pace received bytes at the baud rate and count
+RX overruns, so lost lines show up as they would on hardware. The runner
+also serves a fake Firestore/RTDB/auth HTTP endpoint for the ESP
+(SimHttpCloud) and plays a scenario file of timed faults:
+
+    duration 3600            # simulated seconds
+    0    cloud latency 300 100   # ms, +/- jitter
+    600  esp wifi down
+    900  esp wifi up
+    1200 cloud drop 0.2      # fraction answered 503
+    1300 cloud lost 0.05     # fraction closed without an answer
+    1400 cloud outage on|off
+    1500 serial drop 0.01    # fraction of MEGA lines dropped on the wire
+    1600 serial corrupt 0.01 # fraction of MEGA lines with one byte flipped
+    1700 mega rtd-fault 64   # any esp/mega command is passed to the board
+
+At the end it reports, for every sample line the MEGA sent, whether it
+reached Firestore (sensor_data/*) and how long that took, plus link and
+cloud statistics. Use --json to keep the numbers.
+
+--cloud-only PORT serves only the fake endpoint, as a stand-in collector
+for the fleet simulator (sim/fleet/).
+"""
+
+import argparse
+import json
+import os
+import random
+import select
+import subprocess
+import sys
+import threading
+import time
+import tty
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+DEFAULT_EPOCH_MS = 1767225600000  # 2026-01-01, same as SimClock
+
+
+class VirtualClock:
+    """Virtual time both boards agree on (see SimClock::setRealtime)."""
+
+    def __init__(self, scale, epoch_ms, start_ns):
+        self.scale = scale
+        self.epoch_ms = epoch_ms
+        self.start_ns = start_ns
+
+    def now_s(self):
+        return max(0, time.monotonic_ns() - self.start_ns) * self.scale / 1e9
+
+    def unix_ms(self):
+        return self.epoch_ms + self.now_s() * 1000
+
+    def sleep_until(self, virtual_s):
+        while True:
+            remaining = virtual_s - self.now_s()
+            if remaining <= 0:
+                return
+            time.sleep(min(remaining / self.scale, 0.2))
+
+
+class Faults:
+    """Fault state shared by the cloud endpoint and the serial relay."""
+
+    def __init__(self, seed):
+        self.lock = threading.Lock()
+        self.random = random.Random(seed)
+        self.latency_ms = 250
+        self.jitter_ms = 50
+        self.drop = 0.0
+        self.lost = 0.0
+        self.outage = False
+        self.serial_drop = 0.0
+        self.serial_corrupt = 0.0
+
+    def apply(self, target, args):
+        with self.lock:
+            if target == "cloud" and args[0] == "latency":
+                self.latency_ms = float(args[1])
+                self.jitter_ms = float(args[2]) if len(args) > 2 else 0.0
+            elif target == "cloud" and args[0] == "drop":
+                self.drop = float(args[1])
+            elif target == "cloud" and args[0] == "lost":
+                self.lost = float(args[1])
+            elif target == "cloud" and args[0] == "outage":
+                self.outage = args[1] == "on"
+            elif target == "serial" and args[0] == "drop":
+                self.serial_drop = float(args[1])
+            elif target == "serial" and args[0] == "corrupt":
+                self.serial_corrupt = float(args[1])
+            else:
+                return False
+        return True
+
+    def chance(self, probability):
+        with self.lock:
+            return probability > 0 and self.random.random() < probability
+
+    def latency(self):
+        with self.lock:
+            jitter = self.random.uniform(-self.jitter_ms, self.jitter_ms)
+            return max(1, int(self.latency_ms + jitter))
+
+
+class FakeCloud(ThreadingHTTPServer):
+    """Fake Firestore/RTDB/auth endpoint behind SimHttpCloud."""
+
+    daemon_threads = True
+    request_queue_size = 128  # A fleet connects from many threads at once
+
+    def __init__(self, clock, faults, port=0):
+        super().__init__(("127.0.0.1", port), CloudHandler)
+        self.clock = clock
+        self.faults = faults
+        self.lock = threading.Lock()
+        self.docs = {}  # path -> (body, arrival unix ms)
+        self.stats = {"requests": 0, "stored": 0, "outage": 0, "dropped": 0, "lost": 0, "users": 0}
+
+    def count(self, key):
+        with self.lock:
+            self.stats[key] += 1
+
+
+class CloudHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.0"
+
+    def log_message(self, format, *args):
+        pass
+
+    def do_GET(self):
+        self.serve("GET")
+
+    def do_PUT(self):
+        self.serve("PUT")
+
+    def do_PATCH(self):
+        self.serve("PATCH")
+
+    def do_POST(self):
+        self.serve("POST")
+
+    def reply(self, code, body, latency_ms):
+        data = body.encode()
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(data)))
+        self.send_header("X-Sim-Latency-Ms", str(latency_ms))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def serve(self, method):
+        cloud = self.server
+        faults = cloud.faults
+        length = int(self.headers.get("Content-Length", 0))
+        body = self.rfile.read(length).decode(errors="replace") if length else ""
+        path = self.path.lstrip("/")
+        latency = faults.latency()
+        cloud.count("requests")
+
+        if faults.outage:
+            cloud.count("outage")
+            self.reply(503, '{"error":{"code":503,"status":"UNAVAILABLE"}}', latency)
+            return
+        if faults.chance(faults.lost):
+            cloud.count("lost")
+            self.close_connection = True
+            return  # No response at all
+        if faults.chance(faults.drop):
+            cloud.count("dropped")
+            self.reply(503, '{"error":{"code":503,"status":"UNAVAILABLE"}}', latency)
+            return
+
+        if path.startswith("auth/"):
+            with cloud.lock:
+                if path == "auth/signUp":
+                    cloud.stats["users"] += 1
+                user = cloud.stats["users"]
+                n = cloud.stats["requests"]
+            self.reply(200, '{"idToken":"cosim-id-%d-%d","refreshToken":"cosim-refresh-%d"}' % (user, n, user), latency)
+            return
+
+        # The document lands half way through the request
+        arrival = cloud.clock.unix_ms() + latency / 2
+        with cloud.lock:
+            if method == "GET":
+                doc = cloud.docs.get(path)
+                code, text = (200, doc[0]) if doc else (404, '{"error":{"code":404,"status":"NOT_FOUND"}}')
+            elif method == "POST" and path in cloud.docs:
+                code, text = 409, '{"error":{"code":409,"status":"ALREADY_EXISTS"}}'
+            else:
+                first = cloud.docs.get(path, (None, arrival))[1]
+                cloud.docs[path] = (body, first)
+                cloud.stats["stored"] += 1
+                code, text = 200, body
+        self.reply(code, text, latency)
+
+
+class Relay(threading.Thread):
+    """Forwards the serial link between the two PTYs and watches the lines."""
+
+    def __init__(self, mega_fd, esp_fd, clock, faults, log):
+        super().__init__(daemon=True)
+        self.fds = {mega_fd: esp_fd, esp_fd: mega_fd}
+        self.mega_fd = mega_fd
+        self.clock = clock
+        self.faults = faults
+        self.log = log
+        self.pending = {mega_fd: b"", esp_fd: b""}
+        self.running = True
+        self.samples = []  # send unix ms of every MEGA sample line
+        self.alarms = []
+        self.stats = {"mega_lines": 0, "esp_lines": 0, "dropped": 0, "corrupted": 0,
+                      "time_lines": 0, "clear_lines": 0, "saved_lines": 0}
+
+    def run(self):
+        while self.running:
+            ready, _, _ = select.select(list(self.fds), [], [], 0.05)
+            for fd in ready:
+                try:
+                    data = os.read(fd, 4096)
+                except OSError:
+                    data = b""
+                if data:
+                    self.forward(fd, data)
+
+    def forward(self, fd, data):
+        # Whole lines go through the fault filter; a partial line waits
+        buffered = self.pending[fd] + data
+        lines = buffered.split(b"\n")
+        self.pending[fd] = lines.pop()
+        out = b""
+        for line in lines:
+            out += self.inspect(fd, line + b"\n")
+        while out:
+            try:
+                out = out[os.write(self.fds[fd], out):]
+            except BlockingIOError:
+                time.sleep(0.001)
+
+    def inspect(self, fd, line):
+        now = self.clock.unix_ms()
+        text = line.decode(errors="replace").strip()
+        if self.log:
+            self.log.write("%.3f %s %s\n" % (now / 1000, "M>E" if fd == self.mega_fd else "E>M", text))
+
+        if fd != self.mega_fd:
+            self.stats["esp_lines"] += 1
+            if text.startswith("TIME:"):
+                self.stats["time_lines"] += 1
+            elif text.startswith("CLEAR"):
+                self.stats["clear_lines"] += 1
+            elif text.startswith("SAVED:"):
+                self.stats["saved_lines"] += 1
+            return line
+
+        self.stats["mega_lines"] += 1
+        if text.startswith("{") and '"alarm"' in text:
+            self.alarms.append(now)
+        elif text.startswith("{") and '"temp"' in text:
+            self.samples.append(now)
+
+        if self.faults.chance(self.faults.serial_drop):
+            self.stats["dropped"] += 1
+            return b""
+        if self.faults.chance(self.faults.serial_corrupt) and len(line) > 2:
+            self.stats["corrupted"] += 1
+            i = self.faults.random.randrange(len(line) - 1)
+            line = line[:i] + bytes([line[i] ^ 0x20]) + line[i + 1:]
+        return line
+
+
+def load_scenario(path):
+    duration = 3600.0
+    events = []
+    if not path:
+        return duration, events
+    with open(path) as f:
+        for raw in f:
+            words = raw.split("#", 1)[0].split()
+            if not words:
+                continue
+            if words[0] == "duration":
+                duration = float(words[1])
+            else:
+                events.append((float(words[0]), words[1], words[2:]))
+    events.sort(key=lambda e: e[0])
+    return duration, events
+
+
+def play(events, clock, faults, controls, stop):
+    for at, target, args in events:
+        clock.sleep_until(at)
+        if stop.is_set():
+            return
+        if target in controls:
+            os.write(controls[target], (" ".join(args) + "\n").encode())
+        elif not faults.apply(target, args):
+            print("cosim: unknown event '%s %s'" % (target, " ".join(args)), file=sys.stderr)
+
+
+def percentile(values, p):
+    if not values:
+        return None
+    values = sorted(values)
+    return values[min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))]
+
+
+def delivery(samples, docs, end_unix_ms, grace_s):
+    """Match sensor_data docs to the MEGA lines that produced them."""
+    stamped = []
+    for path, (body, arrival) in docs.items():
+        if not path.startswith("firestore/sensor_data/"):
+            continue
+        try:
+            ts = int(json.loads(body)["fields"]["timestamp"]["integerValue"])
+        except (ValueError, KeyError, TypeError):
+            continue
+        stamped.append((ts, arrival))
+    stamped.sort()
+
+    # The ESP stamps a sample with its own clock when the line is ingested,
+    # a moment after the MEGA sent it
+    used = [False] * len(samples)
+    latencies = []
+    for ts, arrival in stamped:
+        best = None
+        for i, sent in enumerate(samples):
+            if used[i] or not (ts - 5 <= sent / 1000 <= ts + 2):
+                continue
+            if best is None or abs(sent / 1000 - ts) < abs(samples[best] / 1000 - ts):
+                best = i
+        if best is not None:
+            used[best] = True
+            latencies.append((arrival - samples[best]) / 1000)
+
+    eligible = [i for i, sent in enumerate(samples) if sent <= end_unix_ms - grace_s * 1000]
+    delivered = sum(1 for i in eligible if used[i])
+    return {
+        "sent": len(samples),
+        "eligible": len(eligible),
+        "delivered": delivered,
+        "ratio": delivered / len(eligible) if eligible else None,
+        "unmatched_docs": len(stamped) - len(latencies),
+        "latency_s": {
+            "p50": percentile(latencies, 50),
+            "p95": percentile(latencies, 95),
+            "p99": percentile(latencies, 99),
+            "max": max(latencies) if latencies else None,
+        },
+    }
+
+
+def open_pty():
+    master, slave = os.openpty()
+    tty.setraw(master)
+    os.set_blocking(master, False)
+    return master, slave, os.ttyname(slave)
+
+
+def serve_cloud(port, seed):
+    """The fake endpoint on its own, as a stand-in collector for other tools."""
+    cloud = FakeCloud(VirtualClock(1.0, DEFAULT_EPOCH_MS, time.monotonic_ns()), Faults(seed), port)
+    print("cosim: fake cloud on 127.0.0.1:%d, Ctrl-C to stop" % cloud.server_address[1], file=sys.stderr)
+    try:
+        cloud.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print("cloud     : %(requests)d requests, %(stored)d stored" % cloud.stats, file=sys.stderr)
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("scenario", nargs="?", help="scenario file (default: 1 h, no faults)")
+    parser.add_argument("--mega", default=".pio/build/native_mega/program")
+    parser.add_argument("--esp", default=".pio/build/native_esp/program")
+    parser.add_argument("--scale", type=float, default=10.0, help="virtual seconds per real second")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--grace", type=float, default=120.0,
+                        help="samples sent this close to the end are not counted as lost")
+    parser.add_argument("--out", default="cosim_out", help="directory for logs")
+    parser.add_argument("--json", help="write the report here as JSON")
+    parser.add_argument("--cloud-only", type=int, metavar="PORT",
+                        help="only serve the fake cloud on this port until interrupted (for sim/fleet)")
+    args = parser.parse_args()
+
+    if args.cloud_only is not None:
+        return serve_cloud(args.cloud_only, args.seed)
+
+    duration, events = load_scenario(args.scenario)
+    os.makedirs(args.out, exist_ok=True)
+
+    clock = VirtualClock(args.scale, DEFAULT_EPOCH_MS, time.monotonic_ns() + 500_000_000)
+    faults = Faults(args.seed)
+    cloud = FakeCloud(clock, faults)
+    threading.Thread(target=cloud.serve_forever, daemon=True).start()
+
+    mega_master, mega_slave, mega_tty = open_pty()
+    esp_master, esp_slave, esp_tty = open_pty()
+    mega_control_r, mega_control_w = os.pipe()
+    esp_control_r, esp_control_w = os.pipe()
+
+    common = ["--hours", str(duration / 3600.0), "--realtime", str(args.scale),
+              "--start-ns", str(clock.start_ns), "--epoch-ms", str(clock.epoch_ms),
+              "--seed", str(args.seed), "--echo"]
+    boards = {
+        "mega": [args.mega, "--link", mega_tty, "--control-fd", str(mega_control_r)] + common,
+        "esp": [args.esp, "--link", esp_tty, "--control-fd", str(esp_control_r),
+                "--cloud", "127.0.0.1:%d" % cloud.server_address[1]] + common,
+    }
+
+    link_log = open(os.path.join(args.out, "link.log"), "w")
+    relay = Relay(mega_master, esp_master, clock, faults, link_log)
+    relay.start()
+
+    processes = {}
+    for name, command in boards.items():
+        control = mega_control_r if name == "mega" else esp_control_r
+        processes[name] = subprocess.Popen(
+            command, pass_fds=(control,),
+            stdout=open(os.path.join(args.out, name + ".log"), "w"),
+            stderr=open(os.path.join(args.out, name + ".err"), "w"))
+    os.close(mega_control_r)
+    os.close(esp_control_r)
+
+    stop = threading.Event()
+    player = threading.Thread(target=play, args=(events, clock, faults,
+                                                 {"mega": mega_control_w, "esp": esp_control_w}, stop),
+                              daemon=True)
+    player.start()
+
+    print("cosim: %.0f s simulated at %gx, logs in %s/" % (duration, args.scale, args.out), file=sys.stderr)
+    codes = {name: p.wait() for name, p in processes.items()}
+    stop.set()
+    time.sleep(0.2)  # Let the relay drain
+    relay.running = False
+    relay.join()
+    cloud.shutdown()
+    link_log.close()
+    for fd in (mega_master, mega_slave, esp_master, esp_slave, mega_control_w, esp_control_w):
+        os.close(fd)
+
+    end_unix_ms = clock.epoch_ms + duration * 1000
+    with cloud.lock:
+        docs = dict(cloud.docs)
+    report = {
+        "scenario": args.scenario,
+        "duration_s": duration,
+        "scale": args.scale,
+        "exit_codes": codes,
+        "samples": delivery(relay.samples, docs, end_unix_ms, args.grace),
+        "alarms": {"sent": len(relay.alarms),
+                   "delivered": sum(1 for p in docs if p.startswith("firestore/alarms/"))},
+        "summaries": sum(1 for p in docs if p.startswith("firestore/sensor_summary/")),
+        "link": relay.stats,
+        "cloud": cloud.stats,
+    }
+
+    s = report["samples"]
+    lat = s["latency_s"]
+    fmt = lambda v: "-" if v is None else "%.1f" % v
+    print("\n---- co-simulation ----")
+    print("samples   : %d sent, %d delivered of %d eligible (%s)" % (
+        s["sent"], s["delivered"], s["eligible"],
+        "-" if s["ratio"] is None else "%.1f%%" % (100 * s["ratio"])))
+    print("latency   : p50 %s s, p95 %s s, p99 %s s, max %s s" % (
+        fmt(lat["p50"]), fmt(lat["p95"]), fmt(lat["p99"]), fmt(lat["max"])))
+    print("alarms    : %d sent, %d delivered" % (report["alarms"]["sent"], report["alarms"]["delivered"]))
+    print("summaries : %d windows" % report["summaries"])
+    print("link      : %(mega_lines)d MEGA lines (%(dropped)d dropped, %(corrupted)d corrupted), "
+          "%(esp_lines)d ESP lines (%(time_lines)d TIME, %(clear_lines)d CLEAR)" % relay.stats)
+    print("cloud     : %(requests)d requests, %(stored)d stored, %(outage)d outage, "
+          "%(dropped)d dropped, %(lost)d lost" % cloud.stats)
+    for name in boards:
+        with open(os.path.join(args.out, name + ".err")) as f:
+            overruns = [l.strip() for l in f if "overruns" in l]
+        print("%-10s: exit %d; %s" % (name, codes[name], "; ".join(overruns)))
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=2)
+    return 0 if all(c == 0 for c in codes.values()) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,87 @@
+/**
+ * @file Adafruit_MAX31865.cpp
+ * @brief Fake MAX31865 RTD converter over SimPlant
+ */
+
+#include "Adafruit_MAX31865.h"
+#include "SimPlant.h"
+#include "SystemConfig.h"
+
+// main.cpp: vRTD = code / 32768 * VBIAS; T = (vRTD - 0.2437) / 0.0007 - 1
+static const float REG_OFFSET_V = 0.2437f;
+static const float REG_SLOPE_V = 0.0007f;
+
+Adafruit_MAX31865::Adafruit_MAX31865(int8_t spiCs, int8_t spiMosi, int8_t spiMiso, int8_t spiClk)
+    : _wires(MAX31865_2WIRE),
+      _latchedFault(0),
+      _lowerThreshold(0),
+      _upperThreshold(0xFFFF)
+{
+    (void)spiCs;
+    (void)spiMosi;
+    (void)spiMiso;
+    (void)spiClk;
+}
+
+Adafruit_MAX31865::Adafruit_MAX31865(int8_t spiCs)
+    : Adafruit_MAX31865(spiCs, -1, -1, -1)
+{
+}
+
+bool Adafruit_MAX31865::begin(max31865_numwires_t wires)
+{
+    _wires = wires;
+    clearFault();
+    return true;
+}
+
+uint8_t Adafruit_MAX31865::readFault(max31865_fault_cycle_t faultCycle)
+{
+    (void)faultCycle;
+    _latchedFault |= SimPlant::rtdFault();
+    return _latchedFault;
+}
+
+void Adafruit_MAX31865::clearFault()
+{
+    _latchedFault = 0;
+}
+
+uint16_t Adafruit_MAX31865::readRTD()
+{
+    SimClock::advance(SIM_MAX31865_CONVERSION_US);
+
+    float volts = (SimPlant::measuredTemperature() + 1.0f) * REG_SLOPE_V + REG_OFFSET_V;
+    long code = lroundf(volts / VBIAS * 32768.0f);
+    code = constrain(code, 0L, 32767L);
+
+    if ((uint16_t)code > _upperThreshold)
+    {
+        _latchedFault |= MAX31865_FAULT_HIGHTHRESH;
+    }
+    if ((uint16_t)code < _lowerThreshold)
+    {
+        _latchedFault |= MAX31865_FAULT_LOWTHRESH;
+    }
+
+    return (uint16_t)code;
+}
+
+void Adafruit_MAX31865::setThresholds(uint16_t lower, uint16_t upper)
+{
+    _lowerThreshold = lower;
+    _upperThreshold = upper;
+}
+
+float Adafruit_MAX31865::temperature(float rtdNominal, float refResistor)
+{
+    float rt = readRTD() / 32768.0f * refResistor;
+
+    // Quadratic solution of R = R0 (1 + A T + B T^2), valid above 0 °C
+    float z1 = -RTD_A;
+    float z2 = RTD_A * RTD_A - (4 * RTD_B);
+    float z3 = (4 * RTD_B) / rtdNominal;
+    float z4 = 2 * RTD_B;
+
+    return (sqrtf(z2 + (z3 * rt)) + z1) / z4;
+}
@@ -0,0 +1,79 @@
+#ifndef ADAFRUIT_MAX31865_H
+#define ADAFRUIT_MAX31865_H
+
+/**
+ * @file Adafruit_MAX31865.h
+ * @brief Fake MAX31865 RTD converter (Adafruit API) over SimPlant
+ *
+ * readRTD() returns the 15-bit code that makes main.cpp's rtdSensor()
+ * regression come out at SimPlant's temperature, so the firmware's control
+ * loop sees the plant exactly. A one-shot conversion costs 75 ms of
+ * virtual time (10 ms bias settle + 65 ms conversion, as in the library).
+ * Faults set with SimPlant::setRtdFault() latch until clearFault().
+ */
+
+#include <Arduino.h>
+
+#define MAX31865_FAULT_HIGHTHRESH 0x80
+#define MAX31865_FAULT_LOWTHRESH 0x40
+#define MAX31865_FAULT_REFINLOW 0x20
+#define MAX31865_FAULT_REFINHIGH 0x10
+#define MAX31865_FAULT_RTDINLOW 0x08
+#define MAX31865_FAULT_OVUV 0x04
+
+#define RTD_A 3.9083e-3
+#define RTD_B -5.775e-7
+
+#ifndef SIM_MAX31865_CONVERSION_US
+#define SIM_MAX31865_CONVERSION_US 75000
+#endif
+
+typedef enum max31865_numwires
+{
+    MAX31865_2WIRE = 0,
+    MAX31865_3WIRE = 1,
+    MAX31865_4WIRE = 0
+} max31865_numwires_t;
+
+typedef enum
+{
+    MAX31865_FAULT_NONE = 0,
+    MAX31865_FAULT_AUTO,
+    MAX31865_FAULT_MANUAL_RUN,
+    MAX31865_FAULT_MANUAL_FINISH
+} max31865_fault_cycle_t;
+
+class Adafruit_MAX31865
+{
+public:
+    Adafruit_MAX31865(int8_t spiCs, int8_t spiMosi, int8_t spiMiso, int8_t spiClk);
+    Adafruit_MAX31865(int8_t spiCs);
+
+    bool begin(max31865_numwires_t wires = MAX31865_2WIRE);
+
+    uint8_t readFault(max31865_fault_cycle_t faultCycle = MAX31865_FAULT_AUTO);
+    void clearFault();
+    uint16_t readRTD();
+
+    void setThresholds(uint16_t lower, uint16_t upper);
+    uint16_t getLowerThreshold() { return _lowerThreshold; }
+    uint16_t getUpperThreshold() { return _upperThreshold; }
+
+    void setWires(max31865_numwires_t wires) { _wires = wires; }
+    void autoConvert(bool b) { (void)b; }
+    void enable50Hz(bool b) { (void)b; }
+    void enableBias(bool b) { (void)b; }
+
+    /**
+     * @brief Callendar-Van Dusen temperature from the current RTD code
+     */
+    float temperature(float rtdNominal, float refResistor);
+
+private:
+    max31865_numwires_t _wires;
+    uint8_t _latchedFault;
+    uint16_t _lowerThreshold;
+    uint16_t _upperThreshold;
+};
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * @file HX711.cpp
+ * @brief Fake HX711 load-cell amplifier over SimPlant
+ */
+
+#include "HX711.h"
+#include "SimPlant.h"
+
+HX711::HX711()
+    : _scale(1.f),
+      _offset(0),
+      _gain(128),
+      _powered(true)
+{
+}
+
+void HX711::begin(uint8_t dout, uint8_t pdSck, uint8_t gain)
+{
+    (void)dout;
+    (void)pdSck;
+    _gain = gain;
+    _powered = true;
+}
+
+bool HX711::is_ready()
+{
+    return _powered && SimPlant::loadCellPresent();
+}
+
+void HX711::wait_ready(unsigned long delayMs)
+{
+    while (!is_ready())
+    {
+        delay(delayMs > 0 ? delayMs : 1);
+    }
+}
+
+long HX711::read()
+{
+    SimClock::advance(SIM_HX711_SAMPLE_US);
+
+    if (!is_ready())
+    {
+        return 0x7FFFFF; // Floating DOUT reads as all ones
+    }
+    return ZERO_COUNTS + (long)(SimPlant::measuredMass() * SIM_HX711_COUNTS_PER_KG);
+}
+
+long HX711::read_average(uint8_t times)
+{
+    if (times == 0)
+    {
+        times = 1;
+    }
+
+    long sum = 0;
+    for (uint8_t i = 0; i < times; i++)
+    {
+        sum += read();
+    }
+    return sum / times;
+}
+
+double HX711::get_value(uint8_t times)
+{
+    return read_average(times) - _offset;
+}
+
+float HX711::get_units(uint8_t times)
+{
+    return get_value(times) / _scale;
+}
+
+void HX711::tare(uint8_t times)
+{
+    // Empty-platform tare: the conversions still take their time
+    SimClock::advance((uint64_t)times * SIM_HX711_SAMPLE_US);
+    set_offset(ZERO_COUNTS);
+}
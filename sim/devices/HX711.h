@@ -0,0 +1,58 @@
+#ifndef HX711_H
+#define HX711_H
+
+/**
+ * @file HX711.h
+ * @brief Fake HX711 load-cell amplifier (bogde/HX711 API) over SimPlant
+ *
+ * Raw counts are SimPlant's mass times SIM_HX711_COUNTS_PER_KG plus a fixed
+ * zero offset. tare() is modelled as taken on the empty platform (the
+ * board is calibrated before loading), so get_units() reports the load.
+ * Each conversion costs 100 ms of virtual time (10 SPS), which makes
+ * get_units(10) block for a second as it does on the board.
+ */
+
+#include <Arduino.h>
+
+#ifndef SIM_HX711_COUNTS_PER_KG
+#define SIM_HX711_COUNTS_PER_KG 208.0f // calibration_factor in main.cpp
+#endif
+
+#ifndef SIM_HX711_SAMPLE_US
+#define SIM_HX711_SAMPLE_US 100000 // 10 SPS
+#endif
+
+class HX711
+{
+public:
+    HX711();
+
+    void begin(uint8_t dout, uint8_t pdSck, uint8_t gain = 128);
+    bool is_ready();
+    void wait_ready(unsigned long delayMs = 0);
+    void set_gain(uint8_t gain = 128) { _gain = gain; }
+
+    long read();
+    long read_average(uint8_t times = 10);
+    double get_value(uint8_t times = 1);
+    float get_units(uint8_t times = 1);
+    void tare(uint8_t times = 10);
+
+    void set_scale(float scale = 1.f) { _scale = scale; }
+    float get_scale() { return _scale; }
+    void set_offset(long offset = 0) { _offset = offset; }
+    long get_offset() { return _offset; }
+
+    void power_down() { _powered = false; }
+    void power_up() { _powered = true; }
+
+private:
+    static const long ZERO_COUNTS = 8421;
+
+    float _scale;
+    long _offset;
+    uint8_t _gain;
+    bool _powered;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/**
+ * @file SimDwinPanel.cpp
+ * @brief Fake DWIN DGUS panel implementation
+ */
+
+#include "SimDwinPanel.h"
+
+static const uint8_t HEAD1 = 0x5A;
+static const uint8_t HEAD2 = 0xA5;
+static const uint8_t CMD_WRITE = 0x82;
+static const uint8_t CMD_READ = 0x83;
+
+SimDwinPanel::SimDwinPanel(HardwareSerial &port, bool ack)
+    : _port(port),
+      _ack(ack),
+      _vpCount(0),
+      _framePos(0),
+      _frames(0),
+      _badFrames(0)
+{
+    _port.attach(this);
+}
+
+void SimDwinPanel::receive(uint8_t c)
+{
+    // Resynchronise on the two header bytes
+    if ((_framePos == 0 && c != HEAD1) || (_framePos == 1 && c != HEAD2))
+    {
+        if (_framePos == 1)
+        {
+            _badFrames++;
+        }
+        _framePos = c == HEAD1 ? 1 : 0;
+        return;
+    }
+
+    _frame[_framePos++] = c;
+
+    // Header, length byte, then <length> bytes of command + data
+    if (_framePos >= 3 && _framePos == 3 + _frame[2])
+    {
+        handleFrame();
+        _framePos = 0;
+    }
+}
+
+void SimDwinPanel::handleFrame()
+{
+    uint8_t length = _frame[2];
+    if (length < 3)
+    {
+        _badFrames++;
+        return;
+    }
+
+    _frames++;
+    uint8_t cmd = _frame[3];
+    uint16_t address = (_frame[4] << 8) | _frame[5];
+    const uint8_t *data = _frame + 6;
+    uint8_t dataLength = length - 3;
+
+    if (cmd != CMD_WRITE)
+    {
+        return; // Reads of registers are not modelled
+    }
+
+    Vp *vp = findVp(address, true);
+    if (vp)
+    {
+        if (dataLength == 2)
+        {
+            vp->hasWord = true;
+            vp->word = (data[0] << 8) | data[1];
+        }
+
+        uint8_t n = dataLength < TEXT_MAX - 1 ? dataLength : TEXT_MAX - 1;
+        memcpy(vp->text, data, n);
+        vp->text[n] = '\0';
+    }
+
+    if (_ack)
+    {
+        static const uint8_t ACK[] = {HEAD1, HEAD2, 0x03, CMD_WRITE, 0x4F, 0x4B};
+        _port.inject(ACK, sizeof(ACK));
+    }
+}
+
+void SimDwinPanel::touch(uint16_t vp, uint16_t value)
+{
+    uint8_t frame[] = {HEAD1, HEAD2, 0x06, CMD_READ,
+                       (uint8_t)(vp >> 8), (uint8_t)(vp & 0xFF), 0x01,
+                       (uint8_t)(value >> 8), (uint8_t)(value & 0xFF)};
+    _port.inject(frame, sizeof(frame));
+}
+
+const char *SimDwinPanel::text(uint16_t vp) const
+{
+    for (uint8_t i = 0; i < _vpCount; i++)
+    {
+        if (_vps[i].address == vp)
+        {
+            return _vps[i].text;
+        }
+    }
+    return "";
+}
+
+long SimDwinPanel::value(uint16_t vp) const
+{
+    for (uint8_t i = 0; i < _vpCount; i++)
+    {
+        if (_vps[i].address == vp && _vps[i].hasWord)
+        {
+            return _vps[i].word;
+        }
+    }
+    return -1;
+}
+
+SimDwinPanel::Vp *SimDwinPanel::findVp(uint16_t address, bool create)
+{
+    for (uint8_t i = 0; i < _vpCount; i++)
+    {
+        if (_vps[i].address == address)
+        {
+            return &_vps[i];
+        }
+    }
+
+    if (!create || _vpCount >= MAX_VPS)
+    {
+        return NULL;
+    }
+
+    Vp &vp = _vps[_vpCount++];
+    vp.address = address;
+    vp.hasWord = false;
+    vp.word = 0;
+    vp.text[0] = '\0';
+    return &vp;
+}
@@ -0,0 +1,75 @@
+#ifndef SIM_DWIN_PANEL_H
+#define SIM_DWIN_PANEL_H
+
+/**
+ * @file SimDwinPanel.h
+ * @brief Fake DWIN DGUS panel on a simulated serial port
+ *
+ * Attach it to the port DWIN talks through (Serial1 on the MEGA). It
+ * parses the 5A A5 <len> <cmd> ... frames the firmware writes, keeps the
+ * last text and word written to each VP address, and acknowledges every
+ * 0x82 write with "5A A5 03 82 4F 4B" like the real panel. touch() sends
+ * the 0x83 frame a button press produces, so hmiCallback() runs.
+ */
+
+#include <Arduino.h>
+
+class SimDwinPanel : public SerialDevice
+{
+public:
+    static const uint8_t MAX_VPS = 16;
+    static const uint8_t TEXT_MAX = 32;
+
+    /**
+     * @param port Port the firmware's DWIN object uses
+     * @param ack Reply to writes (the stock panel does)
+     */
+    explicit SimDwinPanel(HardwareSerial &port, bool ack = true);
+
+    void receive(uint8_t c) override;
+
+    /**
+     * @brief Simulate a touch on a return-key control
+     * @param vp VP address the control writes
+     * @param value Key value
+     */
+    void touch(uint16_t vp, uint16_t value);
+
+    /**
+     * @brief Last text written to a VP ("" if never)
+     */
+    const char *text(uint16_t vp) const;
+
+    /**
+     * @brief Last 16-bit word written to a VP (-1 if never)
+     */
+    long value(uint16_t vp) const;
+
+    unsigned long frames() const { return _frames; }
+    unsigned long badFrames() const { return _badFrames; }
+
+private:
+    struct Vp
+    {
+        uint16_t address;
+        bool hasWord;
+        uint16_t word;
+        char text[TEXT_MAX];
+    };
+
+    HardwareSerial &_port;
+    bool _ack;
+
+    Vp _vps[MAX_VPS];
+    uint8_t _vpCount;
+
+    uint8_t _frame[258];
+    uint16_t _framePos;
+    unsigned long _frames;
+    unsigned long _badFrames;
+
+    Vp *findVp(uint16_t address, bool create);
+    void handleFrame();
+};
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file SimPlant.cpp
+ * @brief Physical model of the curing barn behind the fake sensors
+ */
+
+#include "SimPlant.h"
+#include <Arduino.h>
+
+SimPlantParams SimPlant::_params = {
+    28.0f,   // ambientTemp
+    95.0f,   // heaterTemp
+    1800.0f, // heatTau: 30 min
+    2400.0f, // coolTau: 40 min
+    100.0f,  // initialMass (M0 in main.cpp)
+    25.0f,   // dryMass: M0 * (1 - w0)
+    86400.0f, // dryTau: one day at full heat
+    0.15f,   // tempNoise
+    0.05f,   // massNoise
+    3        // heaterPin: RELAY_PIN1
+};
+
+float SimPlant::_temp = 28.0f;
+float SimPlant::_mass = 100.0f;
+uint64_t SimPlant::_lastUs = 0;
+uint8_t SimPlant::_rtdFault = 0;
+bool SimPlant::_loadCellPresent = true;
+
+void SimPlant::reset()
+{
+    _temp = _params.ambientTemp;
+    _mass = _params.initialMass;
+    _lastUs = SimClock::nowMicros();
+    _rtdFault = 0;
+    _loadCellPresent = true;
+}
+
+void SimPlant::integrate()
+{
+    uint64_t now = SimClock::nowMicros();
+    float dt = (now - _lastUs) / 1e6f;
+    _lastUs = now;
+
+    if (dt <= 0)
+    {
+        return;
+    }
+
+    bool heating = SimPins::level(_params.heaterPin) == HIGH;
+    float target = heating ? _params.heaterTemp : _params.ambientTemp;
+    float tau = heating ? _params.heatTau : _params.coolTau;
+    _temp = target + (_temp - target) * expf(-dt / tau);
+
+    // Drying speed relative to running at heaterTemp
+    float span = _params.heaterTemp - _params.ambientTemp;
+    float rate = span > 0 ? (_temp - _params.ambientTemp) / span : 0;
+    if (rate > 0)
+    {
+        _mass = _params.dryMass + (_mass - _params.dryMass) * expf(-dt * rate / _params.dryTau);
+    }
+}
+
+float SimPlant::temperature()
+{
+    integrate();
+    return _temp;
+}
+
+float SimPlant::mass()
+{
+    integrate();
+    return _mass;
+}
+
+float SimPlant::noise(float amplitude)
+{
+    // Sum of three uniforms: cheap, bounded, roughly normal
+    long sum = random(1000) + random(1000) + random(1000) - 1500;
+    return amplitude * sum / 500.0f;
+}
+
+float SimPlant::measuredTemperature()
+{
+    return temperature() + noise(_params.tempNoise);
+}
+
+float SimPlant::measuredMass()
+{
+    return mass() + noise(_params.massNoise);
+}
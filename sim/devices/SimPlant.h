@@ -0,0 +1,84 @@
+#ifndef SIM_PLANT_H
+#define SIM_PLANT_H
+
+/**
+ * @file SimPlant.h
+ * @brief Physical model of the curing barn behind the fake sensors
+ *
+ * - Temperature: first-order heating towards heaterTemp while the SSR
+ *   output (RELAY_PIN1) is HIGH, cooling towards ambientTemp otherwise,
+ *   so main.cpp's two-point control runs closed loop.
+ * - Mass: tobacco dries exponentially from initialMass towards dryMass;
+ *   the drying rate scales with the temperature above ambient.
+ *
+ * The model integrates lazily from the last query, so reading it at any
+ * rate gives the same trajectory. Readings get seeded Gaussian-ish noise.
+ */
+
+#include <stdint.h>
+
+struct SimPlantParams
+{
+    float ambientTemp;     // °C
+    float heaterTemp;      // Temperature the heater would settle at (°C)
+    float heatTau;         // Time constant with the heater on (s)
+    float coolTau;         // Time constant with the heater off (s)
+    float initialMass;     // kg on the load cell at start
+    float dryMass;         // kg once fully dried
+    float dryTau;          // Drying time constant at heaterTemp (s)
+    float tempNoise;       // RTD noise amplitude (°C)
+    float massNoise;       // Load-cell noise amplitude (kg)
+    uint8_t heaterPin;     // Output that drives the heater (RELAY_PIN1)
+};
+
+class SimPlant
+{
+public:
+    static SimPlantParams &params() { return _params; }
+
+    /**
+     * @brief Reset to the initial state with the current parameters
+     */
+    static void reset();
+
+    /**
+     * @brief Air temperature now (°C), no noise
+     */
+    static float temperature();
+
+    /**
+     * @brief Mass on the load cell now (kg), no noise
+     */
+    static float mass();
+
+    /**
+     * @brief Noisy readings as a sensor would see them
+     */
+    static float measuredTemperature();
+    static float measuredMass();
+
+    /**
+     * @brief Fault bits the MAX31865 reports (0 = none)
+     */
+    static uint8_t rtdFault() { return _rtdFault; }
+    static void setRtdFault(uint8_t fault) { _rtdFault = fault; }
+
+    /**
+     * @brief Load cell disconnected (HX711 never ready)
+     */
+    static bool loadCellPresent() { return _loadCellPresent; }
+    static void setLoadCellPresent(bool present) { _loadCellPresent = present; }
+
+private:
+    static SimPlantParams _params;
+    static float _temp;
+    static float _mass;
+    static uint64_t _lastUs;
+    static uint8_t _rtdFault;
+    static bool _loadCellPresent;
+
+    static void integrate();
+    static float noise(float amplitude);
+};
+
+#endif
@@ -0,0 +1,260 @@
+/**
+ * @file ESP8266WiFi.cpp
+ * @brief Station-mode WiFi for the host build
+ */
+
+#include "ESP8266WiFi.h"
+
+// Station disconnect reasons used by the SDK
+static const uint8_t REASON_ASSOC_LEAVE = 8;
+static const uint8_t REASON_BEACON_TIMEOUT = 200;
+
+// DHCP lease handed out by the simulated AP
+static const IPAddress DHCP_IP(192, 168, 4, 20);
+static const IPAddress DHCP_GATEWAY(192, 168, 4, 1);
+static const IPAddress DHCP_MASK(255, 255, 255, 0);
+
+template <typename Event>
+class WiFiEventHandlerImpl : public WiFiEventHandlerOpaque
+{
+public:
+    explicit WiFiEventHandlerImpl(std::function<void(const Event &)> f) : handler(f) {}
+    std::function<void(const Event &)> handler;
+};
+
+template <typename Event>
+static WiFiEventHandler addHandler(std::vector<std::weak_ptr<WiFiEventHandlerOpaque> > &list,
+                                   std::function<void(const Event &)> f)
+{
+    WiFiEventHandler handler = std::make_shared<WiFiEventHandlerImpl<Event> >(f);
+    list.push_back(handler);
+    return handler;
+}
+
+// Dropped handlers (the owner let go of the WiFiEventHandler) are skipped
+template <typename Event>
+static void fire(std::vector<std::weak_ptr<WiFiEventHandlerOpaque> > &list, const Event &event)
+{
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        WiFiEventHandler handler = list[i].lock();
+        if (handler)
+        {
+            static_cast<WiFiEventHandlerImpl<Event> *>(handler.get())->handler(event);
+        }
+    }
+}
+
+bool SimWiFi::_apUp = true;
+uint32_t SimWiFi::_connectMs = 3000;
+uint32_t SimWiFi::_fastConnectMs = 400;
+int32_t SimWiFi::_rssi = -62;
+unsigned long SimWiFi::_connects = 0;
+unsigned long SimWiFi::_drops = 0;
+
+const uint8_t *SimWiFi::bssid()
+{
+    static const uint8_t BSSID[6] = {0x02, 0x1A, 0x11, 0xAB, 0xCD, 0xEF};
+    return BSSID;
+}
+
+WiFiClass WiFi;
+
+WiFiClass::WiFiClass()
+    : _mode(WIFI_STA),
+      _autoReconnect(true),
+      _state(LINK_IDLE),
+      _connectAtUs(0),
+      _staticIp(false)
+{
+    SimClock::addTask(this);
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase, int32_t channel,
+                             const uint8_t *bssid, bool connect)
+{
+    (void)passphrase;
+    _ssid = ssid ? ssid : "";
+
+    if (_state == LINK_CONNECTED)
+    {
+        linkDown(REASON_ASSOC_LEAVE);
+    }
+
+    if (!connect)
+    {
+        _state = LINK_IDLE;
+        return WL_DISCONNECTED;
+    }
+
+    // A known BSSID + channel skips the scan; a static IP skips DHCP
+    bool fast = bssid && channel == SimWiFi::CHANNEL && memcmp(bssid, SimWiFi::bssid(), 6) == 0;
+    uint32_t connectMs = fast && _staticIp ? SimWiFi::fastConnectMs() : SimWiFi::connectMs();
+
+    _state = LINK_CONNECTING;
+    _connectAtUs = SimClock::nowMicros() + (uint64_t)connectMs * 1000;
+    return WL_DISCONNECTED;
+}
+
+bool WiFiClass::config(IPAddress localIp, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2)
+{
+    (void)dns2;
+    _staticIp = localIp.isSet();
+    _ip = localIp;
+    _gateway = gateway;
+    _mask = subnet;
+    _dns = dns1;
+    return true;
+}
+
+bool WiFiClass::disconnect(bool wifioff)
+{
+    if (wifioff)
+    {
+        _mode = WIFI_OFF;
+    }
+    if (_state == LINK_CONNECTED)
+    {
+        linkDown(REASON_ASSOC_LEAVE);
+    }
+    _state = LINK_IDLE;
+    return true;
+}
+
+bool WiFiClass::reconnect()
+{
+    begin(_ssid.c_str());
+    return true;
+}
+
+wl_status_t WiFiClass::status()
+{
+    run(SimClock::nowMicros());
+    switch (_state)
+    {
+    case LINK_CONNECTED:
+        return WL_CONNECTED;
+    case LINK_CONNECTING:
+        return WL_DISCONNECTED;
+    default:
+        return WL_IDLE_STATUS;
+    }
+}
+
+void WiFiClass::run(uint64_t nowUs)
+{
+    if (_state == LINK_CONNECTING && SimWiFi::apUp() && nowUs >= _connectAtUs)
+    {
+        linkUp();
+    }
+    else if (_state == LINK_CONNECTED && !SimWiFi::apUp())
+    {
+        linkDown(REASON_BEACON_TIMEOUT);
+        _state = _autoReconnect ? LINK_CONNECTING : LINK_IDLE;
+        _connectAtUs = nowUs + (uint64_t)SimWiFi::connectMs() * 1000;
+    }
+    else if (_state == LINK_CONNECTING && !SimWiFi::apUp())
+    {
+        // Scanning for an AP that is not there: try again once it is back
+        _connectAtUs = nowUs + (uint64_t)SimWiFi::connectMs() * 1000;
+    }
+}
+
+void WiFiClass::linkUp()
+{
+    _state = LINK_CONNECTED;
+    if (!_staticIp)
+    {
+        _ip = DHCP_IP;
+        _gateway = DHCP_GATEWAY;
+        _mask = DHCP_MASK;
+        _dns = DHCP_GATEWAY;
+    }
+    SimWiFi::_connects++;
+
+    WiFiEventStationModeConnected connected;
+    connected.ssid = _ssid;
+    memcpy(connected.bssid, SimWiFi::bssid(), 6);
+    connected.channel = SimWiFi::CHANNEL;
+    fire(_connectedHandlers, connected);
+
+    WiFiEventStationModeGotIP gotIp;
+    gotIp.ip = _ip;
+    gotIp.mask = _mask;
+    gotIp.gw = _gateway;
+    fire(_gotIpHandlers, gotIp);
+}
+
+void WiFiClass::linkDown(uint8_t reason)
+{
+    _state = LINK_IDLE;
+    SimWiFi::_drops++;
+
+    WiFiEventStationModeDisconnected event;
+    event.ssid = _ssid;
+    memcpy(event.bssid, SimWiFi::bssid(), 6);
+    event.reason = reason;
+    fire(_disconnectedHandlers, event);
+}
+
+IPAddress WiFiClass::localIP()
+{
+    return _state == LINK_CONNECTED ? _ip : IPAddress();
+}
+
+IPAddress WiFiClass::gatewayIP()
+{
+    return _state == LINK_CONNECTED ? _gateway : IPAddress();
+}
+
+IPAddress WiFiClass::subnetMask()
+{
+    return _state == LINK_CONNECTED ? _mask : IPAddress();
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t index)
+{
+    return _state == LINK_CONNECTED && index == 0 ? _dns : IPAddress();
+}
+
+uint8_t *WiFiClass::BSSID()
+{
+    static uint8_t bssid[6];
+    memcpy(bssid, SimWiFi::bssid(), 6);
+    return bssid;
+}
+
+int32_t WiFiClass::channel()
+{
+    return SimWiFi::CHANNEL;
+}
+
+int32_t WiFiClass::RSSI()
+{
+    return _state == LINK_CONNECTED ? SimWiFi::rssi() : 31; // 31: not connected
+}
+
+int WiFiClass::hostByName(const char *host, IPAddress &result)
+{
+    if (status() != WL_CONNECTED || !host || !*host)
+    {
+        return 0;
+    }
+    result = IPAddress(10, 0, 0, 1);
+    return 1;
+}
+
+WiFiEventHandler WiFiClass::onStationModeConnected(std::function<void(const WiFiEventStationModeConnected &)> f)
+{
+    return addHandler(_connectedHandlers, f);
+}
+
+WiFiEventHandler WiFiClass::onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected &)> f)
+{
+    return addHandler(_disconnectedHandlers, f);
+}
+
+WiFiEventHandler WiFiClass::onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP &)> f)
+{
+    return addHandler(_gotIpHandlers, f);
+}
@@ -0,0 +1,174 @@
+#ifndef ESP8266WIFI_H
+#define ESP8266WIFI_H
+
+/**
+ * @file ESP8266WiFi.h
+ * @brief Station-mode WiFi for the host build
+ *
+ * A single simulated access point. begin() completes after connectMs of
+ * virtual time (fastConnectMs when the cached BSSID + channel are passed,
+ * as WiFiConnection does), then the got-IP handlers fire. Taking the AP
+ * down (SimWiFi::setApUp(false)) drops the link and fires the
+ * disconnected handlers; nothing connects again until it is back up.
+ * Events are delivered from delay()/yield(), like the SDK does.
+ */
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+typedef enum
+{
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} WiFiMode_t;
+
+struct WiFiEventStationModeConnected
+{
+    String ssid;
+    uint8_t bssid[6];
+    uint8_t channel;
+};
+
+struct WiFiEventStationModeDisconnected
+{
+    String ssid;
+    uint8_t bssid[6];
+    uint8_t reason;
+};
+
+struct WiFiEventStationModeGotIP
+{
+    IPAddress ip;
+    IPAddress mask;
+    IPAddress gw;
+};
+
+class WiFiEventHandlerOpaque
+{
+public:
+    virtual ~WiFiEventHandlerOpaque() {}
+};
+
+typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+class WiFiClass : public SimTask
+{
+public:
+    WiFiClass();
+
+    wl_status_t begin(const char *ssid, const char *passphrase = NULL, int32_t channel = 0,
+                      const uint8_t *bssid = NULL, bool connect = true);
+    bool config(IPAddress localIp, IPAddress gateway, IPAddress subnet,
+                IPAddress dns1 = (uint32_t)0, IPAddress dns2 = (uint32_t)0);
+    bool disconnect(bool wifioff = false);
+    bool reconnect();
+    bool isConnected() { return status() == WL_CONNECTED; }
+    wl_status_t status();
+
+    bool mode(WiFiMode_t mode) { _mode = mode; return true; }
+    WiFiMode_t getMode() const { return _mode; }
+    void persistent(bool persistent) { (void)persistent; }
+    bool setAutoReconnect(bool autoReconnect) { _autoReconnect = autoReconnect; return true; }
+    bool getAutoReconnect() const { return _autoReconnect; }
+    bool hostname(const char *name) { (void)name; return true; }
+
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+    String macAddress() { return "5C:CF:7F:00:00:01"; }
+    String SSID() { return _ssid; }
+    uint8_t *BSSID();
+    int32_t channel();
+    int32_t RSSI();
+
+    int hostByName(const char *host, IPAddress &result);
+
+    WiFiEventHandler onStationModeConnected(std::function<void(const WiFiEventStationModeConnected &)> f);
+    WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected &)> f);
+    WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP &)> f);
+
+    void run(uint64_t nowUs) override;
+
+private:
+    enum LinkState
+    {
+        LINK_IDLE,
+        LINK_CONNECTING,
+        LINK_CONNECTED
+    };
+
+    WiFiMode_t _mode;
+    bool _autoReconnect;
+    String _ssid;
+    LinkState _state;
+    uint64_t _connectAtUs;
+    bool _staticIp;
+    IPAddress _ip, _gateway, _mask, _dns;
+
+    std::vector<std::weak_ptr<WiFiEventHandlerOpaque> > _connectedHandlers;
+    std::vector<std::weak_ptr<WiFiEventHandlerOpaque> > _disconnectedHandlers;
+    std::vector<std::weak_ptr<WiFiEventHandlerOpaque> > _gotIpHandlers;
+
+    void linkUp();
+    void linkDown(uint8_t reason);
+};
+
+extern WiFiClass WiFi;
+
+/**
+ * @class SimWiFi
+ * @brief The simulated access point
+ */
+class SimWiFi
+{
+public:
+    static void setApUp(bool up) { _apUp = up; }
+    static bool apUp() { return _apUp; }
+
+    /**
+     * @brief Association + DHCP time for a full connect / a cached fast connect
+     */
+    static void setConnectTime(uint32_t fullMs, uint32_t fastMs)
+    {
+        _connectMs = fullMs;
+        _fastConnectMs = fastMs;
+    }
+    static uint32_t connectMs() { return _connectMs; }
+    static uint32_t fastConnectMs() { return _fastConnectMs; }
+
+    static void setRssi(int32_t rssi) { _rssi = rssi; }
+    static int32_t rssi() { return _rssi; }
+
+    static const uint8_t CHANNEL = 6;
+    static const uint8_t *bssid();
+
+    static unsigned long connects() { return _connects; }
+    static unsigned long drops() { return _drops; }
+
+private:
+    static bool _apUp;
+    static uint32_t _connectMs;
+    static uint32_t _fastConnectMs;
+    static int32_t _rssi;
+    static unsigned long _connects;
+    static unsigned long _drops;
+
+    friend class WiFiClass;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * @file Esp.cpp
+ * @brief ESP8266 system object for the host build
+ */
+
+#include <Arduino.h>
+
+EspClass ESP;
+
+void EspClass::getHeapStats(uint32_t *hfree, uint32_t *hmax, uint8_t *hfrag) const
+{
+    if (hfree)
+        *hfree = getFreeHeap();
+    if (hmax)
+        *hmax = getMaxFreeBlockSize();
+    if (hfrag)
+        *hfrag = getHeapFragmentation();
+}
+
+uint32_t EspClass::getCycleCount() const
+{
+    return (uint32_t)(SimClock::nowMicros() * 80);
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size)
+{
+    if (offset * 4 + size > RTC_USER_BYTES)
+    {
+        return false;
+    }
+    memcpy(data, _rtc + offset * 4, size);
+    return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size)
+{
+    if (offset * 4 + size > RTC_USER_BYTES)
+    {
+        return false;
+    }
+    memcpy(_rtc + offset * 4, data, size);
+    return true;
+}
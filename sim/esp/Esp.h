@@ -0,0 +1,71 @@
+#ifndef ESP_H
+#define ESP_H
+
+/**
+ * @file Esp.h
+ * @brief ESP8266 system object (ESP.*) for the host build
+ *
+ * Heap figures come from the ESP8266 heap model (SimHeap.h), which holds
+ * every String and Firebase document the firmware allocates; setHeap()
+ * pins them to fixed values instead (heap 0 0 0 returns to the model).
+ * RTC user memory is a 512-byte array that survives restart() within one
+ * run.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SimHeap.h"
+
+class EspClass
+{
+public:
+    uint32_t getFreeHeap() const { return _heapPinned ? _freeHeap : SimHeap::freeBytes(); }
+    uint32_t getMaxFreeBlockSize() const { return _heapPinned ? _maxFreeBlock : SimHeap::maxFreeBlock(); }
+    uint8_t getHeapFragmentation() const { return _heapPinned ? _fragmentation : SimHeap::fragmentation(); }
+    void getHeapStats(uint32_t *hfree, uint32_t *hmax, uint8_t *hfrag) const;
+
+    uint32_t getChipId() const { return 0x00C0FFEE; }
+    uint32_t getCycleCount() const;
+    uint32_t getCpuFreqMHz() const { return 80; }
+    const char *getSdkVersion() const { return "host"; }
+    const char *getResetReason() const { return _restarts ? "Software/System restart" : "Power On"; }
+
+    /**
+     * @param offset Offset in 4-byte blocks (0..127)
+     * @param size Bytes to copy
+     */
+    bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size);
+    bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size);
+
+    /**
+     * @brief Counted only; the runner decides what a restart means
+     */
+    void restart() { _restarts++; }
+    void reset() { _restarts++; }
+
+    // ---- Simulation side ----
+
+    void setHeap(uint32_t freeHeap, uint32_t maxFreeBlock, uint8_t fragmentation)
+    {
+        _freeHeap = freeHeap;
+        _maxFreeBlock = maxFreeBlock;
+        _fragmentation = fragmentation;
+        _heapPinned = freeHeap != 0;
+    }
+
+    unsigned long restarts() const { return _restarts; }
+
+private:
+    static const size_t RTC_USER_BYTES = 512;
+
+    bool _heapPinned = false;
+    uint32_t _freeHeap = 0;
+    uint32_t _maxFreeBlock = 0;
+    uint8_t _fragmentation = 0;
+    unsigned long _restarts = 0;
+    uint8_t _rtc[RTC_USER_BYTES] = {0};
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,444 @@
+/**
+ * @file Firebase_ESP_Client.cpp
+ * @brief Firebase client on SimCloud
+ */
+
+#include "Firebase_ESP_Client.h"
+
+// After a failed token request, wait this long before trying again
+static const unsigned long TOKEN_RETRY_MS = 10 * 1000;
+
+Firebase_ESP_Client Firebase;
+
+// ---- FirebaseJson ----
+
+FirebaseJson::FirebaseJson()
+    : _verbatim(false),
+      _rawValid(false)
+{
+}
+
+FirebaseJson::~FirebaseJson()
+{
+    clear();
+}
+
+void FirebaseJson::account(size_t bytes)
+{
+    void *block = SimHeap::alloc(bytes);
+    if (block)
+    {
+        _blocks.push_back(block);
+    }
+}
+
+void FirebaseJson::clear()
+{
+    for (size_t i = 0; i < _blocks.size(); i++)
+    {
+        SimHeap::free(_blocks[i]);
+    }
+    _blocks.clear();
+    _root.children.clear();
+    _verbatim = false;
+    _raw = "";
+    _rawValid = false;
+}
+
+FirebaseJson &FirebaseJson::set(const char *path, const char *value)
+{
+    std::string quoted = "\"";
+    for (const char *p = value ? value : ""; *p; p++)
+    {
+        char c = *p;
+        if (c == '"' || c == '\\')
+        {
+            quoted += '\\';
+            quoted += c;
+        }
+        else if ((uint8_t)c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (uint8_t)c);
+            quoted += escaped;
+        }
+        else
+        {
+            quoted += c;
+        }
+    }
+    quoted += '"';
+    return setRaw(path, quoted.c_str());
+}
+
+FirebaseJson &FirebaseJson::set(const char *path, float value)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%.7g", (double)value);
+    return setRaw(path, buf);
+}
+
+FirebaseJson &FirebaseJson::set(const char *path, double value)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", value);
+    return setRaw(path, buf);
+}
+
+FirebaseJson &FirebaseJson::setInteger(const char *path, long long value)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%lld", value);
+    return setRaw(path, buf);
+}
+
+FirebaseJson &FirebaseJson::setRaw(const char *path, const char *value)
+{
+    if (_verbatim)
+    {
+        clear();
+    }
+    _rawValid = false;
+
+    Node *node = &_root;
+    const char *p = path;
+    while (*p)
+    {
+        const char *end = strchr(p, '/');
+        size_t length = end ? (size_t)(end - p) : strlen(p);
+        if (length)
+        {
+            std::string key(p, length);
+            Node *child = NULL;
+            for (size_t i = 0; i < node->children.size(); i++)
+            {
+                if (node->children[i].key == key)
+                {
+                    child = &node->children[i];
+                    break;
+                }
+            }
+            if (!child)
+            {
+                node->children.push_back(Node());
+                child = &node->children.back();
+                child->key = key;
+                account(NODE_BYTES);
+                account(length + 1);
+            }
+            node = child;
+            node->value.clear(); // Becomes an object, or gets the value below
+        }
+        p += length + (end ? 1 : 0);
+    }
+
+    node->children.clear();
+    node->value = value;
+    account(strlen(value) + 1);
+    return *this;
+}
+
+bool FirebaseJson::setJsonData(const String &data)
+{
+    clear();
+    _verbatim = true;
+    _raw = data;
+    _rawValid = true;
+    return data.length() > 0;
+}
+
+const char *FirebaseJson::raw()
+{
+    if (!_rawValid)
+    {
+        std::string out;
+        serialize(_root, out);
+        _raw = out.c_str();
+        _rawValid = true;
+    }
+    return _raw.c_str();
+}
+
+void FirebaseJson::serialize(const Node &node, std::string &out)
+{
+    if (!node.value.empty())
+    {
+        out += node.value;
+        return;
+    }
+
+    out += '{';
+    for (size_t i = 0; i < node.children.size(); i++)
+    {
+        if (i)
+        {
+            out += ',';
+        }
+        out += '"';
+        out += node.children[i].key;
+        out += "\":";
+        serialize(node.children[i], out);
+    }
+    out += '}';
+}
+
+// ---- Firestore / RTDB ----
+
+bool FB_Firestore::patchDocument(FirebaseData *fbdo, const String &projectId, const String &databaseId,
+                                 const String &documentPath, const String &content, const String &updateMask)
+{
+    (void)projectId;
+    (void)databaseId;
+    (void)updateMask;
+    return Firebase.request(fbdo, "PATCH", "firestore/" + documentPath, content);
+}
+
+bool FB_Firestore::createDocument(FirebaseData *fbdo, const String &projectId, const String &databaseId,
+                                  const String &documentPath, const String &content)
+{
+    (void)projectId;
+    (void)databaseId;
+    return Firebase.request(fbdo, "POST", "firestore/" + documentPath, content);
+}
+
+bool FB_Firestore::getDocument(FirebaseData *fbdo, const String &projectId, const String &databaseId,
+                               const String &documentPath, const String &mask)
+{
+    (void)projectId;
+    (void)databaseId;
+    (void)mask;
+    return Firebase.request(fbdo, "GET", "firestore/" + documentPath, "");
+}
+
+bool FB_RTDB::setJSON(FirebaseData *fbdo, const String &path, FirebaseJson *json)
+{
+    return Firebase.request(fbdo, "PUT", "rtdb" + path, json ? json->raw() : "null");
+}
+
+bool FB_RTDB::getInt(FirebaseData *fbdo, const String &path)
+{
+    if (!Firebase.request(fbdo, "GET", "rtdb" + path, ""))
+    {
+        return false;
+    }
+    char c = fbdo->payload().length() ? fbdo->payload()[0] : '\0';
+    if (!isdigit((unsigned char)c) && c != '-')
+    {
+        fbdo->_error = "data type mismatch";
+        return false;
+    }
+    return true;
+}
+
+bool FB_RTDB::getJSON(FirebaseData *fbdo, const String &path)
+{
+    if (!Firebase.request(fbdo, "GET", "rtdb" + path, ""))
+    {
+        return false;
+    }
+    if (!fbdo->payload().startsWith("{"))
+    {
+        fbdo->_error = "data type mismatch";
+        return false;
+    }
+    return true;
+}
+
+// ---- Client ----
+
+Firebase_ESP_Client::Firebase_ESP_Client()
+    : _config(NULL),
+      _begun(false),
+      _reconnectWiFi(true),
+      _expiresAtMs(0),
+      _lastTokenAttemptMs(0),
+      _status(token_status_uninitialized),
+      _requests(0),
+      _refreshes(0)
+{
+}
+
+bool Firebase_ESP_Client::request(FirebaseData *fbdo, const char *method, const String &path, const String &body)
+{
+    if (!fbdo)
+    {
+        return false;
+    }
+    _requests++;
+    fbdo->_payload = "";
+
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        fbdo->_httpCode = SIM_HTTP_NOT_CONNECTED;
+        fbdo->_error = "not connected";
+        return false;
+    }
+
+    SimCloud &cloud = SimCloud::current();
+    String response;
+    int code = cloud.handle(method, path, body, response);
+    uint32_t latency = cloud.latencyMs(method, path);
+
+    // The client blocks until the reply or its own timeout
+    unsigned long timeout = _config ? _config->timeout.serverResponse : 10 * 1000;
+    SimClock::advance((uint64_t)(code == SIM_HTTP_READ_TIMEOUT || latency > timeout ? timeout : latency) * 1000);
+    if (latency > timeout)
+    {
+        code = SIM_HTTP_READ_TIMEOUT;
+    }
+
+    fbdo->_httpCode = code;
+    if (code >= 200 && code < 300)
+    {
+        fbdo->_error = "";
+        fbdo->_payload = response;
+        return true;
+    }
+
+    switch (code)
+    {
+    case SIM_HTTP_CONNECTION_REFUSED:
+        fbdo->_error = "connection refused";
+        break;
+    case SIM_HTTP_NOT_CONNECTED:
+        fbdo->_error = "not connected";
+        break;
+    case SIM_HTTP_CONNECTION_LOST:
+        fbdo->_error = "connection lost";
+        break;
+    case SIM_HTTP_READ_TIMEOUT:
+        fbdo->_error = "response read timed out";
+        break;
+    default:
+    {
+        // Firestore/RTDB error bodies carry the status name (NOT_FOUND, ...)
+        int start = response.indexOf("\"status\":\"");
+        int end = start >= 0 ? response.indexOf('"', start + 10) : -1;
+        fbdo->_error = end > start ? response.substring(start + 10, end) : "HTTP " + String(code);
+        break;
+    }
+    }
+    return false;
+}
+
+String Firebase_ESP_Client::tokenField(const String &json, const char *name)
+{
+    String key = String("\"") + name + "\":\"";
+    int start = json.indexOf(key);
+    if (start < 0)
+    {
+        return "";
+    }
+    start += key.length();
+    int end = json.indexOf('"', start);
+    return end > start ? json.substring(start, end) : "";
+}
+
+bool Firebase_ESP_Client::issueToken(const char *path, TokenInfo &info)
+{
+    FirebaseData data;
+    String body = _refreshToken.length() ? "{\"refresh_token\":\"" + _refreshToken + "\"}" : "{}";
+    if (!request(&data, "POST", path, body))
+    {
+        info.status = token_status_error;
+        info.error.code = data.httpCode();
+        info.error.message = data.errorReason();
+        return false;
+    }
+
+    _idToken = tokenField(data.payload(), "idToken");
+    _refreshToken = tokenField(data.payload(), "refreshToken");
+    _expiresAtMs = millis() + TOKEN_LIFETIME_S * 1000UL;
+    info.status = token_status_ready;
+    info.error.code = 0;
+    info.error.message = "";
+    return true;
+}
+
+void Firebase_ESP_Client::notify(const TokenInfo &info)
+{
+    bool changed = info.status != _status || info.status == token_status_error;
+    _status = info.status;
+    if (changed && _config && _config->token_status_callback)
+    {
+        _config->token_status_callback(info);
+    }
+}
+
+bool Firebase_ESP_Client::signUp(FirebaseConfig *config, FirebaseAuth *auth, const String &email,
+                                 const String &password)
+{
+    (void)email;
+    (void)password;
+    _config = config;
+    if (auth)
+    {
+        auth->user.email = "";
+        auth->user.password = "";
+    }
+
+    _refreshToken = "";
+    TokenInfo info;
+    if (!issueToken("auth/signUp", info))
+    {
+        config->signer.signupError.message = info.error.message;
+        return false;
+    }
+    config->signer.signupError.message = "";
+    return true;
+}
+
+void Firebase_ESP_Client::setIdToken(FirebaseConfig *config, const String &idToken, size_t expire,
+                                     const String &refreshToken)
+{
+    _config = config;
+    _idToken = idToken;
+    _refreshToken = refreshToken;
+    _expiresAtMs = idToken.length() ? millis() + (uint64_t)expire * 1000 : 0;
+}
+
+void Firebase_ESP_Client::begin(FirebaseConfig *config, FirebaseAuth *auth)
+{
+    (void)auth;
+    _config = config;
+    _begun = true;
+    ready();
+}
+
+bool Firebase_ESP_Client::ready()
+{
+    if (!_begun || !_config)
+    {
+        return false;
+    }
+
+    uint64_t now = millis();
+    uint64_t margin = (uint64_t)_config->signer.preRefreshSeconds * 1000;
+    if (_idToken.length() && now + margin < _expiresAtMs)
+    {
+        if (_status != token_status_ready)
+        {
+            TokenInfo info;
+            info.status = token_status_ready;
+            notify(info);
+        }
+        return true;
+    }
+
+    // Token missing or about to expire: refresh, but not on every call
+    // while the network is failing
+    if (_status == token_status_error && now - _lastTokenAttemptMs < TOKEN_RETRY_MS)
+    {
+        return false;
+    }
+    _lastTokenAttemptMs = now;
+
+    TokenInfo info;
+    info.status = token_status_on_refresh;
+    notify(info);
+
+    _refreshes++;
+    issueToken("auth/refresh", info);
+    notify(info);
+    return info.status == token_status_ready;
+}
@@ -0,0 +1,235 @@
+#ifndef FIREBASE_ESP_CLIENT_H
+#define FIREBASE_ESP_CLIENT_H
+
+/**
+ * @file Firebase_ESP_Client.h
+ * @brief The part of the Firebase ESP client the firmware uses, on SimCloud
+ *
+ * Calls block for SimCloud::latencyMs() of virtual time (background tasks
+ * keep running, as the real client yields while waiting) and fail fast
+ * with "not connected" while WiFi is down. ID tokens last an hour of
+ * virtual time; ready() refreshes them preRefreshSeconds early and reports
+ * through token_status_callback.
+ */
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <string>
+#include <vector>
+#include "SimCloud.h"
+
+enum firebase_auth_token_status
+{
+    token_status_uninitialized,
+    token_status_on_initialize,
+    token_status_on_signing,
+    token_status_on_request,
+    token_status_on_refresh,
+    token_status_ready,
+    token_status_error
+};
+
+enum firebase_auth_token_type
+{
+    token_type_undefined,
+    token_type_id_token
+};
+
+struct TokenInfo
+{
+    firebase_auth_token_type type = token_type_id_token;
+    firebase_auth_token_status status = token_status_uninitialized;
+    struct
+    {
+        int code = 0;
+        String message;
+    } error;
+};
+
+typedef void (*TokenStatusCallback)(TokenInfo);
+
+struct FirebaseConfig
+{
+    String api_key;
+    String database_url;
+    struct
+    {
+        unsigned long serverResponse = 10 * 1000;
+    } timeout;
+    TokenStatusCallback token_status_callback = NULL;
+    struct
+    {
+        unsigned long preRefreshSeconds = 5 * 60;
+        struct
+        {
+            String message;
+        } signupError;
+    } signer;
+};
+
+struct FirebaseAuth
+{
+    struct
+    {
+        String email;
+        String password;
+    } user;
+};
+
+/**
+ * @class FirebaseJson
+ * @brief JSON built from slash-separated paths ("fields/temp/doubleValue")
+ *
+ * Like the library's, every node and every key/value string is a heap
+ * allocation on the ESP heap model (SimHeap), released by clear() or the
+ * destructor; raw() adds the serialised copy. Paths are plain C strings,
+ * as the library's templated set() takes them.
+ */
+class FirebaseJson
+{
+public:
+    FirebaseJson();
+    ~FirebaseJson();
+    FirebaseJson(const FirebaseJson &) = delete;
+    FirebaseJson &operator=(const FirebaseJson &) = delete;
+
+    FirebaseJson &set(const char *path, const char *value);
+    FirebaseJson &set(const char *path, const String &value) { return set(path, value.c_str()); }
+    FirebaseJson &set(const char *path, int value) { return setInteger(path, value); }
+    FirebaseJson &set(const char *path, unsigned int value) { return setInteger(path, value); }
+    FirebaseJson &set(const char *path, long value) { return setInteger(path, value); }
+    FirebaseJson &set(const char *path, unsigned long value) { return setInteger(path, (long long)value); }
+    FirebaseJson &set(const char *path, float value);
+    FirebaseJson &set(const char *path, double value);
+    FirebaseJson &set(const char *path, bool value) { return setRaw(path, value ? "true" : "false"); }
+
+    /**
+     * @brief Replace the whole document with already serialised JSON
+     */
+    bool setJsonData(const String &data);
+
+    const char *raw();
+    void toString(String &out) { out = raw(); }
+    void clear();
+
+private:
+    // One cJSON-style node on a 32-bit target: links, type, value pointers
+    static const size_t NODE_BYTES = 36;
+
+    struct Node
+    {
+        std::string key;
+        std::string value; // Serialised scalar; empty for objects
+        std::vector<Node> children;
+    };
+
+    Node _root;
+    bool _verbatim;
+    String _raw;
+    bool _rawValid;
+    std::vector<void *> _blocks; // Node and string allocations on SimHeap
+
+    FirebaseJson &setInteger(const char *path, long long value);
+    FirebaseJson &setRaw(const char *path, const char *value);
+    void account(size_t bytes);
+    static void serialize(const Node &node, std::string &out);
+};
+
+class FirebaseData
+{
+public:
+    FirebaseData() : _httpCode(0) {}
+
+    String errorReason() const { return _error; }
+    int httpCode() const { return _httpCode; }
+    String payload() const { return _payload; }
+    int intData() const { return _payload.toInt(); }
+    float floatData() const { return _payload.toFloat(); }
+    String stringData() const { return _payload; }
+    String jsonString() const { return _payload; }
+
+private:
+    int _httpCode;
+    String _error;
+    String _payload;
+
+    friend class Firebase_ESP_Client;
+    friend class FB_RTDB;
+};
+
+class Firebase_ESP_Client;
+
+class FB_Firestore
+{
+public:
+    bool patchDocument(FirebaseData *fbdo, const String &projectId, const String &databaseId,
+                       const String &documentPath, const String &content, const String &updateMask);
+    bool createDocument(FirebaseData *fbdo, const String &projectId, const String &databaseId,
+                        const String &documentPath, const String &content);
+    bool getDocument(FirebaseData *fbdo, const String &projectId, const String &databaseId,
+                     const String &documentPath, const String &mask = "");
+};
+
+class FB_RTDB
+{
+public:
+    bool setJSON(FirebaseData *fbdo, const String &path, FirebaseJson *json);
+    bool getInt(FirebaseData *fbdo, const String &path);
+    bool getJSON(FirebaseData *fbdo, const String &path);
+};
+
+class Firebase_ESP_Client
+{
+public:
+    Firebase_ESP_Client();
+
+    FB_Firestore Firestore;
+    FB_RTDB RTDB;
+
+    void begin(FirebaseConfig *config, FirebaseAuth *auth);
+    bool signUp(FirebaseConfig *config, FirebaseAuth *auth, const String &email, const String &password);
+    void setIdToken(FirebaseConfig *config, const String &idToken, size_t expire = 3600,
+                    const String &refreshToken = "");
+    void reconnectWiFi(bool reconnect) { _reconnectWiFi = reconnect; }
+
+    /**
+     * @brief Session usable; refreshes the token when it is about to expire
+     */
+    bool ready();
+    bool authenticated() const { return _idToken.length() > 0; }
+
+    String getToken() const { return _idToken; }
+    String getRefreshToken() const { return _refreshToken; }
+
+    // ---- Simulation side ----
+
+    unsigned long requests() const { return _requests; }
+    unsigned long refreshes() const { return _refreshes; }
+
+    /**
+     * @brief Run one request against SimCloud, blocking for its latency
+     */
+    bool request(FirebaseData *fbdo, const char *method, const String &path, const String &body);
+
+private:
+    static const unsigned long TOKEN_LIFETIME_S = 3600;
+
+    FirebaseConfig *_config;
+    bool _begun;
+    bool _reconnectWiFi;
+    String _idToken;
+    String _refreshToken;
+    uint64_t _expiresAtMs;
+    uint64_t _lastTokenAttemptMs;
+    firebase_auth_token_status _status;
+    unsigned long _requests;
+    unsigned long _refreshes;
+
+    bool issueToken(const char *path, TokenInfo &info);
+    void notify(const TokenInfo &info);
+    static String tokenField(const String &json, const char *name);
+};
+
+extern Firebase_ESP_Client Firebase;
+
+#endif
@@ -0,0 +1,18 @@
+/**
+ * @file IPAddress.cpp
+ * @brief IPv4 address for the host build
+ */
+
+#include "IPAddress.h"
+
+String IPAddress::toString() const
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buf);
+}
+
+size_t IPAddress::printTo(Print &p) const
+{
+    return p.print(toString());
+}
@@ -0,0 +1,29 @@
+#ifndef IPADDRESS_H
+#define IPADDRESS_H
+
+/**
+ * @file IPAddress.h
+ * @brief IPv4 address for the host build
+ */
+
+#include <Arduino.h>
+
+class IPAddress : public Printable
+{
+public:
+    IPAddress() : _address(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : _address((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+    IPAddress(uint32_t address) : _address(address) {}
+
+    operator uint32_t() const { return _address; }
+    uint8_t operator[](int index) const { return (_address >> (index * 8)) & 0xFF; }
+    bool isSet() const { return _address != 0; }
+    String toString() const;
+    size_t printTo(Print &p) const override;
+
+private:
+    uint32_t _address; // Network byte order, like lwIP
+};
+
+#endif
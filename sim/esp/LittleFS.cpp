@@ -0,0 +1,143 @@
+/**
+ * @file LittleFS.cpp
+ * @brief In-memory LittleFS for the host build
+ */
+
+#include "LittleFS.h"
+
+fs::FS LittleFS;
+
+namespace fs
+{
+
+File::File(std::shared_ptr<std::vector<uint8_t> > data, const String &name, bool writable, bool append)
+    : _data(data),
+      _name(name),
+      _pos(append ? data->size() : 0),
+      _writable(writable)
+{
+}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+    if (!_data || !_writable)
+    {
+        return 0;
+    }
+    if (_pos + size > _data->size())
+    {
+        _data->resize(_pos + size);
+    }
+    memcpy(_data->data() + _pos, buffer, size);
+    _pos += size;
+    LittleFS.countBytes(size);
+    return size;
+}
+
+int File::available()
+{
+    return _data && _pos < _data->size() ? (int)(_data->size() - _pos) : 0;
+}
+
+int File::read()
+{
+    return available() ? (*_data)[_pos++] : -1;
+}
+
+int File::peek()
+{
+    return available() ? (*_data)[_pos] : -1;
+}
+
+size_t File::read(uint8_t *buffer, size_t length)
+{
+    size_t n = (size_t)available();
+    if (n > length)
+    {
+        n = length;
+    }
+    if (n)
+    {
+        memcpy(buffer, _data->data() + _pos, n);
+        _pos += n;
+    }
+    return n;
+}
+
+bool File::seek(uint32_t pos)
+{
+    if (!_data || pos > _data->size())
+    {
+        return false;
+    }
+    _pos = pos;
+    return true;
+}
+
+void File::close()
+{
+    _data.reset();
+    _pos = 0;
+}
+
+bool FS::format()
+{
+    _files.clear();
+    return true;
+}
+
+File FS::open(const char *path, const char *mode)
+{
+    if (!_mounted || !path || !mode)
+    {
+        return File();
+    }
+
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t> > >::iterator it = _files.find(path);
+    bool write = mode[0] == 'w' || mode[0] == 'a';
+    bool plus = mode[1] == '+';
+
+    if (!write)
+    {
+        if (it == _files.end())
+        {
+            return File();
+        }
+        return File(it->second, path, plus, false);
+    }
+
+    _writes++;
+    if (it == _files.end() || mode[0] == 'w')
+    {
+        // "w" truncates; existing File handles keep the old contents
+        std::shared_ptr<std::vector<uint8_t> > data = std::make_shared<std::vector<uint8_t> >();
+        _files[path] = data;
+        return File(data, path, true, false);
+    }
+    return File(it->second, path, true, true);
+}
+
+bool FS::exists(const char *path) const
+{
+    return _mounted && _files.count(path) != 0;
+}
+
+bool FS::remove(const char *path)
+{
+    return _mounted && _files.erase(path) != 0;
+}
+
+bool FS::rename(const char *from, const char *to)
+{
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t> > >::iterator it = _files.find(from);
+    if (!_mounted || it == _files.end())
+    {
+        return false;
+    }
+    std::shared_ptr<std::vector<uint8_t> > data = it->second;
+    _files.erase(it);
+    _files[to] = data;
+    return true;
+}
+
+} // namespace fs
@@ -0,0 +1,95 @@
+#ifndef LITTLEFS_H
+#define LITTLEFS_H
+
+/**
+ * @file LittleFS.h
+ * @brief In-memory LittleFS for the host build
+ *
+ * Files live in a map for the whole run, so they survive a simulated
+ * restart the way flash does. Write traffic is counted because flash wear
+ * is what AuthCache/WiFiConnection/RemoteConfig are careful about.
+ */
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs
+{
+
+class File : public Stream
+{
+public:
+    File() : _pos(0), _writable(false) {}
+    File(std::shared_ptr<std::vector<uint8_t> > data, const String &name, bool writable, bool append);
+
+    explicit operator bool() const { return (bool)_data; }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t *buffer, size_t length);
+    size_t readBytes(char *buffer, size_t length) override { return read((uint8_t *)buffer, length); }
+    using Stream::readBytes;
+    void flush() override {}
+
+    bool seek(uint32_t pos);
+    size_t position() const { return _pos; }
+    size_t size() const { return _data ? _data->size() : 0; }
+    const char *name() const { return _name.c_str(); }
+    void close();
+
+    using Print::write;
+
+private:
+    std::shared_ptr<std::vector<uint8_t> > _data;
+    String _name;
+    size_t _pos;
+    bool _writable;
+};
+
+class FS
+{
+public:
+    FS() : _mounted(false), _writes(0), _bytesWritten(0) {}
+
+    bool begin() { _mounted = true; return true; }
+    void end() { _mounted = false; }
+    bool format();
+
+    File open(const char *path, const char *mode);
+    File open(const String &path, const char *mode) { return open(path.c_str(), mode); }
+    bool exists(const char *path) const;
+    bool exists(const String &path) const { return exists(path.c_str()); }
+    bool remove(const char *path);
+    bool remove(const String &path) { return remove(path.c_str()); }
+    bool rename(const char *from, const char *to);
+
+    // ---- Simulation side ----
+
+    /**
+     * @brief Files opened for writing ("w" or "a")
+     */
+    unsigned long writes() const { return _writes; }
+    unsigned long bytesWritten() const { return _bytesWritten; }
+    void countBytes(size_t n) { _bytesWritten += n; }
+
+private:
+    bool _mounted;
+    unsigned long _writes;
+    unsigned long _bytesWritten;
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t> > > _files;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+extern fs::FS LittleFS;
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * @file SimCloud.cpp
+ * @brief In-memory Firebase backend
+ */
+
+#include "SimCloud.h"
+
+SimCloud *SimCloud::_current = NULL;
+
+SimCloud &SimCloud::current()
+{
+    static SimMemoryCloud fallback;
+    return _current ? *_current : fallback;
+}
+
+SimMemoryCloud::SimMemoryCloud()
+    : _latencyMs(250),
+      _requests(0),
+      _bytesIn(0),
+      _users(0)
+{
+}
+
+uint32_t SimMemoryCloud::latencyMs(const char *method, const String &path)
+{
+    (void)method;
+    (void)path;
+    return _latencyMs;
+}
+
+int SimMemoryCloud::handle(const char *method, const String &path, const String &body, String &response)
+{
+    _requests++;
+    _bytesIn += body.length();
+    response = "";
+
+    if (path == "auth/signUp" || path == "auth/refresh")
+    {
+        if (path == "auth/signUp")
+        {
+            _users++;
+        }
+        char tokens[96];
+        snprintf(tokens, sizeof(tokens), "{\"idToken\":\"sim-id-%lu-%lu\",\"refreshToken\":\"sim-refresh-%lu\"}",
+                 _users, _requests, _users);
+        response = tokens;
+        return 200;
+    }
+
+    std::string key(path.c_str());
+
+    if (strcmp(method, "GET") == 0)
+    {
+        std::map<std::string, std::string>::const_iterator it = _docs.find(key);
+        if (it == _docs.end())
+        {
+            response = "{\"error\":{\"code\":404,\"status\":\"NOT_FOUND\"}}";
+            return 404;
+        }
+        response = it->second.c_str();
+        return 200;
+    }
+
+    // Firestore createDocument refuses to overwrite
+    if (strcmp(method, "POST") == 0 && _docs.count(key))
+    {
+        response = "{\"error\":{\"code\":409,\"status\":\"ALREADY_EXISTS\"}}";
+        return 409;
+    }
+
+    _docs[key] = body.c_str();
+    response = body;
+    return 200;
+}
+
+const std::string *SimMemoryCloud::find(const char *path) const
+{
+    std::map<std::string, std::string>::const_iterator it = _docs.find(path);
+    return it == _docs.end() ? NULL : &it->second;
+}
+
+size_t SimMemoryCloud::count(const char *prefix) const
+{
+    size_t n = 0;
+    size_t length = strlen(prefix);
+    for (std::map<std::string, std::string>::const_iterator it = _docs.begin(); it != _docs.end(); ++it)
+    {
+        if (it->first.compare(0, length, prefix) == 0)
+        {
+            n++;
+        }
+    }
+    return n;
+}
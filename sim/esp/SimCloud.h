@@ -0,0 +1,94 @@
+#ifndef SIM_CLOUD_H
+#define SIM_CLOUD_H
+
+/**
+ * @file SimCloud.h
+ * @brief Backend behind the host build's Firebase client
+ *
+ * Every Firestore/RTDB/auth call the firmware makes ends up in
+ * SimCloud::handle() as (method, path, body). Paths are prefixed with the
+ * service: "firestore/<document path>", "rtdb/<path>", "auth/signUp",
+ * "auth/refresh". The default backend is SimMemoryCloud; SimHttpCloud
+ * forwards to an HTTP endpoint (the co-simulation runner's fake Firestore).
+ */
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+// Transport errors, same codes the Firebase client reports
+#define SIM_HTTP_CONNECTION_REFUSED -1
+#define SIM_HTTP_NOT_CONNECTED -4
+#define SIM_HTTP_CONNECTION_LOST -5
+#define SIM_HTTP_READ_TIMEOUT -11
+
+class SimCloud
+{
+public:
+    virtual ~SimCloud() {}
+
+    /**
+     * @brief Serve one request
+     * @param method "GET", "PUT", "PATCH" or "POST"
+     * @param path Service-prefixed path
+     * @param body Request body (JSON), empty for GET
+     * @param response Response body
+     * @return HTTP status, or a negative SIM_HTTP_* transport error
+     */
+    virtual int handle(const char *method, const String &path, const String &body, String &response) = 0;
+
+    /**
+     * @brief Virtual time the request just handled takes (the client blocks for it)
+     */
+    virtual uint32_t latencyMs(const char *method, const String &path) = 0;
+
+    /**
+     * @brief Backend the Firebase client talks to (SimMemoryCloud by default)
+     */
+    static SimCloud &current();
+    static void install(SimCloud *cloud) { _current = cloud; }
+
+private:
+    static SimCloud *_current;
+};
+
+/**
+ * @class SimMemoryCloud
+ * @brief Keeps every written document in memory; GET returns exact paths only
+ *
+ * Documents are std::string, not String: the backend is not on the ESP and
+ * must not count against its heap model.
+ */
+class SimMemoryCloud : public SimCloud
+{
+public:
+    SimMemoryCloud();
+
+    int handle(const char *method, const String &path, const String &body, String &response) override;
+    uint32_t latencyMs(const char *method, const String &path) override;
+
+    void setLatencyMs(uint32_t ms) { _latencyMs = ms; }
+
+    /**
+     * @brief Stored body for a path, or NULL
+     */
+    const std::string *find(const char *path) const;
+    size_t documents() const { return _docs.size(); }
+
+    /**
+     * @brief Count of stored paths starting with prefix (e.g. "firestore/sensor_data/")
+     */
+    size_t count(const char *prefix) const;
+
+    unsigned long requests() const { return _requests; }
+    unsigned long bytesIn() const { return _bytesIn; }
+
+private:
+    uint32_t _latencyMs;
+    unsigned long _requests;
+    unsigned long _bytesIn;
+    unsigned long _users;
+    std::map<std::string, std::string> _docs;
+};
+
+#endif
@@ -0,0 +1,125 @@
+/**
+ * @file SimHttpCloud.cpp
+ * @brief SimCloud over HTTP
+ */
+
+#include "SimHttpCloud.h"
+#include <errno.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <string>
+
+SimHttpCloud::SimHttpCloud(const char *endpoint)
+    : _port(80),
+      _lastLatencyMs(DEFAULT_LATENCY_MS)
+{
+    const char *colon = strrchr(endpoint, ':');
+    if (colon)
+    {
+        _host = String(endpoint).substring(0, colon - endpoint);
+        _port = (uint16_t)atoi(colon + 1);
+    }
+    else
+    {
+        _host = endpoint;
+    }
+}
+
+uint32_t SimHttpCloud::latencyMs(const char *method, const String &path)
+{
+    (void)method;
+    (void)path;
+    return _lastLatencyMs;
+}
+
+static int connectTo(const char *host, uint16_t port)
+{
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *addresses = NULL;
+    if (getaddrinfo(host, service, &hints, &addresses) != 0)
+    {
+        return -1;
+    }
+
+    int fd = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+    if (fd >= 0 && connect(fd, addresses->ai_addr, addresses->ai_addrlen) != 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    return fd;
+}
+
+int SimHttpCloud::handle(const char *method, const String &path, const String &body, String &response)
+{
+    response = "";
+    _lastLatencyMs = DEFAULT_LATENCY_MS;
+
+    int fd = connectTo(_host.c_str(), _port);
+    if (fd < 0)
+    {
+        _lastLatencyMs = 0;
+        return SIM_HTTP_CONNECTION_REFUSED;
+    }
+
+    struct timeval timeout = {IO_TIMEOUT_S, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char header[160];
+    snprintf(header, sizeof(header),
+             "%s /%s HTTP/1.0\r\nHost: %s\r\nContent-Type: application/json\r\nContent-Length: %u\r\n\r\n",
+             method, path.c_str(), _host.c_str(), body.length());
+    request = header;
+    request.append(body.c_str(), body.length());
+
+    size_t sent = 0;
+    while (sent < request.size())
+    {
+        ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            close(fd);
+            return SIM_HTTP_CONNECTION_LOST;
+        }
+        sent += (size_t)n;
+    }
+
+    // HTTP/1.0: the response ends when the server closes
+    std::string reply;
+    char buffer[1024];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+    {
+        reply.append(buffer, (size_t)n);
+    }
+    bool timedOut = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    close(fd);
+
+    int code = 0;
+    size_t headerEnd = reply.find("\r\n\r\n");
+    if (headerEnd == std::string::npos || sscanf(reply.c_str(), "HTTP/%*d.%*d %d", &code) != 1)
+    {
+        return timedOut ? SIM_HTTP_READ_TIMEOUT : SIM_HTTP_CONNECTION_LOST;
+    }
+
+    const char *latency = strstr(reply.c_str(), "X-Sim-Latency-Ms:");
+    if (latency && latency < reply.c_str() + headerEnd)
+    {
+        _lastLatencyMs = (uint32_t)strtoul(latency + 17, NULL, 10);
+    }
+
+    response = reply.c_str() + headerEnd + 4;
+    return code;
+}
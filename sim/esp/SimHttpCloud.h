@@ -0,0 +1,37 @@
+#ifndef SIM_HTTP_CLOUD_H
+#define SIM_HTTP_CLOUD_H
+
+/**
+ * @file SimHttpCloud.h
+ * @brief SimCloud that forwards every request to an HTTP endpoint
+ *
+ * One HTTP/1.0 request per call: "<METHOD> /<path>" with the JSON body.
+ * The endpoint decides the outcome (status, body) and how long the request
+ * takes in virtual time through an "X-Sim-Latency-Ms" response header, so
+ * latency faults do not depend on how fast the host answers. A closed
+ * connection without a response is reported as "connection lost".
+ */
+
+#include "SimCloud.h"
+
+class SimHttpCloud : public SimCloud
+{
+public:
+    /**
+     * @param endpoint "host:port" (IPv4 or name)
+     */
+    explicit SimHttpCloud(const char *endpoint);
+
+    int handle(const char *method, const String &path, const String &body, String &response) override;
+    uint32_t latencyMs(const char *method, const String &path) override;
+
+private:
+    static const uint32_t DEFAULT_LATENCY_MS = 250;
+    static const int IO_TIMEOUT_S = 5; // Host time; the endpoint answers at once
+
+    String _host;
+    uint16_t _port;
+    uint32_t _lastLatencyMs;
+};
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * @file WiFiUdp.cpp
+ * @brief UDP over the simulated WiFi link
+ */
+
+#include "WiFiUdp.h"
+
+static const uint16_t NTP_PORT = 123;
+static const size_t NTP_PACKET_SIZE = 48;
+static const uint64_t NTP_UNIX_OFFSET_S = 2208988800ULL; // 1900-01-01 to 1970-01-01
+
+bool SimNtpServer::_up = true;
+uint32_t SimNtpServer::_rttMs = 40;
+int32_t SimNtpServer::_errorMs = 0;
+unsigned long SimNtpServer::_requests = 0;
+
+static void writeTimestamp(uint8_t *p, uint64_t unixMs)
+{
+    uint32_t seconds = (uint32_t)(unixMs / 1000 + NTP_UNIX_OFFSET_S);
+    uint32_t fraction = (uint32_t)(((unixMs % 1000) << 32) / 1000);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        p[i] = seconds >> (24 - 8 * i);
+        p[4 + i] = fraction >> (24 - 8 * i);
+    }
+}
+
+size_t SimNtpServer::answer(const uint8_t *request, size_t length, uint8_t *reply, uint64_t atUs)
+{
+    if (length < NTP_PACKET_SIZE || (request[0] & 0x07) != 3)
+    {
+        return 0;
+    }
+    _requests++;
+
+    // Server clock at the moment the request arrives (half the round trip)
+    int64_t serverUs = (int64_t)atUs + (int64_t)_rttMs * 500;
+    uint64_t serverUnixMs = SimClock::unixMillis() + (serverUs - (int64_t)SimClock::nowMicros()) / 1000 + _errorMs;
+
+    memset(reply, 0, NTP_PACKET_SIZE);
+    reply[0] = (0 << 6) | (4 << 3) | 4; // LI = 0, version 4, mode 4 (server)
+    reply[1] = 2;                       // Stratum
+    reply[2] = request[2];              // Poll
+    reply[3] = 0xEC;                    // Precision ~ 2^-20 s
+    memcpy(reply + 24, request + 40, 8); // Originate = client's transmit
+    writeTimestamp(reply + 32, serverUnixMs);
+    writeTimestamp(reply + 40, serverUnixMs);
+    return NTP_PACKET_SIZE;
+}
+
+WiFiUDP::WiFiUDP()
+    : _open(false),
+      _remotePort(0),
+      _txLength(0),
+      _pendingLength(0),
+      _pendingAtUs(0),
+      _rxLength(0),
+      _rxPos(0)
+{
+}
+
+uint8_t WiFiUDP::begin(uint16_t port)
+{
+    (void)port;
+    _open = true;
+    return 1;
+}
+
+void WiFiUDP::stop()
+{
+    _open = false;
+    _pendingLength = 0;
+    _rxLength = 0;
+    _rxPos = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+    if (!_open && !begin(0))
+    {
+        return 0;
+    }
+    _remoteIp = ip;
+    _remotePort = port;
+    _txLength = 0;
+    return 1;
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port)
+{
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip))
+    {
+        return 0;
+    }
+    return beginPacket(ip, port);
+}
+
+int WiFiUDP::endPacket()
+{
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        return 0;
+    }
+
+    // Lost datagrams are not an error for UDP
+    if (_remotePort == NTP_PORT && SimNtpServer::up())
+    {
+        uint64_t now = SimClock::nowMicros();
+        size_t length = SimNtpServer::answer(_tx, _txLength, _pending, now);
+        if (length)
+        {
+            _pendingLength = length;
+            _pendingAtUs = now + (uint64_t)SimNtpServer::roundTripMs() * 1000;
+        }
+    }
+    _txLength = 0;
+    return 1;
+}
+
+size_t WiFiUDP::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (n < size && _txLength < MAX_PACKET)
+    {
+        _tx[_txLength++] = buffer[n++];
+    }
+    return n;
+}
+
+int WiFiUDP::parsePacket()
+{
+    // Whatever was left unread of the previous packet is dropped
+    _rxLength = 0;
+    _rxPos = 0;
+
+    if (!_open || _pendingLength == 0 || SimClock::nowMicros() < _pendingAtUs)
+    {
+        return 0;
+    }
+
+    SimClock::activity();
+    memcpy(_rx, _pending, _pendingLength);
+    _rxLength = _pendingLength;
+    _pendingLength = 0;
+    return (int)_rxLength;
+}
+
+int WiFiUDP::available()
+{
+    return (int)(_rxLength - _rxPos);
+}
+
+int WiFiUDP::read()
+{
+    return _rxPos < _rxLength ? _rx[_rxPos++] : -1;
+}
+
+int WiFiUDP::read(unsigned char *buffer, size_t len)
+{
+    size_t n = 0;
+    while (n < len && _rxPos < _rxLength)
+    {
+        buffer[n++] = _rx[_rxPos++];
+    }
+    return (int)n;
+}
+
+int WiFiUDP::peek()
+{
+    return _rxPos < _rxLength ? _rx[_rxPos] : -1;
+}
@@ -0,0 +1,102 @@
+#ifndef WIFIUDP_H
+#define WIFIUDP_H
+
+/**
+ * @file WiFiUdp.h
+ * @brief UDP over the simulated WiFi link, answered by an in-process NTP server
+ *
+ * Every datagram sent to port 123 while the link is up is answered by
+ * SimNtpServer after its round-trip time, stamped from SimClock::unixMillis()
+ * (plus any configured clock error). Anything else is dropped, which is
+ * all the firmware needs UDP for.
+ */
+
+#include <Udp.h>
+#include <ESP8266WiFi.h>
+
+class WiFiUDP : public UDP
+{
+public:
+    WiFiUDP();
+
+    uint8_t begin(uint16_t port) override;
+    void stop() override;
+
+    int beginPacket(IPAddress ip, uint16_t port) override;
+    int beginPacket(const char *host, uint16_t port) override;
+    int endPacket() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    int parsePacket() override;
+    int available() override;
+    int read() override;
+    int read(unsigned char *buffer, size_t len) override;
+    int read(char *buffer, size_t len) override { return read((unsigned char *)buffer, len); }
+    int peek() override;
+    void flush() override {}
+
+    IPAddress remoteIP() override { return _remoteIp; }
+    uint16_t remotePort() override { return _remotePort; }
+
+    using Print::write;
+
+private:
+    static const size_t MAX_PACKET = 64;
+
+    bool _open;
+    IPAddress _remoteIp;
+    uint16_t _remotePort;
+
+    uint8_t _tx[MAX_PACKET];
+    size_t _txLength;
+
+    // One reply in flight, visible once its arrival time has passed
+    uint8_t _pending[MAX_PACKET];
+    size_t _pendingLength;
+    uint64_t _pendingAtUs;
+
+    uint8_t _rx[MAX_PACKET];
+    size_t _rxLength;
+    size_t _rxPos;
+};
+
+/**
+ * @class SimNtpServer
+ * @brief The NTP server every WiFiUDP talks to
+ */
+class SimNtpServer
+{
+public:
+    static void setUp(bool up) { _up = up; }
+    static bool up() { return _up; }
+
+    /**
+     * @brief Round trip; split evenly between the two directions
+     */
+    static void setRoundTripMs(uint32_t ms) { _rttMs = ms; }
+    static uint32_t roundTripMs() { return _rttMs; }
+
+    /**
+     * @brief Error of the server's clock against SimClock::unixMillis()
+     */
+    static void setClockErrorMs(int32_t ms) { _errorMs = ms; }
+
+    static unsigned long requests() { return _requests; }
+
+private:
+    static bool _up;
+    static uint32_t _rttMs;
+    static int32_t _errorMs;
+    static unsigned long _requests;
+
+    /**
+     * @brief Build the reply to a client request
+     * @return Reply length, 0 if the request is not a valid client packet
+     */
+    static size_t answer(const uint8_t *request, size_t length, uint8_t *reply, uint64_t atUs);
+
+    friend class WiFiUDP;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef TOKEN_HELPER_H
+#define TOKEN_HELPER_H
+
+/**
+ * @file TokenHelper.h
+ * @brief Token status text, as in the Firebase client's addons
+ */
+
+#include <Firebase_ESP_Client.h>
+
+inline String getTokenType(struct TokenInfo info)
+{
+    return info.type == token_type_id_token ? "id token (GITKit token)" : "undefined";
+}
+
+inline String getTokenStatus(struct TokenInfo info)
+{
+    switch (info.status)
+    {
+    case token_status_uninitialized:
+        return "uninitialized";
+    case token_status_on_initialize:
+        return "on initializing";
+    case token_status_on_signing:
+        return "on signing";
+    case token_status_on_request:
+        return "on request";
+    case token_status_on_refresh:
+        return "on refreshing";
+    case token_status_ready:
+        return "ready";
+    case token_status_error:
+        return "error";
+    default:
+        return "uninitialized";
+    }
+}
+
+#endif
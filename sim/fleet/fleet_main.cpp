@@ -0,0 +1,852 @@
+/**
+ * @file fleet_main.cpp
+ * @brief Many virtual ESP8266 loggers uploading to one collector endpoint
+ *
+ * Built into the native_fleet environment. Every virtual device is the
+ * upload side of esp8266_main.cpp on its own:
+ *
+ *   - a SensorData every sample interval (the drying curve host_main.cpp
+ *     feeds the ESP with), folded into a WindowAggregator
+ *   - a ring of --ring records like LocalStorage: a sample arriving at a
+ *     full ring overwrites the oldest record, uploaded or not
+ *   - the firmware's lanes in its order: live (newest record), summaries
+ *     (closed windows, at most AGG_QUEUE_SIZE queued), backfill (oldest
+ *     first, up to --batch per pass, stops at the first failure or when a
+ *     sample is due), and a status document every STATUS_PUBLISH_INTERVAL
+ *   - the firmware's document IDs: sensor_data/{timestamp},
+ *     sensor_summary/{device}_{windowStart}; --device-ids puts the device
+ *     name into sensor_data IDs as well
+ *   - the firmware's backoff: a failed request pauses the device's lanes
+ *     for UPLOAD_BACKOFF_MIN, doubling up to UPLOAD_BACKOFF_MAX while
+ *     requests keep failing. --backoff-ms MIN,MAX sets other limits; 0,0
+ *     retries on the next pass (LOOP_DELAY_MS later), with no backoff
+ *   - a non-retryable 4xx drops the record or summary, counted as rejected
+ *
+ * Documents are built with FirestoreDocument, as the lanes build them, and
+ * sent with SimHttpCloud: one HTTP/1.0 request per document, "<METHOD>
+ * /firestore/<path>" or "/rtdb/<path>", the protocol of the
+ * co-simulation's fake Firestore. Any collector that serves it can be
+ * measured; `cosim.py --cloud-only PORT` is a stand-in.
+ *
+ * Devices are spread over --threads workers. A worker runs whichever of
+ * its devices is due next, and requests block as they do on the ESP, so a
+ * worker has at most one request in flight. When the "late" percentiles
+ * grow, the pool and not the collector is the limit: add threads. Each
+ * worker keeps its own statistics; they are merged after the run, so the
+ * tool adds no lock of its own to the request path.
+ *
+ * --speed divides the sample and status intervals (and runs the devices'
+ * clocks faster), to load a collector with fewer devices.
+ *
+ * Usage: <program> --endpoint HOST:PORT [--devices N] [--threads N]
+ *                  [--seconds S] [--sample-ms MS] [--speed X] [--batch N]
+ *                  [--ring N] [--backoff-ms MIN,MAX] [--device-ids]
+ *                  [--seed N] [--json FILE]
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <math.h>
+#include <queue>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <unordered_set>
+#include <vector>
+
+#include "FirestoreDocument.h"
+#include "SensorData.h"
+#include "SimHttpCloud.h"
+#include "SystemConfig.h"
+#include "WindowAggregator.h"
+
+static const unsigned long LOOP_DELAY_MS = 10; // delay() at the end of the ESP's loop()
+
+struct FleetOptions
+{
+    const char *endpoint = NULL;
+    unsigned devices = 100;
+    unsigned threads = 8;
+    double seconds = 60;
+    unsigned long sampleMs = SAMPLE_INTERVAL;
+    double speed = 1.0;
+    unsigned batch = UPLOAD_BATCH_SIZE;
+    unsigned ring = MAX_RECORDS;
+    unsigned long backoffMinMs = UPLOAD_BACKOFF_MIN; // 0: retry on the next pass
+    unsigned long backoffMaxMs = UPLOAD_BACKOFF_MAX;
+    bool deviceIds = false;
+    unsigned long seed = 1;
+    const char *jsonFile = NULL;
+};
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s --endpoint HOST:PORT [--devices N] [--threads N]\n"
+            "          [--seconds S] [--sample-ms MS] [--speed X] [--batch N]\n"
+            "          [--ring N] [--backoff-ms MIN,MAX] [--device-ids]\n"
+            "          [--seed N] [--json FILE]\n",
+            program);
+}
+
+static bool parseOptions(int argc, char **argv, FleetOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--endpoint") == 0 && hasValue)
+        {
+            options.endpoint = argv[++i];
+        }
+        else if (strcmp(arg, "--devices") == 0 && hasValue)
+        {
+            options.devices = (unsigned)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--threads") == 0 && hasValue)
+        {
+            options.threads = (unsigned)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--seconds") == 0 && hasValue)
+        {
+            options.seconds = atof(argv[++i]);
+        }
+        else if (strcmp(arg, "--sample-ms") == 0 && hasValue)
+        {
+            options.sampleMs = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--speed") == 0 && hasValue)
+        {
+            options.speed = atof(argv[++i]);
+        }
+        else if (strcmp(arg, "--batch") == 0 && hasValue)
+        {
+            options.batch = (unsigned)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--ring") == 0 && hasValue)
+        {
+            options.ring = (unsigned)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--backoff-ms") == 0 && hasValue)
+        {
+            if (sscanf(argv[++i], "%lu,%lu", &options.backoffMinMs, &options.backoffMaxMs) != 2)
+            {
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--device-ids") == 0)
+        {
+            options.deviceIds = true;
+        }
+        else if (strcmp(arg, "--seed") == 0 && hasValue)
+        {
+            options.seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--json") == 0 && hasValue)
+        {
+            options.jsonFile = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return options.endpoint && options.devices > 0 && options.threads > 0 && options.seconds > 0 &&
+           options.sampleMs > 0 && options.speed > 0 && options.batch > 0 && options.ring > 0 &&
+           options.backoffMaxMs >= options.backoffMinMs;
+}
+
+// ---------------------------------------------------------------------------
+// Time
+
+static const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+// Wall microseconds since the fleet started (thread-safe, monotonic)
+static uint64_t elapsedUs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started)
+        .count();
+}
+
+// ---------------------------------------------------------------------------
+// Statistics, one set per worker thread
+
+enum Lane
+{
+    LANE_SAMPLE,
+    LANE_SUMMARY,
+    LANE_STATUS,
+    LANE_COUNT
+};
+
+static const char *LANE_NAMES[LANE_COUNT] = {"sample", "summary", "status"};
+
+struct LaneStats
+{
+    unsigned long requests = 0;
+    unsigned long ok = 0;
+    unsigned long long bytes = 0;
+    std::vector<uint32_t> latencyUs;
+    std::map<int, unsigned long> failures; // HTTP status or SIM_HTTP_* transport error
+
+    void merge(const LaneStats &other)
+    {
+        requests += other.requests;
+        ok += other.ok;
+        bytes += other.bytes;
+        latencyUs.insert(latencyUs.end(), other.latencyUs.begin(), other.latencyUs.end());
+        for (std::map<int, unsigned long>::const_iterator it = other.failures.begin(); it != other.failures.end(); ++it)
+        {
+            failures[it->first] += it->second;
+        }
+    }
+};
+
+struct WorkerStats
+{
+    LaneStats lanes[LANE_COUNT];
+    unsigned long produced = 0;
+    unsigned long uploaded = 0;
+    unsigned long evicted = 0;           // Overwritten in the ring before upload
+    unsigned long summariesDropped = 0;  // Summary queue full
+    unsigned long rejected = 0;          // Records and summaries dropped after a non-retryable 4xx
+    unsigned long backlog = 0;           // Records not uploaded when the run ended
+    unsigned long passes = 0;
+    std::vector<uint32_t> deliveryMs;    // Sample taken -> accepted by the collector
+    std::vector<uint32_t> lateUs;        // Pass started this long after it was due
+    std::vector<std::string> samplePaths;
+};
+
+// ---------------------------------------------------------------------------
+// One logger
+
+class VirtualDevice
+{
+public:
+    VirtualDevice(unsigned index, const FleetOptions &options, time_t epoch)
+        : _options(options),
+          _cloud(options.endpoint),
+          _epoch(epoch),
+          _livePending(false),
+          _retryAtUs(0),
+          _backoffMs(0),
+          _lastCode(0),
+          _rng((uint32_t)(options.seed * 2654435761UL + index * 40503UL) | 1),
+          _samples(0)
+    {
+        snprintf(_name, sizeof(_name), "%s_%04u", DEVICE_NAME, index);
+        snprintf(_statusPath, sizeof(_statusPath), "%s/%s/status", FB_ROOT_PATH, _name);
+
+        // Devices were not switched on in the same millisecond
+        _sampleUs = (uint64_t)(options.sampleMs * 1000 / options.speed);
+        _statusUs = (uint64_t)(STATUS_PUBLISH_INTERVAL * 1000ULL / options.speed);
+        _nextSampleUs = next() % (_sampleUs > 0 ? _sampleUs : 1);
+        _nextStatusUs = _nextSampleUs + _statusUs;
+    }
+
+    uint64_t firstDueUs() const { return _nextSampleUs; }
+
+    /**
+     * @brief One pass of the ESP's loop(): ingest what is due, then the lanes
+     * @return When the device wants to run next (elapsedUs() clock)
+     */
+    uint64_t pass(uint64_t nowUs, WorkerStats &stats)
+    {
+        produce(nowUs, stats);
+        if (nowUs < _retryAtUs)
+        {
+            return std::min(_retryAtUs, _nextSampleUs);
+        }
+
+        // As on the ESP, a failed request also holds back the lanes after it
+        bool failed = false;
+        bool backoff = _options.backoffMinMs > 0;
+        if (_livePending && !serviceLiveLane(stats))
+        {
+            failed = true;
+        }
+        if (!(failed && backoff) && !_summaries.empty() && !uploadSummaries(stats))
+        {
+            failed = true;
+        }
+        if (!(failed && backoff) && !_livePending && hasBacklog() && serviceBackfillLane(stats) < 0)
+        {
+            failed = true;
+        }
+        if (elapsedUs() >= _nextStatusUs)
+        {
+            // Outside the backoff, like the firmware's status publish
+            _nextStatusUs += _statusUs;
+            publishStatus(stats);
+        }
+
+        uint64_t now = elapsedUs();
+        if (failed && _options.backoffMinMs > 0)
+        {
+            _backoffMs = _backoffMs ? std::min(_backoffMs * 2, _options.backoffMaxMs) : _options.backoffMinMs;
+            _retryAtUs = now + _backoffMs * 1000;
+            return std::min(_retryAtUs, _nextSampleUs);
+        }
+        if (!failed)
+        {
+            _backoffMs = 0;
+        }
+
+        uint64_t nextPass = now + LOOP_DELAY_MS * 1000;
+        if (failed || _livePending || !_summaries.empty() || hasBacklog())
+        {
+            return nextPass;
+        }
+        return std::max(nextPass, std::min(_nextSampleUs, _nextStatusUs));
+    }
+
+    unsigned long backlog() const
+    {
+        unsigned long n = 0;
+        for (size_t i = 0; i < _ring.size(); i++)
+        {
+            n += _ring[i].uploaded ? 0 : 1;
+        }
+        return n;
+    }
+
+private:
+    struct Record
+    {
+        SensorData data;
+        uint64_t takenUs;
+        bool uploaded;
+    };
+
+    const FleetOptions &_options;
+    SimHttpCloud _cloud;
+    time_t _epoch;
+    char _name[40];
+    char _statusPath[80];
+    WindowAggregator _aggregator;
+    std::deque<Record> _ring;
+    std::deque<WindowSummary> _summaries;
+    bool _livePending;
+    uint64_t _sampleUs;
+    uint64_t _statusUs;
+    uint64_t _nextSampleUs;
+    uint64_t _nextStatusUs;
+    uint64_t _retryAtUs;
+    unsigned long _backoffMs;
+    int _lastCode; // Result of the last uploadRecord() request
+    uint32_t _rng;
+    unsigned long _samples;
+
+    uint32_t next()
+    {
+        // xorshift32
+        _rng ^= _rng << 13;
+        _rng ^= _rng >> 17;
+        _rng ^= _rng << 5;
+        return _rng;
+    }
+
+    // Synced Unix time of this device; runs --speed times faster than the host
+    unsigned long unixTime(uint64_t us) const
+    {
+        return (unsigned long)(_epoch + (time_t)(us * _options.speed / 1e6));
+    }
+
+    bool hasBacklog() const { return backlog() > 0; }
+
+    // What handleMegaLine() does with every sample line
+    void produce(uint64_t nowUs, WorkerStats &stats)
+    {
+        while (_nextSampleUs <= nowUs)
+        {
+            float hours = _samples * _options.sampleMs / 3600e3f;
+            SensorData data = SensorData();
+            data.temperature() = 60.0f + (int)(next() % 101 - 50) / 100.0f;
+            data.weight() = 25.0f + 75.0f * expf(-hours / 24.0f);
+            data.kadarAir = (data.weight() - 25.0f) / data.weight() * 100.0f;
+            data.relay1 = data.temperature() < 60.0f ? 1 : 0;
+            data.relay2 = 0;
+            data.timestamp = unixTime(_nextSampleUs);
+            data.status = STATUS_OK;
+            data.flags = 0;
+            _samples++;
+            stats.produced++;
+
+            WindowSummary closed;
+            if (_aggregator.addSample(data, closed))
+            {
+                if (_summaries.size() == AGG_QUEUE_SIZE)
+                {
+                    _summaries.pop_front();
+                    stats.summariesDropped++;
+                }
+                _summaries.push_back(closed);
+            }
+
+            if (_ring.size() == _options.ring)
+            {
+                stats.evicted += _ring.front().uploaded ? 0 : 1;
+                _ring.pop_front();
+            }
+            Record record = {data, _nextSampleUs, false};
+            _ring.push_back(record);
+            _livePending = true;
+            _nextSampleUs += _sampleUs;
+        }
+    }
+
+    // HTTP status, or a SIM_HTTP_* transport error
+    int send(Lane lane, const char *method, const char *path, const char *body, WorkerStats &stats)
+    {
+        LaneStats &lanes = stats.lanes[lane];
+        String response;
+        uint64_t start = elapsedUs();
+        int code = _cloud.handle(method, path, body, response);
+        uint64_t latency = elapsedUs() - start;
+
+        lanes.requests++;
+        lanes.bytes += strlen(body);
+        lanes.latencyUs.push_back((uint32_t)std::min<uint64_t>(latency, 0xFFFFFFFFUL));
+        if (succeeded(code))
+        {
+            lanes.ok++;
+        }
+        else
+        {
+            lanes.failures[code]++;
+        }
+        return code;
+    }
+
+    static bool succeeded(int code) { return code >= 200 && code < 300; }
+
+    // Same classes as permanentFailure() in esp8266_main.cpp
+    static bool permanentFailure(int code)
+    {
+        return code >= 400 && code < 500 && code != 401 && code != 403 && code != 408 && code != 429;
+    }
+
+    // Same document and fallback as uploadRecord() in esp8266_main.cpp
+    bool uploadRecord(Record &record, WorkerStats &stats)
+    {
+        const SensorData &data = record.data;
+        char path[128];
+        if (_options.deviceIds)
+        {
+            snprintf(path, sizeof(path), "firestore/sensor_data/%s_%lu", _name, data.timestamp);
+        }
+        else
+        {
+            snprintf(path, sizeof(path), "firestore/sensor_data/%lu", data.timestamp);
+        }
+
+        FirestoreDocument document;
+        document.addDouble("temp", data.getTemperature());
+        document.addDouble("weight", data.getWeight());
+        document.addDouble("ka", data.kadarAir);
+        document.addInteger("relay1", data.relay1);
+        document.addInteger("relay2", data.relay2);
+        document.addInteger("status", data.status);
+        document.addString("device", _name);
+        document.addInteger("timestamp", data.timestamp);
+        document.addBool("time_synced", true);
+        const char *body = document.c_str();
+        if (!body)
+        {
+            _lastCode = 413; // Too large, as patchDocument() reports it
+            return false;
+        }
+
+        int code = send(LANE_SAMPLE, "PATCH", path, body, stats);
+        if (code == 404)
+        {
+            code = send(LANE_SAMPLE, "POST", path, body, stats);
+        }
+        _lastCode = code;
+        bool ok = succeeded(code);
+        if (ok)
+        {
+            record.uploaded = true;
+            stats.uploaded++;
+            stats.deliveryMs.push_back((uint32_t)((elapsedUs() - record.takenUs) / 1000));
+            stats.samplePaths.push_back(path);
+        }
+        return ok;
+    }
+
+    bool serviceLiveLane(WorkerStats &stats)
+    {
+        _livePending = false;
+        if (_ring.empty() || _ring.back().uploaded)
+        {
+            return true;
+        }
+        // Left for the backfill lane, which drops it if it was rejected
+        return uploadRecord(_ring.back(), stats) || permanentFailure(_lastCode);
+    }
+
+    // Uploaded records, or -1 if a request failed
+    int serviceBackfillLane(WorkerStats &stats)
+    {
+        size_t consumed = 0;
+        unsigned uploaded = 0;
+        bool failed = false;
+        while (consumed < _ring.size() && uploaded < _options.batch)
+        {
+            if (_livePending || _nextSampleUs <= elapsedUs())
+            {
+                break; // The MEGA is sending
+            }
+            if (_ring[consumed].uploaded)
+            {
+                consumed++;
+                continue;
+            }
+            if (uploadRecord(_ring[consumed], stats))
+            {
+                uploaded++;
+            }
+            else if (permanentFailure(_lastCode))
+            {
+                stats.rejected++;
+            }
+            else
+            {
+                failed = true;
+                break;
+            }
+            consumed++;
+        }
+        _ring.erase(_ring.begin(), _ring.begin() + consumed);
+        return failed ? -1 : (int)uploaded;
+    }
+
+    // Same document as uploadSummary() in esp8266_main.cpp
+    bool uploadSummaries(WorkerStats &stats)
+    {
+        static const char *channelNames[AGG_CHANNELS] = {"temp", "weight", "ka"};
+
+        while (!_summaries.empty())
+        {
+            const WindowSummary &summary = _summaries.front();
+            char path[128];
+            snprintf(path, sizeof(path), "firestore/sensor_summary/%s_%lu", _name, summary.windowStart);
+
+            FirestoreDocument document;
+            char fieldName[16];
+            for (int i = 0; i < AGG_CHANNELS; i++)
+            {
+                snprintf(fieldName, sizeof(fieldName), "%s_min", channelNames[i]);
+                document.addDouble(fieldName, summary.minValue[i]);
+                snprintf(fieldName, sizeof(fieldName), "%s_max", channelNames[i]);
+                document.addDouble(fieldName, summary.maxValue[i]);
+                snprintf(fieldName, sizeof(fieldName), "%s_avg", channelNames[i]);
+                document.addDouble(fieldName, summary.avgValue[i]);
+            }
+            document.addDouble("relay1_duty", summary.relay1Duty);
+            document.addDouble("relay2_duty", summary.relay2Duty);
+            document.addInteger("samples", summary.sampleCount);
+            document.addInteger("window_s", summary.windowSeconds);
+            document.addInteger("window_start", summary.windowStart);
+            document.addString("device", _name);
+
+            const char *body = document.c_str();
+            int code = body ? send(LANE_SUMMARY, "PATCH", path, body, stats) : 413;
+            if (!succeeded(code))
+            {
+                if (!permanentFailure(code))
+                {
+                    return false;
+                }
+                stats.rejected++;
+            }
+            _summaries.pop_front();
+        }
+        return true;
+    }
+
+    // Stand-in for UploadTelemetry::toJSON(): same path and rate, fewer fields
+    bool publishStatus(WorkerStats &stats)
+    {
+        char path[96];
+        char body[256];
+        snprintf(path, sizeof(path), "rtdb%s", _statusPath);
+        snprintf(body, sizeof(body),
+                 "{\"device\":\"%s\",\"backlog\":%lu,\"summaries\":%u,\"uploads\":%lu,\"failures\":%lu,"
+                 "\"rssi\":-60,\"time\":%lu}",
+                 _name, backlog(), (unsigned)_summaries.size(), stats.lanes[LANE_SAMPLE].ok,
+                 stats.lanes[LANE_SAMPLE].requests - stats.lanes[LANE_SAMPLE].ok, unixTime(elapsedUs()));
+        return succeeded(send(LANE_STATUS, "PUT", path, body, stats));
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Workers
+
+static void runWorker(std::vector<VirtualDevice *> devices, uint64_t endUs, WorkerStats *stats)
+{
+    typedef std::pair<uint64_t, size_t> Due;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due> > due;
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        due.push(Due(devices[i]->firstDueUs(), i));
+    }
+
+    while (!due.empty())
+    {
+        Due item = due.top();
+        due.pop();
+        if (item.first >= endUs)
+        {
+            continue; // Nothing more from this device before the end
+        }
+
+        uint64_t now = elapsedUs();
+        if (now < item.first)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(item.first - now));
+            now = elapsedUs();
+        }
+        stats->lateUs.push_back((uint32_t)std::min<uint64_t>(now - item.first, 0xFFFFFFFFUL));
+        stats->passes++;
+        due.push(Due(devices[item.second]->pass(now, *stats), item.second));
+    }
+
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        stats->backlog += devices[i]->backlog();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Report
+
+static double percentile(std::vector<uint32_t> &values, double p)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    size_t rank = (size_t)(p / 100.0 * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+struct Percentiles
+{
+    double p50, p90, p99, p999, max;
+};
+
+static Percentiles percentiles(std::vector<uint32_t> &values, double scale)
+{
+    Percentiles p;
+    p.p50 = percentile(values, 50) * scale;
+    p.p90 = percentile(values, 90) * scale;
+    p.p99 = percentile(values, 99) * scale;
+    p.p999 = percentile(values, 99.9) * scale;
+    p.max = percentile(values, 100) * scale;
+    return p;
+}
+
+static const char *failureName(int code)
+{
+    static char text[16];
+    switch (code)
+    {
+    case SIM_HTTP_CONNECTION_REFUSED:
+        return "refused";
+    case SIM_HTTP_CONNECTION_LOST:
+        return "lost";
+    case SIM_HTTP_READ_TIMEOUT:
+        return "timeout";
+    default:
+        snprintf(text, sizeof(text), "%d", code);
+        return text;
+    }
+}
+
+static void printFailures(FILE *out, const std::map<int, unsigned long> &failures, bool json)
+{
+    bool first = true;
+    for (std::map<int, unsigned long>::const_iterator it = failures.begin(); it != failures.end(); ++it)
+    {
+        if (json)
+        {
+            fprintf(out, "%s\"%s\": %lu", first ? "" : ", ", failureName(it->first), it->second);
+        }
+        else
+        {
+            fprintf(out, "%s%s %lu", first ? " (" : ", ", failureName(it->first), it->second);
+        }
+        first = false;
+    }
+    if (!json && !first)
+    {
+        fprintf(out, ")");
+    }
+}
+
+static void printPercentiles(FILE *out, const Percentiles &p, bool json)
+{
+    if (json)
+    {
+        fprintf(out, "{\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f}", p.p50, p.p90,
+                p.p99, p.p999, p.max);
+    }
+    else
+    {
+        fprintf(out, "p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f", p.p50, p.p90, p.p99, p.p999, p.max);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    FleetOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    if (options.threads > options.devices)
+    {
+        options.threads = options.devices;
+    }
+
+    time_t epoch = time(NULL);
+    std::vector<VirtualDevice *> devices;
+    std::vector<std::vector<VirtualDevice *> > shares(options.threads);
+    for (unsigned i = 0; i < options.devices; i++)
+    {
+        devices.push_back(new VirtualDevice(i, options, epoch));
+        shares[i % options.threads].push_back(devices.back());
+    }
+
+    fprintf(stderr, "fleet: %u devices on %u threads for %.0f s against %s\n", options.devices, options.threads,
+            options.seconds, options.endpoint);
+    uint64_t endUs = elapsedUs() + (uint64_t)(options.seconds * 1e6);
+    std::vector<WorkerStats> stats(options.threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < options.threads; t++)
+    {
+        workers.push_back(std::thread(runWorker, shares[t], endUs, &stats[t]));
+    }
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+    double wallSeconds = elapsedUs() / 1e6;
+
+    // Merge
+    WorkerStats total;
+    LaneStats all;
+    std::unordered_set<std::string> paths;
+    for (size_t t = 0; t < stats.size(); t++)
+    {
+        WorkerStats &s = stats[t];
+        for (int lane = 0; lane < LANE_COUNT; lane++)
+        {
+            total.lanes[lane].merge(s.lanes[lane]);
+            all.merge(s.lanes[lane]);
+        }
+        total.produced += s.produced;
+        total.uploaded += s.uploaded;
+        total.evicted += s.evicted;
+        total.summariesDropped += s.summariesDropped;
+        total.rejected += s.rejected;
+        total.backlog += s.backlog;
+        total.passes += s.passes;
+        total.deliveryMs.insert(total.deliveryMs.end(), s.deliveryMs.begin(), s.deliveryMs.end());
+        total.lateUs.insert(total.lateUs.end(), s.lateUs.begin(), s.lateUs.end());
+        paths.insert(s.samplePaths.begin(), s.samplePaths.end());
+    }
+
+    Percentiles latency = percentiles(all.latencyUs, 1e-3);
+    Percentiles laneLatency[LANE_COUNT];
+    for (int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        laneLatency[lane] = percentiles(total.lanes[lane].latencyUs, 1e-3);
+    }
+    Percentiles delivery = percentiles(total.deliveryMs, 1);
+    Percentiles late = percentiles(total.lateUs, 1e-3);
+    unsigned long overwritten = total.uploaded - (unsigned long)paths.size();
+
+    printf("\n---- fleet ----\n");
+    printf("devices   : %u on %u threads, %.1f s, one sample per %lu ms (x%g)\n", options.devices, options.threads,
+           wallSeconds, options.sampleMs, options.speed);
+    printf("requests  : %lu (%.1f/s), %lu failed", all.requests, all.requests / wallSeconds, all.requests - all.ok);
+    printFailures(stdout, all.failures, false);
+    printf(", %.1f KB/s sent\n", all.bytes / 1024.0 / wallSeconds);
+    printf("latency ms: ");
+    printPercentiles(stdout, latency, false);
+    printf("\n");
+    for (int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        if (total.lanes[lane].requests == 0)
+        {
+            continue;
+        }
+        printf("  %-8s: %lu ok, %lu failed, ", LANE_NAMES[lane], total.lanes[lane].ok,
+               total.lanes[lane].requests - total.lanes[lane].ok);
+        printPercentiles(stdout, laneLatency[lane], false);
+        printf("\n");
+    }
+    printf("samples   : %lu taken, %lu uploaded (%.1f/s), %lu overwritten in the ring, %lu still queued\n",
+           total.produced, total.uploaded, total.uploaded / wallSeconds, total.evicted, total.backlog);
+    printf("delivery  : ");
+    printPercentiles(stdout, delivery, false);
+    printf(" ms, sample taken to stored\n");
+    printf("documents : %lu distinct sensor_data IDs, %lu uploads overwrote another sample%s\n",
+           (unsigned long)paths.size(), overwritten, options.deviceIds ? "" : " (try --device-ids)");
+    printf("summaries : %lu dropped from full queues\n", total.summariesDropped);
+    printf("rejected  : %lu records and summaries dropped after a non-retryable 4xx\n", total.rejected);
+    printf("late ms   : ");
+    printPercentiles(stdout, late, false);
+    printf(" over %lu passes\n", total.passes);
+
+    if (options.jsonFile)
+    {
+        FILE *out = fopen(options.jsonFile, "w");
+        if (!out)
+        {
+            fprintf(stderr, "Cannot write %s\n", options.jsonFile);
+            return 1;
+        }
+        fprintf(out, "{\n  \"devices\": %u,\n  \"threads\": %u,\n  \"seconds\": %.3f,\n  \"sample_ms\": %lu,\n"
+                     "  \"speed\": %g,\n  \"device_ids\": %s,\n",
+                options.devices, options.threads, wallSeconds, options.sampleMs, options.speed,
+                options.deviceIds ? "true" : "false");
+        fprintf(out, "  \"requests\": %lu,\n  \"requests_per_s\": %.2f,\n  \"failures\": {", all.requests,
+                all.requests / wallSeconds);
+        printFailures(out, all.failures, true);
+        fprintf(out, "},\n  \"bytes_sent\": %llu,\n  \"latency_ms\": ", all.bytes);
+        printPercentiles(out, latency, true);
+        fprintf(out, ",\n  \"lanes\": {");
+        for (int lane = 0; lane < LANE_COUNT; lane++)
+        {
+            fprintf(out, "%s\n    \"%s\": {\"ok\": %lu, \"failed\": %lu, \"latency_ms\": ", lane ? "," : "",
+                    LANE_NAMES[lane], total.lanes[lane].ok, total.lanes[lane].requests - total.lanes[lane].ok);
+            printPercentiles(out, laneLatency[lane], true);
+            fprintf(out, "}");
+        }
+        fprintf(out, "\n  },\n  \"samples\": {\"taken\": %lu, \"uploaded\": %lu, \"evicted\": %lu, \"queued\": %lu, "
+                     "\"distinct_ids\": %lu, \"overwritten\": %lu},\n",
+                total.produced, total.uploaded, total.evicted, total.backlog, (unsigned long)paths.size(), overwritten);
+        fprintf(out, "  \"delivery_ms\": ");
+        printPercentiles(out, delivery, true);
+        fprintf(out, ",\n  \"summaries_dropped\": %lu,\n  \"rejected\": %lu,\n  \"late_ms\": ",
+                total.summariesDropped, total.rejected);
+        printPercentiles(out, late, true);
+        fprintf(out, "\n}\n");
+        fclose(out);
+    }
+
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        delete devices[i];
+    }
+    return 0;
+}
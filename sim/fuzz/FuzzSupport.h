@@ -0,0 +1,74 @@
+#ifndef FUZZ_SUPPORT_H
+#define FUZZ_SUPPORT_H
+
+/**
+ * @file FuzzSupport.h
+ * @brief Shared checks for the fuzz targets in sim/fuzz/
+ *
+ * FUZZ_ASSERT() reports a broken invariant and aborts, which both
+ * libFuzzer and the standalone driver treat as a crash and save the input.
+ *
+ * VirtualBudget catches inputs that make a parser wait: the shims run on
+ * virtual time (SimClock), so a Stream timeout or a DWIN read loop that
+ * spins on bad input shows up as virtual milliseconds spent, deterministic
+ * and independent of how fast the host is. libFuzzer's -timeout still
+ * catches real hangs (a loop that never polls the clock).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "SimClock.h"
+
+#define FUZZ_ASSERT(condition, ...)                         \
+    do                                                      \
+    {                                                       \
+        if (!(condition))                                   \
+        {                                                   \
+            fprintf(stderr, "FUZZ: %s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fputc('\n', stderr);                            \
+            abort();                                        \
+        }                                                   \
+    } while (0)
+
+/**
+ * @class VirtualBudget
+ * @brief Virtual time spent since construction, checked against a limit
+ */
+class VirtualBudget
+{
+public:
+    VirtualBudget() : _startUs(SimClock::nowMicros()) {}
+
+    uint64_t elapsedUs() const { return SimClock::nowMicros() - _startUs; }
+
+    void check(uint64_t limitUs, const char *what) const
+    {
+        uint64_t spent = elapsedUs();
+        FUZZ_ASSERT(spent <= limitUs, "%s took %llu ms of virtual time (limit %llu ms)",
+                    what, (unsigned long long)(spent / 1000), (unsigned long long)(limitUs / 1000));
+    }
+
+private:
+    uint64_t _startUs;
+};
+
+/**
+ * @brief Count the lines a byte string holds (the last one may be unterminated)
+ */
+inline size_t fuzzLineCount(const uint8_t *data, size_t size)
+{
+    size_t lines = 1;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] == '\n')
+        {
+            lines++;
+        }
+    }
+    return lines;
+}
+
+#endif
@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""
+Build and run the fuzz targets in sim/fuzz/ on the host shims.
+
+Every parser that reads bytes from outside the firmware has a target:
+
+    sensor_csv     SensorData::fromCSV() and the toCSV() round trip
+    storage        LocalStorage booting from an arbitrary EEPROM image
+    esp_ingest     ESP8266 ingestSerial()/handleMegaLine() (esp8266_main.cpp)
+    mega_messages  MEGA processESPMessages(): TIME: and CFG: lines (main.cpp)
+    dwin           DWIN::listen() reading panel frames
+
+Targets are built with AddressSanitizer and UndefinedBehaviorSanitizer.
+With clang++ they link libFuzzer (-fsanitize=fuzzer) and fuzz with coverage
+feedback; with g++ they link standalone_main.cpp instead, which replays the
+corpus and tries blind mutations - enough to reproduce a crash, not to find
+many. Sources and defines come from the native_mega / native_esp envs in
+platformio.ini, so the firmware builds exactly as the host simulation does.
+ArduinoJson is taken from .pio/libdeps (run `pio pkg install -e native_esp`
+once) or --arduinojson.
+
+    python3 sim/fuzz/fuzz.py build                 # all targets
+    python3 sim/fuzz/fuzz.py run dwin --seconds 300
+    python3 sim/fuzz/fuzz.py replay                # seed corpora only (CI)
+
+Builds and working corpora go to .pio/fuzz/<target>/; a crash, timeout or
+broken invariant leaves the input there as crash-*/timeout-* and makes the
+script exit 1. Reproduce with `.pio/fuzz/<target>/program <file>`. Inputs
+worth keeping (fixed crashes, new coverage) go into sim/fuzz/corpus/.
+"""
+
+import argparse
+import concurrent.futures
+import configparser
+import glob
+import os
+import shutil
+import subprocess
+import sys
+import time
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+FUZZ_DIR = os.path.join("sim", "fuzz")
+OUT_DIR = os.path.join(".pio", "fuzz")
+
+SANITIZE = ["-fsanitize=address,undefined,float-cast-overflow", "-fno-sanitize-recover=all"]
+COMMON = ["-std=gnu++17", "-g", "-O1", "-fno-omit-frame-pointer", "-DSIM_FUZZ", "-Iinclude", "-I" + FUZZ_DIR]
+
+# env: the platformio.ini environment whose flags (and, with firmware=True,
+# whose sources minus host_main.cpp) the target is built with
+TARGETS = {
+    "sensor_csv": {"env": "native_mega", "sources": [], "dict": "sensor_csv.dict", "max_len": 256},
+    "storage": {"env": "native_mega", "sources": ["src/LocalStorage.cpp"], "dict": "sensor_csv.dict", "max_len": 4096},
+    "esp_ingest": {"env": "native_esp", "firmware": True, "dict": "mega_json.dict", "max_len": 4096},
+    "mega_messages": {"env": "native_mega", "firmware": True, "dict": "esp_messages.dict", "max_len": 1024},
+    "dwin": {"env": "native_mega", "sources": ["lib/DWIN.cpp"], "dict": "dwin.dict", "max_len": 2048},
+}
+
+
+def read_env(env):
+    """Defines/includes and firmware sources of one platformio.ini env."""
+    config = configparser.ConfigParser(interpolation=None)
+    config.read(os.path.join(ROOT, "platformio.ini"))
+    section = config["env:" + env]
+    flags = [f for f in section.get("build_flags", "").split() if f.startswith(("-D", "-I"))]
+
+    sources = []
+    for entry in section.get("src_filter", "").split():
+        if not entry.startswith("+<"):
+            continue
+        path = os.path.normpath(os.path.join("src", entry[2:-1]))
+        if path.endswith(".cpp"):
+            sources.append(path)
+        else:
+            sources.extend(sorted(glob.glob(os.path.join(ROOT, path, "*.cpp"))))
+    sources = [os.path.relpath(s, ROOT) if os.path.isabs(s) else s for s in sources]
+    return flags, [s for s in sources if not s.endswith("host_main.cpp")]
+
+
+def shim_sources(env_sources):
+    return [s for s in env_sources if s.startswith("sim" + os.sep)]
+
+
+def find_arduinojson(explicit):
+    if explicit:
+        return explicit
+    for candidate in sorted(glob.glob(os.path.join(ROOT, ".pio", "libdeps", "*", "ArduinoJson", "src"))):
+        return candidate
+    raise SystemExit("ArduinoJson not found: run `pio pkg install -e native_esp` or pass --arduinojson DIR")
+
+
+def pick_compiler(explicit):
+    if explicit:
+        return explicit
+    return shutil.which("clang++") or shutil.which("g++") or "c++"
+
+
+def has_libfuzzer(cxx):
+    return "clang" in os.path.basename(cxx)
+
+
+def compile_one(cxx, flags, source, obj):
+    os.makedirs(os.path.dirname(obj), exist_ok=True)
+    command = [cxx] + flags + ["-c", source, "-o", obj]
+    result = subprocess.run(command, cwd=ROOT, stderr=subprocess.PIPE, text=True)
+    return source, result.returncode, result.stderr
+
+
+def build(name, cxx, arduinojson, jobs):
+    target = TARGETS[name]
+    env_flags, env_sources = read_env(target["env"])
+    libfuzzer = has_libfuzzer(cxx)
+
+    sources = env_sources if target.get("firmware") else shim_sources(env_sources) + target["sources"]
+    sources = sources + [os.path.join(FUZZ_DIR, "fuzz_%s.cpp" % name)]
+    if not libfuzzer:
+        sources.append(os.path.join(FUZZ_DIR, "standalone_main.cpp"))
+
+    flags = COMMON + SANITIZE + env_flags + ["-isystem", arduinojson]
+    if libfuzzer:
+        flags.append("-fsanitize=fuzzer-no-link")
+
+    out = os.path.join(ROOT, OUT_DIR, name)
+    objects = []
+    failed = False
+    with concurrent.futures.ThreadPoolExecutor(max_workers=jobs) as pool:
+        futures = []
+        for source in sources:
+            obj = os.path.join(out, "obj", source.replace(os.sep, "_") + ".o")
+            objects.append(obj)
+            futures.append(pool.submit(compile_one, cxx, flags, source, obj))
+        for future in futures:
+            source, code, errors = future.result()
+            if code != 0:
+                sys.stderr.write(errors)
+                failed = True
+    if failed:
+        raise SystemExit("%s: build failed" % name)
+
+    program = os.path.join(out, "program")
+    link = [cxx] + objects + SANITIZE + (["-fsanitize=fuzzer"] if libfuzzer else []) + ["-o", program]
+    if subprocess.run(link, cwd=ROOT).returncode != 0:
+        raise SystemExit("%s: link failed" % name)
+    print("built %s (%s)" % (os.path.relpath(program, ROOT), "libFuzzer" if libfuzzer else "standalone driver"))
+    return program
+
+
+def artifacts(name):
+    return sorted(glob.glob(os.path.join(ROOT, OUT_DIR, name, "crash-*")) +
+                  glob.glob(os.path.join(ROOT, OUT_DIR, name, "timeout-*")))
+
+
+def run(name, program, seconds, timeout, replay_only):
+    target = TARGETS[name]
+    seeds = os.path.join(ROOT, FUZZ_DIR, "corpus", name)
+    work = os.path.join(ROOT, OUT_DIR, name, "corpus")
+    os.makedirs(work, exist_ok=True)
+    before = set(artifacts(name))
+
+    command = [program,
+               "-max_len=%d" % target["max_len"],
+               "-timeout=%d" % timeout,
+               "-dict=" + os.path.join(ROOT, FUZZ_DIR, "dict", target["dict"]),
+               "-artifact_prefix=" + os.path.join(ROOT, OUT_DIR, name) + os.sep]
+    if replay_only:
+        command += ["-runs=0", seeds]
+    else:
+        # New inputs land in the first directory, the seeds stay untouched
+        command += ["-max_total_time=%d" % seconds, "-print_final_stats=1", work, seeds]
+
+    started = time.time()
+    result = subprocess.run(command, cwd=ROOT, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True, errors="replace")
+    found = [a for a in artifacts(name) if a not in before]
+    ok = result.returncode == 0 and not found
+    if not ok:
+        sys.stdout.write(result.stdout[-4000:])
+    print("%-14s %-6s %5.0f s  %s" % (name, "ok" if ok else "FAIL", time.time() - started,
+                                       ", ".join(os.path.relpath(a, ROOT) for a in found) or "no crash"))
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("command", choices=["build", "run", "replay"])
+    parser.add_argument("targets", nargs="*", help="default: all of %s" % ", ".join(TARGETS))
+    parser.add_argument("--seconds", type=int, default=60, help="fuzzing time per target")
+    parser.add_argument("--timeout", type=int, default=10, help="real seconds one input may take")
+    parser.add_argument("--cxx", help="compiler (default: clang++ if found, else g++)")
+    parser.add_argument("--arduinojson", help="ArduinoJson src/ directory")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 2)
+    args = parser.parse_args()
+
+    names = args.targets or list(TARGETS)
+    unknown = [n for n in names if n not in TARGETS]
+    if unknown:
+        raise SystemExit("unknown target(s): %s" % ", ".join(unknown))
+
+    cxx = pick_compiler(args.cxx)
+    arduinojson = find_arduinojson(args.arduinojson)
+    programs = {name: build(name, cxx, arduinojson, args.jobs) for name in names}
+    if args.command == "build":
+        return 0
+
+    ok = True
+    for name in names:
+        ok = run(name, programs[name], args.seconds, args.timeout, args.command == "replay") and ok
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,65 @@
+/**
+ * @file fuzz_dwin.cpp
+ * @brief Fuzz target: DWIN::listen() reading touch frames from the panel
+ *
+ * The input arrives on Serial1 at the panel's baud rate while listen()
+ * runs, as in the MEGA's loop(). Garbage on the HMI line (a loose
+ * connector, a panel rebooting mid-frame) must not crash the parser, make
+ * it read a frame that is not there, or hold up loop(): one listen() may
+ * take its READ_TIMEOUT (100 ms) plus CMD_READ_TIMEOUT (50 ms) to finish a
+ * frame it has started, and each wait may overshoot by one idle poll step
+ * of the sim clock (10 ms); LISTEN_BUDGET_US allows one step more. Every
+ * callback gets a VP address of at most four hex digits (the only form
+ * hmiCallback() can use).
+ */
+
+#include <Arduino.h>
+#include "DWIN.h"
+#include "FuzzSupport.h"
+
+static const size_t MAX_INPUT = 2048;
+static const uint64_t LISTEN_BUDGET_US = 180000;
+
+static DWIN *hmi = NULL;
+static unsigned long callbacks = 0;
+
+static void onFrame(String address, int lastByte, String message, String response)
+{
+    (void)lastByte;
+    (void)message;
+    (void)response;
+    FUZZ_ASSERT(address.length() <= 4, "VP address \"%s\"", address.c_str());
+    callbacks++;
+}
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    hmi = new DWIN(Serial1, 115200);
+    hmi->hmiCallBack(onFrame);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size > MAX_INPUT)
+    {
+        return 0;
+    }
+
+    // Whatever a previous input left in the buffer is not this input's
+    while (Serial1.available() > 0)
+    {
+        Serial1.read();
+    }
+
+    Serial1.inject(data, size);
+    while (Serial1.wirePending() > 0 || Serial1.available() > 0)
+    {
+        VirtualBudget budget;
+        hmi->listen();
+        budget.check(LISTEN_BUDGET_US, "DWIN::listen()");
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file fuzz_esp_ingest.cpp
+ * @brief Fuzz target: the ESP8266 reading sample and alarm lines from the MEGA
+ *
+ * Linked against esp8266_main.cpp and the ESP flavour of the shims. The
+ * input goes onto the MEGA link (Serial) at the link's baud rate and
+ * ingestSerial() drains it as loop() would: line assembly into megaLine,
+ * overflow handling, trimming, the JSON parse, alarms, the summary window
+ * and the EEPROM store. A newline is appended so the last line is parsed
+ * by this input and not carried into the next one.
+ *
+ * Beyond crashes and sanitizer reports, no input may keep ingest busy for
+ * longer than the bytes take on the wire plus INGEST_LINE_BUDGET_US for
+ * each line. Back-to-back lines can overrun the RX buffer while a sample
+ * is committed to EEPROM; the MEGA never sends that fast, so lost bytes
+ * are not an error here (they only cut lines short).
+ */
+
+#include <Arduino.h>
+#include "FuzzSupport.h"
+
+void setup();
+void ingestSerial();
+
+static const size_t MAX_INPUT = 4096;
+static const uint64_t INGEST_LINE_BUDGET_US = 100000; // EEPROM commit is 30 ms
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    setup();
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size > MAX_INPUT)
+    {
+        return 0;
+    }
+
+    VirtualBudget budget;
+    Serial.inject(data, size);
+    Serial.inject("\n");
+    while (Serial.wirePending() > 0 || Serial.available() > 0)
+    {
+        ingestSerial();
+        delay(1);
+    }
+
+    uint64_t wireUs = (uint64_t)(size + 1) * Serial.byteTimeMicros();
+    budget.check(wireUs + fuzzLineCount(data, size) * INGEST_LINE_BUDGET_US, "ingest");
+    return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file fuzz_mega_messages.cpp
+ * @brief Fuzz target: the MEGA reading TIME: and CFG: lines from the ESP8266
+ *
+ * Linked against main.cpp and the MEGA flavour of the shims. The input goes
+ * onto the ESP link (ESP8266_SERIAL) at the link's baud rate and
+ * processESPMessages() runs until it is drained, as loop() calls it.
+ *
+ * processESPMessages() runs inside the MEGA's control loop, so it must not
+ * wait for the rest of a line: no input may keep it busy for longer than
+ * the bytes take on the wire plus MESSAGE_LINE_BUDGET_US per line, even
+ * when the last line has no newline yet. A TIME: line may only set a clock
+ * between 2021 and 2100, and the settings a CFG: line can change have to
+ * stay usable: a finite moisture target and thresholds, and a sample
+ * interval of at least 200 ms.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include "FuzzSupport.h"
+#include "SystemConfig.h"
+#include "TimeSync.h"
+
+void setup();
+void processESPMessages();
+
+extern float batas_ka;
+extern float tempHigh;
+extern float tempLow;
+extern unsigned long sampleInterval;
+extern TimeSync timeSync;
+
+static const size_t MAX_INPUT = 4096;
+static const uint64_t MESSAGE_LINE_BUDGET_US = 5000;
+static const unsigned long TIME_MIN_VALID = 1609459200UL; // 2021-01-01, the firmware's own floor
+static const unsigned long TIME_MAX_VALID = 4102444800UL; // 2100-01-01
+
+static void drain()
+{
+    while (ESP8266_SERIAL.wirePending() > 0 || ESP8266_SERIAL.available() > 0)
+    {
+        processESPMessages();
+        delayMicroseconds(ESP8266_SERIAL.byteTimeMicros());
+    }
+}
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    setup();
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size > MAX_INPUT)
+    {
+        return 0;
+    }
+
+    VirtualBudget budget;
+    ESP8266_SERIAL.inject(data, size);
+    drain();
+    uint64_t wireUs = (uint64_t)size * ESP8266_SERIAL.byteTimeMicros();
+    budget.check(wireUs + fuzzLineCount(data, size) * MESSAGE_LINE_BUDGET_US, "processESPMessages()");
+
+    // Finish a last line without newline, so it does not run into the next input
+    ESP8266_SERIAL.inject("\n");
+    drain();
+
+    if (timeSync.isSynced())
+    {
+        unsigned long now = timeSync.getUnixTime();
+        FUZZ_ASSERT(now > TIME_MIN_VALID && now < TIME_MAX_VALID, "clock set to %lu", now);
+    }
+
+    FUZZ_ASSERT(isfinite(batas_ka), "batas_ka = %f", batas_ka);
+    FUZZ_ASSERT(isfinite(tempHigh) && isfinite(tempLow), "temp_high = %f, temp_low = %f", tempHigh, tempLow);
+    FUZZ_ASSERT(sampleInterval >= DATA_SAMPLE_INTERVAL_MIN, "sample_ms = %lu", sampleInterval);
+    return 0;
+}
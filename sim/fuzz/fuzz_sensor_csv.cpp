@@ -0,0 +1,62 @@
+/**
+ * @file fuzz_sensor_csv.cpp
+ * @brief Fuzz target: SensorData::fromCSV() and the toCSV() round trip
+ *
+ * Every stored record is read back through fromCSV(), and EEPROM contents
+ * survive anything (power loss mid-write, an older layout, a flipped bit),
+ * so the parser sees whatever bytes are there. The line is handed over in
+ * an allocation of exactly its size, so reading past the NUL is caught.
+ *
+ * Anything fromCSV() accepts must print again: toCSV() either fits in
+ * SENSOR_CSV_MAX or reports that it does not, and what it prints parses
+ * back to the same timestamp, status, flags and boot epoch (values are
+ * rounded to two decimals and are not compared).
+ */
+
+#include <Arduino.h>
+#include "FuzzSupport.h"
+#include "SensorData.h"
+
+static const size_t MAX_INPUT = 256;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size > MAX_INPUT)
+    {
+        return 0;
+    }
+
+    char *csv = (char *)malloc(size + 1);
+    memcpy(csv, data, size);
+    csv[size] = '\0';
+
+    SensorData parsed;
+    memset(&parsed, 0, sizeof(parsed));
+    if (parsed.fromCSV(csv))
+    {
+        char out[SENSOR_CSV_MAX];
+        size_t length = parsed.toCSV(out, sizeof(out));
+        FUZZ_ASSERT(length < sizeof(out), "toCSV() returned %u for a %u-byte buffer",
+                    (unsigned)length, (unsigned)sizeof(out));
+
+        if (length > 0)
+        {
+            FUZZ_ASSERT(strlen(out) == length, "toCSV() length %u, text \"%s\"", (unsigned)length, out);
+
+            SensorData again;
+            memset(&again, 0, sizeof(again));
+            FUZZ_ASSERT(again.fromCSV(out), "toCSV() output does not parse: \"%s\"", out);
+            FUZZ_ASSERT(again.timestamp == parsed.timestamp, "timestamp %lu -> %lu", parsed.timestamp, again.timestamp);
+            FUZZ_ASSERT(again.status == parsed.status, "status %u -> %u", parsed.status, again.status);
+            FUZZ_ASSERT(again.flags == parsed.flags, "flags %u -> %u", parsed.flags, again.flags);
+            if (parsed.flags & DATA_FLAG_UNSYNCED_TIME)
+            {
+                FUZZ_ASSERT(again.bootEpoch == parsed.bootEpoch, "boot epoch %u -> %u", parsed.bootEpoch, again.bootEpoch);
+            }
+            FUZZ_ASSERT(again.sequence == parsed.sequence, "sequence %u -> %u", parsed.sequence, again.sequence);
+        }
+    }
+
+    free(csv);
+    return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file fuzz_storage.cpp
+ * @brief Fuzz target: LocalStorage booting from an arbitrary EEPROM image
+ *
+ * The input is the EEPROM contents (up to 4 KB, the rest reads erased).
+ * initialize() has to make sense of the header (readHeader()), then every
+ * record is read back (retrieveData(), isUploaded()) and re-stamped, and
+ * the storage must still take a new sample and return it as the newest
+ * record. No access may fall outside the part, whatever the header says.
+ */
+
+#include <Arduino.h>
+#include "FuzzSupport.h"
+#include "LocalStorage.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size > EEPROMClass::CAPACITY)
+    {
+        return 0;
+    }
+
+    EEPROM.erase();
+    EEPROM.load(data, size);
+
+    LocalStorage storage;
+    FUZZ_ASSERT(storage.initialize(), "initialize() failed");
+
+    int count = storage.getRecordCount();
+    FUZZ_ASSERT(count >= 0 && count <= MAX_RECORDS, "record count %d", count);
+    FUZZ_ASSERT(storage.getFreeSpace() == MAX_RECORDS - count, "free space %d with %d records",
+                storage.getFreeSpace(), count);
+
+    SensorData record;
+    uint16_t epoch = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (storage.retrieveData(record, i) && (record.flags & DATA_FLAG_UNSYNCED_TIME))
+        {
+            epoch = record.bootEpoch;
+        }
+        storage.isUploaded(i);
+    }
+    storage.restampUnsynced(epoch, 1700000000UL);
+
+    SensorData sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.timestamp = 1700000123UL;
+    sample.setTemperature(61.25);
+    sample.setWeight(812.5);
+    sample.status = STATUS_OK;
+    FUZZ_ASSERT(storage.saveData(sample), "saveData() failed after boot");
+
+    int newest = storage.getRecordCount() - 1;
+    FUZZ_ASSERT(storage.retrieveData(record, newest), "newest record %d does not read back", newest);
+    FUZZ_ASSERT(record.timestamp == sample.timestamp, "newest record holds %lu", record.timestamp);
+    FUZZ_ASSERT(!storage.isUploaded(newest), "new record flagged as uploaded");
+
+    storage.markUploaded(0);
+    storage.removeOldest(1);
+
+    FUZZ_ASSERT(EEPROM.outOfRange() == 0, "%lu EEPROM accesses outside the part", EEPROM.outOfRange());
+    return 0;
+}
@@ -0,0 +1,366 @@
+/**
+ * @file standalone_main.cpp
+ * @brief Runs a fuzz target without libFuzzer (replay + blind mutation)
+ *
+ * clang builds link the targets with -fsanitize=fuzzer and get libFuzzer's
+ * coverage-guided engine. This driver is for compilers without it (GCC):
+ * it takes the same command line, runs every input in the corpus
+ * directories and files given, then mutated copies of them (bit flips,
+ * byte changes, insertions, deletions, splices and -dict= tokens) until
+ * -runs= inputs or -max_total_time= seconds; with neither it only replays.
+ * The mutations are blind - nothing tells it which inputs reach new code -
+ * so it is a smoke test and a crash reproducer, not a replacement.
+ *
+ * A crash (sanitizer report or abort) or an input running longer than
+ * -timeout= seconds saves the input as <artifact_prefix>crash-<hash> or
+ * timeout-<hash> and exits non-zero, as libFuzzer does.
+ *
+ * Usage: <target> [-runs=N] [-max_total_time=S] [-seed=N] [-max_len=N]
+ *                 [-timeout=S] [-dict=FILE] [-artifact_prefix=P]
+ *                 [CORPUS_DIR|FILE]...
+ */
+
+#include <dirent.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<sanitizer/common_interface_defs.h>)
+#include <sanitizer/common_interface_defs.h>
+#define HAVE_SANITIZER_CALLBACK 1
+#endif
+#endif
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) __attribute__((weak));
+
+typedef std::vector<uint8_t> Input;
+
+static const Input *current = NULL;
+static std::string artifactPrefix;
+
+static uint64_t fnv1a(const Input &input)
+{
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        hash = (hash ^ input[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Signal-safe enough for a process that is about to die
+static void saveArtifact(const char *kind)
+{
+    if (!current)
+    {
+        return;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s-%016llx", artifactPrefix.c_str(), kind, (unsigned long long)fnv1a(*current));
+    FILE *file = fopen(path, "wb");
+    if (file)
+    {
+        if (!current->empty())
+        {
+            fwrite(&(*current)[0], 1, current->size(), file);
+        }
+        fclose(file);
+        fprintf(stderr, "==standalone== input (%u bytes) saved to %s\n", (unsigned)current->size(), path);
+    }
+}
+
+static void onDeath()
+{
+    saveArtifact("crash");
+}
+
+static void onSignal(int signal)
+{
+    saveArtifact(signal == SIGALRM ? "timeout" : "crash");
+    _exit(signal == SIGALRM ? 70 : 1);
+}
+
+static bool readFile(const std::string &path, Input &out)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    out.clear();
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        out.insert(out.end(), buffer, buffer + n);
+    }
+    fclose(file);
+    return true;
+}
+
+static void collect(const std::string &path, std::vector<Input> &corpus)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+    {
+        fprintf(stderr, "Cannot read %s\n", path.c_str());
+        return;
+    }
+    if (!S_ISDIR(info.st_mode))
+    {
+        Input input;
+        if (readFile(path, input))
+        {
+            corpus.push_back(input);
+        }
+        return;
+    }
+
+    DIR *dir = opendir(path.c_str());
+    if (!dir)
+    {
+        return;
+    }
+    std::vector<std::string> names;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] != '.')
+        {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        collect(path + "/" + names[i], corpus);
+    }
+}
+
+// libFuzzer dictionary: one "token" per line, # comments, \xNN escapes
+static void loadDictionary(const char *path, std::vector<Input> &tokens)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "Cannot read %s\n", path);
+        return;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), file))
+    {
+        char *p = strchr(line, '"');
+        char *end = strrchr(line, '"');
+        if (line[0] == '#' || !p || end == p)
+        {
+            continue;
+        }
+        Input token;
+        for (p++; p < end; p++)
+        {
+            if (*p == '\\' && p[1] == 'x' && p + 3 < end)
+            {
+                char hex[3] = {p[2], p[3], 0};
+                token.push_back((uint8_t)strtoul(hex, NULL, 16));
+                p += 3;
+            }
+            else if (*p == '\\' && p + 1 < end)
+            {
+                token.push_back((uint8_t)*++p);
+            }
+            else
+            {
+                token.push_back((uint8_t)*p);
+            }
+        }
+        tokens.push_back(token);
+    }
+    fclose(file);
+}
+
+static uint32_t rng = 1;
+
+static uint32_t next()
+{
+    // xorshift32
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static const uint8_t INTERESTING[] = {0, 1, 0x7F, 0x80, 0xFF, '\r', '\n', ',', '.', '-', '"', '{', '}', ':', 0x5A, 0xA5};
+
+static void mutate(Input &input, const std::vector<Input> &corpus, const std::vector<Input> &tokens, size_t maxLen)
+{
+    unsigned steps = 1 + next() % 4;
+    for (unsigned s = 0; s < steps; s++)
+    {
+        size_t at = input.empty() ? 0 : next() % input.size();
+        switch (next() % 7)
+        {
+        case 0: // Flip a bit
+            if (!input.empty())
+                input[at] ^= (uint8_t)(1u << (next() % 8));
+            break;
+        case 1: // Interesting byte
+            if (!input.empty())
+                input[at] = INTERESTING[next() % sizeof(INTERESTING)];
+            break;
+        case 2: // Insert random bytes
+            input.insert(input.begin() + at, 1 + next() % 8, (uint8_t)next());
+            break;
+        case 3: // Delete a run
+            if (!input.empty())
+                input.erase(input.begin() + at, input.begin() + at + 1 + next() % (input.size() - at));
+            break;
+        case 4: // Dictionary token
+            if (!tokens.empty())
+            {
+                const Input &token = tokens[next() % tokens.size()];
+                input.insert(input.begin() + at, token.begin(), token.end());
+            }
+            break;
+        case 5: // Splice in a piece of another input
+            if (!corpus.empty())
+            {
+                const Input &other = corpus[next() % corpus.size()];
+                if (!other.empty())
+                {
+                    size_t from = next() % other.size();
+                    size_t length = 1 + next() % (other.size() - from);
+                    input.insert(input.begin() + at, other.begin() + from, other.begin() + from + length);
+                }
+            }
+            break;
+        default: // Repeat a run (long numbers, long lines)
+            if (!input.empty())
+            {
+                size_t length = 1 + next() % (input.size() - at);
+                Input run(input.begin() + at, input.begin() + at + length);
+                for (unsigned r = next() % 16; r > 0; r--)
+                {
+                    input.insert(input.begin() + at, run.begin(), run.end());
+                }
+            }
+            break;
+        }
+    }
+    if (input.size() > maxLen)
+    {
+        input.resize(maxLen);
+    }
+}
+
+static bool keepGoing(unsigned long run, unsigned long runs, unsigned long maxTime, time_t started)
+{
+    if (!runs && !maxTime)
+    {
+        return false; // Replay only
+    }
+    if (runs && run >= runs)
+    {
+        return false;
+    }
+    return !maxTime || (unsigned long)(time(NULL) - started) < maxTime;
+}
+
+static void execute(const Input &input, unsigned timeout)
+{
+    current = &input;
+    if (timeout)
+    {
+        alarm(timeout);
+    }
+    LLVMFuzzerTestOneInput(input.empty() ? (const uint8_t *)"" : &input[0], input.size());
+    if (timeout)
+    {
+        alarm(0);
+    }
+    current = NULL;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long runs = 0;
+    unsigned long maxTime = 0;
+    size_t maxLen = 4096;
+    unsigned timeout = 0;
+    std::vector<Input> corpus;
+    std::vector<Input> tokens;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strncmp(arg, "-runs=", 6) == 0)
+            runs = strtoul(arg + 6, NULL, 10);
+        else if (strncmp(arg, "-max_total_time=", 16) == 0)
+            maxTime = strtoul(arg + 16, NULL, 10);
+        else if (strncmp(arg, "-seed=", 6) == 0)
+            rng = (uint32_t)strtoul(arg + 6, NULL, 10) | 1;
+        else if (strncmp(arg, "-max_len=", 9) == 0)
+            maxLen = strtoul(arg + 9, NULL, 10);
+        else if (strncmp(arg, "-timeout=", 9) == 0)
+            timeout = (unsigned)strtoul(arg + 9, NULL, 10);
+        else if (strncmp(arg, "-dict=", 6) == 0)
+            loadDictionary(arg + 6, tokens);
+        else if (strncmp(arg, "-artifact_prefix=", 17) == 0)
+            artifactPrefix = arg + 17;
+        else if (arg[0] == '-')
+            fprintf(stderr, "Ignoring %s\n", arg); // libFuzzer-only flag
+        else
+            paths.push_back(arg);
+    }
+
+#ifdef HAVE_SANITIZER_CALLBACK
+    __sanitizer_set_death_callback(onDeath);
+#else
+    (void)onDeath;
+#endif
+    signal(SIGABRT, onSignal);
+    signal(SIGSEGV, onSignal);
+    signal(SIGALRM, onSignal);
+
+    if (LLVMFuzzerInitialize)
+    {
+        LLVMFuzzerInitialize(&argc, &argv);
+    }
+
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        collect(paths[i], corpus);
+    }
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        execute(corpus[i], timeout);
+    }
+    fprintf(stderr, "==standalone== replayed %u inputs\n", (unsigned)corpus.size());
+
+    time_t started = time(NULL);
+    unsigned long run = 0;
+    for (; keepGoing(run, runs, maxTime, started); run++)
+    {
+        Input input = corpus.empty() ? Input() : corpus[next() % corpus.size()];
+        mutate(input, corpus, tokens, maxLen);
+        execute(input, timeout);
+        if ((run + 1) % 10000 == 0)
+        {
+            fprintf(stderr, "==standalone== %lu mutated runs\n", run + 1);
+        }
+    }
+    if (run)
+    {
+        fprintf(stderr, "==standalone== %lu mutated runs, no crash\n", run);
+    }
+    return 0;
+}
@@ -0,0 +1,666 @@
+/**
+ * @file host_main.cpp
+ * @brief Runs the MEGA or ESP8266 firmware on the host in virtual time
+ *
+ * Built into the native_mega / native_esp environments together with the
+ * unmodified firmware sources and the shims under sim/. main() calls the
+ * firmware's setup() once and loop() until the requested amount of
+ * simulated time has passed, feeding the other board's side of the
+ * MEGA <-> ESP8266 link with synthetic traffic:
+ *
+ *   MEGA: "TIME:<unix>.<ms>" on Serial3 (as the ESP broadcasts it),
+ *         a DWIN panel on Serial1, heater/load cell/RTD from SimPlant
+ *   ESP:  sensor JSON lines on Serial (as the MEGA sends them),
+ *         WiFi, NTP and Firebase from the in-process models
+ *
+ * For the two-board co-simulation (sim/cosim/cosim.py) the link is a tty
+ * instead (--link), both processes follow the host clock from a shared
+ * start instant (--realtime, --start-ns), the ESP's Firebase calls go to
+ * an HTTP endpoint (--cloud), and faults arrive as text commands on a
+ * pipe (--control-fd), one per line:
+ *
+ *   ESP:  wifi up|down, ntp up|down, rssi <dBm>, heap <free> <max> <frag>
+ *         (heap 0 0 0 hands the figures back to the heap model)
+ *   MEGA: rtd-fault <mask>, loadcell 0|1, touch <vp> <value>
+ *
+ * ESP runs sample the heap model (SimHeap) every simulated second; the
+ * report has its extremes and --heap-log writes one CSV row per hour, the
+ * input of the multi-day soak check (sim/soak/heap_soak.py).
+ *
+ * For load tests (sim/loadgen/trace_replay.py) the ESP can replay a MEGA
+ * trace instead of the synthetic samples (--trace), with the gaps between
+ * lines divided by --speed, against an in-memory backend that answers
+ * after --cloud-latency ms and serves a --remote-config document. --stamp
+ * starts every echoed line with the virtual time, so the console can be
+ * turned into rates.
+ *
+ * Usage: <program> [--hours H] [--echo] [--stamp] [--poll-us BASE MAX]
+ *                  [--seed N] [--eeprom FILE] [--feed-ms MS] [--link TTY]
+ *                  [--realtime SCALE] [--start-ns NS] [--epoch-ms MS]
+ *                  [--control-fd FD] [--cloud HOST:PORT] [--heap-log FILE]
+ *                  [--trace FILE] [--speed X] [--cloud-latency MS]
+ *                  [--remote-config FILE]
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifdef ESP8266
+#include <ArduinoJson.h>
+#include <ESP8266WiFi.h>
+#include "SimCloud.h"
+#include "SimHttpCloud.h"
+#include <WiFiUdp.h>
+#include <Firebase_ESP_Client.h>
+#include "SystemConfig.h"
+#include <string>
+#include <vector>
+#else
+#include "SimPlant.h"
+#include "SimDwinPanel.h"
+#include "SystemConfig.h"
+#endif
+
+struct HostOptions
+{
+    double hours = 24.0;
+    bool echo = false;
+    bool stamp = false;                 // Echoed lines start with the virtual time
+    uint32_t pollBaseUs = 10;
+    uint32_t pollMaxUs = 10000;
+    unsigned long seed = 1;
+    const char *eepromFile = NULL;
+    unsigned long feedMs = 10000;       // ESP: one MEGA sample line per interval
+    unsigned long timeBroadcastMs = 60000; // MEGA: one TIME line per interval
+    const char *link = NULL;            // tty of the other board; no synthetic feed
+    double realtime = 0;                // Virtual seconds per real second, 0: jump
+    uint64_t startNs = 0;               // Shared CLOCK_MONOTONIC start, 0: now
+    uint64_t epochMs = 0;               // Unix time at virtual zero, 0: default
+    int controlFd = -1;
+    const char *cloud = NULL;
+    const char *heapLog = NULL;         // ESP: hourly heap samples (CSV)
+    const char *trace = NULL;           // ESP: MEGA lines to replay instead of feedSample()
+    double speed = 1.0;                 // Feed/trace gaps divided by this
+    long cloudLatencyMs = -1;           // ESP: in-memory backend latency, -1: default
+    const char *remoteConfig = NULL;    // ESP: JSON served at FB_CONFIG_PATH
+};
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [--hours H] [--echo] [--stamp] [--poll-us BASE MAX]\n"
+            "          [--seed N] [--eeprom FILE] [--feed-ms MS] [--link TTY]\n"
+            "          [--realtime SCALE] [--start-ns NS] [--epoch-ms MS]\n"
+            "          [--control-fd FD] [--cloud HOST:PORT] [--heap-log FILE]\n"
+            "          [--trace FILE] [--speed X] [--cloud-latency MS]\n"
+            "          [--remote-config FILE]\n",
+            program);
+}
+
+static bool parseOptions(int argc, char **argv, HostOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--hours") == 0 && hasValue)
+        {
+            options.hours = atof(argv[++i]);
+        }
+        else if (strcmp(arg, "--echo") == 0)
+        {
+            options.echo = true;
+        }
+        else if (strcmp(arg, "--stamp") == 0)
+        {
+            options.stamp = true;
+        }
+        else if (strcmp(arg, "--poll-us") == 0 && i + 2 < argc)
+        {
+            options.pollBaseUs = strtoul(argv[++i], NULL, 10);
+            options.pollMaxUs = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--seed") == 0 && hasValue)
+        {
+            options.seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--eeprom") == 0 && hasValue)
+        {
+            options.eepromFile = argv[++i];
+        }
+        else if (strcmp(arg, "--feed-ms") == 0 && hasValue)
+        {
+            options.feedMs = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--link") == 0 && hasValue)
+        {
+            options.link = argv[++i];
+        }
+        else if (strcmp(arg, "--realtime") == 0 && hasValue)
+        {
+            options.realtime = atof(argv[++i]);
+        }
+        else if (strcmp(arg, "--start-ns") == 0 && hasValue)
+        {
+            options.startNs = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--epoch-ms") == 0 && hasValue)
+        {
+            options.epochMs = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(arg, "--control-fd") == 0 && hasValue)
+        {
+            options.controlFd = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--cloud") == 0 && hasValue)
+        {
+            options.cloud = argv[++i];
+        }
+        else if (strcmp(arg, "--heap-log") == 0 && hasValue)
+        {
+            options.heapLog = argv[++i];
+        }
+        else if (strcmp(arg, "--trace") == 0 && hasValue)
+        {
+            options.trace = argv[++i];
+        }
+        else if (strcmp(arg, "--speed") == 0 && hasValue)
+        {
+            options.speed = atof(argv[++i]);
+        }
+        else if (strcmp(arg, "--cloud-latency") == 0 && hasValue)
+        {
+            options.cloudLatencyMs = atol(argv[++i]);
+        }
+        else if (strcmp(arg, "--remote-config") == 0 && hasValue)
+        {
+            options.remoteConfig = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return options.hours > 0 && options.pollBaseUs > 0 && options.pollMaxUs >= options.pollBaseUs &&
+           options.speed > 0;
+}
+
+#ifdef ESP8266
+// What the MEGA sends every cycle: a drying batch sampled from a simple curve
+static void feedSample(uint64_t nowUs)
+{
+    float hours = nowUs / 3600e6f;
+    float temp = 60.0f + random(-50, 51) / 100.0f;
+    float weight = 25.0f + 75.0f * expf(-hours / 24.0f);
+    float ka = (weight - 25.0f) / weight * 100.0f;
+
+    char line[160];
+    snprintf(line, sizeof(line),
+             "{\"temp\":%.2f,\"weight\":%.2f,\"ka\":%.2f,\"relay1\":%d,\"relay2\":0,\"cv\":0,\"ts\":%lu}\n",
+             temp, weight, ka, temp < 60.0f ? 1 : 0, (unsigned long)(SimClock::unixMillis() / 1000));
+    Serial.inject(line);
+}
+#else
+// What the ESP broadcasts once it has NTP time
+static void feedTime()
+{
+    uint64_t nowMs = SimClock::unixMillis();
+    char line[32];
+    snprintf(line, sizeof(line), "TIME:%lu.%03u\n", (unsigned long)(nowMs / 1000), (unsigned)(nowMs % 1000));
+    ESP8266_SERIAL.inject(line);
+}
+#endif
+
+#ifndef ESP8266
+static SimDwinPanel *hostPanel = NULL;
+#endif
+
+#ifdef ESP8266
+/**
+ * @class HeapWatch
+ * @brief Extremes of the ESP heap figures over the run, plus the hourly log
+ */
+class HeapWatch
+{
+public:
+    explicit HeapWatch(FILE *log)
+        : _log(log), _nextSampleUs(0), _nextLogUs(0), _minFree(0xFFFFFFFFUL), _minBlock(0xFFFFFFFFUL), _maxFrag(0)
+    {
+        if (_log)
+        {
+            fprintf(_log, "hours,free,max_block,frag,allocs,failed\n");
+        }
+    }
+
+    void update(uint64_t nowUs)
+    {
+        if (nowUs < _nextSampleUs)
+        {
+            return;
+        }
+        _nextSampleUs = nowUs + 1000000;
+
+        uint32_t free, block;
+        uint8_t frag;
+        ESP.getHeapStats(&free, &block, &frag);
+        _minFree = free < _minFree ? free : _minFree;
+        _minBlock = block < _minBlock ? block : _minBlock;
+        _maxFrag = frag > _maxFrag ? frag : _maxFrag;
+
+        if (_log && nowUs >= _nextLogUs)
+        {
+            _nextLogUs = nowUs + 3600000000ULL;
+            fprintf(_log, "%.2f,%lu,%lu,%u,%lu,%lu\n", nowUs / 3600e6, (unsigned long)free, (unsigned long)block,
+                    (unsigned)frag, SimHeap::allocations(), SimHeap::failures());
+        }
+    }
+
+    void report() const
+    {
+        fprintf(stderr, "heap      : free %lu B (min %lu), max block %lu B (min %lu), frag %u%% (max %u%%)\n",
+                (unsigned long)ESP.getFreeHeap(), (unsigned long)_minFree, (unsigned long)ESP.getMaxFreeBlockSize(),
+                (unsigned long)_minBlock, (unsigned)ESP.getHeapFragmentation(), (unsigned)_maxFrag);
+        fprintf(stderr, "            %lu allocations, %lu failed\n", SimHeap::allocations(), SimHeap::failures());
+    }
+
+private:
+    FILE *_log;
+    uint64_t _nextSampleUs;
+    uint64_t _nextLogUs;
+    uint32_t _minFree;
+    uint32_t _minBlock;
+    uint8_t _maxFrag;
+};
+
+static HeapWatch *heapWatch = NULL;
+
+/**
+ * @class TraceFeed
+ * @brief Replays a MEGA trace onto Serial, running with the clock's tasks
+ *
+ * One line per entry: "<seconds> <line>", cosim's link.log ("<unix s>
+ * M>E <line>", E>M lines skipped) or a bare line, which follows the one
+ * before it after --feed-ms. Gaps are divided by the speed; at the end the
+ * trace starts over. As a task it also runs while a request blocks
+ * loop(), and every line goes on the wire when it was due, so the UART
+ * overruns a real MEGA would cause are counted.
+ */
+class TraceFeed : public SimTask
+{
+public:
+    TraceFeed() : _index(0), _periodUs(0), _baseUs(0), _sent(0), _passes(0) {}
+
+    bool load(const char *path, unsigned long gapMs, double speed)
+    {
+        FILE *file = fopen(path, "r");
+        if (!file)
+        {
+            return false;
+        }
+
+        char text[512];
+        double first = -1, last = 0;
+        while (fgets(text, sizeof(text), file))
+        {
+            text[strcspn(text, "\r\n")] = '\0';
+            char *end;
+            double t = strtod(text, &end);
+            const char *line = text;
+            if (end != text && (*end == ' ' || *end == '\t'))
+            {
+                line = end + strspn(end, " \t");
+            }
+            else
+            {
+                t = last + gapMs / 1000.0; // Bare line
+            }
+
+            if (strncmp(line, "E>M ", 4) == 0)
+            {
+                continue;
+            }
+            if (strncmp(line, "M>E ", 4) == 0)
+            {
+                line += 4;
+            }
+            if (*line == '\0' || *line == '#')
+            {
+                continue;
+            }
+
+            if (first < 0)
+            {
+                first = t;
+            }
+            last = t;
+            _entries.push_back(Entry((uint64_t)((t - first) * 1e6 / speed), std::string(line) + "\n"));
+        }
+        fclose(file);
+
+        if (_entries.empty())
+        {
+            return false;
+        }
+        // One average gap between the last line and the start of the next pass
+        uint64_t span = _entries.back().first;
+        _periodUs = span + (_entries.size() > 1 ? span / (_entries.size() - 1) : (uint64_t)(gapMs * 1000 / speed));
+        _periodUs = _periodUs > 0 ? _periodUs : 1;
+        SimClock::addTask(this);
+        return true;
+    }
+
+    void run(uint64_t nowUs) override
+    {
+        while (_baseUs + _entries[_index].first <= nowUs)
+        {
+            const std::string &line = _entries[_index].second;
+            Serial.inject((const uint8_t *)line.data(), line.size(), _baseUs + _entries[_index].first);
+            _sent++;
+            if (++_index == _entries.size())
+            {
+                _index = 0;
+                _baseUs += _periodUs;
+                _passes++;
+            }
+        }
+    }
+
+    void report() const
+    {
+        fprintf(stderr, "trace     : %lu lines sent, %lu full passes of %u lines\n", _sent, _passes,
+                (unsigned)_entries.size());
+    }
+
+private:
+    typedef std::pair<uint64_t, std::string> Entry;
+
+    std::vector<Entry> _entries;
+    size_t _index;
+    uint64_t _periodUs;
+    uint64_t _baseUs;
+    unsigned long _sent;
+    unsigned long _passes;
+};
+
+static TraceFeed *traceFeed = NULL;
+static SimMemoryCloud *memoryCloud = NULL;
+
+// What an operator would have set at FB_CONFIG_PATH; the firmware finds it
+// through its normal version poll
+static bool loadRemoteConfig(const char *path, SimMemoryCloud &cloud)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        return false;
+    }
+    char json[512];
+    size_t length = fread(json, 1, sizeof(json) - 1, file);
+    fclose(file);
+    json[length] = '\0';
+
+    StaticJsonDocument<384> doc;
+    if (deserializeJson(doc, json))
+    {
+        return false;
+    }
+    char version[16];
+    snprintf(version, sizeof(version), "%lu", doc["version"] | 1UL);
+
+    String response;
+    cloud.handle("PUT", "rtdb" FB_CONFIG_PATH, json, response);
+    cloud.handle("PUT", "rtdb" FB_CONFIG_PATH "/version", version, response);
+    return true;
+}
+#endif
+
+/**
+ * @class SimControl
+ * @brief Fault commands from the co-simulation runner, one per line
+ */
+class SimControl : public SimTask
+{
+public:
+    explicit SimControl(int fd) : _fd(fd), _length(0)
+    {
+        fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+        SimClock::addTask(this);
+    }
+
+    void run(uint64_t nowUs) override
+    {
+        (void)nowUs;
+        char c;
+        while (::read(_fd, &c, 1) == 1)
+        {
+            if (c != '\n' && _length < sizeof(_line) - 1)
+            {
+                _line[_length++] = c;
+                continue;
+            }
+            _line[_length] = '\0';
+            _length = 0;
+            apply(_line);
+        }
+    }
+
+private:
+    int _fd;
+    char _line[64];
+    size_t _length;
+
+    static void apply(const char *line)
+    {
+        char command[16] = "";
+        long a = 0, b = 0, c = 0;
+        char word[8] = "";
+        int n = sscanf(line, "%15s %7s", command, word);
+        sscanf(line, "%*s %li %li %li", &a, &b, &c);
+        bool on = strcmp(word, "up") == 0 || strcmp(word, "1") == 0;
+
+#ifdef ESP8266
+        if (strcmp(command, "wifi") == 0 && n == 2)
+        {
+            SimWiFi::setApUp(on);
+        }
+        else if (strcmp(command, "ntp") == 0 && n == 2)
+        {
+            SimNtpServer::setUp(on);
+        }
+        else if (strcmp(command, "rssi") == 0 && n == 2)
+        {
+            SimWiFi::setRssi(a);
+        }
+        else if (strcmp(command, "heap") == 0 && n == 2)
+        {
+            ESP.setHeap(a, b, c);
+        }
+#else
+        if (strcmp(command, "rtd-fault") == 0 && n == 2)
+        {
+            SimPlant::setRtdFault((uint8_t)a);
+        }
+        else if (strcmp(command, "loadcell") == 0 && n == 2)
+        {
+            SimPlant::setLoadCellPresent(on);
+        }
+        else if (strcmp(command, "touch") == 0 && n == 2 && hostPanel)
+        {
+            hostPanel->touch((uint16_t)a, (uint16_t)b);
+        }
+#endif
+        else
+        {
+            fprintf(stderr, "control: ignored '%s'\n", line);
+        }
+    }
+};
+
+static void report(const HostOptions &options, double wallSeconds, unsigned long loops)
+{
+    double simHours = SimClock::nowMicros() / 3600e6;
+    fprintf(stderr, "\n---- host simulation ----\n");
+    fprintf(stderr, "simulated : %.2f h in %lu loop() calls\n", simHours, loops);
+    fprintf(stderr, "wall time : %.2f s (%.0f simulated hours/minute)\n", wallSeconds,
+            wallSeconds > 0 ? simHours * 60.0 / wallSeconds : 0.0);
+    fprintf(stderr, "serial    : %s rx %lu B / tx %lu B, %lu RX overruns\n", Serial.name(),
+            Serial.rxBytes(), Serial.txBytes(), Serial.rxOverruns());
+#ifdef ESP8266
+    fprintf(stderr, "eeprom    : %lu byte writes, %lu commits, hottest cell %u writes\n",
+            EEPROM.writeCount(), EEPROM.commitCount(), (unsigned)EEPROM.maxCellWrites());
+    fprintf(stderr, "wifi      : %lu connects, %lu drops\n", SimWiFi::connects(), SimWiFi::drops());
+    fprintf(stderr, "firebase  : %lu requests, %lu token refreshes\n", Firebase.requests(), Firebase.refreshes());
+    if (memoryCloud)
+    {
+        fprintf(stderr, "cloud     : %u sensor_data, %u sensor_summary, %u alarms documents\n",
+                (unsigned)memoryCloud->count("firestore/sensor_data/"),
+                (unsigned)memoryCloud->count("firestore/sensor_summary/"),
+                (unsigned)memoryCloud->count("firestore/alarms/"));
+    }
+    if (traceFeed)
+    {
+        traceFeed->report();
+    }
+    heapWatch->report();
+#else
+    fprintf(stderr, "esp link  : %s rx %lu B / tx %lu B, %lu RX overruns\n", ESP8266_SERIAL.name(),
+            ESP8266_SERIAL.rxBytes(), ESP8266_SERIAL.txBytes(), ESP8266_SERIAL.rxOverruns());
+    fprintf(stderr, "eeprom    : %lu byte writes, hottest cell %u writes\n", EEPROM.writeCount(),
+            (unsigned)EEPROM.maxCellWrites());
+    fprintf(stderr, "plant     : %.1f C, %.2f kg\n", SimPlant::temperature(), SimPlant::mass());
+#endif
+    (void)options;
+}
+
+int main(int argc, char **argv)
+{
+    HostOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    SimClock::setPollStep(options.pollBaseUs, options.pollMaxUs);
+    if (options.epochMs)
+    {
+        SimClock::setEpoch(options.epochMs);
+    }
+    if (options.realtime > 0)
+    {
+        SimClock::setRealtime(options.realtime, options.startNs ? options.startNs : SimClock::hostNanos());
+    }
+    randomSeed(options.seed);
+    if (options.eepromFile)
+    {
+        EEPROM.load(options.eepromFile); // A missing file is a blank part
+    }
+    if (options.echo)
+    {
+        Serial.echoTo(stdout, options.stamp);
+    }
+
+#ifdef ESP8266
+    HardwareSerial &link = Serial;
+    SimHttpCloud *httpCloud = options.cloud ? new SimHttpCloud(options.cloud) : NULL;
+    if (httpCloud)
+    {
+        SimCloud::install(httpCloud);
+    }
+    else
+    {
+        memoryCloud = new SimMemoryCloud();
+        if (options.cloudLatencyMs >= 0)
+        {
+            memoryCloud->setLatencyMs((uint32_t)options.cloudLatencyMs);
+        }
+        if (options.remoteConfig && !loadRemoteConfig(options.remoteConfig, *memoryCloud))
+        {
+            fprintf(stderr, "Cannot read %s\n", options.remoteConfig);
+            return 1;
+        }
+        SimCloud::install(memoryCloud);
+    }
+    if (options.trace)
+    {
+        traceFeed = new TraceFeed();
+        if (!traceFeed->load(options.trace, options.feedMs, options.speed))
+        {
+            fprintf(stderr, "Cannot read %s (or no lines in it)\n", options.trace);
+            return 1;
+        }
+    }
+    FILE *heapLog = options.heapLog ? fopen(options.heapLog, "w") : NULL;
+    if (options.heapLog && !heapLog)
+    {
+        fprintf(stderr, "Cannot write %s\n", options.heapLog);
+        return 1;
+    }
+    heapWatch = new HeapWatch(heapLog);
+#else
+    HardwareSerial &link = ESP8266_SERIAL;
+#endif
+    if (options.link && !link.bind(options.link))
+    {
+        fprintf(stderr, "Cannot open %s\n", options.link);
+        return 1;
+    }
+    SimControl *control = options.controlFd >= 0 ? new SimControl(options.controlFd) : NULL;
+    (void)control;
+
+#ifndef ESP8266
+    SimPlant::reset();
+    SimDwinPanel panel(Serial1);
+    hostPanel = &panel;
+#endif
+
+    uint64_t endUs = (uint64_t)(options.hours * 3600e6);
+    uint64_t nextFeedUs = 0;
+    unsigned long loops = 0;
+    uint64_t startedNs = SimClock::hostNanos();
+
+    setup();
+    while (SimClock::nowMicros() < endUs)
+    {
+        uint64_t now = SimClock::nowMicros();
+        if (!options.link && now >= nextFeedUs)
+        {
+#ifdef ESP8266
+            if (!traceFeed)
+            {
+                feedSample(now);
+            }
+            nextFeedUs = now + (uint64_t)(options.feedMs * 1000 / options.speed);
+#else
+            feedTime();
+            nextFeedUs = now + (uint64_t)options.timeBroadcastMs * 1000;
+#endif
+        }
+
+        loop();
+        loops++;
+#ifdef ESP8266
+        heapWatch->update(SimClock::nowMicros());
+#endif
+    }
+
+    double wallSeconds = (SimClock::hostNanos() - startedNs) / 1e9;
+    report(options, wallSeconds, loops);
+#ifdef ESP8266
+    if (heapLog)
+    {
+        fclose(heapLog);
+    }
+#endif
+
+    if (options.eepromFile && !EEPROM.save(options.eepromFile))
+    {
+        fprintf(stderr, "Cannot write %s\n", options.eepromFile);
+        return 1;
+    }
+    return 0;
+}
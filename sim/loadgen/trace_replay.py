@@ -0,0 +1,433 @@
+#!/usr/bin/env python3
+"""
+Trace replay load test of the ESP8266 ingest -> store -> upload pipeline.
+
+Replays a MEGA trace (sample and alarm lines as the MEGA sends them) into
+the ESP at 1x to 1000x its recorded pace and measures what each stage of
+the pipeline keeps up with:
+
+    ingest    lines parsed (DATA:Using..., ALARM:Queued); the rest were lost
+              on the wire/UART (RX overruns) or arrived damaged
+              (STATUS:JSON parse error / too large)
+    storage   samples committed to EEPROM (SAVED:n/125); a commit into a
+              full ring evicts the oldest record, uploaded or not
+    upload    records sent to Firestore (LIVE: + UPLOADED:n)
+
+For every configuration it prints a saturation curve, one row per speed
+with the offered rate and the rate each stage reached, and the first
+speed at which each stage drops samples. The rates come from the ESP's
+own console, time-stamped, so the numbers mean the same on both targets.
+The per-sample lines (DATA:, SAVED:, LIVE:) are not sent on the MEGA link
+by default; the firmware has to be built with ESP_SAMPLE_ECHO=1:
+
+    host build  .pio/build/native_esp_echo/program --trace ... --speed ...
+                runs in virtual time (a 15-minute point takes well under a
+                second) against the in-memory Firebase backend
+    a board     flashed with -DESP_SAMPLE_ECHO=1 in build_flags,
+                --port /dev/ttyUSB0: the trace is written to the ESP's
+                serial port in real time and its console read back. The
+                MEGA must be disconnected, the board keeps its own WiFi,
+                Firebase and remote config (--config keys other than the
+                name do not apply), and the backlog from one point is
+                drained for --settle seconds before the next.
+
+The trace is either --trace FILE ("<seconds> <line>" per line, cosim's
+link.log, or bare lines --interval-ms apart) or a synthetic drying batch
+written to --out. A configuration is NAME[:key=value,...]: latency (ms,
+in-memory backend), wifi (up|down), and any remote config field
+(raw_mode, raw_decimation, upload_batch, agg_window_s):
+
+    python3 sim/loadgen/trace_replay.py
+    python3 sim/loadgen/trace_replay.py --config baseline \\
+        --config slow_cloud:latency=800 --config summaries:raw_mode=2 \\
+        --speeds 1,10,100,1000 --csv curve.csv
+    python3 sim/loadgen/trace_replay.py --port /dev/ttyUSB0 --speeds 1,10,50 --seconds 300
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import json
+import math
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+import termios
+import threading
+import time
+
+DEFAULT_PROGRAM = ".pio/build/native_esp_echo/program"
+DEFAULT_SPEEDS = "1,2,5,10,20,50,100,200,500,1000"
+MAX_RECORDS = 125  # MAX_LOCAL_RECORDS in SystemConfig.h
+
+# Tolerances before a stage counts as dropping samples
+LINK_LOSS = 0.01      # lines lost or damaged per line sent
+UPLOAD_SHORTFALL = 0.05  # commits not matched by uploads
+
+# Console line -> counter (first match wins)
+EVENTS = [
+    ("ingested", re.compile(r"^DATA:Using ")),
+    ("alarms", re.compile(r"^ALARM:Queued ")),
+    ("damaged", re.compile(r"^STATUS:JSON (parse error|too large)")),
+    ("committed", re.compile(r"^SAVED:(\d+)/")),
+    ("failed", re.compile(r"^STATUS:Sample dropped")),
+    ("summaries", re.compile(r"^SUMMARY:(\d+) windows")),
+    ("live", re.compile(r"^LIVE:")),
+    ("backfilled", re.compile(r"^UPLOADED:(\d+) records, (\d+) remaining")),
+    ("upload_errors", re.compile(r"^STATUS:Upload error")),
+]
+STAMPED = re.compile(r"^(\d+\.\d+) (.*)$")
+
+
+def synthetic_trace(path, samples, interval_ms, alarm_every, seed):
+    """A drying batch as sim/host_main.cpp feeds it, with an alarm every N samples."""
+    rng = random.Random(seed)
+    with open(path, "w") as f:
+        f.write("# synthetic MEGA trace: %d samples, %d ms apart\n" % (samples, interval_ms))
+        for i in range(samples):
+            t = i * interval_ms / 1000.0
+            hours = t / 3600.0
+            temp = 60.0 + rng.uniform(-0.5, 0.5)
+            weight = 25.0 + 75.0 * math.exp(-hours / 24.0)
+            ka = (weight - 25.0) / weight * 100.0
+            f.write('%.3f {"temp":%.2f,"weight":%.2f,"ka":%.2f,"relay1":%d,"relay2":0,"cv":0,"ts":%d}\n' % (
+                t, temp, weight, ka, 1 if temp < 60.0 else 0, int(t)))
+            if alarm_every and (i + 1) % alarm_every == 0:
+                f.write('%.3f {"alarm":"TEMP_HIGH","val":%.2f,"ts":%d,"age":40}\n' % (t + 0.5, temp + 20, int(t)))
+
+
+def load_trace(path, interval_ms):
+    """(offset s, line) entries, parsed like TraceFeed in sim/host_main.cpp."""
+    entries = []
+    first = None
+    last = 0.0
+    with open(path, errors="replace") as f:
+        for raw in f:
+            text = raw.rstrip("\r\n")
+            head, _, rest = text.partition(" ")
+            try:
+                t = float(head)
+                line = rest.lstrip(" \t")
+            except ValueError:
+                t = last + interval_ms / 1000.0
+                line = text
+            if line.startswith("E>M "):
+                continue
+            if line.startswith("M>E "):
+                line = line[4:]
+            if not line or line.startswith("#"):
+                continue
+            first = t if first is None else first
+            last = t
+            entries.append((t - first, line))
+    if not entries:
+        raise SystemExit("%s: no lines to replay" % path)
+    return entries
+
+
+def schedule(entries, speed, interval_ms, until_s):
+    """Send times (s) and lines of the replay, passes repeating like TraceFeed."""
+    span = entries[-1][0] / speed
+    gap = span / (len(entries) - 1) if len(entries) > 1 else interval_ms / 1000.0 / speed
+    period = max(span + gap, 1e-6)
+    base = 0.0
+    while True:
+        for offset, line in entries:
+            t = base + offset / speed
+            if t >= until_s:
+                return
+            yield t, line
+        base += period
+
+
+def parse_config(text):
+    name, _, spec = text.partition(":")
+    config = {"name": name, "latency": None, "wifi": "up", "remote": {}}
+    for item in filter(None, spec.split(",")):
+        key, _, value = item.partition("=")
+        if key == "latency":
+            config["latency"] = int(value)
+        elif key == "wifi":
+            config["wifi"] = value
+        else:
+            config["remote"][key] = int(value) if value.lstrip("-").isdigit() else float(value)
+    return config
+
+
+class Tally:
+    """Stage counters from the stamped console, split at the warm-up."""
+
+    def __init__(self, warmup):
+        self.warmup = warmup
+        self.counts = {name: 0 for name, _ in EVENTS}
+        self.counts["uploaded"] = 0
+        self.counts["evicted"] = 0
+        self.backlog = 0
+        self.backlog_max = 0
+        self.uploaded_total = 0  # Warm-up included, to compare with the backend
+        self.report = {}
+
+    def line(self, t, text):
+        for name, pattern in EVENTS:
+            match = pattern.match(text)
+            if not match:
+                continue
+            evicted = False
+            if name == "committed":
+                evicted = self.backlog >= MAX_RECORDS
+                self.backlog = int(match.group(1))
+            elif name == "backfilled":
+                self.backlog = int(match.group(2))
+                self.uploaded_total += int(match.group(1))
+            elif name == "live":
+                self.uploaded_total += 1
+            self.backlog_max = max(self.backlog_max, self.backlog)
+            if t < self.warmup:
+                return
+            if name == "backfilled":
+                self.counts["uploaded"] += int(match.group(1))
+            elif name == "live":
+                self.counts["uploaded"] += 1
+            if evicted:
+                self.counts["evicted"] += 1
+            self.counts[name] += int(match.group(1)) if name == "summaries" else 1
+            return
+
+
+def parse_report(stderr):
+    """Figures only the host build knows, from its end-of-run report."""
+    report = {}
+    match = re.search(r"(\d+) RX overruns", stderr)
+    if match:
+        report["overrun_bytes"] = int(match.group(1))
+    match = re.search(r"(\d+) commits", stderr)
+    if match:
+        report["eeprom_commits"] = int(match.group(1))
+    match = re.search(r"cloud     : (\d+) sensor_data", stderr)
+    if match:
+        report["sensor_docs"] = int(match.group(1))
+    return report
+
+
+def run_sim(args, config, speed, trace_path, workdir):
+    tally = Tally(args.warmup)
+    command = [args.esp, "--hours", str(args.seconds / 3600.0), "--echo", "--stamp", "--seed", str(args.seed),
+               "--trace", trace_path, "--speed", str(speed), "--feed-ms", str(args.interval_ms)]
+    if config["latency"] is not None:
+        command += ["--cloud-latency", str(config["latency"])]
+    if config["remote"]:
+        remote = dict(config["remote"])
+        remote.setdefault("version", 1)
+        path = os.path.join(workdir, "%s.json" % config["name"])
+        with open(path, "w") as f:
+            json.dump(remote, f)
+        command += ["--remote-config", path]
+
+    control = None
+    if config["wifi"] == "down":
+        control, writer = os.pipe()
+        os.write(writer, b"wifi down\n")
+        os.close(writer)
+        command += ["--control-fd", str(control)]
+
+    with tempfile.TemporaryFile(mode="w+") as errors:
+        process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=errors, text=True, errors="replace",
+                                   pass_fds=(control,) if control is not None else ())
+        if control is not None:
+            os.close(control)
+        for raw in process.stdout:
+            match = STAMPED.match(raw.rstrip("\r\n"))
+            if match:
+                tally.line(float(match.group(1)), match.group(2))
+        code = process.wait()
+        errors.seek(0)
+        stderr = errors.read()
+    if code != 0:
+        sys.stderr.write(stderr)
+        raise SystemExit("%s exited with %d" % (args.esp, code))
+    tally.report = parse_report(stderr)
+    return tally
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    attrs = termios.tcgetattr(fd)
+    attrs[0] = attrs[1] = attrs[3] = 0  # Raw: no translation, no echo
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    speed = getattr(termios, "B%d" % baud)
+    attrs[4] = attrs[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+def run_board(args, entries, speed):
+    """Write the schedule to the board in real time, stamp what it prints."""
+    tally = Tally(args.warmup)
+    fd = open_port(args.port, args.baud)
+    started = time.monotonic()
+    stop = threading.Event()
+
+    def reader():
+        pending = b""
+        while not stop.is_set():
+            try:
+                data = os.read(fd, 4096)
+            except OSError:
+                break
+            now = time.monotonic() - started
+            lines = (pending + data).split(b"\n")
+            pending = lines.pop()
+            for line in lines:
+                tally.line(now, line.decode(errors="replace").strip())
+
+    thread = threading.Thread(target=reader, daemon=True)
+    thread.start()
+    for t, line in schedule(entries, speed, args.interval_ms, args.seconds):
+        delay = t - (time.monotonic() - started)
+        if delay > 0:
+            time.sleep(delay)
+        os.write(fd, (line + "\n").encode())
+    time.sleep(max(0.0, args.seconds - (time.monotonic() - started)))
+    stop.set()
+    os.close(fd)
+    thread.join(1.0)
+    return tally
+
+
+def point(args, speed, tally, sent):
+    window = args.seconds - args.warmup
+    c = tally.counts
+    received = c["ingested"] + c["alarms"]
+    row = {
+        "speed": speed,
+        "sent": sent,
+        "offered_per_s": sent / window,
+        "ingest_per_s": received / window,
+        "commit_per_s": c["committed"] / window,
+        "upload_per_s": c["uploaded"] / window,
+        "lost": max(0, sent - received - c["damaged"]),
+        "damaged": c["damaged"],
+        "evicted": c["evicted"],
+        "store_failed": c["failed"],
+        "summaries": c["summaries"],
+        "upload_errors": c["upload_errors"],
+        "backlog_end": tally.backlog,
+        "backlog_max": tally.backlog_max,
+    }
+    row.update(tally.report)
+    if "sensor_docs" in row:
+        # Each sample has its own document; fewer documents than uploads means
+        # a sample was stored twice or two shared an ID
+        row["overwritten"] = max(0, tally.uploaded_total - row["sensor_docs"])
+    row["link_drops"] = (row["lost"] + row["damaged"]) > LINK_LOSS * sent
+    row["storage_drops"] = row["evicted"] + row["store_failed"] > 0
+    row["upload_behind"] = c["uploaded"] < (1 - UPLOAD_SHORTFALL) * c["committed"]
+    return row
+
+
+def print_curve(config, rows):
+    settings = ", ".join(["latency=%s" % config["latency"]] if config["latency"] is not None else [])
+    settings = ", ".join(filter(None, [settings, "wifi=%s" % config["wifi"]] +
+                                ["%s=%s" % kv for kv in sorted(config["remote"].items())]))
+    print("\n---- %s (%s) ----" % (config["name"], settings))
+    print(" speed  offered/s  ingest/s  commit/s  upload/s  backlog  lost  damaged  evicted  overrun B")
+    for r in rows:
+        print("%5gx  %9.2f  %8.2f  %8.2f  %8.2f  %3d/%-3d  %4d  %7d  %7d  %9s" % (
+            r["speed"], r["offered_per_s"], r["ingest_per_s"], r["commit_per_s"], r["upload_per_s"],
+            r["backlog_end"], r["backlog_max"], r["lost"], r["damaged"], r["evicted"] + r["store_failed"],
+            r.get("overrun_bytes", "-")))
+
+    def first(flag):
+        hit = next((r for r in rows if r[flag]), None)
+        return "%gx (%.1f lines/s)" % (hit["speed"], hit["offered_per_s"]) if hit else "none up to %gx" % rows[-1]["speed"]
+
+    peak = max(rows, key=lambda r: r["upload_per_s"])
+    print("drops     : link %s, storage %s; uploads fall behind at %s" % (
+        first("link_drops"), first("storage_drops"), first("upload_behind")))
+    print("capacity  : ingest peaks at %.1f lines/s, commits at %.1f/s, uploads at %.1f records/s (%gx)" % (
+        max(r["ingest_per_s"] for r in rows), max(r["commit_per_s"] for r in rows),
+        peak["upload_per_s"], peak["speed"]))
+    overwritten = sum(r.get("overwritten", 0) for r in rows)
+    if overwritten:
+        print("            %d uploads overwrote an existing sensor_data document" % overwritten)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--trace", help="MEGA trace to replay (default: synthetic)")
+    parser.add_argument("--config", action="append", help="NAME[:key=value,...], repeatable (default: baseline)")
+    parser.add_argument("--speeds", default=DEFAULT_SPEEDS, help="replay speeds, comma separated")
+    parser.add_argument("--seconds", type=float, default=900, help="length of one point (virtual or real)")
+    parser.add_argument("--warmup", type=float, default=60, help="seconds left out of the rates (WiFi, auth, time)")
+    parser.add_argument("--interval-ms", type=int, default=10000, help="sample interval of synthetic and bare-line traces")
+    parser.add_argument("--alarm-every", type=int, default=0, help="synthetic trace: one alarm per N samples")
+    parser.add_argument("--esp", default=DEFAULT_PROGRAM, help="native_esp_echo build to run")
+    parser.add_argument("--port", help="serial port of a real ESP8266 instead of the host build")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--settle", type=float, default=60, help="board: idle seconds between points")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 2, help="host build: points run in parallel")
+    parser.add_argument("--out", default="loadgen_out", help="directory for the synthetic trace and configs")
+    parser.add_argument("--csv", help="write every point here")
+    parser.add_argument("--json", help="write the curves here as JSON")
+    args = parser.parse_args()
+
+    speeds = sorted(float(s) for s in args.speeds.split(","))
+    if args.seconds <= args.warmup or min(speeds) <= 0:
+        raise SystemExit("need --seconds > --warmup and positive speeds")
+    if not args.port and not os.path.exists(args.esp):
+        raise SystemExit("%s not found: run `pio run -e native_esp_echo` first" % args.esp)
+
+    os.makedirs(args.out, exist_ok=True)
+    trace_path = args.trace
+    if not trace_path:
+        # Enough samples that even 1000x does not repeat within a point
+        trace_path = os.path.join(args.out, "synthetic_trace.txt")
+        samples = int(args.seconds * 1000 / args.interval_ms * max(speeds)) + 1
+        synthetic_trace(trace_path, min(samples, 200000), args.interval_ms, args.alarm_every, args.seed)
+    entries = load_trace(trace_path, args.interval_ms)
+
+    configs = [parse_config(c) for c in (args.config or ["baseline"])]
+    if args.port and any(c["latency"] is not None or c["remote"] or c["wifi"] != "up" for c in configs):
+        print("trace_replay: a board keeps its own network and config; only the names apply", file=sys.stderr)
+
+    results = {}
+    for config in configs:
+        sent = {s: sum(1 for t, _ in schedule(entries, s, args.interval_ms, args.seconds) if t >= args.warmup)
+                for s in speeds}
+        if args.port:
+            tallies = {}
+            for i, speed in enumerate(speeds):
+                if i or config is not configs[0]:
+                    time.sleep(args.settle)
+                print("trace_replay: %s at %gx for %.0f s" % (config["name"], speed, args.seconds), file=sys.stderr)
+                tallies[speed] = run_board(args, entries, speed)
+        else:
+            with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+                futures = {s: pool.submit(run_sim, args, config, s, trace_path, args.out) for s in speeds}
+                tallies = {s: f.result() for s, f in futures.items()}
+        rows = [point(args, s, tallies[s], sent[s]) for s in speeds]
+        results[config["name"]] = {"config": config, "points": rows}
+        print_curve(config, rows)
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            fields = ["config"] + list(next(iter(results.values()))["points"][0].keys())
+            writer = csv.DictWriter(f, fieldnames=fields, extrasaction="ignore")
+            writer.writeheader()
+            for name, result in results.items():
+                for row in result["points"]:
+                    writer.writerow(dict(row, config=name))
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"trace": trace_path, "seconds": args.seconds, "warmup": args.warmup,
+                       "target": args.port or args.esp, "results": results}, f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
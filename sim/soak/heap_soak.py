@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Multi-day heap soak of the ESP8266 firmware on the host build.
+
+Runs .pio/build/native_esp/program for --days of virtual time with
+--heap-log, so every String and Firebase document the firmware allocates
+goes through the ESP8266 heap model (sim/arduino/SimHeap.h), and checks
+the hourly samples for a heap that is not flat:
+
+    free heap      least-squares slope after the warm-up, bytes/hour
+    largest block  same, bytes/hour
+    fragmentation  same, points/day
+    failed allocs  any at all
+
+A week takes a few seconds. The first --warmup-hours are left out of the
+fit: token caches, the first summary window and the WiFi cache settle
+there. Exits 1 when a limit is exceeded, so it can gate a change to the
+ingest/store/upload paths. --json keeps the numbers.
+"""
+
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+DEFAULT_PROGRAM = ".pio/build/native_esp/program"
+
+
+def slope(xs, ys):
+    """Least-squares slope of ys over xs (0 with fewer than 3 points)."""
+    n = len(xs)
+    if n < 3:
+        return 0.0
+    mean_x = sum(xs) / n
+    mean_y = sum(ys) / n
+    sxx = sum((x - mean_x) ** 2 for x in xs)
+    sxy = sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, ys))
+    return sxy / sxx if sxx else 0.0
+
+
+def run(program, days, seed, log_path):
+    command = [program, "--hours", str(days * 24), "--seed", str(seed), "--heap-log", log_path]
+    result = subprocess.run(command, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stderr)
+        raise SystemExit("%s exited with %d" % (program, result.returncode))
+    return result.stderr
+
+
+def load(log_path):
+    with open(log_path) as f:
+        return [
+            {
+                "hours": float(row["hours"]),
+                "free": int(row["free"]),
+                "max_block": int(row["max_block"]),
+                "frag": int(row["frag"]),
+                "allocs": int(row["allocs"]),
+                "failed": int(row["failed"]),
+            }
+            for row in csv.DictReader(f)
+        ]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--program", default=DEFAULT_PROGRAM, help="native_esp build to run")
+    parser.add_argument("--days", type=float, default=7, help="virtual days to run")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--warmup-hours", type=float, default=6, help="hours left out of the fit")
+    parser.add_argument("--max-leak", type=float, default=16, help="free heap loss allowed, bytes/hour")
+    parser.add_argument("--max-frag", type=float, default=1, help="fragmentation growth allowed, points/day")
+    parser.add_argument("--csv", help="keep the hourly samples here")
+    parser.add_argument("--json", help="write the summary to this file")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.program):
+        raise SystemExit("%s not found (pio run -e native_esp)" % args.program)
+
+    log_path = args.csv or tempfile.mktemp(prefix="heap_soak_", suffix=".csv")
+    run(args.program, args.days, args.seed, log_path)
+    rows = load(log_path)
+    if not args.csv:
+        os.unlink(log_path)
+
+    settled = [r for r in rows if r["hours"] >= args.warmup_hours]
+    if len(settled) < 3:
+        raise SystemExit("too few samples after the warm-up; run longer")
+
+    hours = [r["hours"] for r in settled]
+    summary = {
+        "days": args.days,
+        "samples": len(rows),
+        "free_start": settled[0]["free"],
+        "free_end": settled[-1]["free"],
+        "free_min": min(r["free"] for r in rows),
+        "block_min": min(r["max_block"] for r in rows),
+        "frag_max": max(r["frag"] for r in rows),
+        "free_slope_bph": slope(hours, [r["free"] for r in settled]),
+        "block_slope_bph": slope(hours, [r["max_block"] for r in settled]),
+        "frag_slope_per_day": slope(hours, [r["frag"] for r in settled]) * 24,
+        "allocs_per_hour": (rows[-1]["allocs"] - rows[0]["allocs"]) / max(rows[-1]["hours"] - rows[0]["hours"], 1e-9),
+        "failed": rows[-1]["failed"],
+    }
+
+    print("day   free min   block min   frag max")
+    day = 0
+    while day * 24 < rows[-1]["hours"]:
+        in_day = [r for r in rows if day * 24 <= r["hours"] < (day + 1) * 24]
+        if in_day:
+            print("%3d %10d %11d %9d%%" % (day + 1, min(r["free"] for r in in_day),
+                                           min(r["max_block"] for r in in_day), max(r["frag"] for r in in_day)))
+        day += 1
+
+    print()
+    print("free heap     %d -> %d B, slope %+.1f B/h" % (summary["free_start"], summary["free_end"], summary["free_slope_bph"]))
+    print("largest block min %d B, slope %+.1f B/h" % (summary["block_min"], summary["block_slope_bph"]))
+    print("fragmentation max %d%%, slope %+.2f points/day" % (summary["frag_max"], summary["frag_slope_per_day"]))
+    print("allocations   %.0f per hour, %d failed" % (summary["allocs_per_hour"], summary["failed"]))
+
+    problems = []
+    if summary["free_slope_bph"] < -args.max_leak or summary["block_slope_bph"] < -args.max_leak:
+        problems.append("heap shrinking faster than %g B/h" % args.max_leak)
+    if summary["frag_slope_per_day"] > args.max_frag:
+        problems.append("fragmentation growing faster than %g points/day" % args.max_frag)
+    if summary["failed"]:
+        problems.append("%d allocations failed" % summary["failed"])
+    summary["flat"] = not problems
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(summary, f, indent=2)
+
+    print()
+    if problems:
+        print("NOT FLAT: " + "; ".join(problems))
+        return 1
+    print("FLAT")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,124 @@
+/**
+ * @file AuthCache.cpp
+ * @brief Persisted Firebase session tokens implementation
+ */
+
+#include "AuthCache.h"
+#include <ArduinoJson.h>
+
+#if defined(ESP8266)
+#include <LittleFS.h>
+#endif
+
+const char *AuthCache::AUTH_FILE = "/auth.json";
+
+AuthCache::AuthCache()
+    : _expiresAt(0)
+{
+}
+
+bool AuthCache::load()
+{
+#if defined(ESP8266)
+    File file = LittleFS.open(AUTH_FILE, "r");
+    if (!file)
+    {
+        return false;
+    }
+
+    // ID tokens are ~1 KB; only held while loading
+    DynamicJsonDocument doc(1536);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error)
+    {
+        Serial.println(F("STATUS:Persisted auth unreadable"));
+        return false;
+    }
+
+    _idToken = doc["id_token"] | "";
+    _refreshToken = doc["refresh_token"] | "";
+    _expiresAt = doc["expires"] | 0UL;
+
+    return isValid();
+#else
+    return false;
+#endif
+}
+
+bool AuthCache::save(const String &idToken, const String &refreshToken, unsigned long expiresAt)
+{
+    if (idToken.length() == 0 || refreshToken.length() == 0)
+    {
+        return false;
+    }
+
+    // Token status callbacks repeat; only a new token is worth a flash write
+    if (idToken == _idToken && refreshToken == _refreshToken)
+    {
+        return true;
+    }
+
+    _idToken = idToken;
+    _refreshToken = refreshToken;
+    _expiresAt = expiresAt;
+    return write();
+}
+
+bool AuthCache::saveExpiry(unsigned long expiresAt)
+{
+    if (!isValid() || expiresAt == _expiresAt)
+    {
+        return false;
+    }
+
+    _expiresAt = expiresAt;
+    return write();
+}
+
+bool AuthCache::write()
+{
+#if defined(ESP8266)
+    File file = LittleFS.open(AUTH_FILE, "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    // JWT and refresh tokens are base64url: nothing to escape
+    file.print(F("{\"expires\":"));
+    file.print(_expiresAt);
+    file.print(F(",\"refresh_token\":\""));
+    file.print(_refreshToken);
+    file.print(F("\",\"id_token\":\""));
+    file.print(_idToken);
+    file.print(F("\"}"));
+    file.close();
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AuthCache::clear()
+{
+    _idToken = "";
+    _refreshToken = "";
+    _expiresAt = 0;
+
+#if defined(ESP8266)
+    LittleFS.remove(AUTH_FILE);
+#endif
+}
+
+unsigned long AuthCache::secondsLeft(unsigned long now) const
+{
+    if (now == 0 || _expiresAt <= now)
+    {
+        return 0;
+    }
+
+    unsigned long left = _expiresAt - now;
+    return left > AUTH_TOKEN_LIFETIME ? AUTH_TOKEN_LIFETIME : left;
+}
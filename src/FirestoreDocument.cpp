@@ -0,0 +1,113 @@
+/**
+ * @file FirestoreDocument.cpp
+ * @brief Fixed-buffer Firestore document implementation
+ */
+
+#include "FirestoreDocument.h"
+#include <math.h>
+
+static const char DOC_OPEN[] = "{\"fields\":{";
+
+FirestoreDocument::FirestoreDocument()
+    : _length(0),
+      _closed(false),
+      _overflow(false)
+{
+    append(DOC_OPEN);
+}
+
+void FirestoreDocument::append(const char *text)
+{
+    size_t length = strlen(text);
+    if (_overflow || _length + length >= sizeof(_buffer))
+    {
+        _overflow = true;
+        return;
+    }
+    memcpy(_buffer + _length, text, length + 1);
+    _length += length;
+}
+
+// ,"name":{"type":
+void FirestoreDocument::beginField(const char *name, const char *type)
+{
+    if (_length > sizeof(DOC_OPEN) - 1)
+    {
+        append(",");
+    }
+    append("\"");
+    append(name);
+    append("\":{\"");
+    append(type);
+    append("\":");
+}
+
+void FirestoreDocument::addDouble(const char *name, double value)
+{
+    char number[24];
+    if (isnan(value))
+    {
+        strcpy(number, "\"NaN\"");
+    }
+    else if (isinf(value))
+    {
+        strcpy(number, value > 0 ? "\"Infinity\"" : "\"-Infinity\"");
+    }
+    else
+    {
+        snprintf(number, sizeof(number), "%.7g", value);
+    }
+
+    beginField(name, "doubleValue");
+    append(number);
+    append("}");
+}
+
+void FirestoreDocument::addInteger(const char *name, unsigned long value)
+{
+    char number[16];
+    snprintf(number, sizeof(number), "\"%lu\"", value);
+
+    beginField(name, "integerValue");
+    append(number);
+    append("}");
+}
+
+void FirestoreDocument::addString(const char *name, const char *value)
+{
+    beginField(name, "stringValue");
+    append("\"");
+
+    // Escape quotes and backslashes; codes and device names have nothing else
+    char escaped[3] = "\\";
+    for (const char *p = value; *p; p++)
+    {
+        if (*p == '"' || *p == '\\')
+        {
+            escaped[1] = *p;
+            append(escaped);
+        }
+        else
+        {
+            char c[2] = {*p, '\0'};
+            append(c);
+        }
+    }
+    append("\"}");
+}
+
+void FirestoreDocument::addBool(const char *name, bool value)
+{
+    beginField(name, "booleanValue");
+    append(value ? "true}" : "false}");
+}
+
+const char *FirestoreDocument::c_str()
+{
+    if (!_closed)
+    {
+        append("}}");
+        _closed = true;
+    }
+    return _overflow ? NULL : _buffer;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file HeapMonitor.cpp
+ * @brief ESP8266 heap sampling, trend and alarms implementation
+ */
+
+#include "HeapMonitor.h"
+
+#ifdef ESP8266
+
+static const uint16_t SAMPLES_PER_BUCKET = HEAP_TREND_BUCKET / HEAP_SAMPLE_INTERVAL;
+
+HeapMonitor::HeapMonitor()
+    : _lastSample(0),
+      _free(0),
+      _maxBlock(0),
+      _fragmentation(0),
+      _bucketFreeSum(0),
+      _bucketFragSum(0),
+      _bucketSamples(0),
+      _head(0),
+      _points(0),
+      _alarms(0),
+      _raised(0)
+{
+}
+
+bool HeapMonitor::update()
+{
+    unsigned long now = millis();
+    if (_bucketSamples + _points > 0 && now - _lastSample < HEAP_SAMPLE_INTERVAL)
+    {
+        return false;
+    }
+    _lastSample = now;
+
+    uint32_t freeHeap;
+    uint32_t maxBlock;
+    uint8_t fragmentation;
+    ESP.getHeapStats(&freeHeap, &maxBlock, &fragmentation);
+    sample(freeHeap, maxBlock, fragmentation);
+    return true;
+}
+
+void HeapMonitor::sample(uint32_t freeHeap, uint32_t maxBlock, uint8_t fragmentation)
+{
+    _free = freeHeap;
+    _maxBlock = maxBlock;
+    _fragmentation = fragmentation;
+
+    _bucketFreeSum += freeHeap;
+    _bucketFragSum += fragmentation;
+    if (++_bucketSamples >= SAMPLES_PER_BUCKET)
+    {
+        uint8_t slot = (_head + _points) % HEAP_TREND_POINTS;
+        if (_points == HEAP_TREND_POINTS)
+        {
+            _head = (_head + 1) % HEAP_TREND_POINTS;
+        }
+        else
+        {
+            _points++;
+        }
+        _freePoints[slot] = _bucketFreeSum / _bucketSamples;
+        _fragPoints[slot] = _bucketFragSum * 10 / _bucketSamples;
+
+        _bucketFreeSum = 0;
+        _bucketFragSum = 0;
+        _bucketSamples = 0;
+    }
+
+    updateAlarm(HEAP_ALARM_LOW_FREE, freeHeap < HEAP_ALARM_FREE, freeHeap >= HEAP_ALARM_FREE + HEAP_ALARM_FREE / 8);
+    updateAlarm(HEAP_ALARM_LOW_BLOCK, maxBlock < HEAP_ALARM_BLOCK, maxBlock >= HEAP_ALARM_BLOCK + HEAP_ALARM_BLOCK / 8);
+    updateAlarm(HEAP_ALARM_FRAGMENTED, fragmentation > HEAP_ALARM_FRAG,
+                fragmentation <= HEAP_ALARM_FRAG - HEAP_ALARM_FRAG / 8);
+
+    // A leak needs half a window of points before it is believed
+    if (_points >= HEAP_TREND_POINTS / 2)
+    {
+        long trend = freeTrend();
+        updateAlarm(HEAP_ALARM_LEAKING, trend < -HEAP_ALARM_LEAK, trend >= -(HEAP_ALARM_LEAK - HEAP_ALARM_LEAK / 8));
+    }
+}
+
+void HeapMonitor::updateAlarm(uint8_t bit, bool over, bool clear)
+{
+    if (over && !(_alarms & bit))
+    {
+        _alarms |= bit;
+        _raised |= bit;
+    }
+    else if (clear)
+    {
+        _alarms &= ~bit;
+    }
+}
+
+uint8_t HeapMonitor::takeRaised()
+{
+    uint8_t raised = _raised;
+    _raised = 0;
+    return raised;
+}
+
+// Least-squares slope per bucket, x = 0 .. points-1 from the oldest point
+float HeapMonitor::slope(bool fragmentation) const
+{
+    if (_points < 3)
+    {
+        return 0;
+    }
+
+    float sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
+    for (uint8_t i = 0; i < _points; i++)
+    {
+        uint8_t slot = (_head + i) % HEAP_TREND_POINTS;
+        float y = fragmentation ? (float)_fragPoints[slot] : (float)_freePoints[slot];
+        sumX += i;
+        sumY += y;
+        sumXY += i * y;
+        sumXX += (float)i * i;
+    }
+
+    float n = _points;
+    return (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+}
+
+long HeapMonitor::freeTrend() const
+{
+    return (long)(slope(false) * 3600000.0f / HEAP_TREND_BUCKET);
+}
+
+int HeapMonitor::fragTrend() const
+{
+    return (int)(slope(true) * 3600000.0f / HEAP_TREND_BUCKET);
+}
+
+void HeapMonitor::printReport(Print &out) const
+{
+    char line[112];
+    int fragTenths = fragTrend();
+    snprintf(line, sizeof(line), "HEAP:free=%lu blk=%lu frag=%u%% trend=%ldB/h frag_trend=%s%d.%d%%/h points=%u alarms=%u",
+             (unsigned long)_free, (unsigned long)_maxBlock, _fragmentation, freeTrend(),
+             fragTenths < 0 ? "-" : "", abs(fragTenths) / 10, abs(fragTenths) % 10, _points, _alarms);
+    out.println(line);
+}
+
+#endif
@@ -1,7 +1,7 @@
 #include "LocalStorage.h"
 
 LocalStorage::LocalStorage(int maxRec, int recSize)
-    : maxRecords(maxRec), recordSize(recSize), currentIndex(0), recordCount(0)
+    : maxRecords(maxRec), recordSize(recSize), currentIndex(0), recordCount(0), bootEpoch(0)
 {
 }
 
@@ -33,6 +33,14 @@ bool LocalStorage::initialize()
         clearStorage();
     }
 
+    // New boot, new epoch: uptime timestamps from earlier boots stay distinct
+    bootEpoch++;
+    writeHeader();
+
+    #if defined(ESP8266) || defined(ESP32)
+        EEPROM.commit();
+    #endif
+
     isInitialized = true;
     Serial.println(F("Local Storage initialized successfully"));
     return true;
@@ -46,12 +54,15 @@ bool LocalStorage::saveData(const SensorData &data)
         return false;
     }
 
-    String csvData = data.toCSV();
+    // Stack buffer: the store path runs for every sample and must not
+    // churn the heap of a unit that stays up for weeks
+    char csvData[SENSOR_CSV_MAX];
+    size_t csvLength = data.toCSV(csvData, sizeof(csvData));
 
     // Check if CSV data fits in record (accounting for 2-byte length prefix)
-    if (csvData.length() > (unsigned int)(recordSize - 2))
+    if (csvLength == 0 || csvLength > (unsigned int)(recordSize - 2))
     {
-        handleError("Data too large for record size");
+        handleError("Sample too long for a record");
         return false;
     }
 
@@ -64,22 +75,7 @@ bool LocalStorage::saveData(const SensorData &data)
         return false;
     }
 
-    // Write 2-byte length header (supports up to 65535 bytes)
-    uint16_t dataLen = csvData.length();
-    EEPROM.write(address, (dataLen >> 8) & 0xFF);      // High byte
-    EEPROM.write(address + 1, dataLen & 0xFF);         // Low byte
-
-    // Write actual data
-    for (unsigned int i = 0; i < csvData.length(); i++)
-    {
-        EEPROM.write(address + 2 + i, csvData[i]);
-    }
-
-    // Clear remaining bytes in record
-    for (unsigned int i = csvData.length() + 2; i < (unsigned int)recordSize; i++)
-    {
-        EEPROM.write(address + i, 0);
-    }
+    writeRecord(address, csvData, csvLength, 0);
 
     // Circular buffer: rotate index properly
     currentIndex = (currentIndex + 1) % maxRecords;
@@ -111,30 +107,30 @@ bool LocalStorage::retrieveData(SensorData &data, int index)
         return false;
     }
 
-    if (index >= recordCount)
+    if (index < 0 || index >= recordCount)
     {
         handleError("Index out of range");
         return false;
     }
 
-    int address = calculateAddress(index);
+    int address = calculateAddress(physicalSlot(index));
 
-    // Read 2-byte length header
-    uint16_t dataLength = (EEPROM.read(address) << 8) | EEPROM.read(address + 1);
+    // Read 2-byte length header (upper bit is the uploaded flag)
+    uint16_t dataLength = ((EEPROM.read(address) << 8) | EEPROM.read(address + 1)) & RECORD_LENGTH_MASK;
 
-    if (dataLength == 0 || dataLength > (unsigned int)(recordSize - 2))
+    char csvData[SENSOR_CSV_MAX];
+    if (dataLength == 0 || dataLength > (unsigned int)(recordSize - 2) || dataLength >= sizeof(csvData))
     {
         handleError("Invalid data length");
         return false;
     }
 
     // Read data
-    String csvData = "";
-    csvData.reserve(dataLength);  // Pre-allocate for efficiency
     for (unsigned int i = 0; i < dataLength; i++)
     {
-        csvData += (char)EEPROM.read(address + 2 + i);
+        csvData[i] = (char)EEPROM.read(address + 2 + i);
     }
+    csvData[dataLength] = '\0';
 
     return data.fromCSV(csvData);
 }
@@ -191,9 +187,9 @@ void LocalStorage::writeHeader()
                        (recordCount >> 8) ^ (recordCount & 0xFF);
     EEPROM.write(7, checksum);
 
-    // Reserved bytes (8-9) for future use
-    EEPROM.write(8, 0x00);
-    EEPROM.write(9, 0x00);
+    // Boot epoch (2 bytes, formerly reserved; not part of the checksum)
+    EEPROM.write(8, (bootEpoch >> 8) & 0xFF);
+    EEPROM.write(9, bootEpoch & 0xFF);
 }
 
 bool LocalStorage::readHeader()
@@ -218,6 +214,7 @@ bool LocalStorage::readHeader()
     // Read values
     currentIndex = (EEPROM.read(3) << 8) | EEPROM.read(4);
     recordCount = (EEPROM.read(5) << 8) | EEPROM.read(6);
+    bootEpoch = (EEPROM.read(8) << 8) | EEPROM.read(9);
 
     // Validate checksum
     uint8_t checksum = 0xAB ^ 0xCD ^ STORAGE_VERSION ^
@@ -246,11 +243,37 @@ bool LocalStorage::readHeader()
     return true;
 }
 
+void LocalStorage::writeRecord(int address, const char *csv, size_t length, uint16_t flagBits)
+{
+    // Write 2-byte length header (supports up to 32767 bytes + flag bit)
+    uint16_t dataLen = length | flagBits;
+    EEPROM.write(address, (dataLen >> 8) & 0xFF);      // High byte
+    EEPROM.write(address + 1, dataLen & 0xFF);         // Low byte
+
+    // Write actual data
+    for (unsigned int i = 0; i < length; i++)
+    {
+        EEPROM.write(address + 2 + i, csv[i]);
+    }
+
+    // Clear remaining bytes in record
+    for (unsigned int i = length + 2; i < (unsigned int)recordSize; i++)
+    {
+        EEPROM.write(address + i, 0);
+    }
+}
+
 int LocalStorage::calculateAddress(int index)
 {
     return RECORD_START + (index * recordSize);
 }
 
+int LocalStorage::physicalSlot(int index) const
+{
+    // Oldest record sits recordCount slots behind the write position
+    return (currentIndex - recordCount + index + 2 * maxRecords) % maxRecords;
+}
+
 bool LocalStorage::isFull() const
 {
     return recordCount >= maxRecords;
@@ -280,4 +303,119 @@ bool LocalStorage::exportToCSV(String &output, int startIndex, int count)
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+bool LocalStorage::markUploaded(int index)
+{
+    if (!isInitialized || index < 0 || index >= recordCount)
+    {
+        handleError("Index out of range");
+        return false;
+    }
+
+    // Only the high byte of the length prefix carries the flag
+    int address = calculateAddress(physicalSlot(index));
+    uint8_t high = EEPROM.read(address);
+    if (high & (RECORD_FLAG_UPLOADED >> 8))
+    {
+        return true;
+    }
+
+    // No commit of its own: on the ESP8266 every commit erases a flash
+    // sector, so the flag goes out with the next saveData(). A flag lost
+    // to a reset only means the record is sent once more.
+    EEPROM.write(address, high | (RECORD_FLAG_UPLOADED >> 8));
+    return true;
+}
+
+bool LocalStorage::isUploaded(int index)
+{
+    if (!isInitialized || index < 0 || index >= recordCount)
+    {
+        return false;
+    }
+
+    int address = calculateAddress(physicalSlot(index));
+    return (EEPROM.read(address) & (RECORD_FLAG_UPLOADED >> 8)) != 0;
+}
+
+int LocalStorage::removeOldest(int count)
+{
+    if (!isInitialized || count <= 0)
+    {
+        return 0;
+    }
+
+    if (count > recordCount)
+    {
+        count = recordCount;
+    }
+
+    // The write position stays put; shrinking the count moves the tail.
+    // Like markUploaded(), the header is committed with the next saveData().
+    recordCount -= count;
+    writeHeader();
+
+    return count;
+}
+
+int LocalStorage::restampUnsynced(uint16_t epoch, unsigned long offset)
+{
+    if (!isInitialized)
+    {
+        return 0;
+    }
+
+    int corrected = 0;
+    int skipped = 0;
+    SensorData data;
+
+    // Single pass over the buffer, one commit at the end
+    for (int i = 0; i < recordCount; i++)
+    {
+        if (!retrieveData(data, i))
+        {
+            continue;
+        }
+
+        if (!(data.flags & DATA_FLAG_UNSYNCED_TIME) || data.bootEpoch != epoch)
+        {
+            continue;
+        }
+
+        data.timestamp += offset;
+        data.flags &= ~DATA_FLAG_UNSYNCED_TIME;
+        data.bootEpoch = 0;
+
+        // Unix time is longer than uptime; a record that no longer fits
+        // keeps its flag and goes up uncorrected rather than being lost
+        char csvData[SENSOR_CSV_MAX];
+        size_t csvLength = data.toCSV(csvData, sizeof(csvData));
+        if (csvLength == 0 || csvLength > (unsigned int)(recordSize - 2))
+        {
+            skipped++;
+            continue;
+        }
+
+        int address = calculateAddress(physicalSlot(i));
+        uint16_t uploadedBit = (EEPROM.read(address) << 8) & RECORD_FLAG_UPLOADED;
+        writeRecord(address, csvData, csvLength, uploadedBit);
+        corrected++;
+    }
+
+    #if defined(ESP8266) || defined(ESP32)
+        if (corrected > 0)
+        {
+            EEPROM.commit();
+        }
+    #endif
+
+    if (skipped > 0)
+    {
+        Serial.print(F("STATUS:Restamp skipped "));
+        Serial.print(skipped);
+        Serial.println(F(" records (too long)"));
+    }
+
+    return corrected;
+}
@@ -0,0 +1,309 @@
+/**
+ * @file MemoryMonitor.cpp
+ * @brief SRAM headroom measurement implementation
+ */
+
+#include "MemoryMonitor.h"
+
+uint16_t MemoryMonitor::_stackPeak = 0;
+uint16_t MemoryMonitor::_heapPeak = 0;
+uint16_t MemoryMonitor::_unused = 0;
+uint16_t MemoryMonitor::_taskPeak[MEM_TASK_COUNT];
+uint8_t *MemoryMonitor::_probeBottom = NULL;
+uint8_t *MemoryMonitor::_probeTop = NULL;
+
+#if defined(__AVR__)
+
+// avr-libc heap state (malloc.c)
+struct __freelist
+{
+    size_t sz;
+    struct __freelist *nx;
+};
+extern struct __freelist *__flp;
+extern char *__brkval;
+extern char *__malloc_heap_end;
+extern size_t __malloc_margin;
+extern char __heap_start;
+
+static const uint8_t CANARY = 0xC5;
+
+static const char TASK_RTD[] PROGMEM = "rtd";
+static const char TASK_CELL[] PROGMEM = "cell";
+static const char TASK_JSON[] PROGMEM = "json";
+static const char TASK_HMI[] PROGMEM = "hmi";
+static const char TASK_LISTEN[] PROGMEM = "listen";
+static const char TASK_ESP[] PROGMEM = "esp";
+static const char *const TASK_NAMES[MEM_TASK_COUNT] = {TASK_RTD, TASK_CELL, TASK_JSON, TASK_HMI, TASK_LISTEN, TASK_ESP};
+
+// Runs from .init3: the stack pointer is set, .data/.bss and constructors
+// come later. No frame and no calls, it paints the stack it would use.
+void memoryPaintStack() __attribute__((naked, used, section(".init3")));
+void memoryPaintStack()
+{
+    volatile uint8_t *p = (volatile uint8_t *)&__heap_start;
+    while (p < (volatile uint8_t *)SP)
+    {
+        *p++ = CANARY;
+    }
+}
+
+static uint8_t *heapTop()
+{
+    return (uint8_t *)(__brkval ? __brkval : &__heap_start);
+}
+
+bool MemoryMonitor::supported()
+{
+    return true;
+}
+
+uint16_t MemoryMonitor::freeNow()
+{
+    uint8_t *top = heapTop();
+    uint8_t *sp = (uint8_t *)SP;
+    uint16_t total = sp > top ? sp - top : 0;
+
+    for (struct __freelist *fl = __flp; fl; fl = fl->nx)
+    {
+        total += fl->sz;
+    }
+    return total;
+}
+
+uint16_t MemoryMonitor::largestFreeBlock()
+{
+    uint16_t largest = 0;
+    for (struct __freelist *fl = __flp; fl; fl = fl->nx)
+    {
+        if (fl->sz > largest)
+        {
+            largest = fl->sz;
+        }
+    }
+
+    // Growing the heap: malloc() keeps __malloc_margin clear of the stack
+    char *limit = __malloc_heap_end ? __malloc_heap_end : (char *)SP - __malloc_margin;
+    char *top = (char *)heapTop();
+    if (limit > top + sizeof(size_t))
+    {
+        uint16_t grow = limit - top - sizeof(size_t);
+        if (grow > largest)
+        {
+            largest = grow;
+        }
+    }
+    return largest;
+}
+
+void MemoryMonitor::scan()
+{
+    uint8_t *p = (uint8_t *)&__heap_start;
+    uint8_t *end = (uint8_t *)SP;
+
+    // Longest canary run between the start of the heap and the stack
+    uint8_t *runStart = NULL;
+    uint8_t *bestStart = heapTop();
+    uint16_t bestLength = 0;
+    for (; p <= end; p++)
+    {
+        if (p < end && *p == CANARY)
+        {
+            if (!runStart)
+            {
+                runStart = p;
+            }
+        }
+        else if (runStart)
+        {
+            if ((uint16_t)(p - runStart) > bestLength)
+            {
+                bestLength = p - runStart;
+                bestStart = runStart;
+            }
+            runStart = NULL;
+        }
+    }
+
+    uint16_t stack = RAMEND + 1 - (uint16_t)(bestStart + bestLength);
+    uint16_t heap = bestStart - (uint8_t *)&__heap_start;
+    if (stack > _stackPeak)
+    {
+        _stackPeak = stack;
+    }
+    if (heap > _heapPeak)
+    {
+        _heapPeak = heap;
+    }
+
+    uint16_t ram = RAMEND + 1 - (uint16_t)&__heap_start;
+    _unused = ram > _stackPeak + _heapPeak ? ram - _stackPeak - _heapPeak : 0;
+}
+
+uint16_t MemoryMonitor::unusedSinceBoot()
+{
+    return _unused;
+}
+
+uint16_t MemoryMonitor::stackPeak()
+{
+    return _stackPeak;
+}
+
+uint16_t MemoryMonitor::heapPeak()
+{
+    return _heapPeak;
+}
+
+void MemoryMonitor::beginTask(uint8_t task)
+{
+#if MEMORY_PROBE_ENABLED
+    (void)task;
+    volatile uint8_t *top = (volatile uint8_t *)SP;
+    volatile uint8_t *bottom = (volatile uint8_t *)heapTop();
+    if ((uint16_t)(top - bottom) > MEMORY_PROBE_WINDOW)
+    {
+        bottom = top - MEMORY_PROBE_WINDOW;
+    }
+
+    // Whatever ran since the last probe may have gone deeper: keep it
+    volatile uint8_t *p = bottom;
+    while (p < top && *p == CANARY)
+    {
+        p++;
+    }
+    if (p < top && (uint16_t)(RAMEND + 1 - (uint16_t)p) > _stackPeak)
+    {
+        _stackPeak = RAMEND + 1 - (uint16_t)p;
+    }
+
+    // No calls from here on: the window is below our own frame
+    for (p = bottom; p < top; p++)
+    {
+        *p = CANARY;
+    }
+    _probeBottom = (uint8_t *)bottom;
+    _probeTop = (uint8_t *)top;
+#else
+    (void)task;
+#endif
+}
+
+void MemoryMonitor::endTask(uint8_t task)
+{
+#if MEMORY_PROBE_ENABLED
+    if (!_probeTop || task >= MEM_TASK_COUNT)
+    {
+        return;
+    }
+
+    volatile uint8_t *p = _probeBottom;
+    while (p < _probeTop && *p == CANARY)
+    {
+        p++;
+    }
+
+    uint16_t depth = _probeTop - p;
+    if (depth > _taskPeak[task])
+    {
+        _taskPeak[task] = depth;
+    }
+    if (p < _probeTop && (uint16_t)(RAMEND + 1 - (uint16_t)p) > _stackPeak)
+    {
+        _stackPeak = RAMEND + 1 - (uint16_t)p;
+    }
+    _probeTop = NULL;
+#else
+    (void)task;
+#endif
+}
+
+uint16_t MemoryMonitor::taskPeak(uint8_t task)
+{
+    return task < MEM_TASK_COUNT ? _taskPeak[task] : 0;
+}
+
+void MemoryMonitor::printReport(Print &out)
+{
+    out.print(F("MEM:free="));
+    out.print(freeNow());
+    out.print(F(" blk="));
+    out.print(largestFreeBlock());
+    out.print(F(" unused="));
+    out.print(_unused);
+    out.print(F(" stack="));
+    out.print(_stackPeak);
+    out.print(F(" heap="));
+    out.print(_heapPeak);
+    #if MEMORY_PROBE_ENABLED
+    for (uint8_t i = 0; i < MEM_TASK_COUNT; i++)
+    {
+        out.print(' ');
+        out.print((const __FlashStringHelper *)TASK_NAMES[i]);
+        out.print('=');
+        out.print(_taskPeak[i]);
+    }
+    #endif
+    out.println();
+}
+
+#else
+
+// Host builds: no fixed SRAM map to measure
+
+bool MemoryMonitor::supported()
+{
+    return false;
+}
+
+uint16_t MemoryMonitor::freeNow()
+{
+    return 0;
+}
+
+uint16_t MemoryMonitor::largestFreeBlock()
+{
+    return 0;
+}
+
+void MemoryMonitor::scan()
+{
+}
+
+uint16_t MemoryMonitor::unusedSinceBoot()
+{
+    return 0;
+}
+
+uint16_t MemoryMonitor::stackPeak()
+{
+    return 0;
+}
+
+uint16_t MemoryMonitor::heapPeak()
+{
+    return 0;
+}
+
+void MemoryMonitor::beginTask(uint8_t task)
+{
+    (void)task;
+}
+
+void MemoryMonitor::endTask(uint8_t task)
+{
+    (void)task;
+}
+
+uint16_t MemoryMonitor::taskPeak(uint8_t task)
+{
+    (void)task;
+    return 0;
+}
+
+void MemoryMonitor::printReport(Print &out)
+{
+    out.println(F("MEM:not measured on this board"));
+}
+
+#endif
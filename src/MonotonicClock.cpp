@@ -0,0 +1,44 @@
+/**
+ * @file MonotonicClock.cpp
+ * @brief Rollover-safe 64-bit uptime clock implementation
+ */
+
+#include "MonotonicClock.h"
+
+uint32_t MonotonicClock::_lastMillis = 0;
+uint32_t MonotonicClock::_millisWraps = 0;
+uint32_t MonotonicClock::_lastMicros = 0;
+uint32_t MonotonicClock::_microsWraps = 0;
+
+uint64_t MonotonicClock::millis64()
+{
+    uint32_t now = millis();
+
+    // Went backwards: the 32-bit counter wrapped since the last call
+    if (now < _lastMillis)
+    {
+        _millisWraps++;
+    }
+    _lastMillis = now;
+
+    return ((uint64_t)_millisWraps << 32) | now;
+}
+
+uint64_t MonotonicClock::micros64()
+{
+    uint32_t now = micros();
+
+    if (now < _lastMicros)
+    {
+        _microsWraps++;
+    }
+    _lastMicros = now;
+
+    return ((uint64_t)_microsWraps << 32) | now;
+}
+
+void MonotonicClock::update()
+{
+    millis64();
+    micros64();
+}
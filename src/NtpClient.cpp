@@ -0,0 +1,192 @@
+/**
+ * @file NtpClient.cpp
+ * @brief Minimal SNTP client implementation
+ */
+
+#include "NtpClient.h"
+#include "MonotonicClock.h"
+#include <string.h>
+#include <stdlib.h>
+
+// Seconds from 1900-01-01 (NTP era 0) to 1970-01-01
+static const uint64_t NTP_UNIX_OFFSET = 2208988800ULL;
+
+static const uint16_t LOCAL_PORT = 8123;
+
+static uint64_t readTimestamp(const uint8_t *p)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static void writeTimestamp(uint8_t *p, uint64_t value)
+{
+    for (int i = 7; i >= 0; i--)
+    {
+        p[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+NtpClient::NtpClient(UDP &udp)
+    : _udp(udp),
+      _servers(NULL),
+      _serverCount(0)
+{
+}
+
+void NtpClient::setServers(const char *const *servers, uint8_t count)
+{
+    _servers = servers;
+    _serverCount = count;
+}
+
+bool NtpClient::query(NtpSample &best, uint8_t samples, uint16_t timeoutMs)
+{
+    if (_serverCount == 0 || !_udp.begin(LOCAL_PORT))
+    {
+        return false;
+    }
+
+    bool found = false;
+
+    for (uint8_t i = 0; i < samples; i++)
+    {
+        NtpSample sample;
+        if (!exchange(_servers[i % _serverCount], timeoutMs, sample))
+        {
+            continue;
+        }
+
+        if (!found || sample.delayMs < best.delayMs)
+        {
+            best = sample;
+            found = true;
+        }
+    }
+
+    _udp.stop();
+    return found;
+}
+
+bool NtpClient::exchange(const char *server, uint16_t timeoutMs, NtpSample &sample)
+{
+    // "host:port" selects a non-standard port (local stand-in)
+    char host[64];
+    uint16_t port = DEFAULT_PORT;
+    strncpy(host, server, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+
+    char *colon = strchr(host, ':');
+    if (colon)
+    {
+        *colon = '\0';
+        port = atoi(colon + 1);
+    }
+
+    // Discard late replies from an earlier exchange (parsePacket drops the
+    // unread remainder of the previous packet)
+    while (_udp.parsePacket() > 0)
+    {
+    }
+
+    uint8_t packet[PACKET_SIZE];
+    uint64_t t1 = MonotonicClock::millis64();
+    buildRequest(packet, t1);
+
+    if (!_udp.beginPacket(host, port))
+    {
+        return false;
+    }
+    _udp.write(packet, PACKET_SIZE);
+    if (!_udp.endPacket())
+    {
+        return false;
+    }
+
+    unsigned long start = millis();
+    while (millis() - start < timeoutMs)
+    {
+        if (_udp.parsePacket() >= PACKET_SIZE)
+        {
+            uint64_t t4 = MonotonicClock::millis64();
+            _udp.read(packet, PACKET_SIZE);
+            return parseResponse(packet, t1, t4, sample);
+        }
+        yield();
+    }
+
+    return false;
+}
+
+void NtpClient::buildRequest(uint8_t *packet, uint64_t transmitMs)
+{
+    memset(packet, 0, PACKET_SIZE);
+
+    packet[0] = (0 << 6) | (4 << 3) | 3; // LI = 0, version 4, mode 3 (client)
+
+    // The server echoes this back as the originate timestamp
+    writeTimestamp(packet + 40, unixMsToNtp(transmitMs));
+}
+
+bool NtpClient::parseResponse(const uint8_t *packet, uint64_t t1, uint64_t t4, NtpSample &sample)
+{
+    uint8_t leap = packet[0] >> 6;
+    uint8_t mode = packet[0] & 0x07;
+    uint8_t stratum = packet[1];
+
+    // Server (4) or broadcast (5) mode; LI 3 = server clock not synchronised;
+    // stratum 0 is a kiss-o'-death, 16+ is unsynchronised
+    if ((mode != 4 && mode != 5) || leap == 3 || stratum == 0 || stratum > 15)
+    {
+        return false;
+    }
+
+    // Reply must answer this request, not an earlier one
+    if (readTimestamp(packet + 24) != unixMsToNtp(t1))
+    {
+        return false;
+    }
+
+    uint64_t receiveNtp = readTimestamp(packet + 32);
+    uint64_t transmitNtp = readTimestamp(packet + 40);
+    if (receiveNtp == 0 || transmitNtp == 0)
+    {
+        return false;
+    }
+
+    int64_t t2 = ntpToUnixMs(receiveNtp);
+    int64_t t3 = ntpToUnixMs(transmitNtp);
+
+    int64_t roundTrip = ((int64_t)t4 - (int64_t)t1) - (t3 - t2);
+    sample.offsetMs = ((t2 - (int64_t)t1) + (t3 - (int64_t)t4)) / 2;
+    sample.delayMs = roundTrip < 0 ? 0 : (uint32_t)roundTrip;
+    sample.stratum = stratum;
+
+    return true;
+}
+
+uint64_t NtpClient::unixMsToNtp(uint64_t unixMs)
+{
+    uint64_t seconds = unixMs / 1000 + NTP_UNIX_OFFSET;
+    uint64_t fraction = ((unixMs % 1000) << 32) / 1000;
+    return ((seconds & 0xFFFFFFFFULL) << 32) | fraction;
+}
+
+uint64_t NtpClient::ntpToUnixMs(uint64_t ntp)
+{
+    uint64_t seconds = ntp >> 32;
+    uint64_t fraction = ntp & 0xFFFFFFFFULL;
+
+    // Era 1 starts in 2036: small era-0 values mean the counter wrapped
+    if (seconds < 0x80000000ULL)
+    {
+        seconds += 0x100000000ULL;
+    }
+
+    return (seconds - NTP_UNIX_OFFSET) * 1000 + ((fraction * 1000 + 0x80000000ULL) >> 32);
+}
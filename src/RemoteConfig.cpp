@@ -0,0 +1,203 @@
+/**
+ * @file RemoteConfig.cpp
+ * @brief Versioned runtime settings implementation
+ */
+
+#include "RemoteConfig.h"
+
+#if defined(ESP8266)
+#include <LittleFS.h>
+#endif
+
+const char *RemoteConfig::CONFIG_FILE = "/config.json";
+
+DeviceSettings DeviceSettings::defaults()
+{
+    DeviceSettings settings;
+    settings.version = 0;
+    settings.sampleInterval = SAMPLE_INTERVAL;
+    settings.batasKa = MOISTURE_TARGET;
+    settings.tempHigh = TEMP_SSR_OFF;
+    settings.tempLow = TEMP_SSR_ON;
+    settings.uploadBatchSize = UPLOAD_BATCH_SIZE;
+    settings.aggWindowSeconds = AGG_WINDOW_SECONDS;
+    settings.rawUploadMode = RAW_UPLOAD_MODE;
+    settings.rawDecimation = RAW_DECIMATION_FACTOR;
+    return settings;
+}
+
+RemoteConfig::RemoteConfig()
+    : _current(DeviceSettings::defaults())
+{
+}
+
+bool RemoteConfig::load()
+{
+#if defined(ESP8266)
+    File file = LittleFS.open(CONFIG_FILE, "r");
+    if (!file)
+    {
+        return false;
+    }
+
+    StaticJsonDocument<384> doc;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error)
+    {
+        Serial.println(F("CONFIG:Persisted config unreadable"));
+        return false;
+    }
+
+    DeviceSettings settings = DeviceSettings::defaults();
+    if (!fromJSON(doc, settings) || settings.version == 0 || !validate(settings))
+    {
+        Serial.println(F("CONFIG:Persisted config invalid"));
+        return false;
+    }
+
+    _current = settings;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool RemoteConfig::save()
+{
+#if defined(ESP8266)
+    StaticJsonDocument<384> doc;
+    toJSON(_current, doc);
+
+    File file = LittleFS.open(CONFIG_FILE, "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    bool ok = serializeJson(doc, file) > 0;
+    file.close();
+    return ok;
+#else
+    return false;
+#endif
+}
+
+bool RemoteConfig::apply(JsonDocument &doc)
+{
+    unsigned long version = doc["version"] | 0UL;
+    if (version == 0 || version == _current.version)
+    {
+        return false;
+    }
+
+    // Start from the current values so partial documents are allowed
+    DeviceSettings candidate = _current;
+    if (!fromJSON(doc, candidate) || !validate(candidate))
+    {
+        Serial.print(F("CONFIG:Rejected invalid config version "));
+        Serial.println(version);
+        return false;
+    }
+
+    _current = candidate;
+    return true;
+}
+
+int RemoteConfig::writeMegaDelta(const DeviceSettings *from, Print &out) const
+{
+    int sent = 0;
+
+    if (!from || from->sampleInterval != _current.sampleInterval)
+    {
+        out.print(F("CFG:sample_ms="));
+        out.println(_current.sampleInterval);
+        sent++;
+    }
+    if (!from || from->batasKa != _current.batasKa)
+    {
+        out.print(F("CFG:batas_ka="));
+        out.println(_current.batasKa, 2);
+        sent++;
+    }
+    if (!from || from->tempHigh != _current.tempHigh)
+    {
+        out.print(F("CFG:temp_high="));
+        out.println(_current.tempHigh, 2);
+        sent++;
+    }
+    if (!from || from->tempLow != _current.tempLow)
+    {
+        out.print(F("CFG:temp_low="));
+        out.println(_current.tempLow, 2);
+        sent++;
+    }
+
+    // Version last: the MEGA adopts it only after the fields above
+    out.print(F("CFG:version="));
+    out.println(_current.version);
+
+    return sent;
+}
+
+bool RemoteConfig::validate(const DeviceSettings &settings)
+{
+    if (settings.sampleInterval < DATA_SAMPLE_INTERVAL_MIN || settings.sampleInterval > 3600000UL)
+        return false;
+    if (settings.batasKa < 0.0 || settings.batasKa > 100.0)
+        return false;
+    if (settings.tempLow < SENSOR1_MIN || settings.tempHigh > SENSOR1_MAX || settings.tempLow >= settings.tempHigh)
+        return false;
+    if (settings.uploadBatchSize < 1 || settings.uploadBatchSize > 50)
+        return false;
+    if (settings.aggWindowSeconds < 10 || settings.aggWindowSeconds > 3600)
+        return false;
+    if (settings.rawUploadMode > RAW_UPLOAD_OFF)
+        return false;
+    if (settings.rawDecimation < 1 || settings.rawDecimation > 1000)
+        return false;
+
+    return true;
+}
+
+// Copy one field if present. A value of the wrong type or outside the range
+// of the target (300 for a uint8_t) fails instead of being truncated.
+template <typename T>
+static bool readField(JsonDocument &doc, const char *key, T &value)
+{
+    if (doc[key].isNull())
+        return true; // Absent: keep the current value
+
+    if (!doc[key].template is<T>())
+        return false;
+
+    value = doc[key].template as<T>();
+    return true;
+}
+
+bool RemoteConfig::fromJSON(JsonDocument &doc, DeviceSettings &settings)
+{
+    return readField(doc, "version", settings.version) &&
+           readField(doc, "sample_ms", settings.sampleInterval) &&
+           readField(doc, "batas_ka", settings.batasKa) &&
+           readField(doc, "temp_high", settings.tempHigh) &&
+           readField(doc, "temp_low", settings.tempLow) &&
+           readField(doc, "upload_batch", settings.uploadBatchSize) &&
+           readField(doc, "agg_window_s", settings.aggWindowSeconds) &&
+           readField(doc, "raw_mode", settings.rawUploadMode) &&
+           readField(doc, "raw_decimation", settings.rawDecimation);
+}
+
+void RemoteConfig::toJSON(const DeviceSettings &settings, JsonDocument &doc)
+{
+    doc["version"] = settings.version;
+    doc["sample_ms"] = settings.sampleInterval;
+    doc["batas_ka"] = settings.batasKa;
+    doc["temp_high"] = settings.tempHigh;
+    doc["temp_low"] = settings.tempLow;
+    doc["upload_batch"] = settings.uploadBatchSize;
+    doc["agg_window_s"] = settings.aggWindowSeconds;
+    doc["raw_mode"] = settings.rawUploadMode;
+    doc["raw_decimation"] = settings.rawDecimation;
+}
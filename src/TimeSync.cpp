@@ -4,118 +4,104 @@
  */
 
 #include "TimeSync.h"
+#include "MonotonicClock.h"
 
 #ifdef ESP8266
-#include <ESP8266HTTPClient.h>
-#include <WiFiClient.h>
-#include <ArduinoJson.h>
-#include <EEPROM.h>
+#include <WiFiUdp.h>
+#include "NtpClient.h"
+
+static const char *const defaultNtpServers[] = {NTP_SERVERS};
+
+static WiFiUDP ntpUdp;
+static NtpClient ntp(ntpUdp);
 
 TimeSync::TimeSync()
-    : _bootUnixTime(0),
-      _bootMillis(0),
+    : _anchorUnixMs(0),
+      _anchorMillis(0),
+      _driftPpm(0),
+      _slewMs(0),
+      _driftValid(false),
+      _refUnixMs(0),
+      _refMillis(0),
       _timeSynced(false),
-      _lastSyncAttempt(0)
+      _lastSyncAttempt(0),
+      _lastOffsetMs(0),
+      _lastRoundTrip(0)
 {
 }
 
 bool TimeSync::begin()
 {
-    EEPROM.begin(512);
-
-    // Try to load time from EEPROM first
-    if (loadTimeFromEEPROM())
-    {
-        Serial.println("TIME:Loaded from EEPROM");
-        return true;
-    }
+    ntp.setServers(defaultNtpServers, sizeof(defaultNtpServers) / sizeof(defaultNtpServers[0]));
 
-    // If EEPROM load failed, try to sync from API
-    Serial.println("TIME:No valid EEPROM time, syncing from API...");
-    return syncTimeFromAPI();
+    // Time only comes from the network; see syncTimeFromNTP()
+    _timeSynced = false;
+    _lastSyncAttempt = 0;
+    return true;
 }
 
-bool TimeSync::syncTimeFromAPI()
+bool TimeSync::syncTimeFromNTP()
 {
-    // Don't spam the API - wait at least 10 seconds between attempts
-    if (millis() - _lastSyncAttempt < 10000)
+    // Don't spam the servers - wait at least 10 seconds between attempts
+    if (_lastSyncAttempt != 0 && millis() - _lastSyncAttempt < 10000)
     {
         return false;
     }
 
     _lastSyncAttempt = millis();
 
-    WiFiClient client;
-    HTTPClient http;
-
-    // Use worldtimeapi.org - free, no API key needed
-    // Using Asia/Jakarta timezone (adjust for your location)
-    const char *timeApiUrl = "http://worldtimeapi.org/api/timezone/Asia/Jakarta";
-
-    Serial.print("TIME:Fetching time from ");
-    Serial.println(timeApiUrl);
+    Serial.println("TIME:Querying NTP servers...");
 
-    http.begin(client, timeApiUrl);
-    http.setTimeout(5000); // 5 second timeout
-
-    int httpCode = http.GET();
-
-    if (httpCode == HTTP_CODE_OK)
+    NtpSample sample;
+    if (!ntp.query(sample, NTP_SAMPLES, NTP_TIMEOUT))
     {
-        String payload = http.getString();
+        Serial.println("TIME:No valid NTP reply");
+        return false;
+    }
 
-        // Parse JSON response
-        StaticJsonDocument<512> doc;
-        DeserializationError error = deserializeJson(doc, payload);
+    uint64_t localMs = MonotonicClock::millis64();
+    uint64_t unixMs = (uint64_t)((int64_t)localMs + sample.offsetMs);
 
-        if (!error)
-        {
-            // Get Unix timestamp from API
-            unsigned long unixTime = doc["unixtime"];
-
-            if (unixTime > 1609459200) // Sanity check: after 2021-01-01
-            {
-                _bootUnixTime = unixTime;
-                _bootMillis = millis();
-                _timeSynced = true;
+    if (unixMs < 1609459200000ULL) // Sanity check: after 2021-01-01
+    {
+        Serial.println("TIME:NTP time out of range");
+        return false;
+    }
 
-                // Save to EEPROM
-                saveTimeToEEPROM();
+    _lastOffsetMs = sample.offsetMs;
+    _lastRoundTrip = sample.delayMs;
+    applySync(unixMs, localMs);
 
-                Serial.print("TIME:Synced! Unix time: ");
-                Serial.println(unixTime);
+    Serial.print("TIME:Synced! Unix time: ");
+    Serial.print(getUnixTime());
+    Serial.print(", rtt ");
+    Serial.print(sample.delayMs);
+    Serial.print(" ms, drift ");
+    Serial.print(_driftPpm, 1);
+    Serial.println(" ppm");
 
-                http.end();
-                return true;
-            }
-        }
-        else
-        {
-            Serial.print("TIME:JSON parse error: ");
-            Serial.println(error.c_str());
-        }
-    }
-    else
-    {
-        Serial.print("TIME:HTTP error: ");
-        Serial.println(httpCode);
-    }
+    return true;
+}
 
-    http.end();
-    return false;
+void TimeSync::setNtpServers(const char *const *servers, uint8_t count)
+{
+    ntp.setServers(servers, count);
 }
 
 unsigned long TimeSync::getUnixTime()
+{
+    // Returns 0 if not synced (caller should check with isSynced())
+    return getUnixTimeMs() / 1000;
+}
+
+uint64_t TimeSync::getUnixTimeMs()
 {
     if (!_timeSynced)
     {
-        // Return 0 if not synced (caller should check with isSynced())
         return 0;
     }
 
-    // Calculate current Unix time based on boot time and elapsed millis
-    unsigned long elapsedSeconds = (millis() - _bootMillis) / 1000;
-    return _bootUnixTime + elapsedSeconds;
+    return unixMsAt(MonotonicClock::millis64());
 }
 
 bool TimeSync::isSynced()
@@ -136,81 +122,25 @@ void TimeSync::update()
     if (_timeSynced && (millis() - _lastSyncAttempt > RESYNC_INTERVAL))
     {
         Serial.println("TIME:24h elapsed, re-syncing...");
-        syncTimeFromAPI();
-    }
-}
-
-void TimeSync::saveTimeToEEPROM()
-{
-    // Write Unix time (4 bytes)
-    EEPROM.put(EEPROM_TIME_ADDR, _bootUnixTime);
-
-    // Write boot millis (4 bytes)
-    EEPROM.put(EEPROM_MILLIS_ADDR, _bootMillis);
-
-    // Write valid flag (1 byte) - magic number 0xAB
-    EEPROM.write(EEPROM_VALID_FLAG_ADDR, 0xAB);
-
-    EEPROM.commit();
-
-    Serial.println("TIME:Saved to EEPROM");
-}
-
-bool TimeSync::loadTimeFromEEPROM()
-{
-    // Check valid flag
-    byte validFlag = EEPROM.read(EEPROM_VALID_FLAG_ADDR);
-    if (validFlag != 0xAB)
-    {
-        Serial.println("TIME:EEPROM invalid flag");
-        return false;
-    }
-
-    // Read Unix time
-    unsigned long savedUnixTime;
-    EEPROM.get(EEPROM_TIME_ADDR, savedUnixTime);
-
-    // Read boot millis
-    unsigned long savedBootMillis;
-    EEPROM.get(EEPROM_MILLIS_ADDR, savedBootMillis);
-
-    // Sanity check
-    if (savedUnixTime < 1609459200) // Before 2021-01-01
-    {
-        Serial.println("TIME:EEPROM time too old");
-        return false;
+        syncTimeFromNTP();
     }
-
-    // Calculate elapsed time since EEPROM save
-    unsigned long currentMillis = millis();
-    unsigned long elapsedMillis = currentMillis - savedBootMillis;
-
-    // If millis wrapped around or elapsed time is huge, reject it
-    if (elapsedMillis > 604800000UL) // 7 days in milliseconds
-    {
-        Serial.println("TIME:EEPROM time too stale");
-        return false;
-    }
-
-    // Restore time reference
-    _bootUnixTime = savedUnixTime + (elapsedMillis / 1000);
-    _bootMillis = currentMillis;
-    _timeSynced = true;
-
-    Serial.print("TIME:Restored from EEPROM: ");
-    Serial.println(getUnixTime());
-
-    return true;
 }
 
 #else
 // AVR implementation (Mega2560) - receives time from ESP8266
 
 TimeSync::TimeSync()
-    : _bootUnixTime(0),
-      _bootMillis(0),
+    : _anchorUnixMs(0),
+      _anchorMillis(0),
+      _driftPpm(0),
+      _slewMs(0),
+      _driftValid(false),
+      _refUnixMs(0),
+      _refMillis(0),
       _timeSynced(false),
-      _lastSyncAttempt(0)
+      _lastSyncAttempt(0),
+      _lastOffsetMs(0),
+      _lastRoundTrip(0)
 {
 }
 
@@ -221,7 +151,7 @@ bool TimeSync::begin()
     return true;
 }
 
-bool TimeSync::syncTimeFromAPI()
+bool TimeSync::syncTimeFromNTP()
 {
     // On AVR, this is a no-op
     // Time is received from ESP8266
@@ -229,15 +159,19 @@ bool TimeSync::syncTimeFromAPI()
 }
 
 unsigned long TimeSync::getUnixTime()
+{
+    return getUnixTimeMs() / 1000;
+}
+
+uint64_t TimeSync::getUnixTimeMs()
 {
     if (!_timeSynced)
     {
-        // Use millis as fallback
-        return millis() / 1000;
+        // Use uptime as fallback
+        return MonotonicClock::millis64();
     }
 
-    unsigned long elapsedSeconds = (millis() - _bootMillis) / 1000;
-    return _bootUnixTime + elapsedSeconds;
+    return unixMsAt(MonotonicClock::millis64());
 }
 
 bool TimeSync::isSynced()
@@ -255,25 +189,166 @@ void TimeSync::update()
     // No-op on AVR
 }
 
-void TimeSync::saveTimeToEEPROM()
-{
-    // No EEPROM saving on AVR for time
-}
-
-bool TimeSync::loadTimeFromEEPROM()
+void TimeSync::setNtpServers(const char *const *, uint8_t)
 {
-    return false;
+    // No network on AVR
 }
 
 #endif
 
 // Common implementation for both platforms
-void TimeSync::setUnixTime(unsigned long unixTime)
+void TimeSync::setUnixTime(unsigned long unixTime, uint16_t millisPart)
 {
-    _bootUnixTime = unixTime;
-    _bootMillis = millis();
-    _timeSynced = true;
+    applySync((uint64_t)unixTime * 1000 + millisPart, MonotonicClock::millis64());
 
     Serial.print("TIME:Set to ");
     Serial.println(unixTime);
 }
+
+bool TimeSync::parseTimeMessage(const char *line, unsigned long &unixTime, uint16_t &millisPart)
+{
+    if (strncmp(line, "TIME:", 5) != 0)
+    {
+        return false;
+    }
+
+    const char *p = line + 5;
+    uint32_t seconds = 0;
+    uint8_t digits = 0;
+    for (; *p >= '0' && *p <= '9'; p++, digits++)
+    {
+        uint8_t digit = *p - '0';
+        if (digits == 10 || seconds > (0xFFFFFFFFUL - digit) / 10)
+        {
+            return false;
+        }
+        seconds = seconds * 10 + digit;
+    }
+    if (digits == 0)
+    {
+        return false;
+    }
+
+    uint16_t ms = 0;
+    if (*p == '.')
+    {
+        uint16_t scale = 100;
+        for (p++, digits = 0; *p >= '0' && *p <= '9'; p++, digits++)
+        {
+            if (digits == 3)
+            {
+                return false;
+            }
+            ms += (*p - '0') * scale;
+            scale /= 10;
+        }
+        if (digits == 0)
+        {
+            return false;
+        }
+    }
+    if (*p != '\0')
+    {
+        return false;
+    }
+
+    unixTime = seconds;
+    millisPart = ms;
+    return true;
+}
+
+long TimeSync::getPendingSlewMs()
+{
+    if (!_timeSynced)
+    {
+        return 0;
+    }
+
+    uint64_t elapsed = MonotonicClock::millis64() - _anchorMillis;
+    long maxSlew = (long)((float)elapsed * TIME_SLEW_RATE_PPM / 1000000.0f);
+
+    if (_slewMs > 0)
+    {
+        return _slewMs > maxSlew ? _slewMs - maxSlew : 0;
+    }
+    return -_slewMs > maxSlew ? _slewMs + maxSlew : 0;
+}
+
+uint64_t TimeSync::unixMsAt(uint64_t localMs)
+{
+    uint64_t elapsed = localMs - _anchorMillis;
+
+    // Rate correction from the drift estimate
+    int64_t corrected = (int64_t)elapsed + (int64_t)((float)elapsed * _driftPpm / 1000000.0f);
+
+    // Slew: the pending error is applied gradually, never faster than
+    // TIME_SLEW_RATE_PPM, so the clock never steps or runs backwards
+    long slew = (long)((float)elapsed * TIME_SLEW_RATE_PPM / 1000000.0f);
+    if (slew > labs(_slewMs))
+    {
+        slew = labs(_slewMs);
+    }
+    if (_slewMs < 0)
+    {
+        slew = -slew;
+    }
+
+    return _anchorUnixMs + corrected + slew;
+}
+
+void TimeSync::applySync(uint64_t unixMs, uint64_t localMs)
+{
+    if (!_timeSynced)
+    {
+        // First sync: step
+        _anchorUnixMs = unixMs;
+        _anchorMillis = localMs;
+        _slewMs = 0;
+        _refUnixMs = unixMs;
+        _refMillis = localMs;
+        _timeSynced = true;
+        return;
+    }
+
+    uint64_t predicted = unixMsAt(localMs);
+    long long error = (long long)(unixMs - predicted);
+
+    // Drift from the true vs. local time elapsed over a long enough baseline
+    uint64_t interval = localMs - _refMillis;
+    if (interval >= TIME_DRIFT_MIN_INTERVAL)
+    {
+        long long trueElapsed = (long long)(unixMs - _refUnixMs);
+        float observed = (float)(trueElapsed - (long long)interval) * 1000000.0f / (float)interval;
+
+        // Smooth: one noisy sync only moves the estimate part of the way
+        _driftPpm = _driftValid ? _driftPpm + (observed - _driftPpm) / 2 : observed;
+        _driftValid = true;
+
+        if (_driftPpm > TIME_DRIFT_MAX_PPM)
+            _driftPpm = TIME_DRIFT_MAX_PPM;
+        if (_driftPpm < -TIME_DRIFT_MAX_PPM)
+            _driftPpm = -TIME_DRIFT_MAX_PPM;
+
+        _refUnixMs = unixMs;
+        _refMillis = localMs;
+    }
+
+    if (error > TIME_STEP_THRESHOLD || error < -TIME_STEP_THRESHOLD)
+    {
+        // Too far off to slew in reasonable time: step
+        Serial.print("TIME:Stepped by ");
+        Serial.print((long)error);
+        Serial.println(" ms");
+
+        _anchorUnixMs = unixMs;
+        _slewMs = 0;
+    }
+    else
+    {
+        // Re-anchor on the clock as it reads now and slew out the error
+        _anchorUnixMs = predicted;
+        _slewMs = (long)error;
+    }
+
+    _anchorMillis = localMs;
+}
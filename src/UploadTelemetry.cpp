@@ -0,0 +1,220 @@
+/**
+ * @file UploadTelemetry.cpp
+ * @brief Upload pipeline metrics implementation
+ */
+
+#include "UploadTelemetry.h"
+#include "MonotonicClock.h"
+#include <stdio.h>
+
+const uint16_t UploadTelemetry::BUCKET_LIMITS[UploadTelemetry::LATENCY_BUCKETS] = {
+    50, 100, 200, 300, 500, 750, 1000, 1500, 2000, 3000, 5000, 10000};
+
+UploadTelemetry::UploadTelemetry()
+    : _heapLowWater(0xFFFFFFFFUL),
+      _heapLast(0),
+      _heapBlock(0),
+      _heapBlockMin(0xFFFFFFFFUL),
+      _heapFrag(0),
+      _heapFragMax(0),
+      _heapTrend(0),
+      _heapFragTrend(0),
+      _heapAlarms(0),
+      _megaRamFree(0),
+      _megaRamMin(0xFFFF),
+      _megaRamUnused(0),
+      _megaHeapBlock(0),
+      _megaStackPeak(0),
+      _wifiConnectMs(0),
+      _wifiFast(false)
+{
+    resetPeriod();
+}
+
+void UploadTelemetry::recordSuccess(unsigned long latencyMs, size_t bytes, int records)
+{
+    _requests++;
+    _records += records;
+    _bytes += bytes;
+    recordLatency(latencyMs);
+}
+
+void UploadTelemetry::recordFailure(int httpCode, unsigned long latencyMs)
+{
+    _requests++;
+    recordLatency(latencyMs);
+
+    if (httpCode <= 0)
+        _failures[FAIL_NETWORK]++;
+    else if (httpCode == 401 || httpCode == 403)
+        _failures[FAIL_AUTH]++;
+    else if (httpCode >= 400 && httpCode < 500)
+        _failures[FAIL_CLIENT]++;
+    else if (httpCode >= 500)
+        _failures[FAIL_SERVER]++;
+    else
+        _failures[FAIL_OTHER]++;
+}
+
+void UploadTelemetry::sampleHeap(uint32_t freeHeap, uint32_t maxBlock, uint8_t fragmentation)
+{
+    _heapLast = freeHeap;
+    if (freeHeap < _heapLowWater)
+    {
+        _heapLowWater = freeHeap;
+    }
+    _heapBlock = maxBlock;
+    if (maxBlock < _heapBlockMin)
+    {
+        _heapBlockMin = maxBlock;
+    }
+    _heapFrag = fragmentation;
+    if (fragmentation > _heapFragMax)
+    {
+        _heapFragMax = fragmentation;
+    }
+}
+
+void UploadTelemetry::setHeapTrend(long freePerHour, int fragTenthsPerHour, uint8_t alarms)
+{
+    _heapTrend = freePerHour;
+    _heapFragTrend = fragTenthsPerHour;
+    _heapAlarms = alarms;
+}
+
+void UploadTelemetry::sampleMegaMemory(uint16_t freeNow, uint16_t unused, uint16_t largestBlock, uint16_t stackPeak)
+{
+    _megaRamFree = freeNow;
+    if (freeNow < _megaRamMin)
+    {
+        _megaRamMin = freeNow;
+    }
+    _megaRamUnused = unused;
+    _megaHeapBlock = largestBlock;
+    _megaStackPeak = stackPeak;
+}
+
+void UploadTelemetry::recordAlarmLatency(unsigned long latencyMs)
+{
+    _alarmLatencyLast = latencyMs;
+    if (latencyMs > _alarmLatencyMax)
+    {
+        _alarmLatencyMax = latencyMs;
+    }
+}
+
+void UploadTelemetry::recordWiFiConnect(unsigned long connectMs, bool fast)
+{
+    _wifiConnectMs = connectMs;
+    _wifiFast = fast;
+}
+
+unsigned long UploadTelemetry::latencyPercentile(uint8_t percent) const
+{
+    unsigned long total = 0;
+    for (uint8_t i = 0; i <= LATENCY_BUCKETS; i++)
+    {
+        total += _latencyHistogram[i];
+    }
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    // Rank of the requested percentile, rounded up
+    unsigned long rank = (total * percent + 99) / 100;
+    unsigned long seen = 0;
+
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += _latencyHistogram[i];
+        if (seen >= rank)
+        {
+            return BUCKET_LIMITS[i];
+        }
+    }
+
+    return _latencyMax; // Overflow bucket: report the worst seen
+}
+
+size_t UploadTelemetry::toJSON(char *buffer, size_t size, int backlog, int rssi, unsigned long unixTime) const
+{
+    unsigned long periodMs = millis() - _periodStart;
+    if (periodMs == 0)
+    {
+        periodMs = 1;
+    }
+
+    int written = snprintf(buffer, size,
+        "{\"ts\":%lu,\"uptime_s\":%lu,\"period_s\":%lu,"
+        "\"requests\":%lu,\"records\":%lu,\"records_per_s\":%.2f,\"bytes_per_s\":%.1f,"
+        "\"lat_p50_ms\":%lu,\"lat_p90_ms\":%lu,\"lat_p99_ms\":%lu,\"lat_max_ms\":%lu,"
+        "\"fail_network\":%lu,\"fail_auth\":%lu,\"fail_client\":%lu,\"fail_server\":%lu,\"fail_other\":%lu,\"rejected\":%lu,"
+        "\"backlog\":%d,\"heap_free\":%lu,\"heap_min\":%lu,\"rssi\":%d,"
+        "\"heap_blk\":%lu,\"heap_blk_min\":%lu,\"heap_frag\":%u,\"heap_frag_max\":%u,"
+        "\"heap_trend_bph\":%ld,\"heap_frag_trend\":%.1f,\"heap_alarms\":%u,"
+        "\"alarm_latency_ms\":%lu,\"alarm_latency_max_ms\":%lu,"
+        "\"wifi_connect_ms\":%lu,\"wifi_fast\":%s,"
+        "\"mega_ram_free\":%u,\"mega_ram_min\":%u,\"mega_ram_unused\":%u,"
+        "\"mega_heap_blk\":%u,\"mega_stack_peak\":%u}",
+        unixTime, (unsigned long)(MonotonicClock::millis64() / 1000), periodMs / 1000,
+        _requests, _records, _records * 1000.0 / periodMs, _bytes * 1000.0 / periodMs,
+        latencyPercentile(50), latencyPercentile(90), latencyPercentile(99), _latencyMax,
+        _failures[FAIL_NETWORK], _failures[FAIL_AUTH], _failures[FAIL_CLIENT], _failures[FAIL_SERVER], _failures[FAIL_OTHER], _rejected,
+        backlog, (unsigned long)_heapLast, (unsigned long)(_heapLowWater == 0xFFFFFFFFUL ? 0 : _heapLowWater), rssi,
+        (unsigned long)_heapBlock, (unsigned long)(_heapBlockMin == 0xFFFFFFFFUL ? 0 : _heapBlockMin), _heapFrag, _heapFragMax,
+        _heapTrend, _heapFragTrend / 10.0, _heapAlarms,
+        _alarmLatencyLast, _alarmLatencyMax,
+        _wifiConnectMs, _wifiFast ? "true" : "false",
+        _megaRamFree, _megaRamMin == 0xFFFF ? 0 : _megaRamMin, _megaRamUnused,
+        _megaHeapBlock, _megaStackPeak);
+
+    if (written < 0 || (size_t)written >= size)
+    {
+        return 0;
+    }
+
+    return written;
+}
+
+void UploadTelemetry::resetPeriod()
+{
+    _periodStart = millis();
+    _requests = 0;
+    _records = 0;
+    _bytes = 0;
+    _rejected = 0;
+    _latencyMax = 0;
+    _alarmLatencyMax = 0;
+    _alarmLatencyLast = 0;
+
+    for (uint8_t i = 0; i < FAIL_CLASSES; i++)
+    {
+        _failures[i] = 0;
+    }
+
+    for (uint8_t i = 0; i <= LATENCY_BUCKETS; i++)
+    {
+        _latencyHistogram[i] = 0;
+    }
+}
+
+void UploadTelemetry::recordLatency(unsigned long latencyMs)
+{
+    if (latencyMs > _latencyMax)
+    {
+        _latencyMax = latencyMs;
+    }
+
+    uint8_t bucket = 0;
+    while (bucket < LATENCY_BUCKETS && latencyMs > BUCKET_LIMITS[bucket])
+    {
+        bucket++;
+    }
+
+    if (_latencyHistogram[bucket] < 0xFFFF)
+    {
+        _latencyHistogram[bucket]++;
+    }
+}
@@ -0,0 +1,252 @@
+/**
+ * @file WiFiConnection.cpp
+ * @brief Event-driven WiFi connection manager implementation
+ */
+
+#include "WiFiConnection.h"
+
+#ifdef ESP8266
+#include <LittleFS.h>
+
+static const uint32_t CACHE_MAGIC = 0x57464331; // "WFC1"
+static const char *CACHE_FILE = "/wifi.bin";
+
+WiFiConnection::WiFiConnection()
+    : _ssid(""),
+      _password(""),
+      _state(CONN_IDLE),
+      _attemptStart(0),
+      _backoffStart(0),
+      _backoffDelay(WIFI_BACKOFF_MIN),
+      _lastConnectTime(0),
+      _connectCount(0),
+      _cacheValid(false),
+      _fastAttempt(false),
+      _skipFast(false),
+      _gotIp(false),
+      _disconnected(false)
+{
+}
+
+void WiFiConnection::begin(const char *ssid, const char *password)
+{
+    _ssid = ssid;
+    _password = password;
+
+    // We drive reconnects ourselves; keep the SDK from racing us and
+    // from rewriting the flash config on every WiFi.begin()
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false);
+
+    _gotIpHandler = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP &) {
+        _gotIp = true;
+    });
+    _disconnectedHandler = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected &) {
+        _disconnected = true;
+    });
+
+    _cacheValid = loadCache();
+    startAttempt();
+}
+
+void WiFiConnection::update()
+{
+    unsigned long now = millis();
+
+    switch (_state)
+    {
+    case CONN_IDLE:
+        break;
+
+    case CONN_CONNECTING:
+        if (_gotIp)
+        {
+            _gotIp = false;
+            _disconnected = false;
+            _state = CONN_CONNECTED;
+            _lastConnectTime = now - _attemptStart;
+            _connectCount++;
+            _backoffDelay = WIFI_BACKOFF_MIN;
+            _skipFast = false;
+            storeCache();
+
+            Serial.print(F("STATUS:WiFi connected in "));
+            Serial.print(_lastConnectTime);
+            Serial.println(_fastAttempt ? F(" ms (fast)") : F(" ms"));
+        }
+        else if (_fastAttempt && now - _attemptStart >= WIFI_FAST_CONNECT_TIMEOUT)
+        {
+            // Cached AP/IP did not work: fall straight back to scan + DHCP
+            Serial.println(F("STATUS:WiFi fast connect failed, full scan"));
+            _skipFast = true;
+            WiFi.disconnect();
+            startAttempt();
+        }
+        else if (now - _attemptStart >= WIFI_CONNECT_TIMEOUT)
+        {
+            Serial.println(F("STATUS:WiFi attempt timed out"));
+            enterBackoff();
+        }
+        break;
+
+    case CONN_CONNECTED:
+        if (_disconnected)
+        {
+            _disconnected = false;
+            Serial.println(F("STATUS:WiFi lost"));
+            enterBackoff();
+        }
+        break;
+
+    case CONN_BACKOFF:
+        if (now - _backoffStart >= _backoffDelay)
+        {
+            startAttempt();
+        }
+        break;
+    }
+}
+
+const char *WiFiConnection::getStateName() const
+{
+    switch (_state)
+    {
+    case CONN_CONNECTING:
+        return "connecting";
+    case CONN_CONNECTED:
+        return "connected";
+    case CONN_BACKOFF:
+        return "backoff";
+    default:
+        return "idle";
+    }
+}
+
+void WiFiConnection::forgetCache()
+{
+    _cacheValid = false;
+    memset(&_cache, 0, sizeof(_cache));
+
+    ESP.rtcUserMemoryWrite(WIFI_RTC_SLOT, (uint32_t *)&_cache, sizeof(_cache));
+    LittleFS.remove(CACHE_FILE);
+}
+
+void WiFiConnection::startAttempt()
+{
+    _gotIp = false;
+    _disconnected = false;
+    _attemptStart = millis();
+    _state = CONN_CONNECTING;
+    _fastAttempt = _cacheValid && !_skipFast;
+
+    if (_fastAttempt)
+    {
+        // Known AP and lease: no scan, no DHCP round trips
+        WiFi.config(IPAddress(_cache.ip), IPAddress(_cache.gateway), IPAddress(_cache.mask), IPAddress(_cache.dns));
+        WiFi.begin(_ssid, _password, _cache.channel, _cache.bssid);
+    }
+    else
+    {
+        // All-zero config switches DHCP back on
+        WiFi.config(IPAddress(0U), IPAddress(0U), IPAddress(0U));
+        WiFi.begin(_ssid, _password);
+    }
+}
+
+void WiFiConnection::enterBackoff()
+{
+    WiFi.disconnect();
+
+    // disconnect() raises its own event; it must not end the backoff early
+    _gotIp = false;
+    _disconnected = false;
+    _backoffStart = millis();
+    _state = CONN_BACKOFF;
+
+    Serial.print(F("STATUS:WiFi retry in "));
+    Serial.print(_backoffDelay);
+    Serial.println(F(" ms"));
+
+    unsigned long next = _backoffDelay * 2;
+    _backoffDelay = next > WIFI_BACKOFF_MAX ? WIFI_BACKOFF_MAX : next;
+}
+
+bool WiFiConnection::loadCache()
+{
+    // RTC memory survives resets; flash covers power cycles
+    if (ESP.rtcUserMemoryRead(WIFI_RTC_SLOT, (uint32_t *)&_cache, sizeof(_cache)) &&
+        _cache.magic == CACHE_MAGIC &&
+        _cache.crc == crc32((const uint8_t *)&_cache, offsetof(WiFiFastConnectCache, crc)))
+    {
+        return true;
+    }
+
+    File file = LittleFS.open(CACHE_FILE, "r");
+    if (!file)
+    {
+        return false;
+    }
+
+    size_t read = file.read((uint8_t *)&_cache, sizeof(_cache));
+    file.close();
+
+    if (read != sizeof(_cache) || _cache.magic != CACHE_MAGIC ||
+        _cache.crc != crc32((const uint8_t *)&_cache, offsetof(WiFiFastConnectCache, crc)))
+    {
+        return false;
+    }
+
+    ESP.rtcUserMemoryWrite(WIFI_RTC_SLOT, (uint32_t *)&_cache, sizeof(_cache));
+    return true;
+}
+
+void WiFiConnection::storeCache()
+{
+    WiFiFastConnectCache fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    fresh.magic = CACHE_MAGIC;
+    memcpy(fresh.bssid, WiFi.BSSID(), sizeof(fresh.bssid));
+    fresh.channel = WiFi.channel();
+    fresh.ip = WiFi.localIP();
+    fresh.gateway = WiFi.gatewayIP();
+    fresh.mask = WiFi.subnetMask();
+    fresh.dns = WiFi.dnsIP();
+    fresh.crc = crc32((const uint8_t *)&fresh, offsetof(WiFiFastConnectCache, crc));
+
+    // Unchanged AP and lease: nothing to write (spares the flash)
+    if (_cacheValid && memcmp(&fresh, &_cache, sizeof(fresh)) == 0)
+    {
+        return;
+    }
+
+    _cache = fresh;
+    _cacheValid = true;
+
+    ESP.rtcUserMemoryWrite(WIFI_RTC_SLOT, (uint32_t *)&_cache, sizeof(_cache));
+
+    File file = LittleFS.open(CACHE_FILE, "w");
+    if (file)
+    {
+        file.write((const uint8_t *)&_cache, sizeof(_cache));
+        file.close();
+    }
+}
+
+uint32_t WiFiConnection::crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (length--)
+    {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+
+    return ~crc;
+}
+
+#endif // ESP8266
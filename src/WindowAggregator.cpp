@@ -0,0 +1,105 @@
+/**
+ * @file WindowAggregator.cpp
+ * @brief Rolling per-window summary implementation
+ */
+
+#include "WindowAggregator.h"
+
+WindowAggregator::WindowAggregator(uint16_t windowSeconds)
+    : _windowSeconds(windowSeconds > 0 ? windowSeconds : 1),
+      _windowStart(0),
+      _count(0),
+      _relay1On(0),
+      _relay2On(0)
+{
+    reset(0);
+}
+
+bool WindowAggregator::addSample(const SensorData &data, WindowSummary &closed)
+{
+    unsigned long bucket = data.timestamp - (data.timestamp % _windowSeconds);
+    bool didClose = false;
+
+    // A sample outside the current window (later, or earlier after a clock
+    // step such as the first time sync) closes the window in progress
+    if (_count > 0 && bucket != _windowStart)
+    {
+        close(closed);
+        didClose = true;
+    }
+
+    if (_count == 0)
+    {
+        reset(bucket);
+    }
+
+    const float values[AGG_CHANNELS] = {data.getTemperature(), data.getWeight(), data.getKadarAir()};
+    for (int i = 0; i < AGG_CHANNELS; i++)
+    {
+        if (values[i] < _min[i]) _min[i] = values[i];
+        if (values[i] > _max[i]) _max[i] = values[i];
+        _sum[i] += values[i];
+    }
+
+    if (data.relay1) _relay1On++;
+    if (data.relay2) _relay2On++;
+    _count++;
+
+    return didClose;
+}
+
+bool WindowAggregator::flush(unsigned long now, WindowSummary &closed)
+{
+    if (_count == 0 || now < _windowStart + _windowSeconds)
+    {
+        return false;
+    }
+
+    close(closed);
+    return true;
+}
+
+void WindowAggregator::setWindowSeconds(uint16_t windowSeconds)
+{
+    if (windowSeconds == 0 || windowSeconds == _windowSeconds)
+    {
+        return;
+    }
+
+    _windowSeconds = windowSeconds;
+    reset(0);
+}
+
+void WindowAggregator::reset(unsigned long windowStart)
+{
+    _windowStart = windowStart;
+    _count = 0;
+    _relay1On = 0;
+    _relay2On = 0;
+
+    for (int i = 0; i < AGG_CHANNELS; i++)
+    {
+        _min[i] = 3.4e38f;
+        _max[i] = -3.4e38f;
+        _sum[i] = 0.0f;
+    }
+}
+
+void WindowAggregator::close(WindowSummary &closed)
+{
+    closed.windowStart = _windowStart;
+    closed.windowSeconds = _windowSeconds;
+    closed.sampleCount = _count;
+
+    for (int i = 0; i < AGG_CHANNELS; i++)
+    {
+        closed.minValue[i] = _min[i];
+        closed.maxValue[i] = _max[i];
+        closed.avgValue[i] = _sum[i] / _count;
+    }
+
+    closed.relay1Duty = (float)_relay1On / _count;
+    closed.relay2Duty = (float)_relay2On / _count;
+
+    reset(0);
+}
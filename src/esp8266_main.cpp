@@ -11,19 +11,36 @@
 #include <ESP8266WiFi.h>
 #include <ArduinoJson.h>
 #include <Firebase_ESP_Client.h>
+#include <LittleFS.h>
 #include <addons/TokenHelper.h>
 #include "SystemConfig.h"
 #include "SensorData.h"
 #include "LocalStorage.h"
 #include "TimeSync.h"
+#include "WindowAggregator.h"
+#include "UploadTelemetry.h"
+#include "RemoteConfig.h"
+#include "WiFiConnection.h"
+#include "AuthCache.h"
+#include "MonotonicClock.h"
+#include "HeapMonitor.h"
+#include "FirestoreDocument.h"
 
 // Firebase
 FirebaseData fbdo;
 FirebaseAuth auth;
 FirebaseConfig config;
 
+// Background WiFi connection manager
+WiFiConnection wifi;
+
 bool wifiConnected = false;
-bool firebaseReady = false;
+bool firebaseReady = false; // Session configured; survives WiFi drops
+bool authPending = false;   // Network task: Firebase session still to set up
+bool timePending = false;   // Network task: time sync still to attempt
+AuthCache authCache;
+bool tokenExpiryPending = false;  // ID token issued before time sync, expiry not saved yet
+unsigned long tokenIssuedUptime = 0; // Uptime (s) it was issued at
 
 // LocalStorage instance (reuse MEGA's class!)
 LocalStorage *localStorage;
@@ -31,40 +48,140 @@ LocalStorage *localStorage;
 // TimeSync instance
 TimeSync timeSync;
 
+// Edge aggregation: closed windows wait here for the summary lane
+WindowAggregator aggregator;
+WindowSummary summaryQueue[AGG_QUEUE_SIZE];
+int summaryHead = 0;
+int summaryCount = 0;
+
+// Alarm fast path: events from the MEGA, uploaded ahead of everything else
+struct AlarmEvent
+{
+    char code[12];              // ALARM_* code sent by the MEGA
+    float value;                // Value that triggered the alarm
+    unsigned long timestamp;    // MEGA timestamp (Unix time or seconds since boot)
+    unsigned long receivedAt;   // millis() when the line arrived at the ESP
+    unsigned long detectDelay;  // MEGA detection -> ESP receipt (ms)
+    bool unsynced;              // timestamp is this boot's uptime, re-stamped at the first sync
+};
+
+AlarmEvent alarmQueue[ALARM_QUEUE_SIZE];
+int alarmHead = 0;
+int alarmCount = 0;
+
+// Upload lanes: live (newest sample) and backfill (historical backlog)
+bool livePending = false;
+int uploadBatchSize = UPLOAD_BATCH_SIZE;
+
+// Upload backoff: a failed request pauses every lane, doubling like the
+// WiFi manager; the next success clears it
+int lastUploadCode = 0;             // HTTP status of the last upload request (<= 0: no response)
+unsigned long uploadBackoff = 0;    // Current pause (ms), 0 = none
+unsigned long lastUploadFailure = 0;
+
+// Raw sample policy (full / decimated / off)
+uint8_t rawUploadMode = RAW_UPLOAD_MODE;
+uint16_t rawDecimation = RAW_DECIMATION_FACTOR;
+uint16_t rawDecimationCounter = 0;
+
+// First second no sample has been stamped with yet, and the sequence of
+// the last sample stamped before it
+unsigned long nextSampleSecond = 0;
+uint16_t lastSampleSequence = 0;
+
+// Upload pipeline metrics, published to FB_STATUS_PATH
+UploadTelemetry telemetry;
+
+// Heap trend and alarms for long-running units
+HeapMonitor heapMonitor;
+
+// MEGA line being received; a line split across ingest passes is kept here
+char megaLine[ESP_LINE_MAX + 2]; // + CR + NUL
+size_t megaLineLength = 0;
+bool megaLineOverflow = false;
+
+// Remote configuration (FB_CONFIG_PATH) and what the MEGA currently runs
+RemoteConfig remoteConfig;
+DeviceSettings megaSettings = DeviceSettings::defaults();
+unsigned long megaConfigVersion = 0; // "cv" reported in the MEGA's samples
+
 // Timing
 unsigned long lastStatusTime = 0;
-unsigned long lastWiFiCheck = 0;
+unsigned long lastStatusPublish = 0;
+unsigned long lastConfigPoll = 0;
+unsigned long lastConfigPush = 0;
+unsigned long lastNetworkRetry = 0;
 unsigned long lastTimeBroadcast = 0;
+unsigned long lastHeapReport = 0;
 
-// Connect WiFi
-void connectWiFi()
+// Persist every new ID token so the next connect/boot can reuse it
+void onTokenStatus(TokenInfo info)
 {
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    if (info.status == token_status_ready)
+    {
+        String idToken = Firebase.getToken();
+        if (timeSync.isSynced())
+        {
+            authCache.save(idToken, Firebase.getRefreshToken(), timeSync.getUnixTime() + AUTH_TOKEN_LIFETIME);
+            return;
+        }
 
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < ESP_RECONNECT_ATTEMPTS)
+        // No Unix time yet: settleTokenExpiry() saves the expiry after the first sync
+        if (idToken != authCache.idToken())
+        {
+            tokenExpiryPending = true;
+            tokenIssuedUptime = (unsigned long)(MonotonicClock::millis64() / 1000);
+        }
+        authCache.save(idToken, Firebase.getRefreshToken(), 0);
+    }
+    else if (info.status == token_status_error)
     {
-        delay(250);
-        attempts++;
+        Serial.print("STATUS:Token error: ");
+        Serial.println(getTokenStatus(info));
+
+        // Server rejected the session (revoked, user deleted): sign up again
+        // on the next retry. Network errors (code <= 0) keep the cache.
+        if (info.error.code > 0 && authCache.isValid())
+        {
+            authCache.clear();
+            firebaseReady = false;
+        }
     }
+}
 
-    wifiConnected = (WiFi.status() == WL_CONNECTED);
+// Configure Firebase and sign in (needs WiFi)
+void setupFirebase()
+{
+    if (firebaseReady)
+        return;
 
-    if (wifiConnected && !firebaseReady)
-    {
-        Serial.print("STATUS:Configuring Firebase... API: ");
-        Serial.println(API_KEY);
-        Serial.print("STATUS:Database URL: ");
-        Serial.println(DATABASE_URL);
+    Serial.print("STATUS:Configuring Firebase... API: ");
+    Serial.println(API_KEY);
+    Serial.print("STATUS:Database URL: ");
+    Serial.println(DATABASE_URL);
 
-        config.api_key = API_KEY;
-        config.timeout.serverResponse = 10 * 1000;
+    config.api_key = API_KEY;
+    config.database_url = DATABASE_URL; // RTDB hosts the status document
+    config.timeout.serverResponse = 10 * 1000;
+    config.token_status_callback = onTokenStatus;
+    config.signer.preRefreshSeconds = AUTH_REFRESH_MARGIN;
 
-        Serial.println("STATUS:Signing in anonymously...");
+    // Reconnects are owned by the WiFi connection manager
+    Firebase.reconnectWiFi(false);
 
-        Firebase.reconnectWiFi(true);
+    if (authCache.isValid() || authCache.load())
+    {
+        // Same anonymous user as last time; at most one token refresh
+        unsigned long now = timeSync.isSynced() ? timeSync.getUnixTime() : 0;
+        Firebase.setIdToken(&config, authCache.idToken(), authCache.secondsLeft(now), authCache.refreshToken());
+        Serial.println("STATUS:Reusing cached Firebase session");
+        firebaseReady = true;
+    }
+    else
+    {
+        Serial.println("STATUS:Signing in anonymously...");
 
-        // Use signUp for anonymous authentication
+        // Use signUp for anonymous authentication (first boot only)
         if (Firebase.signUp(&config, &auth, "", ""))
         {
             Serial.println("STATUS:Anonymous signup success");
@@ -74,111 +191,884 @@ void connectWiFi()
         {
             Serial.print("STATUS:Signup failed: ");
             Serial.println(config.signer.signupError.message.c_str());
+            return;
         }
+    }
 
-        Firebase.begin(&config, &auth);
+    Firebase.begin(&config, &auth);
+}
+
+// The server refused the request itself: sending it again fails the same
+// way. Auth, timeout and rate-limit answers are worth a retry.
+bool permanentFailure(int httpCode)
+{
+    return httpCode >= 400 && httpCode < 500 && httpCode != 401 && httpCode != 403 &&
+           httpCode != 408 && httpCode != 429;
+}
+
+// Track the outcome of an upload request for the backoff
+void noteUploadResult(bool ok, int httpCode)
+{
+    lastUploadCode = ok ? 200 : httpCode;
+    if (ok)
+    {
+        uploadBackoff = 0;
+    }
+    else if (!permanentFailure(httpCode))
+    {
+        uploadBackoff = uploadBackoff ? min(uploadBackoff * 2, (unsigned long)UPLOAD_BACKOFF_MAX) : UPLOAD_BACKOFF_MIN;
+        lastUploadFailure = millis();
     }
 }
 
-// Upload all EEPROM data to Firestore
-int uploadAllData()
+bool uploadBackingOff(unsigned long now)
 {
-    if (!wifiConnected)
+    return uploadBackoff > 0 && now - lastUploadFailure < uploadBackoff;
+}
+
+// After a failed upload: true if the lane should drop the item instead of
+// retrying it (counted in the status document)
+bool uploadRejected(const char *what)
+{
+    if (!permanentFailure(lastUploadCode))
+        return false;
+
+    telemetry.recordRejected();
+    Serial.print(F("STATUS:Dropped "));
+    Serial.print(what);
+    Serial.print(F(", rejected with HTTP "));
+    Serial.println(lastUploadCode);
+    return true;
+}
+
+// Firestore patch with timing and failure accounting for the status document
+bool patchDocument(const char *documentPath, FirestoreDocument &document, int records)
+{
+    const char *content = document.c_str();
+    if (!content)
     {
-        Serial.println("STATUS:Upload failed - WiFi not connected");
-        return 0;
+        Serial.println(F("STATUS:Document too large"));
+        lastUploadCode = 413; // Would be refused every time, like Payload Too Large
+        return false;
     }
-    if (!firebaseReady)
+
+    unsigned long start = millis();
+    bool ok = Firebase.Firestore.patchDocument(&fbdo, FIREBASE_PROJECT_ID, "", documentPath, content, "");
+    unsigned long latency = millis() - start;
+
+    if (ok)
+        telemetry.recordSuccess(latency, document.length(), records);
+    else
+        telemetry.recordFailure(fbdo.httpCode(), latency);
+
+    noteUploadResult(ok, fbdo.httpCode());
+    return ok;
+}
+
+// Current sample timestamp: Unix time when synced, otherwise seconds since boot
+unsigned long currentTimestamp()
+{
+    return timeSync.isSynced() ? timeSync.getUnixTime() : (unsigned long)(MonotonicClock::millis64() / 1000);
+}
+
+// Number the samples stamped with the same second. Lines queued behind a
+// blocking request arrive together; without this they would share one
+// sensor_data document. Also counts up while a stepped-back clock repeats
+// seconds already used.
+uint16_t sampleSequence(unsigned long timestamp)
+{
+    if (timestamp >= nextSampleSecond)
     {
-        Serial.println("STATUS:Upload failed - Firebase not initialized");
-        return 0;
+        nextSampleSecond = timestamp + 1;
+        lastSampleSequence = 0;
     }
-    if (!Firebase.ready())
+    else
     {
-        Serial.print("STATUS:Upload failed - Firebase not ready. Error: ");
+        lastSampleSequence++;
+    }
+    return lastSampleSequence;
+}
+
+// Queue a closed window for the summary lane (oldest dropped when full)
+void queueSummary(const WindowSummary &summary)
+{
+    if (summaryCount == AGG_QUEUE_SIZE)
+    {
+        summaryHead = (summaryHead + 1) % AGG_QUEUE_SIZE;
+        summaryCount--;
+        Serial.println(F("STATUS:Summary queue full, dropped oldest window"));
+    }
+
+    summaryQueue[(summaryHead + summaryCount) % AGG_QUEUE_SIZE] = summary;
+    summaryCount++;
+}
+
+// Decide whether a raw sample goes to LocalStorage under the current policy
+bool shouldStoreRaw()
+{
+    if (rawUploadMode == RAW_UPLOAD_OFF)
+        return false;
+    if (rawUploadMode == RAW_UPLOAD_FULL || rawDecimation <= 1)
+        return true;
+
+    bool keep = (rawDecimationCounter == 0);
+    rawDecimationCounter = (rawDecimationCounter + 1) % rawDecimation;
+    return keep;
+}
+
+// Upload one window summary to Firestore: sensor_summary/{device}_{windowStart}
+bool uploadSummary(const WindowSummary &summary)
+{
+    static const char *channelNames[AGG_CHANNELS] = {"temp", "weight", "ka"};
+
+    char documentPath[128];
+    snprintf(documentPath, sizeof(documentPath), "sensor_summary/%s_%lu", DEVICE_NAME, summary.windowStart);
+
+    FirestoreDocument document;
+    char fieldName[16];
+    for (int i = 0; i < AGG_CHANNELS; i++)
+    {
+        snprintf(fieldName, sizeof(fieldName), "%s_min", channelNames[i]);
+        document.addDouble(fieldName, summary.minValue[i]);
+        snprintf(fieldName, sizeof(fieldName), "%s_max", channelNames[i]);
+        document.addDouble(fieldName, summary.maxValue[i]);
+        snprintf(fieldName, sizeof(fieldName), "%s_avg", channelNames[i]);
+        document.addDouble(fieldName, summary.avgValue[i]);
+    }
+    document.addDouble("relay1_duty", summary.relay1Duty);
+    document.addDouble("relay2_duty", summary.relay2Duty);
+    document.addInteger("samples", summary.sampleCount);
+    document.addInteger("window_s", summary.windowSeconds);
+    document.addInteger("window_start", summary.windowStart);
+    document.addString("device", DEVICE_NAME);
+
+    if (patchDocument(documentPath, document, 1))
+    {
+        return true;
+    }
+
+    Serial.print("STATUS:Summary upload error: ");
+    Serial.println(fbdo.errorReason());
+    return false;
+}
+
+// Summary lane: drain closed windows ahead of the raw batch
+int uploadSummaries()
+{
+    int uploaded = 0;
+
+    while (summaryCount > 0)
+    {
+        bool sent = uploadSummary(summaryQueue[summaryHead]);
+        if (!sent && !uploadRejected("summary"))
+            break; // Retried after the backoff
+
+        summaryHead = (summaryHead + 1) % AGG_QUEUE_SIZE;
+        summaryCount--;
+        uploaded += sent ? 1 : 0;
+        yield();
+    }
+
+    if (uploaded > 0)
+    {
+        Serial.print(F("SUMMARY:"));
+        Serial.print(uploaded);
+        Serial.print(F(" windows uploaded, "));
+        Serial.print(summaryCount);
+        Serial.println(F(" pending"));
+    }
+
+    return uploaded;
+}
+
+// Next slot of the alarm fast path (oldest dropped when full)
+AlarmEvent &pushAlarm(const char *code, float value, unsigned long timestamp)
+{
+    if (alarmCount == ALARM_QUEUE_SIZE)
+    {
+        alarmHead = (alarmHead + 1) % ALARM_QUEUE_SIZE;
+        alarmCount--;
+        Serial.println(F("STATUS:Alarm queue full, dropped oldest alarm"));
+    }
+
+    AlarmEvent &event = alarmQueue[(alarmHead + alarmCount) % ALARM_QUEUE_SIZE];
+    strncpy(event.code, code, sizeof(event.code) - 1);
+    event.code[sizeof(event.code) - 1] = '\0';
+    event.value = value;
+    event.timestamp = timestamp;
+    event.receivedAt = millis();
+    event.detectDelay = 0;
+    event.unsynced = timestamp < UNIX_TIME_MIN;
+
+    alarmCount++;
+
+    Serial.print(F("ALARM:Queued "));
+    Serial.println(event.code);
+    return event;
+}
+
+// Queue an alarm from the MEGA for the fast path
+void queueAlarm(JsonDocument &doc, size_t lineLength)
+{
+    // MEGA-side delay plus the time the line spent on the wire (10 bits/byte)
+    unsigned long wireMs = ((lineLength + 2) * 10000UL) / ESP_SERIAL_BAUD;
+    unsigned long detectDelay = (doc["age"] | 0UL) + wireMs;
+
+    // Before its first TIME: line the MEGA stamps its own uptime, which the
+    // ESP cannot re-stamp. Take the detection time from the ESP clock then.
+    unsigned long timestamp = doc["ts"] | 0UL;
+    if (timestamp < UNIX_TIME_MIN)
+    {
+        unsigned long now = currentTimestamp();
+        unsigned long delaySeconds = detectDelay / 1000;
+        timestamp = now > delaySeconds ? now - delaySeconds : 0;
+    }
+
+    AlarmEvent &event = pushAlarm(doc["alarm"] | "unknown", doc["val"] | 0.0, timestamp);
+    event.detectDelay = detectDelay;
+}
+
+// Heap alarms raised by the monitor go out on the same fast path
+void queueHeapAlarms(uint8_t raised)
+{
+    if (raised & HEAP_ALARM_LOW_FREE)
+        pushAlarm(ALARM_HEAP_FREE, heapMonitor.freeHeap(), currentTimestamp());
+    if (raised & HEAP_ALARM_LOW_BLOCK)
+        pushAlarm(ALARM_HEAP_BLOCK, heapMonitor.maxBlock(), currentTimestamp());
+    if (raised & HEAP_ALARM_FRAGMENTED)
+        pushAlarm(ALARM_HEAP_FRAG, heapMonitor.fragmentation(), currentTimestamp());
+    if (raised & HEAP_ALARM_LEAKING)
+        pushAlarm(ALARM_HEAP_LEAK, heapMonitor.freeTrend(), currentTimestamp());
+
+    heapMonitor.printReport(Serial);
+}
+
+// Upload one alarm to Firestore: alarms/{device}_{timestamp}_{code}, or
+// alarms/{device}_boot{epoch}_{uptime}_{code} while the time is not synced
+bool uploadAlarm(const AlarmEvent &event)
+{
+    char documentPath[128];
+    if (event.unsynced)
+        snprintf(documentPath, sizeof(documentPath), "alarms/%s_boot%u_%lu_%s", DEVICE_NAME,
+                 (unsigned)localStorage->getBootEpoch(), event.timestamp, event.code);
+    else
+        snprintf(documentPath, sizeof(documentPath), "alarms/%s_%lu_%s", DEVICE_NAME, event.timestamp, event.code);
+
+    // Latency up to the moment the request leaves the ESP
+    unsigned long queuedMs = event.detectDelay + (millis() - event.receivedAt);
+
+    FirestoreDocument document;
+    document.addString("code", event.code);
+    document.addDouble("value", event.value);
+    document.addInteger("timestamp", event.timestamp);
+    document.addInteger("queued_ms", queuedMs);
+    document.addString("device", DEVICE_NAME);
+    document.addBool("time_synced", !event.unsynced);
+
+    if (!patchDocument(documentPath, document, 1))
+    {
+        Serial.print("STATUS:Alarm upload error: ");
         Serial.println(fbdo.errorReason());
-        return 0;
+        return false;
+    }
+
+    unsigned long latency = event.detectDelay + (millis() - event.receivedAt);
+    telemetry.recordAlarmLatency(latency);
+
+    Serial.print(F("ALARM:Sent "));
+    Serial.print(event.code);
+    Serial.print(F(" latency="));
+    Serial.print(latency);
+    Serial.println(F("ms"));
+    return true;
+}
+
+// Alarm lane: drain every pending alarm before any sample traffic
+int uploadAlarms()
+{
+    int uploaded = 0;
+
+    while (alarmCount > 0)
+    {
+        bool sent = uploadAlarm(alarmQueue[alarmHead]);
+        if (!sent && !uploadRejected("alarm"))
+            break; // Retried after the backoff
+
+        alarmHead = (alarmHead + 1) % ALARM_QUEUE_SIZE;
+        alarmCount--;
+        uploaded += sent ? 1 : 0;
+        yield();
+    }
+
+    return uploaded;
+}
+
+// Check that the cloud side is usable before touching any upload lane
+bool uploadReady()
+{
+    return wifiConnected && firebaseReady && Firebase.ready();
+}
+
+// Firestore path of a raw record: sensor_data/{timestamp}. An uptime stamp
+// that was never re-stamped restarts every boot, so it carries the boot:
+// sensor_data/boot{epoch}_{uptime}. Later samples of a second add _{sequence}.
+void recordDocumentPath(const SensorData &data, char *path, size_t size)
+{
+    int length;
+    if (data.flags & DATA_FLAG_UNSYNCED_TIME)
+        length = snprintf(path, size, "sensor_data/boot%u_%lu", (unsigned)data.bootEpoch, data.timestamp);
+    else
+        length = snprintf(path, size, "sensor_data/%lu", data.timestamp);
+
+    if (data.sequence > 0 && length > 0 && (size_t)length < size)
+        snprintf(path + length, size - length, "_%u", (unsigned)data.sequence);
+}
+
+// Upload one raw record to Firestore (path from recordDocumentPath())
+bool uploadRecord(const SensorData &data)
+{
+    char documentPath[128];
+    recordDocumentPath(data, documentPath, sizeof(documentPath));
+
+    // Create the document with all fields (fixed buffer, no heap)
+    FirestoreDocument document;
+    document.addDouble("temp", data.getTemperature());
+    document.addDouble("weight", data.getWeight());
+    document.addDouble("ka", data.kadarAir);
+    document.addInteger("relay1", data.relay1);
+    document.addInteger("relay2", data.relay2);
+    document.addInteger("status", data.status);
+    document.addString("device", DEVICE_NAME);
+    document.addInteger("timestamp", data.timestamp);
+    document.addBool("time_synced", (data.flags & DATA_FLAG_UNSYNCED_TIME) == 0);
+    if (data.sequence > 0)
+        document.addInteger("seq", data.sequence);
+
+    // Upload to Firestore using patchDocument (creates or updates)
+    // This prevents "Document already exists" errors
+    if (patchDocument(documentPath, document, 1))
+    {
+        return true;
     }
 
+    Serial.print("STATUS:Upload error: ");
+    Serial.println(fbdo.errorReason());
+
+    // If error is "Not Found", try createDocument as fallback. The HTTP
+    // code says the same as errorReason() without copying it into a String.
+    if (lastUploadCode == 404 && document.c_str())
+    {
+        unsigned long start = millis();
+        bool created = Firebase.Firestore.createDocument(&fbdo, FIREBASE_PROJECT_ID, "", documentPath, document.c_str());
+        noteUploadResult(created, fbdo.httpCode());
+        if (created)
+        {
+            telemetry.recordSuccess(millis() - start, document.length(), 1);
+            Serial.println("STATUS:Created new document");
+            return true;
+        }
+        telemetry.recordFailure(fbdo.httpCode(), millis() - start);
+    }
+
+    return false;
+}
+
+// Unsynced samples of this boot wait for the time sync to re-stamp them
+bool awaitingRestamp(const SensorData &data)
+{
+    return (data.flags & DATA_FLAG_UNSYNCED_TIME) && !timeSync.isSynced() &&
+           data.bootEpoch == localStorage->getBootEpoch();
+}
+
+// Live lane: push the newest stored record right after it is ingested.
+// The record stays in storage flagged as uploaded; backfill drops it later.
+bool serviceLiveLane()
+{
+    livePending = false;
+
+    int newest = localStorage->getRecordCount() - 1;
+    if (newest < 0 || localStorage->isUploaded(newest))
+        return false;
+
+    SensorData data;
+    if (!localStorage->retrieveData(data, newest) || awaitingRestamp(data) || !uploadRecord(data))
+        return false; // Left for the backfill lane
+
+    localStorage->markUploaded(newest);
+#if ESP_SAMPLE_ECHO
+    Serial.print(F("LIVE:"));
+    Serial.println(data.timestamp);
+#endif
+    return true;
+}
+
+// Backfill lane: drain the backlog oldest-first while the link is otherwise
+// idle. Stops as soon as the MEGA sends data or a live record is waiting.
+int serviceBackfillLane()
+{
     int totalRecords = localStorage->getRecordCount();
+    int consumed = 0;
     int uploaded = 0;
-    const int BATCH_SIZE = 10; // Upload 10 at a time to prevent memory issues
 
-    for (int i = 0; i < totalRecords && i < BATCH_SIZE; i++)
+    while (consumed < totalRecords && uploaded < uploadBatchSize)
     {
+        if (alarmCount > 0 || livePending || Serial.available())
+            break;
+
+        // Already sent by the live lane: consume without re-uploading
+        if (localStorage->isUploaded(consumed))
+        {
+            consumed++;
+            continue;
+        }
+
         SensorData data;
-        if (!localStorage->retrieveData(data, i))
+        if (!localStorage->retrieveData(data, consumed))
+        {
+            consumed++; // Unreadable record, drop it rather than stall the lane
             continue;
+        }
+
+        // Everything after it is newer and unsynced too
+        if (awaitingRestamp(data))
+            break;
 
-        // Create Firestore document path: sensor_data/{timestamp}
-        char documentPath[128];
-        snprintf(documentPath, sizeof(documentPath), "sensor_data/%lu", data.timestamp);
-
-        // Create JSON document with all fields
-        FirebaseJson json;
-        json.set("fields/temp/doubleValue", data.temperature());
-        json.set("fields/weight/doubleValue", data.weight());
-        json.set("fields/ka/doubleValue", data.kadarAir);  // Added moisture content!
-        json.set("fields/relay1/integerValue", String(data.relay1));
-        json.set("fields/relay2/integerValue", String(data.relay2));
-        json.set("fields/status/integerValue", String(data.status));
-        json.set("fields/device/stringValue", DEVICE_NAME);
-        json.set("fields/timestamp/integerValue", String(data.timestamp));
-
-        // Upload to Firestore using patchDocument (creates or updates)
-        // This prevents "Document already exists" errors
-        if (Firebase.Firestore.patchDocument(&fbdo, FIREBASE_PROJECT_ID, "", documentPath, json.raw(), ""))
+        if (!uploadRecord(data))
         {
-            uploaded++;
-            Serial.print("STATUS:OK ");
-            Serial.print(uploaded);
-            Serial.print("/");
-            Serial.println(totalRecords);
+            if (!uploadRejected("record"))
+                break; // Retried after the backoff
+
+            consumed++;
+            continue;
+        }
+
+        consumed++;
+        uploaded++;
+        yield(); // Let ESP8266 handle WiFi
+    }
+
+    // One header write per pass for everything consumed
+    localStorage->removeOldest(consumed);
+
+    // Records the live lane already sent do not make a backlog
+    if (uploaded > 0 && localStorage->getRecordCount() == 0)
+    {
+        Serial.println("CLEAR"); // Backlog fully drained
+    }
+
+    return uploaded;
+}
+
+// Publish one coalesced status document with the current telemetry period
+bool publishStatus()
+{
+    char status[768];
+    int backlog = localStorage->getRecordCount() + summaryCount + alarmCount;
+
+    if (telemetry.toJSON(status, sizeof(status), backlog, WiFi.RSSI(),
+                         timeSync.isSynced() ? timeSync.getUnixTime() : 0) == 0)
+    {
+        Serial.println(F("STATUS:Status document too large"));
+        return false;
+    }
+
+    FirebaseJson json;
+    json.setJsonData(status);
+
+    if (!Firebase.RTDB.setJSON(&fbdo, FB_STATUS_PATH, &json))
+    {
+        Serial.print(F("STATUS:Status publish error: "));
+        Serial.println(fbdo.errorReason());
+        return false; // Keep accumulating into the same period
+    }
+
+    telemetry.resetPeriod();
+    return true;
+}
+
+// Apply the ESP-side part of the current settings
+void applyLocalSettings()
+{
+    const DeviceSettings &settings = remoteConfig.current();
+
+    uploadBatchSize = settings.uploadBatchSize;
+    aggregator.setWindowSeconds(settings.aggWindowSeconds);
+    rawUploadMode = settings.rawUploadMode;
+    rawDecimation = settings.rawDecimation;
+    rawDecimationCounter = 0;
+}
+
+// The MEGA reported the config version it runs (sample "cv" or CFGACK:)
+void noteMegaConfigVersion(unsigned long version)
+{
+    megaConfigVersion = version;
+    if (megaConfigVersion == remoteConfig.version())
+    {
+        megaSettings = remoteConfig.current();
+    }
+}
+
+// Forward MEGA-side settings that differ from what the MEGA runs
+void pushConfigToMega()
+{
+    lastConfigPush = millis();
+
+    // A MEGA at version 0 runs its boot defaults; an unknown version gets everything
+    DeviceSettings bootDefaults = DeviceSettings::defaults();
+    const DeviceSettings *from = NULL;
+    if (megaConfigVersion == 0)
+        from = &bootDefaults;
+    else if (megaConfigVersion == megaSettings.version)
+        from = &megaSettings;
+
+    int sent = remoteConfig.writeMegaDelta(from, Serial);
+
+    Serial.print(F("CONFIG:Pushed "));
+    Serial.print(sent);
+    Serial.print(F(" changed fields, version "));
+    Serial.println(remoteConfig.version());
+}
+
+// Cheap version probe first; the full document is only fetched on change
+bool pollRemoteConfig()
+{
+    if (!Firebase.RTDB.getInt(&fbdo, FB_CONFIG_PATH "/version"))
+        return false; // No config document (or no access)
+
+    unsigned long version = fbdo.intData();
+    if (version == 0 || version == remoteConfig.version())
+        return false;
+
+    if (!Firebase.RTDB.getJSON(&fbdo, FB_CONFIG_PATH))
+    {
+        Serial.print(F("CONFIG:Fetch error: "));
+        Serial.println(fbdo.errorReason());
+        return false;
+    }
+
+    StaticJsonDocument<384> doc;
+    if (deserializeJson(doc, fbdo.jsonString()))
+    {
+        Serial.println(F("CONFIG:Config document parse error"));
+        return false;
+    }
+
+    if (!remoteConfig.apply(doc))
+        return false;
+
+    if (!remoteConfig.save())
+        Serial.println(F("CONFIG:Could not persist config"));
+
+    applyLocalSettings();
+    pushConfigToMega();
+
+    Serial.print(F("CONFIG:Applied version "));
+    Serial.println(remoteConfig.version());
+    return true;
+}
+
+// Handle one line from the MEGA: alarm event or sensor sample.
+// The line is parsed in place; nothing on this path allocates.
+void handleMegaLine(char *line, size_t length)
+{
+    // Trim (CR from println, stray spaces)
+    while (length > 0 && isspace((unsigned char)line[length - 1]))
+    {
+        line[--length] = '\0';
+    }
+    while (length > 0 && isspace((unsigned char)*line))
+    {
+        line++;
+        length--;
+    }
+
+    // Bounds check to prevent memory overflow
+    if (length > ESP_LINE_MAX)
+    {
+        Serial.println(F("STATUS:JSON too large, discarding"));
+        return;
+    }
+
+    // "CFGACK:<version>": the MEGA adopted a config push, stop re-sending it
+    if (strncmp(line, "CFGACK:", 7) == 0)
+    {
+        noteMegaConfigVersion(strtoul(line + 7, NULL, 10));
+        Serial.print(F("CONFIG:MEGA runs version "));
+        Serial.println(megaConfigVersion);
+        return;
+    }
+
+    if (length > 0 && line[0] == '{')
+    {
+        // Parse JSON from MEGA
+        // Expected format: {"temp":25.5,"weight":100.2,"ka":15.3,"ts":12345}
+        // Room for the MEGA's memory fields next to the sample. Zero-copy:
+        // strings in doc point into line, which outlives doc.
+        StaticJsonDocument<384> doc;
+        DeserializationError error = deserializeJson(doc, line, length);
+
+        if (!error && doc.containsKey("alarm"))
+        {
+            // Alarm event: fast path, never stored as a sample
+            queueAlarm(doc, length);
+        }
+        else if (!error)
+        {
+            // Convert JSON to SensorData (stores temp, weight, ka, relay states)
+            SensorData data;
+            data.temperature() = doc["temp"] | 0.0;
+            data.weight() = doc["weight"] | 0.0;
+            data.kadarAir = doc["ka"] | 0.0;  // Now saving kadar air!
+            data.relay1 = doc["relay1"] | 0;
+            data.relay2 = doc["relay2"] | 0;
+
+            // Track which config version the MEGA runs
+            noteMegaConfigVersion(doc["cv"] | 0UL);
+
+            // MEGA SRAM headroom, for the status document
+            if (doc.containsKey("ram"))
+            {
+                telemetry.sampleMegaMemory(doc["ram"] | 0U, doc["ram_min"] | 0U,
+                                           doc["heap_blk"] | 0U, doc["stack"] | 0U);
+            }
+
+            // Use real Unix timestamp if time is synced, otherwise use millis
+            data.timestamp = currentTimestamp();
+#if ESP_SAMPLE_ECHO
+            if (timeSync.isSynced())
+            {
+                Serial.print("DATA:Using Unix time: ");
+                Serial.println(data.timestamp);
+            }
+            else
+            {
+                Serial.print("DATA:Using millis (time not synced): ");
+                Serial.println(data.timestamp);
+            }
+#endif
+
+            data.status = STATUS_OK;
+            data.flags = timeSync.isSynced() ? 0 : DATA_FLAG_UNSYNCED_TIME;
+            data.bootEpoch = localStorage->getBootEpoch();
+            data.sequence = sampleSequence(data.timestamp);
+
+            // Fold into the current summary window
+            WindowSummary closed;
+            if (aggregator.addSample(data, closed))
+            {
+                queueSummary(closed);
+            }
+
+            if (!shouldStoreRaw())
+            {
+#if ESP_SAMPLE_ECHO
+                Serial.println(F("DATA:Aggregated only (raw upload policy)"));
+#endif
+            }
+            else if (data.sequence > SENSOR_SEQUENCE_MAX)
+            {
+                // The record has one digit for it; later samples of this second are lost
+                Serial.println(F("STATUS:Sample dropped: too many in one second"));
+            }
+            // Save to EEPROM using LocalStorage
+            else if (localStorage->saveData(data))
+            {
+                livePending = true;
+
+#if ESP_SAMPLE_ECHO
+                // Saved successfully - echo back for confirmation
+                Serial.print(F("SAVED:"));
+                Serial.print(localStorage->getRecordCount());
+                Serial.print(F("/"));
+                Serial.println(MAX_RECORDS);
+#endif
+            }
+            else
+            {
+                // The ring overwrites, so it is never full: LocalStorage
+                // printed the reason as an [ERROR] line
+                Serial.println(F("STATUS:Sample dropped: not stored"));
+            }
         }
         else
         {
-            Serial.print("STATUS:Upload error: ");
-            Serial.println(fbdo.errorReason());
+            Serial.println("STATUS:JSON parse error");
+        }
+    }
+}
 
-            // If error is "Not Found", try createDocument as fallback
-            if (String(fbdo.errorReason()).indexOf("NOT_FOUND") >= 0)
+// Ingest task: drain every complete line the MEGA has sent. Runs first in
+// every pass and again after each network step, so a slow request never
+// leaves samples sitting in the UART buffer long enough to overflow it.
+// Bytes go into the fixed megaLine buffer: no String per line, and a line
+// still arriving is picked up next pass instead of being waited for.
+void ingestSerial()
+{
+    int lines = 0;
+    while (lines < INGEST_MAX_LINES && Serial.available())
+    {
+        char c = Serial.read();
+        if (c != '\n')
+        {
+            if (megaLineLength < sizeof(megaLine) - 1)
             {
-                if (Firebase.Firestore.createDocument(&fbdo, FIREBASE_PROJECT_ID, "", documentPath, json.raw()))
-                {
-                    uploaded++;
-                    Serial.println("STATUS:Created new document");
-                }
+                megaLine[megaLineLength++] = c;
             }
             else
             {
-                break; // Stop on other errors
+                megaLineOverflow = true;
             }
+            continue;
         }
 
-        if (!wifiConnected)
-            break;
+        megaLine[megaLineLength] = '\0';
+        if (megaLineOverflow)
+        {
+            Serial.println(F("STATUS:JSON too large, discarding"));
+        }
+        else
+        {
+            handleMegaLine(megaLine, megaLineLength);
+        }
+        megaLineLength = 0;
+        megaLineOverflow = false;
+        lines++;
+    }
+}
 
-        delay(200); // Delay between Firestore writes (slower than RTDB)
-        yield(); // Let ESP8266 handle WiFi
+// "TIME:<unix>.<ms>" - older MEGA builds read the integer part only
+void sendTimeToMega()
+{
+    uint64_t nowMs = timeSync.getUnixTimeMs();
+    char line[32];  // Room for a 64-bit unsigned long on the host build
+    snprintf(line, sizeof(line), "TIME:%lu.%03u", (unsigned long)(nowMs / 1000), (unsigned)(nowMs % 1000));
+    Serial.println(line);
+    lastTimeBroadcast = millis();
+}
+
+// First sync of this boot: move everything stamped with uptime onto Unix
+// time before any of it is uploaded
+void restampBootEpoch()
+{
+    unsigned long offset = timeSync.getUnixTime() - (unsigned long)(MonotonicClock::millis64() / 1000);
+
+    // Close the uptime-aligned window and shift every queued summary
+    WindowSummary closed;
+    if (aggregator.flush(0xFFFFFFFFUL, closed))
+    {
+        queueSummary(closed);
+    }
+    for (int i = 0; i < summaryCount; i++)
+    {
+        summaryQueue[(summaryHead + i) % AGG_QUEUE_SIZE].windowStart += offset;
     }
 
-    // Clear storage after successful batch upload
-    if (uploaded == BATCH_SIZE || uploaded == totalRecords)
+    // Queued alarms carry this boot's uptime too
+    for (int i = 0; i < alarmCount; i++)
     {
-        localStorage->clearStorage();
-        Serial.println("CLEAR"); // Tell MEGA to clear its EEPROM too
-        Serial.print("STATUS:Cleared ");
-        Serial.print(uploaded);
-        Serial.println(" records from storage");
+        AlarmEvent &event = alarmQueue[(alarmHead + i) % ALARM_QUEUE_SIZE];
+        if (event.unsynced)
+        {
+            event.timestamp += offset;
+            event.unsynced = false;
+        }
     }
 
-    return uploaded;
+    int corrected = localStorage->restampUnsynced(localStorage->getBootEpoch(), offset);
+
+    Serial.print(F("TIME:Re-stamped "));
+    Serial.print(corrected);
+    Serial.print(F(" records of boot epoch "));
+    Serial.println(localStorage->getBootEpoch());
+}
+
+// First sync of this boot: give a token issued before it its expiry, so
+// the next boot reuses it instead of refreshing
+void settleTokenExpiry()
+{
+    if (!tokenExpiryPending)
+        return;
+    tokenExpiryPending = false;
+
+    if (authCache.isValid() && !authCache.expiryKnown())
+    {
+        unsigned long age = (unsigned long)(MonotonicClock::millis64() / 1000) - tokenIssuedUptime;
+        authCache.saveExpiry(timeSync.getUnixTime() - age + AUTH_TOKEN_LIFETIME);
+    }
+}
+
+// Time sync attempt; the MEGA gets the new time straight away
+void syncTime()
+{
+    bool wasSynced = timeSync.isSynced();
+
+    if (timeSync.syncTimeFromNTP())
+    {
+        if (!wasSynced)
+        {
+            restampBootEpoch();
+            settleTokenExpiry();
+        }
+
+        sendTimeToMega();
+    }
+    else
+    {
+        Serial.println("TIME:Failed to sync, will retry...");
+    }
+}
+
+// Network task: WiFi, then time, then auth, each in the background. At
+// most one blocking step runs per pass so ingest is serviced in between.
+// Time goes first: a cached session's expiry is Unix time, unknown before.
+void serviceNetwork(unsigned long now)
+{
+    wifi.update();
+    if (wifi.isConnected() != wifiConnected)
+    {
+        wifiConnected = wifi.isConnected();
+        if (wifiConnected)
+        {
+            Serial.println("STATUS:WiFi connected!");
+            telemetry.recordWiFiConnect(wifi.getLastConnectTime(), wifi.wasFastConnect());
+
+            lastNetworkRetry = now;
+            authPending = !firebaseReady;
+            timePending = !timeSync.isSynced();
+        }
+    }
+
+    if (!wifiConnected)
+        return;
+
+    if (timePending)
+    {
+        timePending = false;
+        syncTime();
+        return;
+    }
+
+    if (authPending)
+    {
+        authPending = false;
+        setupFirebase();
+        return;
+    }
+
+    // Retry whatever is still missing every 30 seconds while connected
+    if (now - lastNetworkRetry >= ESP_WIFI_CHECK_INTERVAL)
+    {
+        lastNetworkRetry = now;
+        authPending = !firebaseReady;
+        timePending = !timeSync.isSynced();
+    }
 }
 
 void setup()
 {
+    // Room for several MEGA lines while a network request blocks loop()
+    Serial.setRxBufferSize(ESP_SERIAL_RX_BUFFER);
     Serial.begin(115200);
-    delay(1000);
 
     // Send boot message
     Serial.println("STATUS:ESP8266 booting...");
@@ -194,183 +1084,145 @@ void setup()
         }
     }
 
-    Serial.println("STATUS:Storage initialized");
-
-    connectWiFi();
+    Serial.print(F("STATUS:Storage initialized, boot epoch "));
+    Serial.println(localStorage->getBootEpoch());
 
-    if (wifiConnected)
+    // Last accepted remote config survives reboots
+    if (LittleFS.begin() && remoteConfig.load())
     {
-        Serial.println("STATUS:WiFi connected!");
+        applyLocalSettings();
+        Serial.print(F("CONFIG:Loaded version "));
+        Serial.println(remoteConfig.version());
+    }
 
-        // Initialize time sync
-        Serial.println("TIME:Initializing time sync...");
-        if (timeSync.begin())
-        {
-            Serial.print("TIME:Synced! Unix time: ");
-            Serial.println(timeSync.getUnixTime());
+    // Samples are flagged until the network provides the time
+    timeSync.begin();
 
-            // Send time to Mega immediately
-            Serial.print("TIME:");
-            Serial.println(timeSync.getUnixTime());
-        }
-        else
-        {
-            Serial.println("TIME:Failed to sync, will retry...");
-        }
-    }
-    else
-    {
-        Serial.println("STATUS:WiFi connection failed");
-    }
+    // Storage and ingest are live from here on; WiFi, auth and time sync
+    // progress in the background (see serviceNetwork())
+    wifi.begin(WIFI_SSID, WIFI_PASSWORD);
 
     Serial.println("STATUS:ESP8266 ready");
 }
 
 void loop()
 {
+    MonotonicClock::update();
     unsigned long currentTime = millis();
 
+    // Ingest first: the MEGA never waits on the network
+    ingestSerial();
+
+    serviceNetwork(currentTime);
+    ingestSerial();
+
     // Update time sync (auto re-sync every 24h)
     timeSync.update();
 
     // Broadcast time to Mega every 60 seconds
     if (timeSync.isSynced() && (currentTime - lastTimeBroadcast >= 60000))
     {
-        lastTimeBroadcast = currentTime;
-        Serial.print("TIME:");
-        Serial.println(timeSync.getUnixTime());
+        sendTimeToMega();
     }
 
-    // Check WiFi every 30 seconds
-    if (currentTime - lastWiFiCheck >= 30000)
+    // Close the summary window on time even if samples stop arriving
+    WindowSummary closed;
+    if (aggregator.flush(currentTimestamp(), closed))
     {
-        lastWiFiCheck = currentTime;
-        if (WiFi.status() != WL_CONNECTED)
+        queueSummary(closed);
+    }
+
+    // A lane whose request fails starts the backoff; the lanes after it wait too
+    if (uploadReady() && !uploadBackingOff(currentTime))
+    {
+        // Alarms go out ahead of any queued data
+        if (alarmCount > 0)
         {
-            wifiConnected = false;
-            firebaseReady = false;
-            connectWiFi();
+            uploadAlarms();
         }
-        else
-        {
-            connectWiFi();
-            wifiConnected = true;
 
-            // Try to sync time if not synced yet
-            if (!timeSync.isSynced())
-            {
-                timeSync.syncTimeFromAPI();
-            }
+        // Live lane next: the dashboard always sees the newest sample
+        if (livePending && !uploadBackingOff(millis()))
+        {
+            serviceLiveLane();
         }
-    }
-
-    // Receive JSON from MEGA
-    if (Serial.available())
-    {
-        String json = Serial.readStringUntil('\n');
-        json.trim();
 
-        // Bounds check to prevent memory overflow
-        if (json.length() > 300)
+        // Summary lane: upload closed windows as soon as they are available
+        // (pre-sync windows are shifted to Unix time at the first sync)
+        if (summaryCount > 0 && timeSync.isSynced() && !uploadBackingOff(millis()))
         {
-            Serial.println(F("STATUS:JSON too large, discarding"));
-            Serial.flush();
-            return;
+            uploadSummaries();
         }
 
-        if (json.length() > 0 && json.startsWith("{"))
+        // Backfill lane: historical backlog with whatever time is left
+        if (localStorage->getRecordCount() > 0 && !livePending && !Serial.available() &&
+            !uploadBackingOff(millis()))
         {
-            // Parse JSON from MEGA
-            // Expected format: {"temp":25.5,"weight":100.2,"ka":15.3,"ts":12345}
-            StaticJsonDocument<250> doc;
-            DeserializationError error = deserializeJson(doc, json);
+            int uploaded = serviceBackfillLane();
 
-            if (!error)
-            {
-                // Convert JSON to SensorData (stores temp, weight, ka, relay states)
-                SensorData data;
-                data.temperature() = doc["temp"] | 0.0;
-                data.weight() = doc["weight"] | 0.0;
-                data.kadarAir = doc["ka"] | 0.0;  // Now saving kadar air!
-                data.relay1 = doc["relay1"] | 0;
-                data.relay2 = doc["relay2"] | 0;
-
-                // Use real Unix timestamp if time is synced, otherwise use millis
-                if (timeSync.isSynced())
-                {
-                    data.timestamp = timeSync.getUnixTime();
-                    Serial.print("DATA:Using Unix time: ");
-                    Serial.println(data.timestamp);
-                }
-                else
-                {
-                    data.timestamp = millis() / 1000; // Fallback to millis
-                    Serial.print("DATA:Using millis (time not synced): ");
-                    Serial.println(data.timestamp);
-                }
-
-                data.status = STATUS_OK;
-
-                // Save to EEPROM using LocalStorage
-                if (localStorage->saveData(data))
-                {
-                    // Saved successfully - echo back for confirmation
-                    Serial.print(F("SAVED:"));
-                    Serial.print(localStorage->getRecordCount());
-                    Serial.print(F("/"));
-                    Serial.println(MAX_RECORDS);
-                }
-                else
-                {
-                    Serial.println("STATUS:Storage full!");
-                }
-            }
-            else
+            if (uploaded > 0)
             {
-                Serial.println("STATUS:JSON parse error");
+                Serial.print(F("UPLOADED:"));
+                Serial.print(uploaded);
+                Serial.print(F(" records, "));
+                Serial.print(localStorage->getRecordCount());
+                Serial.println(F(" remaining"));
             }
         }
     }
-    if (!wifiConnected || !firebaseReady || !Firebase.ready())
+
+    // Remote config: poll for a new version, re-push until the MEGA adopts it
+    if (currentTime - lastConfigPoll >= CONFIG_POLL_INTERVAL && uploadReady())
     {
-        // Serial.println("STATUS:ERROR - Firebase error");
+        lastConfigPoll = currentTime;
+        pollRemoteConfig();
     }
 
-    // Upload when ≥ 10 records (lower threshold to prevent memory issues)
-    int currentCount = localStorage->getRecordCount();
-
-    if (currentCount >= 10 && wifiConnected && firebaseReady && Firebase.ready())
+    // millis(), not currentTime: pollRemoteConfig() may have just pushed
+    if (remoteConfig.version() != 0 && megaConfigVersion != remoteConfig.version() &&
+        millis() - lastConfigPush >= CONFIG_PUSH_RETRY)
     {
-        Serial.print(F("STATUS:Uploading batch from "));
-        Serial.print(currentCount);
-        Serial.println(F(" records..."));
+        pushConfigToMega();
+    }
 
-        int uploaded = uploadAllData();
+    // Heap: sample, trend and alarms
+    if (heapMonitor.update())
+    {
+        telemetry.sampleHeap(heapMonitor.freeHeap(), heapMonitor.maxBlock(), heapMonitor.fragmentation());
+        telemetry.setHeapTrend(heapMonitor.freeTrend(), heapMonitor.fragTrend(), heapMonitor.alarms());
 
-        if (uploaded > 0)
-        {
-            Serial.print(F("UPLOADED:"));
-            Serial.print(uploaded);
-            Serial.print(F(" records, "));
-            Serial.print(localStorage->getRecordCount());
-            Serial.println(F(" remaining"));
-        }
-        else
+        uint8_t raised = heapMonitor.takeRaised();
+        if (raised)
         {
-            Serial.println(F("STATUS:Upload failed"));
+            queueHeapAlarms(raised);
         }
     }
 
+    if (currentTime - lastHeapReport >= HEAP_REPORT_INTERVAL)
+    {
+        lastHeapReport = currentTime;
+        heapMonitor.printReport(Serial);
+    }
+
+    // Coalesced status document at a low fixed rate
+    if (currentTime - lastStatusPublish >= STATUS_PUBLISH_INTERVAL && uploadReady())
+    {
+        lastStatusPublish = currentTime;
+        publishStatus();
+    }
+
     // Status every 15 seconds
     if (currentTime - lastStatusTime >= 15000)
     {
         lastStatusTime = currentTime;
 
         Serial.print(F("STATUS:"));
-        Serial.print(wifiConnected ? F("WiFi OK, ") : F("WiFi FAIL, "));
+        Serial.print(F("WiFi "));
+        Serial.print(wifi.getStateName());
+        Serial.print(F(", "));
         Serial.print(F("Firebase "));
         Serial.print(Firebase.ready() ? F("READY, ") : F("NOT READY, "));
-        Serial.print(currentCount);
+        Serial.print(localStorage->getRecordCount());
         Serial.print(F("/"));
         Serial.print(MAX_RECORDS);
         Serial.println(F(" records"));
@@ -16,6 +16,13 @@
 #include "HX711.h"
 #include "DWIN.h"
 #include "TimeSync.h"
+#include "MonotonicClock.h"
+#include "MemoryMonitor.h"
+
+#if ESP_AT_FIREBASE
+    #include "LocalStorage.h"
+    #include "FirebaseStorage.h"
+#endif
 
 // ========================================
 // BOARD-SPECIFIC CONFIGURATION
@@ -57,7 +64,12 @@
     // For hardware SPI: Adafruit_MAX31865 thermo = Adafruit_MAX31865(10);
 
     // ESP Communication via Serial3
-    #define ESP_AVAILABLE true
+    #if ESP_AT_FIREBASE
+        // ESP-AT firmware: FirebaseStorage owns Serial3, no JSON link
+        #define ESP_AVAILABLE false
+    #else
+        #define ESP_AVAILABLE true
+    #endif
 
 #endif
 
@@ -81,6 +93,7 @@
 // Timing
 unsigned long lastSampleTime = 0;
 unsigned long lastDisplayTime = 0;
+unsigned long lastMemoryReport = 0;
 unsigned long checkup = 0;
 int statusSSR = 0;
 
@@ -91,7 +104,13 @@ HX711 scale;
 float calibration_factor = 208;
 float M0 = 100.0;    // Initial tobacco mass (kg)
 float w0 = 0.75;     // Initial moisture content (75%)
-float batas_ka = 15.0;
+float batas_ka = MOISTURE_TARGET;
+
+// Runtime settings (pushed by the ESP from FB_CONFIG_PATH)
+unsigned long sampleInterval = SAMPLE_INTERVAL;
+float tempHigh = TEMP_SSR_OFF;
+float tempLow = TEMP_SSR_ON;
+unsigned long configVersion = 0;
 
 // Sensor Readings
 float Temp = 0.0;
@@ -104,6 +123,48 @@ bool powerSwitchState = false;
 // TimeSync instance
 TimeSync timeSync;
 
+// ESP line being received (processESPMessages)
+#if ESP_AVAILABLE
+char espLine[MEGA_LINE_MAX + 1];
+uint16_t espLineLength = 0;
+bool espLineOverflow = false;
+#endif
+
+#if ESP_AT_FIREBASE
+// Direct upload over ESP-AT; EEPROM holds what the RAM ring cannot
+LocalStorage localStorage;
+FirebaseStorage cloud(FIREBASE_HOST, FIREBASE_AUTH, DEVICE_NAME, &localStorage);
+#endif
+
+// Alarm state (edge-triggered, re-armed with ALARM_HYSTERESIS)
+bool tempAlarmActive = false;
+bool kaAlarmActive = false;
+uint8_t lastRtdFault = 0;
+
+// ========================================
+// ALARM EVENTS
+// ========================================
+
+// Send an alarm to the ESP immediately, bypassing the sample cadence
+void sendAlarm(const char *code, float value, unsigned long detectedAt)
+{
+    StaticJsonDocument<96> doc;
+    doc["alarm"] = code;
+    doc["val"] = value;
+    doc["ts"] = timeSync.getUnixTime();
+    doc["age"] = millis() - detectedAt; // Detection -> transmit delay (ms)
+
+    #if ESP_AVAILABLE
+    serializeJson(doc, ESP_SERIAL);
+    ESP_SERIAL.println();
+    #endif
+
+    Serial.print(F("ALARM: "));
+    Serial.print(code);
+    Serial.print(F(" = "));
+    Serial.println(value, 2);
+}
+
 // ========================================
 // SENSOR FUNCTIONS
 // ========================================
@@ -128,6 +189,17 @@ void loadCell()
         Serial.print(KA, 2);
         Serial.print(F("% | Relay2: "));
 
+        // Moisture target alarm
+        if (KA <= batas_ka && !kaAlarmActive)
+        {
+            kaAlarmActive = true;
+            sendAlarm(ALARM_KA_TARGET, KA, millis());
+        }
+        else if (KA > batas_ka + ALARM_HYSTERESIS)
+        {
+            kaAlarmActive = false;
+        }
+
         // Moisture control
         if (KA <= batas_ka)
         {
@@ -177,6 +249,7 @@ float rtdSensor()
 
     // Check fault
     uint8_t fault = thermo.readFault();
+    unsigned long faultDetectedAt = millis();
     if (fault)
     {
         Serial.print(F(" Fault 0x"));
@@ -194,15 +267,33 @@ float rtdSensor()
         if (fault & MAX31865_FAULT_OVUV)
             Serial.println(F("  Under/Over voltage"));
         thermo.clearFault();
+
+        // New or changed fault code raises an alarm
+        if (fault != lastRtdFault)
+        {
+            sendAlarm(ALARM_RTD_FAULT, fault, faultDetectedAt);
+        }
+    }
+    lastRtdFault = fault;
+
+    // Over-temperature alarm
+    if (suhu_reg >= tempHigh && !tempAlarmActive)
+    {
+        tempAlarmActive = true;
+        sendAlarm(ALARM_TEMP_HIGH, suhu_reg, millis());
+    }
+    else if (suhu_reg < tempHigh - ALARM_HYSTERESIS)
+    {
+        tempAlarmActive = false;
     }
 
     // Temperature control
-    if (suhu_reg >= 70)
+    if (suhu_reg >= tempHigh)
     {
         digitalWrite(RELAY_PIN1, LOW);
         statusSSR = 0;
     }
-    if (suhu_reg <= 40)
+    if (suhu_reg <= tempLow)
     {
         digitalWrite(RELAY_PIN1, HIGH);
         statusSSR = 1;
@@ -221,6 +312,16 @@ String readSensors()
     doc["ka"] = KadarAir;
     doc["relay1"] = statusSSR;
     doc["relay2"] = digitalRead(RELAY_PIN2);
+    doc["cv"] = configVersion; // Lets the ESP see which config we run
+
+    // SRAM headroom for the ESP's status document
+    if (MemoryMonitor::supported())
+    {
+        doc["ram"] = MemoryMonitor::freeNow();
+        doc["ram_min"] = MemoryMonitor::unusedSinceBoot();
+        doc["heap_blk"] = MemoryMonitor::largestFreeBlock();
+        doc["stack"] = MemoryMonitor::stackPeak();
+    }
 
     // Use real Unix timestamp if available, otherwise use millis
     if (timeSync.isSynced())
@@ -229,7 +330,7 @@ String readSensors()
     }
     else
     {
-        doc["ts"] = millis() / 1000; // Fallback to millis in seconds
+        doc["ts"] = (unsigned long)(MonotonicClock::millis64() / 1000); // Fallback to uptime in seconds
     }
 
     String json;
@@ -237,6 +338,33 @@ String readSensors()
     return json;
 }
 
+#if ESP_AT_FIREBASE
+// Current readings as a SensorData record for FirebaseStorage
+SensorData currentSample()
+{
+    SensorData data = SensorData();
+    data.setTemperature(Temp);
+    data.setWeight(Weight);
+    data.setKadarAir(KadarAir);
+    data.status = STATUS_OK;
+    data.relay1 = statusSSR;
+    data.relay2 = digitalRead(RELAY_PIN2);
+
+    if (timeSync.isSynced())
+    {
+        data.timestamp = timeSync.getUnixTime();
+    }
+    else
+    {
+        data.timestamp = (unsigned long)(MonotonicClock::millis64() / 1000);
+        data.flags = DATA_FLAG_UNSYNCED_TIME;
+        data.bootEpoch = localStorage.getBootEpoch();
+    }
+
+    return data;
+}
+#endif
+
 // ========================================
 // HMI FUNCTIONS
 // ========================================
@@ -278,41 +406,145 @@ void updateHmiDisplay()
 // ESP COMMUNICATION
 // ========================================
 
-void processESPMessages()
+// A whole-number value (no sign, nothing after the digits)
+static bool parseConfigUnsigned(const char *text, unsigned long &value)
 {
-    #if ESP_AVAILABLE
-    while (ESP_SERIAL.available())
+    char *end;
+    if (*text < '0' || *text > '9')
+        return false;
+    value = strtoul(text, &end, 10);
+    return *end == '\0';
+}
+
+// A finite decimal value (no "nan"/"inf", nothing after the number)
+static bool parseConfigFloat(const char *text, float &value)
+{
+    char *end;
+    double number = strtod(text, &end);
+    if (end == text || *end != '\0' || !isfinite(number) || fabs(number) > 1e6)
+        return false;
+    value = number;
+    return true;
+}
+
+// Apply one "CFG:key=value" line from the ESP (keys match RemoteConfig).
+// A value that does not parse leaves the setting alone.
+void applyConfigLine(char *line)
+{
+    char *eq = strchr(line, '=');
+    if (eq == NULL)
+        return;
+
+    *eq = '\0';
+    const char *key = line + 4;
+    const char *value = eq + 1;
+    unsigned long number;
+    float decimal;
+
+    if (strcmp(key, "sample_ms") == 0 && parseConfigUnsigned(value, number))
+    {
+        if (number >= DATA_SAMPLE_INTERVAL_MIN)
+            sampleInterval = number;
+    }
+    else if (strcmp(key, "batas_ka") == 0 && parseConfigFloat(value, decimal))
+        batas_ka = decimal;
+    else if (strcmp(key, "temp_high") == 0 && parseConfigFloat(value, decimal))
+        tempHigh = decimal;
+    else if (strcmp(key, "temp_low") == 0 && parseConfigFloat(value, decimal))
+        tempLow = decimal;
+    else if (strcmp(key, "version") == 0 && parseConfigUnsigned(value, number))
     {
-        String msg = ESP_SERIAL.readStringUntil('\n');
-        msg.trim();
+        configVersion = number;
+
+        // Acknowledge at once: samples report it too, but only every sample_ms
+        #if ESP_AVAILABLE
+        ESP_SERIAL.print(F("CFGACK:"));
+        ESP_SERIAL.println(configVersion);
+        #endif
+    }
+    else
+        return;
+
+    Serial.print(F("[ESP] Config "));
+    Serial.print(key);
+    Serial.print(F(" = "));
+    Serial.println(value);
+}
 
-        if (msg.length() > 256)
+// One complete line from the ESP (NUL-terminated, trimmed in place)
+void handleESPLine(char *msg, size_t length)
+{
+    while (length > 0 && isspace((unsigned char)msg[length - 1]))
+    {
+        msg[--length] = '\0';
+    }
+    while (length > 0 && isspace((unsigned char)*msg))
+    {
+        msg++;
+        length--;
+    }
+    if (length == 0)
+        return;
+
+    // Check if it's a TIME sync message ("TIME:<unix>" or "TIME:<unix>.<ms>")
+    if (strncmp(msg, "TIME:", 5) == 0)
+    {
+        unsigned long unixTime;
+        uint16_t millisPart;
+        // Sanity check: after 2021-01-01 and before 2100-01-01
+        if (TimeSync::parseTimeMessage(msg, unixTime, millisPart) &&
+            unixTime > 1609459200UL && unixTime < 4102444800UL)
         {
-            ESP_SERIAL.flush();
-            Serial.println(F("[ESP] Message too large, discarded"));
-            continue;
+            timeSync.setUnixTime(unixTime, millisPart);
+            Serial.print(F("[ESP] Time synced: "));
+            Serial.println(unixTime);
         }
+    }
+    else if (strncmp(msg, "CFG:", 4) == 0)
+    {
+        applyConfigLine(msg);
+    }
+    else
+    {
+        // Show everything else ESP sends
+        Serial.print(F("[ESP] "));
+        Serial.println(msg);
+    }
+}
 
-        if (msg.length() > 0)
+// Drain what the ESP has sent without waiting: bytes collect in espLine
+// and a line still arriving is finished on a later pass, so loop() never
+// sits in a Stream timeout. Lines over MEGA_LINE_MAX are discarded.
+void processESPMessages()
+{
+    #if ESP_AVAILABLE
+    while (ESP_SERIAL.available())
+    {
+        char c = ESP_SERIAL.read();
+        if (c != '\n')
         {
-            // Check if it's a TIME sync message
-            if (msg.startsWith("TIME:"))
+            if (espLineLength < MEGA_LINE_MAX)
             {
-                // Extract Unix timestamp
-                unsigned long unixTime = msg.substring(5).toInt();
-                if (unixTime > 1609459200) // Sanity check: after 2021-01-01
-                {
-                    timeSync.setUnixTime(unixTime);
-                    Serial.print(F("[ESP] Time synced: "));
-                    Serial.println(unixTime);
-                }
+                espLine[espLineLength++] = c;
             }
             else
             {
-                // Show everything else ESP sends
-                Serial.println("[ESP] " + msg);
+                espLineOverflow = true;
             }
+            continue;
         }
+
+        espLine[espLineLength] = '\0';
+        if (espLineOverflow)
+        {
+            Serial.println(F("[ESP] Message too large, discarded"));
+        }
+        else
+        {
+            handleESPLine(espLine, espLineLength);
+        }
+        espLineLength = 0;
+        espLineOverflow = false;
     }
     #endif
 }
@@ -334,6 +566,8 @@ void setup()
     Serial.println(F("Job: Read sensors -> Send JSON"));
     #if ESP_AVAILABLE
     Serial.println(F("ESP handles storage & upload"));
+    #elif ESP_AT_FIREBASE
+    Serial.println(F("Uploading via ESP-AT (FirebaseStorage)"));
     #else
     Serial.println(F("ESP disabled (Uno testing mode)"));
     #endif
@@ -427,6 +661,11 @@ void setup()
     Serial.println(F("ESP8266 ready"));
     #endif
 
+    #if ESP_AT_FIREBASE
+    localStorage.initialize();
+    cloud.initialize();
+    #endif
+
     // Initialize RTD sensor
     thermo.begin(MAX31865_3WIRE);
     Serial.println(F("MAX31865 RTD sensor initialized"));
@@ -440,24 +679,37 @@ void setup()
 
 void loop()
 {
+    MonotonicClock::update();
     unsigned long currentTime = millis();
 
-    // Read sensors every SAMPLE_INTERVAL
-    if (currentTime - lastSampleTime >= SAMPLE_INTERVAL)
+    // Read sensors every sampleInterval
+    if (currentTime - lastSampleTime >= sampleInterval)
     {
         lastSampleTime = currentTime;
 
         // Read sensors
+        MemoryMonitor::beginTask(MEM_TASK_RTD);
         Temp = rtdSensor();
+        MemoryMonitor::endTask(MEM_TASK_RTD);
+
+        MemoryMonitor::beginTask(MEM_TASK_CELL);
         loadCell();
+        MemoryMonitor::endTask(MEM_TASK_CELL);
 
         // Create JSON
-        String json = readSensors();
-
-        // Send to ESP
-        #if ESP_AVAILABLE
-        ESP_SERIAL.println(json);
-        #endif
+        MemoryMonitor::scan();
+        MemoryMonitor::beginTask(MEM_TASK_JSON);
+        {
+            String json = readSensors();
+
+            // Send to ESP
+            #if ESP_AVAILABLE
+            ESP_SERIAL.println(json);
+            #elif ESP_AT_FIREBASE
+            cloud.saveData(currentSample());
+            #endif
+        }
+        MemoryMonitor::endTask(MEM_TASK_JSON);
 
         // Summary
         Serial.print(F("━━━ SUMMARY ━━━ Temp: "));
@@ -477,16 +729,31 @@ void loop()
     if (currentTime - lastDisplayTime >= 500)
     {
         lastDisplayTime = currentTime;
+        MemoryMonitor::beginTask(MEM_TASK_HMI);
         updateHmiDisplay();
+        MemoryMonitor::endTask(MEM_TASK_HMI);
     }
 
     // Process HMI input
+    MemoryMonitor::beginTask(MEM_TASK_LISTEN);
     hmi.listen();
+    MemoryMonitor::endTask(MEM_TASK_LISTEN);
 
     // Process ESP messages
+    MemoryMonitor::beginTask(MEM_TASK_ESP);
     #if ESP_AVAILABLE
     processESPMessages();
+    #elif ESP_AT_FIREBASE
+    cloud.update();
     #endif
+    MemoryMonitor::endTask(MEM_TASK_ESP);
+
+    // SRAM headroom on the console
+    if (currentTime - lastMemoryReport >= MEMORY_REPORT_INTERVAL)
+    {
+        lastMemoryReport = currentTime;
+        MemoryMonitor::printReport(Serial);
+    }
 
     delay(10);
 }
@@ -34,6 +34,7 @@ SensorData generateSimulatedData()
     // data.weight = simulatedWeight;
     data.timestamp = millis();
     data.status = 1; // 1 = OK, 0 = Error
+    data.flags = 0;
 
     return data;
 }
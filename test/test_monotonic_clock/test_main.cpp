@@ -0,0 +1,158 @@
+/**
+ * @file test_main.cpp
+ * @brief MonotonicClock across millis()/micros() wraps (host, virtual time)
+ *
+ * The sim/arduino core serves millis()/micros() from SimClock, so the
+ * clock can be put just below a wrap and jumped over whole periods in no
+ * time. Every check compares what millis64()/micros64() advanced by with
+ * what virtual time advanced by between the same two calls.
+ *
+ * The tests share one clock that only moves forward, so they run in order.
+ *
+ *   pio test -e native_test
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "MonotonicClock.h"
+
+static const uint64_t MICROS_PERIOD_US = 1ULL << 32;            // micros() wraps (71.6 min)
+static const uint64_t MILLIS_PERIOD_US = (1ULL << 32) * 1000ULL; // millis() wraps (49.7 days)
+static const uint64_t MINUTE_US = 60ULL * 1000000ULL;
+static const uint64_t HOUR_US = 60ULL * MINUTE_US;
+
+struct Reading
+{
+    uint64_t ms;        // millis64()
+    uint64_t virtualMs; // Virtual time that call saw
+    uint64_t us;        // micros64()
+    uint64_t virtualUs;
+};
+
+static Reading readClocks()
+{
+    Reading reading;
+    reading.ms = MonotonicClock::millis64();
+    reading.virtualMs = SimClock::nowMicros() / 1000;
+    reading.us = MonotonicClock::micros64();
+    reading.virtualUs = SimClock::nowMicros();
+    return reading;
+}
+
+// Move virtual time to an absolute point without calling either clock
+static void jumpTo(uint64_t us)
+{
+    SimClock::advance(us - SimClock::nowMicros());
+}
+
+static void checkMillis(const Reading &from, const Reading &to)
+{
+    TEST_ASSERT_TRUE(to.ms > from.ms);
+    TEST_ASSERT_EQUAL_UINT64(to.virtualMs - from.virtualMs, to.ms - from.ms);
+}
+
+static void checkMicros(const Reading &from, const Reading &to)
+{
+    TEST_ASSERT_TRUE(to.us > from.us);
+    TEST_ASSERT_EQUAL_UINT64(to.virtualUs - from.virtualUs, to.us - from.us);
+}
+
+// Read both clocks after every step; each must follow virtual time exactly
+static void stepAndCheck(uint64_t stepUs, int steps)
+{
+    Reading last = readClocks();
+
+    for (int i = 0; i < steps; i++)
+    {
+        SimClock::advance(stepUs);
+        Reading now = readClocks();
+        checkMillis(last, now);
+        checkMicros(last, now);
+        last = now;
+    }
+}
+
+void setUp()
+{
+    // Every millis()/micros() call costs 1 us, so gaps are exact
+    SimClock::setPollStep(1, 1);
+}
+
+void tearDown()
+{
+}
+
+void test_micros_across_wraps()
+{
+    jumpTo(MICROS_PERIOD_US - 3000);
+    Reading start = readClocks();
+    TEST_ASSERT_EQUAL_UINT64(start.virtualUs, start.us);
+
+    stepAndCheck(1000, 10);          // Over the first wrap in 1 ms steps
+    stepAndCheck(10 * MINUTE_US, 30); // Four more wraps
+
+    Reading end = readClocks();
+    TEST_ASSERT_EQUAL_UINT64(end.virtualUs, end.us);
+    TEST_ASSERT_TRUE(end.us > 5 * MICROS_PERIOD_US);
+}
+
+void test_millis_across_wraps()
+{
+    // Far below a millis() period, but micros() misses wraps on the way:
+    // only millis64() can still match virtual time absolutely
+    jumpTo(MILLIS_PERIOD_US - 3000000);
+    Reading start = readClocks();
+    TEST_ASSERT_EQUAL_UINT64(start.virtualMs, start.ms);
+
+    stepAndCheck(1000, 5000);       // Over the first wrap in 1 ms steps
+    stepAndCheck(HOUR_US, 3 * 1200); // Three more wraps, micros() wraps in between
+
+    Reading end = readClocks();
+    TEST_ASSERT_EQUAL_UINT64(end.virtualMs, end.ms);
+    TEST_ASSERT_TRUE(end.ms > 4 * (1ULL << 32));
+}
+
+void test_gap_just_under_a_period()
+{
+    Reading before = readClocks();
+    SimClock::advance(MICROS_PERIOD_US - 1000);
+    Reading after = readClocks();
+    checkMicros(before, after);
+
+    before = readClocks();
+    SimClock::advance(MILLIS_PERIOD_US - 1000000);
+    after = readClocks();
+    checkMillis(before, after);
+}
+
+void test_gap_of_a_whole_period()
+{
+    // The documented limit: with no call for a whole period the wrap goes
+    // unseen and the clock falls behind by exactly one period...
+    Reading before = readClocks();
+    SimClock::advance(MICROS_PERIOD_US + 5000);
+    Reading after = readClocks();
+    TEST_ASSERT_EQUAL_UINT64(after.virtualUs - before.virtualUs - MICROS_PERIOD_US,
+                             after.us - before.us);
+
+    before = readClocks();
+    SimClock::advance(MILLIS_PERIOD_US + 5000000);
+    after = readClocks();
+    TEST_ASSERT_EQUAL_UINT64(after.virtualMs - before.virtualMs - (1ULL << 32),
+                             after.ms - before.ms);
+
+    // ...but it never runs backwards, and regular calls track again
+    TEST_ASSERT_TRUE(after.ms > before.ms);
+    stepAndCheck(1000, 10);
+    stepAndCheck(HOUR_US, 48);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_micros_across_wraps);
+    RUN_TEST(test_millis_across_wraps);
+    RUN_TEST(test_gap_just_under_a_period);
+    RUN_TEST(test_gap_of_a_whole_period);
+    return UNITY_END();
+}
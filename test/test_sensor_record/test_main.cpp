@@ -0,0 +1,116 @@
+/**
+ * @file test_main.cpp
+ * @brief Worst-case SensorData records against the EEPROM record budget
+ *
+ * A record is RECORD_SIZE_BYTES: the 2-byte length prefix leaves 30 CSV
+ * characters. The longest legal synced sample has a 10-digit timestamp,
+ * the highest same-second sequence, an RTD-fault temperature and a
+ * full-scale weight; it has to be stored and read back unchanged.
+ *
+ *   pio test -e native_test
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "LocalStorage.h"
+
+static const size_t RECORD_CSV_MAX = RECORD_SIZE_BYTES - 2;
+
+static LocalStorage storage;
+
+static SensorData sample(unsigned long timestamp, float temperature, float weight, uint16_t sequence)
+{
+    SensorData data;
+    memset(&data, 0, sizeof(data));
+    data.timestamp = timestamp;
+    data.setTemperature(temperature);
+    data.setWeight(weight);
+    data.status = STATUS_OK;
+    data.sequence = sequence;
+    return data;
+}
+
+static void checkSame(const SensorData &expected, const SensorData &actual)
+{
+    TEST_ASSERT_EQUAL_UINT32(expected.timestamp, actual.timestamp);
+    TEST_ASSERT_FLOAT_WITHIN(0.005, expected.getTemperature(), actual.getTemperature());
+    TEST_ASSERT_FLOAT_WITHIN(0.005, expected.getWeight(), actual.getWeight());
+    TEST_ASSERT_EQUAL_UINT8(expected.status, actual.status);
+    TEST_ASSERT_EQUAL_UINT8(expected.flags, actual.flags);
+    TEST_ASSERT_EQUAL_UINT16(expected.sequence, actual.sequence);
+}
+
+// Store one sample and read it back from the newest slot
+static void storeAndCheck(const SensorData &data)
+{
+    TEST_ASSERT_TRUE(storage.saveData(data));
+
+    SensorData stored;
+    TEST_ASSERT_TRUE(storage.retrieveData(stored, storage.getRecordCount() - 1));
+    checkSame(data, stored);
+}
+
+void setUp()
+{
+    TEST_ASSERT_TRUE(storage.initialize());
+    TEST_ASSERT_TRUE(storage.clearStorage());
+}
+
+void tearDown()
+{
+}
+
+void test_longest_synced_sample_fits()
+{
+    SensorData data = sample(4294967295UL, -242.02, 1000.00, SENSOR_SEQUENCE_MAX);
+
+    char csv[SENSOR_CSV_MAX];
+    size_t length = data.toCSV(csv, sizeof(csv));
+    TEST_ASSERT_EQUAL_STRING("4294967295_z,-242.02,1000.00,1", csv);
+    TEST_ASSERT_TRUE(length > 0 && length <= RECORD_CSV_MAX);
+
+    storeAndCheck(data);
+}
+
+void test_every_sequence_round_trips()
+{
+    for (uint16_t sequence = 0; sequence <= SENSOR_SEQUENCE_MAX; sequence++)
+    {
+        storeAndCheck(sample(1767225600UL, 150.00, 1000.00, sequence));
+    }
+}
+
+void test_sequence_over_the_cap_is_rejected()
+{
+    SensorData data = sample(1767225600UL, 25.50, 100.25, SENSOR_SEQUENCE_MAX + 1);
+
+    char csv[SENSOR_CSV_MAX];
+    TEST_ASSERT_EQUAL(0, data.toCSV(csv, sizeof(csv)));
+    TEST_ASSERT_FALSE(storage.saveData(data));
+    TEST_ASSERT_EQUAL(0, storage.getRecordCount());
+}
+
+void test_restamped_sample_keeps_its_sequence()
+{
+    // Taken before time sync at uptime 3600 s, fourth sample of that second
+    SensorData data = sample(3600, -242.02, 1000.00, 3);
+    data.flags = DATA_FLAG_UNSYNCED_TIME;
+    data.bootEpoch = storage.getBootEpoch();
+    storeAndCheck(data);
+
+    TEST_ASSERT_EQUAL(1, storage.restampUnsynced(storage.getBootEpoch(), 1767222000UL));
+
+    SensorData restamped;
+    TEST_ASSERT_TRUE(storage.retrieveData(restamped, 0));
+    checkSame(sample(1767225600UL, -242.02, 1000.00, 3), restamped);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_longest_synced_sample_fits);
+    RUN_TEST(test_every_sequence_round_trips);
+    RUN_TEST(test_sequence_over_the_cap_is_rejected);
+    RUN_TEST(test_restamped_sample_keeps_its_sequence);
+    return UNITY_END();
+}
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Local NTP stand-in for testing TimeSync / NtpClient.
+
+Answers SNTP client requests with the host clock plus an optional offset,
+and can delay or drop replies to exercise sample selection and timeouts.
+
+Usage:
+    python3 tools/ntp_standin.py --port 12300 --offset-ms 1500 --delay-ms 40 --drop 0.25
+
+Point the ESP at it with NTP_SERVERS "192.168.1.50:12300" in SystemConfig.h
+(or TimeSync::setNtpServers()).
+"""
+
+import argparse
+import random
+import socket
+import struct
+import threading
+import time
+
+NTP_UNIX_OFFSET = 2208988800
+
+
+def to_ntp(unix_seconds):
+    seconds = int(unix_seconds)
+    fraction = int((unix_seconds - seconds) * (1 << 32))
+    return ((seconds + NTP_UNIX_OFFSET) & 0xFFFFFFFF) << 32 | fraction
+
+
+def reply(sock, request, addr, args):
+    receive = time.time() + args.offset_ms / 1000.0
+
+    if args.delay_ms:
+        time.sleep(random.uniform(0, args.delay_ms) / 1000.0)
+
+    originate = request[40:48]  # Client transmit timestamp, echoed back
+    transmit = time.time() + args.offset_ms / 1000.0
+
+    packet = struct.pack(
+        "!BBbbII4s8s8sQQ",
+        (0 << 6) | (4 << 3) | 4,  # LI 0, version 4, server mode
+        args.stratum,
+        4,    # poll
+        -20,  # precision (~1 us)
+        0,    # root delay
+        0,    # root dispersion
+        b"LOCL",
+        struct.pack("!Q", to_ntp(receive)),  # reference timestamp
+        originate,
+        to_ntp(receive),
+        to_ntp(transmit),
+    )
+    sock.sendto(packet, addr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=12300)
+    parser.add_argument("--offset-ms", type=float, default=0.0, help="added to the host clock")
+    parser.add_argument("--delay-ms", type=float, default=0.0, help="max random reply delay")
+    parser.add_argument("--drop", type=float, default=0.0, help="fraction of requests ignored")
+    parser.add_argument("--stratum", type=int, default=2)
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.host, args.port))
+    print(f"NTP stand-in on {args.host}:{args.port} (offset {args.offset_ms} ms)")
+
+    while True:
+        request, addr = sock.recvfrom(512)
+        if len(request) < 48 or (request[0] & 0x07) != 3:
+            continue
+        if random.random() < args.drop:
+            print(f"{addr[0]}: dropped")
+            continue
+        threading.Thread(target=reply, args=(sock, request, addr, args), daemon=True).start()
+        print(f"{addr[0]}: answered")
+
+
+if __name__ == "__main__":
+    main()